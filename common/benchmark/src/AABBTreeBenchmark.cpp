@@ -36,6 +36,11 @@
 #include <kdl/overload.h>
 
 #include <vecmath/bbox.h>
+#include <vecmath/ray.h>
+#include <vecmath/vec.h>
+
+#include <random>
+#include <vector>
 
 #include "../../test/src/Catch2.h"
 #include "BenchmarkUtils.h"
@@ -83,5 +88,162 @@ TEST_CASE("AABBTreeBenchmark.benchBuildTree", "[AABBTreeBenchmark]") {
       }
     },
     "Add objects to AABB tree");
+
+  auto nodes = std::vector<Model::Node*>{};
+  world->accept(kdl::overload(
+    [](auto&& thisLambda, Model::WorldNode* world_) {
+      world_->visitChildren(thisLambda);
+    },
+    [](auto&& thisLambda, Model::LayerNode* layer) {
+      layer->visitChildren(thisLambda);
+    },
+    [](auto&& thisLambda, Model::GroupNode* group) {
+      group->visitChildren(thisLambda);
+    },
+    [&](auto&& thisLambda, Model::EntityNode* entity) {
+      entity->visitChildren(thisLambda);
+      nodes.push_back(entity);
+    },
+    [&](Model::BrushNode* brush) {
+      nodes.push_back(brush);
+    },
+    [&](Model::PatchNode* patch) {
+      nodes.push_back(patch);
+    }));
+
+  timeLambda(
+    [&nodes, &trees]() {
+      for (auto& tree : trees) {
+        tree.clearAndBuild(nodes, [](const auto* node) {
+          return node->physicalBounds();
+        });
+      }
+    },
+    "Bulk build AABB tree");
+}
+
+TEST_CASE("AABBTreeBenchmark.benchBulkBuildAndQuery", "[AABBTreeBenchmark]") {
+  using Tree = AABBTree<double, 3, size_t>;
+
+  // 100k brush sized boxes scattered over a large, flat map
+  auto rng = std::mt19937{0};
+  auto xy = std::uniform_real_distribution<double>{-8192.0, 8192.0};
+  auto z = std::uniform_real_distribution<double>{-1024.0, 1024.0};
+  auto size = std::uniform_real_distribution<double>{8.0, 256.0};
+
+  auto bounds = std::vector<Tree::Box>{};
+  auto data = std::vector<size_t>{};
+  for (size_t i = 0; i < 100'000; ++i) {
+    const auto min = vm::vec3d{xy(rng), xy(rng), z(rng)};
+    bounds.emplace_back(min, min + vm::vec3d{size(rng), size(rng), size(rng)});
+    data.push_back(i);
+  }
+
+  auto rays = std::vector<vm::ray3d>{};
+  auto points = std::vector<vm::vec3d>{};
+  for (size_t i = 0; i < 10'000; ++i) {
+    const auto origin = vm::vec3d{xy(rng), xy(rng), z(rng)};
+    const auto target = vm::vec3d{xy(rng), xy(rng), z(rng)};
+    rays.emplace_back(origin, vm::normalize(target - origin));
+    points.push_back(target);
+  }
+
+  const auto getBounds = [&](const size_t i) {
+    return bounds[i];
+  };
+
+  auto insertedTree = Tree{};
+  timeLambda(
+    [&]() {
+      for (const auto i : data) {
+        insertedTree.insert(bounds[i], i);
+      }
+    },
+    "Build AABB tree by insertion");
+
+  auto builtTree = Tree{};
+  timeLambda(
+    [&]() {
+      builtTree.clearAndBuild(data, getBounds);
+    },
+    "Bulk build AABB tree");
+
+  auto insertedHits = size_t(0);
+  auto builtHits = size_t(0);
+  timeLambda(
+    [&]() {
+      for (const auto& ray : rays) {
+        insertedHits += insertedTree.findIntersectors(ray).size();
+      }
+    },
+    "Find intersectors in AABB tree built by insertion");
+  timeLambda(
+    [&]() {
+      for (const auto& ray : rays) {
+        builtHits += builtTree.findIntersectors(ray).size();
+      }
+    },
+    "Find intersectors in bulk built AABB tree");
+  CHECK(builtHits == insertedHits);
+
+  auto insertedContainers = size_t(0);
+  auto builtContainers = size_t(0);
+  timeLambda(
+    [&]() {
+      for (const auto& point : points) {
+        insertedContainers += insertedTree.findContainers(point).size();
+      }
+    },
+    "Find containers in AABB tree built by insertion");
+  timeLambda(
+    [&]() {
+      for (const auto& point : points) {
+        builtContainers += builtTree.findContainers(point).size();
+      }
+    },
+    "Find containers in bulk built AABB tree");
+  CHECK(builtContainers == insertedContainers);
+
+  const auto halfSize = vm::vec3d{128.0, 128.0, 128.0};
+  auto insertedIntersectors = size_t(0);
+  auto builtIntersectors = size_t(0);
+  timeLambda(
+    [&]() {
+      for (const auto& point : points) {
+        const auto box = Tree::Box{point - halfSize, point + halfSize};
+        insertedIntersectors += insertedTree.findIntersectors(box).size();
+      }
+    },
+    "Find box intersectors in AABB tree built by insertion");
+  timeLambda(
+    [&]() {
+      for (const auto& point : points) {
+        const auto box = Tree::Box{point - halfSize, point + halfSize};
+        builtIntersectors += builtTree.findIntersectors(box).size();
+      }
+    },
+    "Find box intersectors in bulk built AABB tree");
+  CHECK(builtIntersectors == insertedIntersectors);
+
+  // move every tenth box a little and update the trees
+  auto moved = std::vector<size_t>{};
+  for (size_t i = 0; i < data.size(); i += 10) {
+    bounds[i] = bounds[i].translate(vm::vec3d{16.0, 0.0, 0.0});
+    moved.push_back(i);
+  }
+
+  timeLambda(
+    [&]() {
+      for (const auto i : moved) {
+        insertedTree.update(bounds[i], i);
+      }
+    },
+    "Update AABB tree node by node");
+  timeLambda(
+    [&]() {
+      builtTree.refit(moved, getBounds);
+    },
+    "Refit AABB tree");
+  CHECK(builtTree.bounds() == insertedTree.bounds());
 }
 } // namespace TrenchBroom
@@ -0,0 +1,133 @@
+/*
+ Copyright (C) 2023 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Assets/Palette.h"
+#include "Assets/TextureBuffer.h"
+#include "Color.h"
+#include "IO/Reader.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "../../test/src/Catch2.h"
+#include "BenchmarkUtils.h"
+
+namespace TrenchBroom {
+namespace Assets {
+/**
+ * The palette expansion as implemented before it was fused into a single pass, for comparison.
+ */
+static bool referenceIndexedToRgba(
+  const std::vector<unsigned char>& paletteData, const unsigned char* indexedImage,
+  const size_t pixelCount, TextureBuffer& rgbaImage, Color& averageColor) {
+  unsigned char* const rgbaData = rgbaImage.data();
+  for (size_t i = 0; i < pixelCount; ++i) {
+    std::memcpy(rgbaData + (i * 4), &paletteData[indexedImage[i] * 4u], 4);
+  }
+
+  uint32_t colorSum[3] = {0, 0, 0};
+  for (size_t i = 0; i < pixelCount; ++i) {
+    colorSum[0] += static_cast<uint32_t>(rgbaData[(i * 4) + 0]);
+    colorSum[1] += static_cast<uint32_t>(rgbaData[(i * 4) + 1]);
+    colorSum[2] += static_cast<uint32_t>(rgbaData[(i * 4) + 2]);
+  }
+  averageColor = Color(
+    static_cast<float>(colorSum[0]) / (255.0f * static_cast<float>(pixelCount)),
+    static_cast<float>(colorSum[1]) / (255.0f * static_cast<float>(pixelCount)),
+    static_cast<float>(colorSum[2]) / (255.0f * static_cast<float>(pixelCount)), 1.0f);
+
+  unsigned char andAlpha = 0xff;
+  for (size_t i = 0; i < pixelCount; ++i) {
+    andAlpha &= rgbaData[(i * 4) + 3];
+  }
+  return andAlpha != 0xff;
+}
+
+TEST_CASE("PaletteBenchmark.indexedToRgba", "[PaletteBenchmark]") {
+  // roughly the contents of a large WAD file: 2000 textures of 128x128 pixels with 4 mip levels
+  constexpr size_t TextureCount = 2000;
+  constexpr size_t Width = 128;
+  constexpr size_t Height = 128;
+  constexpr size_t MipLevels = 4;
+
+  auto rawPalette = std::vector<unsigned char>(768);
+  for (size_t i = 0; i < rawPalette.size(); ++i) {
+    rawPalette[i] = static_cast<unsigned char>((i * 31) % 256);
+  }
+  const auto palette = Palette{rawPalette};
+
+  auto paletteData = std::vector<unsigned char>{};
+  for (size_t i = 0; i < 256; ++i) {
+    paletteData.insert(paletteData.end(), &rawPalette[3 * i], &rawPalette[3 * i] + 3);
+    paletteData.push_back(static_cast<unsigned char>(i == 255 ? 0 : 0xff));
+  }
+
+  auto mipSizes = std::vector<size_t>{};
+  for (size_t level = 0; level < MipLevels; ++level) {
+    mipSizes.push_back((Width >> level) * (Height >> level));
+  }
+
+  auto indices = std::vector<unsigned char>(Width * Height * 2);
+  for (size_t i = 0; i < indices.size(); ++i) {
+    indices[i] = static_cast<unsigned char>((i * 7919) % 256);
+  }
+  const auto* begin = reinterpret_cast<const char*>(indices.data());
+
+  auto buffers = std::vector<TextureBuffer>{};
+  for (const auto mipSize : mipSizes) {
+    buffers.emplace_back(4 * mipSize);
+  }
+
+  auto referenceColor = Color{};
+  auto referenceTransparency = false;
+  timeLambda(
+    [&]() {
+      for (size_t i = 0; i < TextureCount; ++i) {
+        for (size_t level = 0; level < MipLevels; ++level) {
+          referenceTransparency = referenceIndexedToRgba(
+            paletteData, indices.data() + i % Width, mipSizes[level], buffers[level],
+            referenceColor);
+        }
+      }
+    },
+    "Expand indices in separate passes");
+
+  auto color = Color{};
+  auto transparency = false;
+  timeLambda(
+    [&]() {
+      for (size_t i = 0; i < TextureCount; ++i) {
+        for (size_t level = 0; level < MipLevels; ++level) {
+          auto reader = IO::Reader::from(begin + i % Width, begin + indices.size()).buffer();
+          transparency = palette.indexedToRgba(
+            reader, mipSizes[level], buffers[level],
+            PaletteTransparency::Index255Transparent, color);
+        }
+      }
+    },
+    "Expand indices in a single pass");
+
+  CHECK(transparency == referenceTransparency);
+  CHECK(color.r() == Approx(referenceColor.r()));
+  CHECK(color.g() == Approx(referenceColor.g()));
+  CHECK(color.b() == Approx(referenceColor.b()));
+}
+} // namespace Assets
+} // namespace TrenchBroom
@@ -0,0 +1,81 @@
+/*
+ Copyright (C) 2023 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Assets/TextureBuffer.h"
+
+#include <kdl/parallel.h>
+
+#include <cstring>
+#include <vector>
+
+#include "../../test/src/Catch2.h"
+#include "BenchmarkUtils.h"
+
+namespace TrenchBroom {
+namespace Assets {
+TEST_CASE("TextureBufferBenchmark.generateMipmaps", "[TextureBufferBenchmark]") {
+  // roughly the contents of a large texture directory: 2000 textures of 256x256 pixels
+  constexpr size_t TextureCount = 2000;
+  constexpr size_t Width = 256;
+  constexpr size_t Height = 256;
+
+  const auto mipLevels = mipLevelCount(Width, Height);
+
+  auto pixels = std::vector<unsigned char>(Width * Height * 4u);
+  for (size_t i = 0; i < pixels.size(); ++i) {
+    pixels[i] = static_cast<unsigned char>((i * 7919) % 256);
+  }
+
+  const auto makeBaseLevel = [&]() {
+    auto buffers = TextureBufferList{};
+    buffers.emplace_back(pixels.size());
+    std::memcpy(buffers[0].data(), pixels.data(), pixels.size());
+    return buffers;
+  };
+
+  auto sequentialSize = size_t(0);
+  timeLambda(
+    [&]() {
+      for (size_t i = 0; i < TextureCount; ++i) {
+        auto buffers = makeBaseLevel();
+        generateMipmaps(buffers, mipLevels, Width, Height, GL_RGBA);
+        sequentialSize += buffers.back().size();
+      }
+    },
+    "Generate mipmaps sequentially");
+
+  auto sizes = std::vector<size_t>(TextureCount);
+  timeLambda(
+    [&]() {
+      kdl::parallel_for(TextureCount, [&](const size_t i) {
+        auto buffers = makeBaseLevel();
+        generateMipmaps(buffers, mipLevels, Width, Height, GL_RGBA);
+        sizes[i] = buffers.back().size();
+      });
+    },
+    "Generate mipmaps in parallel");
+
+  auto parallelSize = size_t(0);
+  for (const auto size : sizes) {
+    parallelSize += size;
+  }
+  CHECK(parallelSize == sequentialSize);
+}
+} // namespace Assets
+} // namespace TrenchBroom
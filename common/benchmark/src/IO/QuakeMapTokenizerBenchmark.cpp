@@ -0,0 +1,196 @@
+/*
+ Copyright (C) 2023 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "IO/StandardMapParser.h"
+#include "IO/Tokenizer.h"
+
+#include <kdl/string_utils.h>
+
+#include <fmt/format.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../../test/src/Catch2.h"
+#include "BenchmarkUtils.h"
+
+namespace TrenchBroom {
+namespace IO {
+/**
+ * The map tokenizer as implemented on top of the generic character matching functions of
+ * Tokenizer, for comparison.
+ */
+class GenericQuakeMapTokenizer : public Tokenizer<QuakeMapToken::Type> {
+public:
+  explicit GenericQuakeMapTokenizer(std::string_view str)
+    : Tokenizer{str, "\"", '\\'} {}
+
+private:
+  static const std::string& NumberDelim() {
+    static const auto numberDelim = Whitespace() + ")";
+    return numberDelim;
+  }
+
+  Token emitToken() override {
+    while (!eof()) {
+      auto startLine = line();
+      auto startColumn = column();
+      const auto* c = curPos();
+      switch (*c) {
+        case '/':
+          advance();
+          if (curChar() == '/') {
+            advance();
+            if (curChar() == '/' && lookAhead(1) == ' ') {
+              advance();
+              return Token(QuakeMapToken::Comment, c, c + 3, offset(c), startLine, startColumn);
+            }
+            discardUntil("\n\r");
+          }
+          break;
+        case ';':
+          advance();
+          discardUntil("\n\r");
+          break;
+        case '{':
+          advance();
+          return Token(QuakeMapToken::OBrace, c, c + 1, offset(c), startLine, startColumn);
+        case '}':
+          advance();
+          return Token(QuakeMapToken::CBrace, c, c + 1, offset(c), startLine, startColumn);
+        case '(':
+          advance();
+          return Token(QuakeMapToken::OParenthesis, c, c + 1, offset(c), startLine, startColumn);
+        case ')':
+          advance();
+          return Token(QuakeMapToken::CParenthesis, c, c + 1, offset(c), startLine, startColumn);
+        case '[':
+          advance();
+          return Token(QuakeMapToken::OBracket, c, c + 1, offset(c), startLine, startColumn);
+        case ']':
+          advance();
+          return Token(QuakeMapToken::CBracket, c, c + 1, offset(c), startLine, startColumn);
+        case '"': {
+          advance();
+          c = curPos();
+          const auto* e = readQuotedString('"', "\n}");
+          return Token(QuakeMapToken::String, c, e, offset(c), startLine, startColumn);
+        }
+        case '\r':
+        case '\n':
+        case ' ':
+        case '\t':
+          discardWhile(Whitespace());
+          break;
+        default: {
+          const auto* e = readInteger(NumberDelim());
+          if (e != nullptr) {
+            return Token(QuakeMapToken::Integer, c, e, offset(c), startLine, startColumn);
+          }
+
+          e = readDecimal(NumberDelim());
+          if (e != nullptr) {
+            return Token(QuakeMapToken::Decimal, c, e, offset(c), startLine, startColumn);
+          }
+
+          e = readUntil(Whitespace());
+          return Token(QuakeMapToken::String, c, e, offset(c), startLine, startColumn);
+        }
+      }
+    }
+    return Token(QuakeMapToken::Eof, nullptr, nullptr, length(), line(), column());
+  }
+};
+
+static std::string makeMap(const size_t brushCount) {
+  auto result = std::string{"// Game: Quake\n// Format: Valve\n// entity 0\n{\n"};
+  result += "\"classname\" \"worldspawn\"\n\"wad\" \"quake.wad\"\n";
+  for (size_t i = 0; i < brushCount; ++i) {
+    const auto x = static_cast<double>(i % 256) * 64.0 - 8192.0;
+    const auto y = static_cast<double>(i / 256) * 64.0 - 8192.0;
+    result += fmt::format("// brush {}\n{{\n", i);
+    for (size_t j = 0; j < 6; ++j) {
+      result += fmt::format(
+        "( {} {} -16 ) ( {} {} -16 ) ( {} {} 16 ) tech_{} [ 1 0 0 {} ] [ 0 -1 0 -0.5 ] 0 1 1\n",
+        x, y, x + 64.0, y + 0.125, x, y + 64.0, j, static_cast<double>(j) * 0.25);
+    }
+    result += "}\n";
+  }
+  result += "}\n";
+  return result;
+}
+
+template <typename T> static std::vector<QuakeMapToken::Type> tokenize(const std::string& str) {
+  auto result = std::vector<QuakeMapToken::Type>{};
+  auto tokenizer = T{str};
+  for (auto token = tokenizer.nextToken(); !token.hasType(QuakeMapToken::Eof);
+       token = tokenizer.nextToken()) {
+    result.push_back(token.type());
+  }
+  return result;
+}
+
+TEST_CASE("QuakeMapTokenizerBenchmark.tokenize", "[QuakeMapTokenizerBenchmark]") {
+  const auto map = makeMap(100'000);
+
+  auto genericTokens = std::vector<QuakeMapToken::Type>{};
+  auto tokens = std::vector<QuakeMapToken::Type>{};
+
+  timeLambda(
+    [&]() { genericTokens = tokenize<GenericQuakeMapTokenizer>(map); },
+    "Tokenize map with generic tokenizer");
+  timeLambda([&]() { tokens = tokenize<QuakeMapTokenizer>(map); }, "Tokenize map");
+
+  CHECK(tokens == genericTokens);
+}
+
+TEST_CASE("QuakeMapTokenizerBenchmark.parseNumbers", "[QuakeMapTokenizerBenchmark]") {
+  const auto map = makeMap(100'000);
+
+  auto expected = 0.0;
+  auto actual = 0.0;
+
+  timeLambda(
+    [&]() {
+      auto tokenizer = QuakeMapTokenizer{map};
+      for (auto token = tokenizer.nextToken(); !token.hasType(QuakeMapToken::Eof);
+           token = tokenizer.nextToken()) {
+        if (token.hasType(QuakeMapToken::Number)) {
+          expected += kdl::str_to_double(token.data()).value_or(0.0);
+        }
+      }
+    },
+    "Tokenize map and parse numbers with str_to_double");
+  timeLambda(
+    [&]() {
+      auto tokenizer = QuakeMapTokenizer{map};
+      for (auto token = tokenizer.nextToken(); !token.hasType(QuakeMapToken::Eof);
+           token = tokenizer.nextToken()) {
+        if (token.hasType(QuakeMapToken::Number)) {
+          actual += token.toFloat<double>();
+        }
+      }
+    },
+    "Tokenize map and parse numbers with Token::toFloat");
+
+  CHECK(actual == expected);
+}
+} // namespace IO
+} // namespace TrenchBroom
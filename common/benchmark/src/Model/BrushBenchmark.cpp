@@ -0,0 +1,252 @@
+/*
+ Copyright (C) 2023 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "IO/DiskIO.h"
+#include "IO/File.h"
+#include "IO/Path.h"
+#include "IO/Reader.h"
+#include "IO/TestParserStatus.h"
+#include "IO/WorldReader.h"
+#include "Model/Brush.h"
+#include "Model/BrushBuilder.h"
+#include "Model/BrushFace.h"
+#include "Model/BrushGeometry.h"
+#include "Model/BrushNode.h"
+#include "Model/EntityNode.h"
+#include "Model/GroupNode.h"
+#include "Model/LayerNode.h"
+#include "Model/MapFormat.h"
+#include "Model/PatchNode.h"
+#include "Model/WorldNode.h"
+
+#include <kdl/overload.h>
+#include <kdl/result.h>
+#include <kdl/vector_utils.h>
+
+#include <vecmath/bbox.h>
+#include <vecmath/mat.h>
+#include <vecmath/mat_ext.h>
+#include <vecmath/plane.h>
+#include <vecmath/scalar.h>
+#include <vecmath/vec.h>
+
+#include <memory>
+#include <vector>
+
+#include "../../test/src/Catch2.h"
+#include "BenchmarkUtils.h"
+
+namespace TrenchBroom {
+namespace Model {
+static constexpr size_t NumBrushes = 10'000;
+
+static std::vector<Brush> makeBrushes(const vm::bbox3& worldBounds) {
+  const auto builder = BrushBuilder{MapFormat::Standard, worldBounds};
+
+  auto result = std::vector<Brush>{};
+  result.reserve(NumBrushes);
+  for (size_t i = 0; i < NumBrushes; ++i) {
+    const auto x = static_cast<FloatType>(i % 100) * 64.0 - 3200.0;
+    const auto y = static_cast<FloatType>(i / 100) * 64.0 - 3200.0;
+    result.push_back(
+      builder.createCuboid(vm::bbox3{vm::vec3{x, y, 0.0}, vm::vec3{x + 32.0, y + 48.0, 64.0}}, "")
+        .value());
+  }
+  return result;
+}
+
+TEST_CASE("BrushBenchmark.copyAndTransform", "[BrushBenchmark]") {
+  const auto worldBounds = vm::bbox3{8192.0};
+  const auto brushes = makeBrushes(worldBounds);
+
+  auto copies = std::vector<std::vector<Brush>>{};
+  timeLambda(
+    [&]() {
+      for (size_t i = 0; i < 10; ++i) {
+        copies.push_back(brushes);
+      }
+    },
+    "Copy brushes 10 times");
+
+  timeLambda(
+    [&]() {
+      copies.clear();
+    },
+    "Destroy brush copies");
+
+  const auto transformation = vm::translation_matrix(vm::vec3{16.0, 8.0, 0.0})
+                              * vm::rotation_matrix(0.0, 0.0, vm::to_radians(15.0));
+  auto transformed = brushes;
+  timeLambda(
+    [&]() {
+      for (auto& brush : transformed) {
+        REQUIRE(brush.transform(worldBounds, transformation, false).is_success());
+      }
+    },
+    "Transform brushes");
+
+  timeLambda(
+    [&]() {
+      for (size_t i = 0; i < 10; ++i) {
+        auto copy = brushes;
+        for (auto& brush : copy) {
+          REQUIRE(brush.transform(worldBounds, transformation, false).is_success());
+        }
+      }
+    },
+    "Copy and transform brushes 10 times");
+
+  CHECK(transformed.size() == brushes.size());
+}
+
+TEST_CASE("BrushBenchmark.buildGeometry", "[BrushBenchmark]") {
+  const auto mapPath =
+    IO::Disk::getCurrentWorkingDir() + IO::Path("fixture/benchmark/AABBTree/ne_ruins.map");
+  const auto file = IO::Disk::openFile(mapPath);
+  auto fileReader = file->reader().buffer();
+
+  IO::TestParserStatus status;
+  IO::WorldReader worldReader(fileReader.stringView(), MapFormat::Standard, {});
+
+  const auto worldBounds = vm::bbox3{8192.0};
+  auto world = std::unique_ptr<WorldNode>{};
+  timeLambda(
+    [&]() {
+      world = worldReader.read(worldBounds, status);
+    },
+    "Load map");
+
+  auto brushFaces = std::vector<std::vector<BrushFace>>{};
+  world->accept(kdl::overload(
+    [](auto&& thisLambda, WorldNode* world_) {
+      world_->visitChildren(thisLambda);
+    },
+    [](auto&& thisLambda, LayerNode* layer) {
+      layer->visitChildren(thisLambda);
+    },
+    [](auto&& thisLambda, GroupNode* group) {
+      group->visitChildren(thisLambda);
+    },
+    [](auto&& thisLambda, EntityNode* entity) {
+      entity->visitChildren(thisLambda);
+    },
+    [&](BrushNode* brush) {
+      brushFaces.push_back(brush->brush().faces());
+    },
+    [](PatchNode*) {}));
+
+  const auto brushPlanes = kdl::vec_transform(brushFaces, [](const auto& faces) {
+    return kdl::vec_transform(faces, [](const BrushFace& face) {
+      return face.boundary();
+    });
+  });
+
+  auto clippedFaceCounts = std::vector<size_t>{};
+  timeLambda(
+    [&]() {
+      for (const auto& planes : brushPlanes) {
+        auto geometry = BrushGeometry{worldBounds};
+        for (const auto& plane : planes) {
+          geometry.clip(plane);
+        }
+        clippedFaceCounts.push_back(geometry.faceCount());
+      }
+    },
+    "Build geometry by clipping the world bounds");
+
+  auto intersectedFaceCounts = std::vector<size_t>{};
+  timeLambda(
+    [&]() {
+      auto facePlaneIndices = std::vector<size_t>{};
+      for (const auto& planes : brushPlanes) {
+        const auto geometry = BrushGeometry::fromPlanes(planes, facePlaneIndices);
+        intersectedFaceCounts.push_back(geometry ? geometry->faceCount() : 0u);
+      }
+    },
+    "Build geometry by intersecting the face planes");
+
+  timeLambda(
+    [&]() {
+      for (auto faces : brushFaces) {
+        REQUIRE(Brush::create(worldBounds, std::move(faces)).is_success());
+      }
+    },
+    "Create brushes");
+
+  // brushes which cannot be built reliably by intersecting the face planes are skipped
+  for (size_t i = 0; i < brushPlanes.size(); ++i) {
+    if (intersectedFaceCounts[i] > 0u) {
+      CHECK(intersectedFaceCounts[i] == clippedFaceCounts[i]);
+    }
+  }
+}
+
+TEST_CASE("BrushBenchmark.subtract", "[BrushBenchmark]") {
+  const auto worldBounds = vm::bbox3{8192.0};
+  const auto builder = BrushBuilder{MapFormat::Standard, worldBounds};
+  const auto minuends = makeBrushes(worldBounds);
+
+  // carve a grid of trenches into the brushes
+  auto subtrahends = std::vector<Brush>{};
+  for (size_t i = 0; i < 20; ++i) {
+    const auto offset = static_cast<FloatType>(i) * 320.0 - 3200.0;
+    subtrahends.push_back(
+      builder
+        .createCuboid(
+          vm::bbox3{vm::vec3{offset, -3200.0, 32.0}, vm::vec3{offset + 48.0, 3200.0, 96.0}}, "")
+        .value());
+    subtrahends.push_back(
+      builder
+        .createCuboid(
+          vm::bbox3{vm::vec3{-3200.0, offset, 48.0}, vm::vec3{3200.0, offset + 48.0, 96.0}}, "")
+        .value());
+  }
+
+  const auto minuendPtrs = kdl::vec_transform(minuends, [](const auto& brush) {
+    return &brush;
+  });
+  const auto subtrahendPtrs = kdl::vec_transform(subtrahends, [](const auto& brush) {
+    return &brush;
+  });
+
+  auto sequentialCount = size_t(0);
+  timeLambda(
+    [&]() {
+      for (const auto* minuend : minuendPtrs) {
+        sequentialCount +=
+          minuend->subtract(MapFormat::Standard, worldBounds, "", subtrahendPtrs).size();
+      }
+    },
+    "Subtract from each brush in sequence");
+
+  auto batchedCount = size_t(0);
+  timeLambda(
+    [&]() {
+      const auto results =
+        subtractBrushes(MapFormat::Standard, worldBounds, "", minuendPtrs, subtrahendPtrs);
+      for (const auto& result : results) {
+        batchedCount += result.size();
+      }
+    },
+    "Subtract from all brushes at once");
+
+  CHECK(batchedCount == sequentialCount);
+}
+} // namespace Model
+} // namespace TrenchBroom
@@ -0,0 +1,92 @@
+/*
+ Copyright (C) 2023 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "IO/DiskIO.h"
+#include "IO/File.h"
+#include "IO/Path.h"
+#include "IO/Reader.h"
+#include "IO/TestParserStatus.h"
+#include "IO/WorldReader.h"
+#include "Model/EditorContext.h"
+#include "Model/PickResult.h"
+#include "Model/WorldNode.h"
+
+#include <vecmath/bbox.h>
+#include <vecmath/ray.h>
+#include <vecmath/vec.h>
+
+#include <vector>
+
+#include "../../test/src/Catch2.h"
+#include "BenchmarkUtils.h"
+
+namespace TrenchBroom {
+namespace Model {
+TEST_CASE("PickingBenchmark.pickRays", "[PickingBenchmark]") {
+  const auto mapPath =
+    IO::Disk::getCurrentWorkingDir() + IO::Path("fixture/benchmark/AABBTree/ne_ruins.map");
+  const auto file = IO::Disk::openFile(mapPath);
+  auto fileReader = file->reader().buffer();
+
+  IO::TestParserStatus status;
+  IO::WorldReader worldReader(fileReader.stringView(), MapFormat::Standard, {});
+
+  const vm::bbox3 worldBounds(8192.0);
+  auto world = worldReader.read(worldBounds, status);
+  const auto editorContext = EditorContext{};
+
+  // a 256x256 grid of rays cast from a point above the map towards its bounds
+  const auto& bounds = world->nodeTree().bounds();
+  const auto origin =
+    vm::vec3{bounds.center().x(), bounds.center().y(), bounds.max.z() + 256.0};
+  auto rays = std::vector<vm::ray3>{};
+  for (size_t y = 0; y < 256; ++y) {
+    for (size_t x = 0; x < 256; ++x) {
+      const auto target = vm::vec3{
+        bounds.min.x() + bounds.size().x() * static_cast<FloatType>(x) / 255.0,
+        bounds.min.y() + bounds.size().y() * static_cast<FloatType>(y) / 255.0,
+        bounds.min.z()};
+      rays.emplace_back(origin, vm::normalize(target - origin));
+    }
+  }
+
+  auto hitCount = size_t(0);
+  timeLambda(
+    [&]() {
+      for (const auto& ray : rays) {
+        auto pickResult = PickResult::byDistance();
+        world->pick(editorContext, ray, pickResult);
+        hitCount += pickResult.size();
+      }
+    },
+    "Pick rays one by one");
+
+  auto batchHitCount = size_t(0);
+  timeLambda(
+    [&]() {
+      for (const auto& pickResult : world->pickRays(editorContext, rays)) {
+        batchHitCount += pickResult.size();
+      }
+    },
+    "Pick rays in packets");
+
+  CHECK(batchHitCount == hitCount);
+}
+} // namespace Model
+} // namespace TrenchBroom
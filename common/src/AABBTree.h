@@ -20,6 +20,9 @@
 #pragma once
 
 #include "Exceptions.h"
+#include "Sse2.h"
+
+#include <kdl/thread_pool.h>
 
 #include <vecmath/bbox.h>
 #include <vecmath/bbox_io.h>
@@ -27,9 +30,16 @@
 #include <vecmath/ray.h>
 #include <vecmath/scalar.h>
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cstdint>
 #include <iosfwd>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
+#include <type_traits>
 #include <vector>
 
 namespace TrenchBroom {
@@ -48,43 +58,317 @@ public:
   using FloatType = T;
   static constexpr size_t Components = S;
 
+  /**
+   * The maximum number of rays that are tested together when finding the intersectors of multiple
+   * rays.
+   */
+  static constexpr size_t RayPacketSize = 64;
+
+  /**
+   * After the structure of the tree was changed, this many queries are answered by traversing the
+   * tree itself before the flat tree is rebuilt. This avoids rebuilding the flat tree after every
+   * change when changes and queries are interleaved.
+   */
+  static constexpr size_t FlatTreeRebuildQueryCount = 32;
+
 private:
   class InnerNode;
   class LeafNode;
 
-  class Visitor {
-  public:
-    virtual ~Visitor() = default;
+  /**
+   * A read optimized copy of a tree that is used for queries.
+   *
+   * Every node of the flat tree has up to Width children, which are obtained by collapsing the
+   * upper levels of the corresponding subtree of the binary tree. The nodes are stored in a
+   * contiguous array in depth first order. Every node stores the bounds of its children per
+   * component, so that a ray or a box can be tested against all children at once, and references
+   * to its children, which are either indices of other nodes or indices into the leaf data.
+   */
+  struct FlatTree {
+    static constexpr size_t Width = 4;
+    static constexpr size_t LeafFlag = size_t(1) << (std::numeric_limits<size_t>::digits - 1);
 
-    virtual bool visit(const InnerNode* innerNode) = 0;
-    virtual void visit(const LeafNode* leaf) = 0;
-  };
+    /**
+     * A ray prepared for testing it against the nodes of a flat tree.
+     */
+    struct RayQuery {
+      vm::vec<T, S> origin;
+      vm::vec<T, S> inverseDirection;
+      std::array<bool, S> parallel;
+
+      explicit RayQuery(const vm::ray<T, S>& ray)
+        : origin(ray.origin) {
+        for (size_t i = 0; i < S; ++i) {
+          parallel[i] = ray.direction[i] == T(0);
+          inverseDirection[i] = parallel[i] ? T(0) : T(1) / ray.direction[i];
+        }
+      }
+    };
 
-  template <typename I_V, typename L_V> class LambdaVisitor : public Visitor {
-  private:
-    I_V m_innerNodeVisitor;
-    L_V m_leafNodeVisitor;
+    struct alignas(16) Node {
+      std::array<std::array<T, Width>, S> mins;
+      std::array<std::array<T, Width>, S> maxs;
+      std::array<size_t, Width> children;
+      size_t childCount;
 
-  public:
-    LambdaVisitor(I_V innerNodeVisitor, L_V leafNodeVisitor)
-      : m_innerNodeVisitor(std::move(innerNodeVisitor))
-      , m_leafNodeVisitor(std::move(leafNodeVisitor)) {}
+      void setChild(const size_t index, const Box& bounds, const size_t child) {
+        setChildBounds(index, bounds);
+        children[index] = child;
+      }
 
-    bool visit(const InnerNode* innerNode) override { return m_innerNodeVisitor(innerNode); }
-    void visit(const LeafNode* leafNode) override { m_leafNodeVisitor(leafNode); }
-  };
+      void setChildBounds(const size_t index, const Box& bounds) {
+        for (size_t i = 0; i < S; ++i) {
+          mins[i][index] = bounds.min[i];
+          maxs[i][index] = bounds.max[i];
+        }
+      }
 
-#if !defined __GNUC__ || defined __clang__
-  /**
-   * Deduction guide.
-   *
-   * Note that as of GCC 9.2, there appears to be a bug in GCC that disallows deduction guides in
-   * non-namespace scope. Luckily, GCC does not need a guide to deduce the template parameters of
-   * LambdaVisitor, but clang does!
-   */
-  template <typename I_V, typename L_V>
-  LambdaVisitor(I_V innerNodeVisitor, L_V outerNodeVisitor) -> LambdaVisitor<I_V, L_V>;
+      /**
+       * Returns the bounds of the child with the given index.
+       */
+      Box childBounds(const size_t index) const {
+        auto result = Box{};
+        for (size_t i = 0; i < S; ++i) {
+          result.min[i] = mins[i][index];
+          result.max[i] = maxs[i][index];
+        }
+        return result;
+      }
+
+      /**
+       * Returns a mask with one bit set for every child whose bounds are hit by the given ray or
+       * contain the ray's origin.
+       */
+      unsigned int intersect(const RayQuery& query) const {
+#ifdef TB_SSE2
+        if constexpr (std::is_same_v<T, double>) {
+          const auto result = intersectSse2(query, 0) | (intersectSse2(query, 2) << 2);
+          return result & childMask();
+        } else {
+          return intersectScalar(query);
+        }
+#else
+        return intersectScalar(query);
+#endif
+      }
+
+      /**
+       * Returns a mask with one bit set for every child whose bounds intersect the given box.
+       */
+      unsigned int intersect(const Box& box) const {
+#ifdef TB_SSE2
+        if constexpr (std::is_same_v<T, double>) {
+          const auto result = intersectSse2(box, 0) | (intersectSse2(box, 2) << 2);
+          return result & childMask();
+        } else {
+          return intersectScalar(box);
+        }
+#else
+        return intersectScalar(box);
+#endif
+      }
+
+    private:
+      unsigned int childMask() const { return (1u << childCount) - 1u; }
+
+      unsigned int intersectScalar(const RayQuery& query) const {
+        auto result = 0u;
+        for (size_t lane = 0; lane < childCount; ++lane) {
+          auto hit = true;
+          auto tMin = T(0);
+          auto tMax = std::numeric_limits<T>::max();
+          for (size_t i = 0; i < S; ++i) {
+            if (query.parallel[i]) {
+              hit = hit && mins[i][lane] <= query.origin[i] && maxs[i][lane] >= query.origin[i];
+            } else {
+              const auto t1 = (mins[i][lane] - query.origin[i]) * query.inverseDirection[i];
+              const auto t2 = (maxs[i][lane] - query.origin[i]) * query.inverseDirection[i];
+              tMin = std::max(tMin, std::min(t1, t2));
+              tMax = std::min(tMax, std::max(t1, t2));
+            }
+          }
+          if (hit && tMin <= tMax) {
+            result |= 1u << lane;
+          }
+        }
+        return result;
+      }
+
+      unsigned int intersectScalar(const Box& box) const {
+        auto result = 0u;
+        for (size_t lane = 0; lane < childCount; ++lane) {
+          auto hit = true;
+          for (size_t i = 0; i < S; ++i) {
+            hit = hit && mins[i][lane] <= box.max[i] && maxs[i][lane] >= box.min[i];
+          }
+          if (hit) {
+            result |= 1u << lane;
+          }
+        }
+        return result;
+      }
+
+#ifdef TB_SSE2
+      /**
+       * Tests the two children starting at the given lane at once. Only used if T is double.
+       */
+      unsigned int intersectSse2(const RayQuery& query, const size_t lane) const {
+        auto hit = _mm_castsi128_pd(_mm_set1_epi32(-1));
+        auto tMin = _mm_setzero_pd();
+        auto tMax = _mm_set1_pd(std::numeric_limits<double>::max());
+        for (size_t i = 0; i < S; ++i) {
+          const auto nodeMin = _mm_loadu_pd(&mins[i][lane]);
+          const auto nodeMax = _mm_loadu_pd(&maxs[i][lane]);
+          const auto origin = _mm_set1_pd(query.origin[i]);
+          if (query.parallel[i]) {
+            hit = _mm_and_pd(
+              hit, _mm_and_pd(_mm_cmple_pd(nodeMin, origin), _mm_cmpge_pd(nodeMax, origin)));
+          } else {
+            const auto inverseDirection = _mm_set1_pd(query.inverseDirection[i]);
+            const auto t1 = _mm_mul_pd(_mm_sub_pd(nodeMin, origin), inverseDirection);
+            const auto t2 = _mm_mul_pd(_mm_sub_pd(nodeMax, origin), inverseDirection);
+            tMin = _mm_max_pd(tMin, _mm_min_pd(t1, t2));
+            tMax = _mm_min_pd(tMax, _mm_max_pd(t1, t2));
+          }
+        }
+        hit = _mm_and_pd(hit, _mm_cmple_pd(tMin, tMax));
+        return static_cast<unsigned int>(_mm_movemask_pd(hit));
+      }
+
+      unsigned int intersectSse2(const Box& box, const size_t lane) const {
+        auto hit = _mm_castsi128_pd(_mm_set1_epi32(-1));
+        for (size_t i = 0; i < S; ++i) {
+          const auto nodeMin = _mm_loadu_pd(&mins[i][lane]);
+          const auto nodeMax = _mm_loadu_pd(&maxs[i][lane]);
+          hit = _mm_and_pd(
+            hit,
+            _mm_and_pd(
+              _mm_cmple_pd(nodeMin, _mm_set1_pd(box.max[i])),
+              _mm_cmpge_pd(nodeMax, _mm_set1_pd(box.min[i]))));
+        }
+        return static_cast<unsigned int>(_mm_movemask_pd(hit));
+      }
 #endif
+    };
+
+    static constexpr size_t NoParent = std::numeric_limits<size_t>::max();
+
+    std::vector<Node> nodes;
+    std::vector<U> data;
+
+    /**
+     * For every node, the location of the node in its parent, or NoParent for the root. For every
+     * data item, the location of its leaf. A location is the index of a node times Width plus the
+     * index of the child.
+     */
+    std::vector<size_t> nodeLocations;
+    std::vector<size_t> dataLocations;
+
+    static bool isLeaf(const size_t child) { return (child & LeafFlag) != 0; }
+
+    /**
+     * Sets the bounds of the leaf of the data item with the given index and recomputes the bounds
+     * of the leaf's ancestors.
+     */
+    void refit(const size_t dataIndex, const Box& bounds) {
+      auto location = dataLocations[dataIndex];
+      auto childBounds = bounds;
+      while (location != NoParent) {
+        const auto nodeIndex = location / Width;
+        auto& node = nodes[nodeIndex];
+        node.setChildBounds(location % Width, childBounds);
+
+        childBounds = node.childBounds(0);
+        for (size_t i = 1; i < node.childCount; ++i) {
+          childBounds = vm::merge(childBounds, node.childBounds(i));
+        }
+        location = nodeLocations[nodeIndex];
+      }
+    }
+
+    /**
+     * Visits the data of every leaf for which the given node test passes for all ancestors and the
+     * leaf itself.
+     */
+    template <typename Test, typename O> void find(const Test& test, O& out) const {
+      if (nodes.empty()) {
+        return;
+      }
+
+      auto stack = std::vector<size_t>{0};
+      while (!stack.empty()) {
+        const auto& node = nodes[stack.back()];
+        stack.pop_back();
+
+        auto mask = test(node);
+        for (size_t i = 0; mask != 0; ++i, mask >>= 1) {
+          if ((mask & 1u) != 0) {
+            const auto child = node.children[i];
+            if (isLeaf(child)) {
+              out = data[child & ~LeafFlag];
+              ++out;
+            } else {
+              stack.push_back(child);
+            }
+          }
+        }
+      }
+    }
+
+    /**
+     * Calls the given function with the index of every given ray and the data of every leaf whose
+     * bounds are hit by that ray. The rays are traversed together as one packet, so every node is
+     * visited at most once for all rays.
+     */
+    template <typename F>
+    void findPacket(const RayQuery* queries, const size_t count, const F& callback) const {
+      assert(count <= std::numeric_limits<std::uint64_t>::digits);
+      if (nodes.empty() || count == 0) {
+        return;
+      }
+
+      const auto allRays = count == std::numeric_limits<std::uint64_t>::digits
+                             ? ~std::uint64_t(0)
+                             : (std::uint64_t(1) << count) - 1;
+
+      auto stack = std::vector<std::pair<size_t, std::uint64_t>>{{0, allRays}};
+      while (!stack.empty()) {
+        const auto [nodeIndex, rays] = stack.back();
+        stack.pop_back();
+
+        const auto& node = nodes[nodeIndex];
+
+        // for every child, collect the rays that hit it
+        auto childRays = std::array<std::uint64_t, Width>{};
+        for (size_t ray = 0; ray < count; ++ray) {
+          if (((rays >> ray) & 1u) != 0) {
+            auto mask = node.intersect(queries[ray]);
+            for (size_t i = 0; mask != 0; ++i, mask >>= 1) {
+              if ((mask & 1u) != 0) {
+                childRays[i] |= std::uint64_t(1) << ray;
+              }
+            }
+          }
+        }
+
+        for (size_t i = 0; i < node.childCount; ++i) {
+          if (childRays[i] != 0) {
+            const auto child = node.children[i];
+            if (isLeaf(child)) {
+              const auto& leafData = data[child & ~LeafFlag];
+              for (size_t ray = 0; ray < count; ++ray) {
+                if (((childRays[i] >> ray) & 1u) != 0) {
+                  callback(ray, leafData);
+                }
+              }
+            } else {
+              stack.emplace_back(child, childRays[i]);
+            }
+          }
+        }
+      }
+    }
+  };
 
   class Node {
   public:
@@ -124,13 +408,6 @@ private:
      */
     virtual std::pair<Node*, LeafNode*> insert(const Box& bounds, const U& data) = 0;
 
-    /**
-     * Accepts the given visitor.
-     *
-     * @param visitor the visitor to accept
-     */
-    virtual void accept(Visitor& visitor) const = 0;
-
   public:
     /**
      * Appends a textual representation of this node to the given output stream.
@@ -273,6 +550,9 @@ private:
 
     size_t height() const override { return m_height; }
 
+    const Node* left() const { return m_left; }
+    const Node* right() const { return m_right; }
+
     std::pair<Node*, LeafNode*> insert(const Box& bounds, const U& data) override {
       // Select the subtree which is increased the least by inserting a node with the given bounds.
       // Then insert the node into that subtree and update our reference to it.
@@ -300,6 +580,20 @@ private:
       return std::make_pair(this, insertedLeafNode);
     }
 
+    /**
+     * Recomputes the bounds of this node from the bounds of its children.
+     *
+     * @return true if the bounds of this node changed and false otherwise
+     */
+    bool refitBounds() {
+      const auto newBounds = merge(m_left->bounds(), m_right->bounds());
+      if (newBounds == this->bounds()) {
+        return false;
+      }
+      this->setBounds(newBounds);
+      return true;
+    }
+
   private:
     /**
      * Selects one of the two given nodes such that it increases the given bounds the least.
@@ -357,13 +651,6 @@ private:
       assert(m_height > 0);
     }
 
-    void accept(Visitor& visitor) const override {
-      if (visitor.visit(this)) {
-        m_left->accept(visitor);
-        m_right->accept(visitor);
-      }
-    }
-
   public:
     void appendTo(std::ostream& str, const std::string& indent, const size_t level) const override {
       for (size_t i = 0; i < level; ++i)
@@ -380,7 +667,7 @@ private:
     void checkParentPointers([[maybe_unused]] const Node* expectedParent) const override {
       assert(this->m_parent == expectedParent);
       m_left->checkParentPointers(this);
-      m_left->checkParentPointers(this);
+      m_right->checkParentPointers(this);
     }
   };
 
@@ -393,9 +680,15 @@ private:
     U m_data;
 
   public:
+    /**
+     * The index of this leaf's data in the flat tree, set when the flat tree is built.
+     */
+    mutable size_t m_flatTreeIndex;
+
     LeafNode(const Box& bounds, const U& data)
       : Node(bounds)
-      , m_data(data) {}
+      , m_data(data)
+      , m_flatTreeIndex(0) {}
 
     /**
      * Deletes this. Returns the new root of the tree.
@@ -421,6 +714,20 @@ private:
      */
     const U& data() const { return m_data; }
 
+    /**
+     * Sets the bounds of this leaf to the given bounds and recomputes the bounds of its ancestors.
+     * Stops at the first ancestor whose bounds remain unchanged.
+     *
+     * @param bounds the new bounds
+     */
+    void refit(const Box& bounds) {
+      this->setBounds(bounds);
+      auto* parent = this->m_parent;
+      while (parent != nullptr && parent->refitBounds()) {
+        parent = parent->m_parent;
+      }
+    }
+
   public: // Node overrides
     size_t height() const override { return 1; }
 
@@ -440,8 +747,6 @@ private:
       return std::make_pair(newParent, newLeaf);
     }
 
-    void accept(Visitor& visitor) const override { visitor.visit(this); }
-
     void appendTo(std::ostream& str, const std::string& indent, const size_t level) const override {
       for (size_t i = 0; i < level; ++i)
         str << indent;
@@ -456,13 +761,59 @@ private:
     }
   };
 
+  /**
+   * An object to be inserted into a tree by the bulk build.
+   */
+  struct BuildItem {
+    Box bounds;
+    vm::vec<T, S> center;
+    U data;
+  };
+
+  /**
+   * The number of bins per axis that are used to evaluate the surface area heuristic.
+   */
+  static constexpr size_t SahBinCount = 16;
+
+  /**
+   * Subtrees with fewer objects than this are always built on the calling thread.
+   */
+  static constexpr size_t ParallelBuildThreshold = 4096;
+
 private:
   Node* m_root;
   std::unordered_map<U, LeafNode*> m_leafForData;
 
+  /**
+   * Refitting updates the flat tree in place, but any other change discards it. It is rebuilt
+   * lazily by a query once FlatTreeRebuildQueryCount queries were answered without it. Queries
+   * share ownership of the flat tree while they use it. The mutex guards against concurrent
+   * queries rebuilding it at the same time.
+   */
+  mutable std::shared_ptr<FlatTree> m_flatTree;
+  mutable size_t m_queriesWithoutFlatTree;
+  mutable std::mutex m_flatTreeMutex;
+
 public:
   AABBTree()
-    : m_root(nullptr) {}
+    : m_root(nullptr)
+    , m_queriesWithoutFlatTree(0) {}
+
+  /**
+   * Creates a tree containing the given objects using a bulk build, see clearAndBuild.
+   *
+   * @param objects the objects to insert, a list of DataType
+   * @param getBounds a function from DataType -> Box to compute the bounds of each object
+   *
+   * @throws NodeTreeException if the given objects contain duplicates, or the bounds of any object
+   * contains NaN
+   */
+  template <typename DataList, typename GetBounds>
+  AABBTree(const DataList& objects, GetBounds&& getBounds)
+    : m_root(nullptr)
+    , m_queriesWithoutFlatTree(0) {
+    clearAndBuild(objects, std::forward<GetBounds>(getBounds));
+  }
 
   ~AABBTree() { clear(); }
 
@@ -478,16 +829,87 @@ public:
   }
 
   /**
-   * Clears this tree and rebuilds it by inserting given objects.
+   * Clears this tree and rebuilds it from the given objects.
+   *
+   * Instead of inserting the objects one by one, the tree is built top down by recursively
+   * splitting the objects where the surface area heuristic estimates the lowest query cost. The
+   * resulting tree is usually much better suited for ray queries than a tree built by successive
+   * insertion, and it is faster to build. Large subtrees are built in parallel.
    *
    * @param objects the objects to insert, a list of DataType
    * @param getBounds a function from DataType -> Box to compute the bounds of each object
+   *
+   * @throws NodeTreeException if the given objects contain duplicates, or the bounds of any object
+   * contains NaN; the tree is empty afterwards
    */
   template <typename DataList, typename GetBounds>
   void clearAndBuild(const DataList& objects, GetBounds&& getBounds) {
     clear();
+    invalidateFlatTree();
+
+    auto items = std::vector<BuildItem>{};
+    for (const U& object : objects) {
+      const auto bounds = getBounds(object);
+      if (vm::is_nan(bounds.min) || vm::is_nan(bounds.max)) {
+        m_leafForData.clear();
+        throw NodeTreeException("Cannot add node to AABB tree with invalid bounds");
+      }
+      if (!m_leafForData.emplace(object, nullptr).second) {
+        m_leafForData.clear();
+        throw NodeTreeException("Data already in tree");
+      }
+      items.push_back(BuildItem{bounds, bounds.center(), object});
+    }
+
+    if (items.empty()) {
+      return;
+    }
+
+    auto leafs = std::vector<LeafNode*>(items.size(), nullptr);
+    m_root = buildSubtree(items, 0, items.size(), leafs);
+
+    for (auto* leaf : leafs) {
+      m_leafForData[leaf->data()] = leaf;
+    }
+
+    // the whole tree was changed at once, so the next query can rebuild the flat tree right away
+    m_queriesWithoutFlatTree = FlatTreeRebuildQueryCount;
+  }
+
+  /**
+   * Updates the bounds of the nodes with the given data in place without changing the structure of
+   * this tree.
+   *
+   * This is much cheaper than updating each node individually, and the flat tree used for queries
+   * is updated in place instead of being rebuilt. But the quality of the tree degrades if the
+   * bounds change significantly. In that case, the tree should be rebuilt using clearAndBuild.
+   *
+   * @param objects the data of the nodes to update, a list of DataType
+   * @param getBounds a function from DataType -> Box to compute the new bounds of each node
+   *
+   * @throws NodeTreeException if no node with the given data can be found in this tree, or the
+   * bounds of any node contains NaN; the tree remains unchanged in that case
+   */
+  template <typename DataList, typename GetBounds>
+  void refit(const DataList& objects, GetBounds&& getBounds) {
+    auto leafsAndBounds = std::vector<std::pair<LeafNode*, Box>>{};
     for (const U& object : objects) {
-      insert(getBounds(object), object);
+      const auto bounds = getBounds(object);
+      check(bounds);
+
+      const auto it = m_leafForData.find(object);
+      if (it == m_leafForData.end()) {
+        throw NodeTreeException("AABB node not found");
+      }
+      leafsAndBounds.emplace_back(it->second, bounds);
+    }
+
+    const auto lock = std::lock_guard<std::mutex>{m_flatTreeMutex};
+    for (const auto& [leaf, bounds] : leafsAndBounds) {
+      leaf->refit(bounds);
+      if (m_flatTree) {
+        m_flatTree->refit(leaf->m_flatTreeIndex, bounds);
+      }
     }
   }
 
@@ -508,6 +930,8 @@ public:
       throw NodeTreeException("Data already in tree");
     }
 
+    invalidateFlatTree();
+
     if (empty()) {
       auto* insertedLeafNode = new LeafNode(bounds, data);
 
@@ -538,6 +962,7 @@ public:
     m_leafForData.erase(it);
 
     m_root = leaf->deleteThis();
+    invalidateFlatTree();
 
     return true;
   }
@@ -566,6 +991,255 @@ private:
     }
   }
 
+  void invalidateFlatTree() {
+    m_flatTree.reset();
+    m_queriesWithoutFlatTree = 0;
+  }
+
+  /**
+   * Returns the flat copy of this tree, or nullptr if the tree was changed since the flat tree was
+   * last built and not enough queries were answered since, see FlatTreeRebuildQueryCount. If
+   * `rebuild` is true, the flat tree is rebuilt regardless. The returned flat tree remains valid
+   * while the caller holds on to it.
+   */
+  std::shared_ptr<const FlatTree> flatTree(const bool rebuild = false) const {
+    const auto lock = std::lock_guard<std::mutex>{m_flatTreeMutex};
+    if (!m_flatTree) {
+      if (!rebuild && m_queriesWithoutFlatTree < FlatTreeRebuildQueryCount) {
+        ++m_queriesWithoutFlatTree;
+        return nullptr;
+      }
+
+      auto result = std::make_shared<FlatTree>();
+      if (!empty()) {
+        flatten(*result, {m_root}, 1, FlatTree::NoParent);
+      }
+      m_flatTree = std::move(result);
+    }
+    return m_flatTree;
+  }
+
+  /**
+   * Appends a node with the given children to the given flat tree, followed by the nodes for the
+   * subtrees of the children, and returns its index.
+   */
+  static size_t flatten(
+    FlatTree& flatTree,
+    const std::array<const Node*, FlatTree::Width>& children,
+    const size_t childCount,
+    const size_t location) {
+    const auto index = flatTree.nodes.size();
+    flatTree.nodes.emplace_back();
+    flatTree.nodes[index].childCount = childCount;
+    flatTree.nodeLocations.push_back(location);
+
+    for (size_t i = 0; i < childCount; ++i) {
+      const auto* child = children[i];
+      const auto childLocation = index * FlatTree::Width + i;
+      auto childReference = size_t(0);
+      if (child->height() == 1) {
+        const auto* leaf = static_cast<const LeafNode*>(child);
+        leaf->m_flatTreeIndex = flatTree.data.size();
+        childReference = FlatTree::LeafFlag | flatTree.data.size();
+        flatTree.data.push_back(leaf->data());
+        flatTree.dataLocations.push_back(childLocation);
+      } else {
+        auto grandChildren = std::array<const Node*, FlatTree::Width>{};
+        const auto grandChildCount =
+          collapse(static_cast<const InnerNode*>(child), grandChildren);
+        childReference = flatten(flatTree, grandChildren, grandChildCount, childLocation);
+      }
+
+      // the recursive call may have reallocated the nodes
+      flatTree.nodes[index].setChild(i, child->bounds(), childReference);
+    }
+
+    return index;
+  }
+
+  /**
+   * Collects up to FlatTree::Width descendants of the given inner node whose subtrees together
+   * contain all leafs of the node's subtree. Starting with the node's children, the inner node
+   * with the largest bounds is repeatedly replaced by its children.
+   *
+   * @return the number of collected nodes
+   */
+  static size_t collapse(
+    const InnerNode* innerNode, std::array<const Node*, FlatTree::Width>& result) {
+    result[0] = innerNode->left();
+    result[1] = innerNode->right();
+
+    auto count = size_t(2);
+    while (count < FlatTree::Width) {
+      auto largest = count;
+      for (size_t i = 0; i < count; ++i) {
+        if (
+          result[i]->height() > 1 &&
+          (largest == count ||
+           surfaceArea(result[i]->bounds()) > surfaceArea(result[largest]->bounds()))) {
+          largest = i;
+        }
+      }
+
+      if (largest == count) {
+        break;
+      }
+
+      const auto* largestInnerNode = static_cast<const InnerNode*>(result[largest]);
+      result[largest] = largestInnerNode->left();
+      result[count++] = largestInnerNode->right();
+    }
+
+    return count;
+  }
+
+  /**
+   * Returns a cost proportional to the surface area of the given box.
+   */
+  static T surfaceArea(const Box& box) {
+    const auto size = box.size();
+    if constexpr (S == 1) {
+      return size[0];
+    } else {
+      auto result = T(0);
+      for (size_t i = 0; i < S; ++i) {
+        for (size_t j = i + 1; j < S; ++j) {
+          result += size[i] * size[j];
+        }
+      }
+      return result;
+    }
+  }
+
+  /**
+   * Builds a subtree for the items in the range [first, last) and returns its root.
+   *
+   * Each created leaf is stored in the given vector at the index of its item after partitioning.
+   * If the range is large enough, the subtrees are built in parallel on the shared thread pool.
+   */
+  static Node* buildSubtree(
+    std::vector<BuildItem>& items,
+    const size_t first,
+    const size_t last,
+    std::vector<LeafNode*>& leafs) {
+    assert(first < last);
+
+    if (last - first == 1) {
+      auto* leaf = new LeafNode(items[first].bounds, items[first].data);
+      leafs[first] = leaf;
+      return leaf;
+    }
+
+    const auto mid = partitionItems(items, first, last);
+    assert(first < mid && mid < last);
+
+    if (last - first >= ParallelBuildThreshold) {
+      // the calling thread builds one of the subtrees, so this can be nested safely
+      auto children = std::array<Node*, 2>{};
+      kdl::thread_pool::shared().parallel_for(
+        2,
+        [&](const size_t i) {
+          children[i] = i == 0 ? buildSubtree(items, first, mid, leafs)
+                               : buildSubtree(items, mid, last, leafs);
+        },
+        1);
+      return new InnerNode(children[0], children[1]);
+    }
+
+    auto* left = buildSubtree(items, first, mid, leafs);
+    auto* right = buildSubtree(items, mid, last, leafs);
+    return new InnerNode(left, right);
+  }
+
+  /**
+   * Partitions the items in the range [first, last) into two non-empty ranges [first, mid) and
+   * [mid, last) and returns mid.
+   *
+   * The item centers are sorted into bins along the axis on which they are spread the most, and
+   * the split between two adjacent bins that minimizes the surface area heuristic is chosen. If
+   * all item centers coincide, the range is split in half.
+   */
+  static size_t partitionItems(
+    std::vector<BuildItem>& items, const size_t first, const size_t last) {
+    struct Bin {
+      Box bounds;
+      size_t count;
+    };
+
+    auto centerBounds = Box{items[first].center, items[first].center};
+    for (size_t i = first + 1; i < last; ++i) {
+      centerBounds = vm::merge(centerBounds, items[i].center);
+    }
+
+    const auto centerExtents = centerBounds.size();
+    auto axis = size_t(0);
+    for (size_t i = 1; i < S; ++i) {
+      if (centerExtents[i] > centerExtents[axis]) {
+        axis = i;
+      }
+    }
+
+    if (!(centerExtents[axis] > T(0))) {
+      return first + (last - first) / 2;
+    }
+
+    const auto getBinIndex = [&](const BuildItem& item) {
+      const auto offset = (item.center[axis] - centerBounds.min[axis]) / centerExtents[axis];
+      return std::min(
+        SahBinCount - 1, static_cast<size_t>(offset * static_cast<T>(SahBinCount)));
+    };
+
+    auto bins = std::array<Bin, SahBinCount>{};
+    for (size_t i = first; i < last; ++i) {
+      auto& bin = bins[getBinIndex(items[i])];
+      bin.bounds = bin.count == 0 ? items[i].bounds : vm::merge(bin.bounds, items[i].bounds);
+      ++bin.count;
+    }
+
+    // sweep from the right to compute the cost of the right side of every split
+    auto rightCosts = std::array<T, SahBinCount>{};
+    auto rightBounds = Box{};
+    auto rightCount = size_t(0);
+    for (size_t i = SahBinCount - 1; i > 0; --i) {
+      if (bins[i].count > 0) {
+        rightBounds = rightCount == 0 ? bins[i].bounds : vm::merge(rightBounds, bins[i].bounds);
+        rightCount += bins[i].count;
+      }
+      rightCosts[i] = static_cast<T>(rightCount) * surfaceArea(rightBounds);
+    }
+
+    // sweep from the left and evaluate the split after every bin that leaves both sides non-empty
+    auto bestCost = std::numeric_limits<T>::max();
+    auto bestBin = SahBinCount;
+    auto leftBounds = Box{};
+    auto leftCount = size_t(0);
+    for (size_t i = 0; i < SahBinCount - 1; ++i) {
+      if (bins[i].count > 0) {
+        leftBounds = leftCount == 0 ? bins[i].bounds : vm::merge(leftBounds, bins[i].bounds);
+        leftCount += bins[i].count;
+      }
+      if (leftCount > 0 && leftCount < last - first) {
+        const auto cost =
+          static_cast<T>(leftCount) * surfaceArea(leftBounds) + rightCosts[i + 1];
+        if (cost < bestCost) {
+          bestCost = cost;
+          bestBin = i;
+        }
+      }
+    }
+
+    // the first and the last bin are never empty because the centers span the entire axis
+    assert(bestBin < SahBinCount);
+
+    const auto it = std::partition(
+      std::next(items.begin(), static_cast<std::ptrdiff_t>(first)),
+      std::next(items.begin(), static_cast<std::ptrdiff_t>(last)),
+      [&](const BuildItem& item) {
+        return getBinIndex(item) <= bestBin;
+      });
+    return static_cast<size_t>(std::distance(items.begin(), it));
+  }
+
 public:
   /**
    * Clears this node tree.
@@ -575,6 +1249,7 @@ public:
       m_leafForData.clear();
       delete m_root;
       m_root = nullptr;
+      invalidateFlatTree();
     }
   }
 
@@ -632,20 +1307,95 @@ public:
    */
   template <typename O> void findIntersectors(const vm::ray<T, S>& ray, O out) const {
     if (!empty()) {
-      LambdaVisitor visitor(
-        [&](const InnerNode* innerNode) {
-          return innerNode->bounds().contains(ray.origin) ||
-                 !vm::is_nan(vm::intersect_ray_bbox(ray, innerNode->bounds()));
-        },
-        [&](const LeafNode* leaf) {
-          if (
-            leaf->bounds().contains(ray.origin) ||
-            !vm::is_nan(vm::intersect_ray_bbox(ray, leaf->bounds()))) {
-            out = leaf->data();
-            ++out;
-          }
+      if (const auto flatTree = this->flatTree()) {
+        const auto query = typename FlatTree::RayQuery{ray};
+        flatTree->find(
+          [&](const typename FlatTree::Node& node) {
+            return node.intersect(query);
+          },
+          out);
+      } else {
+        findInTree(
+          [&](const Box& bounds) {
+            return bounds.contains(ray.origin) || !vm::is_nan(vm::intersect_ray_bbox(ray, bounds));
+          },
+          out);
+      }
+    }
+  }
+
+  /**
+   * Finds every data item in this tree whose bounding box intersects with any of the rays in the
+   * given range and calls the given function with the offset of the ray in the range and the item
+   * for every such pair.
+   *
+   * The rays are processed in packets of RayPacketSize rays, and the tree is traversed only once
+   * per packet. This is faster than finding the intersectors of each ray individually if the rays
+   * are coherent, e.g. if they originate from the same camera.
+   *
+   * @tparam I the type of the ray iterators
+   * @tparam F the type of the function to call, must be callable as `f(size_t, const U&)`
+   * @param raysBegin the beginning of the range of rays
+   * @param raysEnd the end of the range of rays
+   * @param callback the function to call
+   */
+  template <typename I, typename F>
+  void findIntersectors(I raysBegin, I raysEnd, const F& callback) const {
+    if (!empty()) {
+      auto queries = std::vector<typename FlatTree::RayQuery>{};
+      for (auto it = raysBegin; it != raysEnd; ++it) {
+        queries.emplace_back(*it);
+      }
+
+      // the packet traversal requires the flat tree, so it is rebuilt right away if necessary
+      const auto flatTree = this->flatTree(true);
+
+      for (size_t first = 0; first < queries.size(); first += RayPacketSize) {
+        const auto count = std::min(RayPacketSize, queries.size() - first);
+        flatTree->findPacket(queries.data() + first, count, [&](const size_t ray, const U& data) {
+          callback(first + ray, data);
         });
-      m_root->accept(visitor);
+      }
+    }
+  }
+
+  /**
+   * Finds every data item in this tree whose bounding box intersects with the given box and
+   * returns a list of those items. Boxes that only touch the given box are considered to
+   * intersect it.
+   *
+   * @param box the box to test
+   * @return a list containing all found data items
+   */
+  List findIntersectors(const Box& box) const {
+    List result;
+    findIntersectors(box, std::back_inserter(result));
+    return result;
+  }
+
+  /**
+   * Finds every data item in this tree whose bounding box intersects with the given box and
+   * appends it to the given output iterator.
+   *
+   * @tparam O the output iterator type
+   * @param box the box to test
+   * @param out the output iterator to append to
+   */
+  template <typename O> void findIntersectors(const Box& box, O out) const {
+    if (!empty()) {
+      if (const auto flatTree = this->flatTree()) {
+        flatTree->find(
+          [&](const typename FlatTree::Node& node) {
+            return node.intersect(box);
+          },
+          out);
+      } else {
+        findInTree(
+          [&](const Box& bounds) {
+            return bounds.intersects(box);
+          },
+          out);
+      }
     }
   }
 
@@ -671,21 +1421,68 @@ public:
    * @param out the output iterator to append to
    */
   template <typename O> void findContainers(const vm::vec<T, S>& point, O out) const {
+    findIntersectors(Box{point, point}, out);
+  }
+
+  /**
+   * Finds every data item in this tree for which the given test passes for its bounding box and
+   * for the bounds of every inner node that contains it, and appends it to the given output
+   * iterator.
+   *
+   * Since the test is used to skip entire subtrees, it must pass for a box if it passes for any box
+   * contained in it.
+   *
+   * @tparam P the type of the test, a function from Box to bool
+   * @tparam O the output iterator type
+   * @param test the test to apply
+   * @param out the output iterator to append to
+   */
+  template <typename P, typename O> void findIf(const P& test, O out) const {
     if (!empty()) {
-      LambdaVisitor visitor(
-        [&](const InnerNode* innerNode) {
-          return innerNode->bounds().contains(point);
-        },
-        [&](const LeafNode* leaf) {
-          if (leaf->bounds().contains(point)) {
-            out = leaf->data();
-            ++out;
-          }
-        });
-      m_root->accept(visitor);
+      if (const auto flatTree = this->flatTree()) {
+        flatTree->find(
+          [&](const typename FlatTree::Node& node) {
+            auto mask = 0u;
+            for (size_t i = 0; i < node.childCount; ++i) {
+              if (test(node.childBounds(i))) {
+                mask |= 1u << i;
+              }
+            }
+            return mask;
+          },
+          out);
+      } else {
+        findInTree(test, out);
+      }
+    }
+  }
+
+private:
+  /**
+   * Visits the data of every leaf for which the given test passes for the bounds of the leaf and
+   * of all of its ancestors. Used to answer queries while there is no flat tree.
+   */
+  template <typename P, typename O> void findInTree(const P& test, O& out) const {
+    auto stack = std::vector<const Node*>{m_root};
+    while (!stack.empty()) {
+      const auto* node = stack.back();
+      stack.pop_back();
+
+      if (test(node->bounds())) {
+        if (node->height() == 1) {
+          out = static_cast<const LeafNode*>(node)->data();
+          ++out;
+        } else {
+          const auto* innerNode = static_cast<const InnerNode*>(node);
+          stack.push_back(innerNode->right());
+          stack.push_back(innerNode->left());
+        }
+      }
     }
   }
 
+public:
+
   /**
    * Prints a textual representation of this tree to the given output stream.
    *
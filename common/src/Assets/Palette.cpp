@@ -26,9 +26,12 @@
 #include "IO/FileSystem.h"
 #include "IO/ImageLoader.h"
 #include "IO/Reader.h"
+#include "Sse2.h"
 
 #include <kdl/string_format.h>
 
+#include <algorithm>
+#include <cstdint>
 #include <cstring>
 #include <string>
 
@@ -125,6 +128,82 @@ Palette Palette::fromRaw(IO::Reader& reader) {
   return Palette(std::move(data));
 }
 
+namespace {
+struct ExpandedPixels {
+  /**
+   * The sums of the red, green and blue channels of all pixels.
+   */
+  uint64_t colorSum[3];
+  /**
+   * The bitwise AND of the alpha channels of all pixels.
+   */
+  unsigned char andAlpha;
+};
+
+/**
+ * Writes the RGBA values of the given palette indices to `rgbaData` and accumulates the channels
+ * of the written pixels in the same pass.
+ */
+ExpandedPixels expandIndices(
+  const unsigned char* indices, const size_t pixelCount, const unsigned char* paletteData,
+  unsigned char* rgbaData) {
+  auto result = ExpandedPixels{{0, 0, 0}, 0xff};
+  size_t i = 0;
+
+#ifdef TB_SSE2
+  const auto lookup = [&](const unsigned char index) {
+    int pixel;
+    std::memcpy(&pixel, &paletteData[index * 4], 4);
+    return pixel;
+  };
+
+  // the channel sums of a block fit into 32 bit lanes since every iteration adds at most 4 * 255
+  constexpr size_t BlockSize = size_t(1) << 16;
+  const auto zero = _mm_setzero_si128();
+  auto andPixels = _mm_set1_epi32(-1);
+  while (pixelCount - i >= 4) {
+    const auto blockEnd = i + std::min(BlockSize, (pixelCount - i) & ~size_t(3));
+    auto sums = _mm_setzero_si128();
+    for (; i < blockEnd; i += 4) {
+      const auto pixels = _mm_set_epi32(
+        lookup(indices[i + 3]), lookup(indices[i + 2]), lookup(indices[i + 1]),
+        lookup(indices[i]));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(rgbaData + i * 4), pixels);
+      andPixels = _mm_and_si128(andPixels, pixels);
+
+      // add pixels 0 and 2 and pixels 1 and 3 as 16 bit lanes, then widen to 32 bit lanes
+      const auto pairs =
+        _mm_add_epi16(_mm_unpacklo_epi8(pixels, zero), _mm_unpackhi_epi8(pixels, zero));
+      sums = _mm_add_epi32(
+        sums, _mm_add_epi32(_mm_unpacklo_epi16(pairs, zero), _mm_unpackhi_epi16(pairs, zero)));
+    }
+
+    uint32_t channelSums[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(channelSums), sums);
+    result.colorSum[0] += channelSums[0];
+    result.colorSum[1] += channelSums[1];
+    result.colorSum[2] += channelSums[2];
+  }
+
+  unsigned char andBytes[16];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(andBytes), andPixels);
+  result.andAlpha =
+    static_cast<unsigned char>(andBytes[3] & andBytes[7] & andBytes[11] & andBytes[15]);
+#endif
+
+  for (; i < pixelCount; ++i) {
+    const auto* pixel = &paletteData[indices[i] * 4];
+    std::memcpy(rgbaData + i * 4, pixel, 4);
+    result.colorSum[0] += pixel[0];
+    result.colorSum[1] += pixel[1];
+    result.colorSum[2] += pixel[2];
+    result.andAlpha &= pixel[3];
+  }
+
+  return result;
+}
+} // namespace
+
 bool Palette::initialized() const {
   return m_data.get() != nullptr;
 }
@@ -144,38 +223,15 @@ bool Palette::indexedToRgba(
   reader.seekForward(
     pixelCount); // throws ReaderException if there aren't pixelCount bytes available
 
-  // Write rgba pixels
-  unsigned char* const rgbaData = rgbaImage.data();
-  for (size_t i = 0; i < pixelCount; ++i) {
-    const int index = static_cast<int>(indexedImage[i]);
-
-    std::memcpy(rgbaData + (i * 4), &paletteData[index * 4], 4);
-  }
-
-  // Check average color
-  uint32_t colorSum[3] = {0, 0, 0};
-  for (size_t i = 0; i < pixelCount; ++i) {
-    colorSum[0] += static_cast<uint32_t>(rgbaData[(i * 4) + 0]);
-    colorSum[1] += static_cast<uint32_t>(rgbaData[(i * 4) + 1]);
-    colorSum[2] += static_cast<uint32_t>(rgbaData[(i * 4) + 2]);
-  }
+  const auto [colorSum, andAlpha] =
+    expandIndices(indexedImage, pixelCount, paletteData, rgbaImage.data());
   averageColor = Color(
     static_cast<float>(colorSum[0]) / (255.0f * static_cast<float>(pixelCount)),
     static_cast<float>(colorSum[1]) / (255.0f * static_cast<float>(pixelCount)),
     static_cast<float>(colorSum[2]) / (255.0f * static_cast<float>(pixelCount)), 1.0f);
 
   // Check for transparency
-  bool hasTransparency = false;
-  if (transparency == PaletteTransparency::Index255Transparent) {
-    // Take the bitwise AND of the alpha channel of all pixels
-    unsigned char andAlpha = 0xff;
-    for (size_t i = 0; i < pixelCount; ++i) {
-      andAlpha &= rgbaData[(i * 4) + 3];
-    }
-    hasTransparency = (andAlpha != 0xff);
-  }
-
-  return hasTransparency;
+  return transparency == PaletteTransparency::Index255Transparent && andAlpha != 0xff;
 }
 } // namespace Assets
 } // namespace TrenchBroom
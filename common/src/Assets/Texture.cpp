@@ -23,8 +23,12 @@
 #include "Macros.h"
 #include "Renderer/GL.h"
 
+#include <kdl/thread_pool.h>
+
 #include <algorithm> // for std::max
 #include <cassert>
+#include <exception>
+#include <memory>
 #include <ostream>
 
 namespace TrenchBroom {
@@ -57,6 +61,10 @@ Texture::Texture(
   , m_culling(TextureCulling::CullDefault)
   , m_blendFunc{TextureBlendFunc::Enable::UseDefault, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA}
   , m_textureId{0}
+  , m_prefetching{false}
+  , m_uploadPending{false}
+  , m_minFilter{0}
+  , m_magFilter{0}
   , m_gameData{std::move(gameData)} {
   assert(m_width > 0);
   assert(m_height > 0);
@@ -79,6 +87,10 @@ Texture::Texture(
   , m_blendFunc{TextureBlendFunc::Enable::UseDefault, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA}
   , m_textureId(0)
   , m_buffers{std::move(buffers)}
+  , m_prefetching{false}
+  , m_uploadPending{false}
+  , m_minFilter{0}
+  , m_magFilter{0}
   , m_gameData{std::move(gameData)} {
   assert(m_width > 0);
   assert(m_height > 0);
@@ -106,6 +118,10 @@ Texture::Texture(
   , m_culling(TextureCulling::CullDefault)
   , m_blendFunc{TextureBlendFunc::Enable::UseDefault, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA}
   , m_textureId{0}
+  , m_prefetching{false}
+  , m_uploadPending{false}
+  , m_minFilter{0}
+  , m_magFilter{0}
   , m_gameData{std::move(gameData)} {}
 
 Texture::~Texture() = default;
@@ -126,6 +142,13 @@ Texture::Texture(Texture&& other)
   , m_blendFunc{std::move(other.m_blendFunc)}
   , m_textureId{std::move(other.m_textureId)}
   , m_buffers{std::move(other.m_buffers)}
+  , m_bufferLoader{std::move(other.m_bufferLoader)}
+  , m_buffersReloaded{std::move(other.m_buffersReloaded)}
+  , m_prefetchedBuffers{std::move(other.m_prefetchedBuffers)}
+  , m_prefetching{static_cast<bool>(other.m_prefetching)}
+  , m_uploadPending{std::move(other.m_uploadPending)}
+  , m_minFilter{std::move(other.m_minFilter)}
+  , m_magFilter{std::move(other.m_magFilter)}
   , m_gameData{std::move(other.m_gameData)} {}
 
 Texture& Texture::operator=(Texture&& other) {
@@ -144,6 +167,13 @@ Texture& Texture::operator=(Texture&& other) {
   m_blendFunc = std::move(other.m_blendFunc);
   m_textureId = std::move(other.m_textureId);
   m_buffers = std::move(other.m_buffers);
+  m_bufferLoader = std::move(other.m_bufferLoader);
+  m_buffersReloaded = std::move(other.m_buffersReloaded);
+  m_prefetchedBuffers = std::move(other.m_prefetchedBuffers);
+  m_prefetching = static_cast<bool>(other.m_prefetching);
+  m_uploadPending = std::move(other.m_uploadPending);
+  m_minFilter = std::move(other.m_minFilter);
+  m_magFilter = std::move(other.m_magFilter);
   m_gameData = std::move(other.m_gameData);
   return *this;
 }
@@ -231,7 +261,9 @@ size_t Texture::usageCount() const {
 }
 
 void Texture::incUsageCount() {
-  ++m_usageCount;
+  if (m_usageCount++ == 0u) {
+    prefetchBuffers();
+  }
 }
 
 void Texture::decUsageCount() {
@@ -248,61 +280,64 @@ void Texture::setOverridden(const bool overridden) {
   m_overridden = overridden;
 }
 
-bool Texture::isPrepared() const {
-  return m_textureId != 0;
+void Texture::setBufferLoader(TextureBufferLoader bufferLoader) {
+  m_bufferLoader = std::move(bufferLoader);
 }
 
-void Texture::prepare(const GLuint textureId, const int minFilter, const int magFilter) {
-  assert(textureId > 0);
-  assert(m_textureId == 0);
+const TextureBufferLoader& Texture::bufferLoader() const {
+  return m_bufferLoader;
+}
 
-  if (!m_buffers.empty()) {
-    glAssert(glPixelStorei(GL_UNPACK_SWAP_BYTES, false));
-    glAssert(glPixelStorei(GL_UNPACK_LSB_FIRST, false));
-    glAssert(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
-    glAssert(glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0));
-    glAssert(glPixelStorei(GL_UNPACK_SKIP_ROWS, 0));
-    glAssert(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
-
-    glAssert(glBindTexture(GL_TEXTURE_2D, textureId));
-    glAssert(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter));
-    glAssert(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter));
-    glAssert(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT));
-    glAssert(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT));
+void Texture::setBuffersReloaded(std::function<void()> buffersReloaded) {
+  m_buffersReloaded = std::move(buffersReloaded);
+}
 
-    if (m_type == TextureType::Masked) {
-      // masked textures don't work well with automatic mipmaps, so we force GL_NEAREST filtering
-      // and don't generate any
-      glAssert(glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_FALSE));
-      glAssert(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
-      glAssert(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
-    } else if (m_buffers.size() == 1) {
-      // generate mipmaps if we don't have any
-      glAssert(glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE));
-    } else {
-      glAssert(glTexParameteri(
-        GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(m_buffers.size() - 1)));
-    }
+bool Texture::hasBuffers() const {
+  return !m_buffers.empty();
+}
 
-    // Upload only the first mipmap for masked textures.
-    const auto mipmapsToUpload = (m_type == TextureType::Masked) ? 1u : m_buffers.size();
+size_t Texture::bufferSize() const {
+  auto result = size_t(0);
+  for (const auto& buffer : m_buffers) {
+    result += buffer.size();
+  }
+  return result;
+}
 
-    for (size_t j = 0; j < mipmapsToUpload; ++j) {
-      const auto mipSize = sizeAtMipLevel(m_width, m_height, j);
+void Texture::discardBuffers() {
+  if (m_bufferLoader) {
+    m_buffers.clear();
+  }
+}
 
-      const GLvoid* data = reinterpret_cast<const GLvoid*>(m_buffers[j].data());
-      glAssert(glTexImage2D(
-        GL_TEXTURE_2D, static_cast<GLint>(j), GL_RGBA, static_cast<GLsizei>(mipSize.x()),
-        static_cast<GLsizei>(mipSize.y()), 0, m_format, GL_UNSIGNED_BYTE, data));
-    }
+Texture::BufferList Texture::releaseBuffers() {
+  return std::move(m_buffers);
+}
 
-    m_buffers.clear();
+bool Texture::isPrepared() const {
+  return m_textureId != 0;
+}
+
+void Texture::prepare(const GLuint textureId, const int minFilter, const int magFilter) {
+  assert(textureId > 0);
+  assert(m_textureId == 0);
+
+  if (m_bufferLoader) {
+    m_textureId = textureId;
+    m_minFilter = minFilter;
+    m_magFilter = magFilter;
+    m_uploadPending = true;
+  } else if (!m_buffers.empty()) {
     m_textureId = textureId;
+    upload(minFilter, magFilter);
   }
 }
 
 void Texture::setMode(const int minFilter, const int magFilter) {
-  if (isPrepared()) {
+  if (m_uploadPending) {
+    m_minFilter = minFilter;
+    m_magFilter = magFilter;
+  } else if (isPrepared()) {
     activate();
     if (m_type == TextureType::Masked) {
       // Force GL_NEAREST filtering for masked textures.
@@ -318,6 +353,10 @@ void Texture::setMode(const int minFilter, const int magFilter) {
 
 void Texture::activate() const {
   if (isPrepared()) {
+    if (m_uploadPending) {
+      uploadPending();
+    }
+
     glAssert(glBindTexture(GL_TEXTURE_2D, m_textureId));
 
     switch (m_culling) {
@@ -383,5 +422,87 @@ GLenum Texture::format() const {
 TextureType Texture::type() const {
   return m_type;
 }
+
+void Texture::upload(const int minFilter, const int magFilter) const {
+  glAssert(glPixelStorei(GL_UNPACK_SWAP_BYTES, false));
+  glAssert(glPixelStorei(GL_UNPACK_LSB_FIRST, false));
+  glAssert(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+  glAssert(glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0));
+  glAssert(glPixelStorei(GL_UNPACK_SKIP_ROWS, 0));
+  glAssert(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+
+  glAssert(glBindTexture(GL_TEXTURE_2D, m_textureId));
+  glAssert(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter));
+  glAssert(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter));
+  glAssert(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT));
+  glAssert(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT));
+
+  if (m_type == TextureType::Masked) {
+    // masked textures don't work well with automatic mipmaps, so we force GL_NEAREST filtering
+    // and don't generate any
+    glAssert(glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_FALSE));
+    glAssert(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+    glAssert(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+  } else if (m_buffers.size() == 1) {
+    // generate mipmaps if we don't have any
+    glAssert(glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE));
+  } else {
+    glAssert(glTexParameteri(
+      GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(m_buffers.size() - 1)));
+  }
+
+  // Upload only the first mipmap for masked textures.
+  const auto mipmapsToUpload = (m_type == TextureType::Masked) ? 1u : m_buffers.size();
+
+  for (size_t j = 0; j < mipmapsToUpload; ++j) {
+    const auto mipSize = sizeAtMipLevel(m_width, m_height, j);
+
+    const GLvoid* data = reinterpret_cast<const GLvoid*>(m_buffers[j].data());
+    glAssert(glTexImage2D(
+      GL_TEXTURE_2D, static_cast<GLint>(j), GL_RGBA, static_cast<GLsizei>(mipSize.x()),
+      static_cast<GLsizei>(mipSize.y()), 0, m_format, GL_UNSIGNED_BYTE, data));
+  }
+
+  m_buffers.clear();
+}
+
+void Texture::uploadPending() const {
+  m_uploadPending = false;
+  if (m_buffers.empty()) {
+    if (m_prefetchedBuffers.valid()) {
+      // the buffers were prefetched when the texture was first used, so they are usually decoded
+      // by now
+      m_buffers = m_prefetchedBuffers.get();
+      m_prefetching = false;
+    } else {
+      m_buffers = m_bufferLoader();
+    }
+    if (m_buffersReloaded) {
+      m_buffersReloaded();
+    }
+  }
+  if (!m_buffers.empty()) {
+    upload(m_minFilter, m_magFilter);
+  }
+}
+
+/**
+ * The usage count may be increased on several threads at once, so only the first caller submits a
+ * task.
+ */
+void Texture::prefetchBuffers() {
+  const auto uploaded = isPrepared() && !m_uploadPending;
+  if (!m_bufferLoader || !m_buffers.empty() || uploaded || m_prefetching.exchange(true)) {
+    return;
+  }
+
+  auto promise = std::make_shared<std::promise<BufferList>>();
+  m_prefetchedBuffers = promise->get_future();
+  kdl::thread_pool::shared().submit([promise, bufferLoader = m_bufferLoader]() {
+    try {
+      promise->set_value(bufferLoader());
+    } catch (...) { promise->set_exception(std::current_exception()); }
+  });
+}
 } // namespace Assets
 } // namespace TrenchBroom
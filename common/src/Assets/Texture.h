@@ -27,6 +27,8 @@
 #include <vecmath/forward.h>
 
 #include <atomic>
+#include <functional>
+#include <future>
 #include <iosfwd>
 #include <set>
 #include <string>
@@ -89,6 +91,13 @@ std::ostream& operator<<(std::ostream& str, const Q2Data& data);
 
 using GameData = std::variant<std::monostate, Q2Data>;
 
+/**
+ * Decodes the mip buffers of a texture again after they have been discarded. Returns an empty
+ * vector if the buffers cannot be decoded. The loader is called on a worker thread when the buffers
+ * are prefetched.
+ */
+using TextureBufferLoader = std::function<TextureBufferList()>;
+
 class Texture {
 private:
   using Buffer = TextureBuffer;
@@ -122,6 +131,16 @@ private:
   mutable GLuint m_textureId;
   mutable BufferList m_buffers;
 
+  // if set, the buffers may be discarded before the texture is prepared, and the upload is
+  // deferred until the texture is activated for the first time
+  TextureBufferLoader m_bufferLoader;
+  std::function<void()> m_buffersReloaded;
+  mutable std::future<BufferList> m_prefetchedBuffers;
+  mutable std::atomic<bool> m_prefetching;
+  mutable bool m_uploadPending;
+  int m_minFilter;
+  int m_magFilter;
+
   GameData m_gameData;
 
 public:
@@ -182,12 +201,57 @@ public:
   const GameData& gameData() const;
 
   size_t usageCount() const;
+
+  /**
+   * If the buffers of this texture have been discarded before it was uploaded, the first use of the
+   * texture prefetches them on the shared thread pool so that they are not decoded when the texture
+   * is activated.
+   */
   void incUsageCount();
   void decUsageCount();
   bool overridden() const;
   void setOverridden(bool overridden);
 
+  /**
+   * Allows this texture to discard its buffers and to decode them again using the given loader
+   * when they are needed.
+   */
+  void setBufferLoader(TextureBufferLoader bufferLoader);
+  const TextureBufferLoader& bufferLoader() const;
+
+  /**
+   * Sets a function that is called on the rendering thread once the buffers of this texture have
+   * been decoded again, e.g. to forward the messages that were logged while decoding them.
+   */
+  void setBuffersReloaded(std::function<void()> buffersReloaded);
+
+  /**
+   * Indicates whether this texture holds decoded buffers that have not been uploaded yet.
+   */
+  bool hasBuffers() const;
+
+  /**
+   * Returns the number of bytes of the buffers held by this texture.
+   */
+  size_t bufferSize() const;
+
+  /**
+   * Discards the buffers of this texture if it has a buffer loader to decode them again when the
+   * texture is uploaded.
+   */
+  void discardBuffers();
+
+  /**
+   * Moves the buffers out of this texture.
+   */
+  BufferList releaseBuffers();
+
   bool isPrepared() const;
+
+  /**
+   * Assigns the given texture ID to this texture and uploads its buffers. If this texture has a
+   * buffer loader, the upload is deferred until the texture is activated for the first time.
+   */
   void prepare(GLuint textureId, int minFilter, int magFilter);
   void setMode(int minFilter, int magFilter);
 
@@ -205,6 +269,11 @@ public: // exposed for tests only
    */
   GLenum format() const;
   TextureType type() const;
+
+private:
+  void upload(int minFilter, int magFilter) const;
+  void uploadPending() const;
+  void prefetchBuffers();
 };
 } // namespace Assets
 } // namespace TrenchBroom
@@ -20,15 +20,128 @@
 #include "TextureBuffer.h"
 
 #include "Ensure.h"
+#include "Sse2.h"
 
 #include <vecmath/vec.h>
 
 #include <FreeImage.h>
 
 #include <algorithm> // for std::max
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
 
 namespace TrenchBroom {
 namespace Assets {
+namespace {
+/**
+ * Mip levels are computed from linear color values with 14 bits per channel, so that the sum of the
+ * four values of a 2x2 block fits into 16 bits.
+ */
+constexpr size_t LinearMax = (1u << 14) - 1u;
+constexpr unsigned int AlphaShift = 6u;
+
+const std::array<std::uint16_t, 256>& srgbToLinearTable() {
+  static const auto table = []() {
+    auto result = std::array<std::uint16_t, 256>{};
+    for (size_t i = 0; i < result.size(); ++i) {
+      const auto c = static_cast<double>(i) / 255.0;
+      const auto linear = c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+      result[i] = static_cast<std::uint16_t>(std::lround(linear * double(LinearMax)));
+    }
+    return result;
+  }();
+  return table;
+}
+
+const std::array<unsigned char, LinearMax + 1u>& linearToSrgbTable() {
+  static const auto table = []() {
+    auto result = std::array<unsigned char, LinearMax + 1u>{};
+    for (size_t i = 0; i < result.size(); ++i) {
+      const auto linear = static_cast<double>(i) / double(LinearMax);
+      const auto c =
+        linear <= 0.0031308 ? linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+      result[i] = static_cast<unsigned char>(std::lround(c * 255.0));
+    }
+    return result;
+  }();
+  return table;
+}
+
+/**
+ * Converts the given RGBA or BGRA pixels to linear values. The alpha channel is not gamma encoded,
+ * so it is only scaled to the range of the color values.
+ */
+void toLinear(const unsigned char* pixels, const size_t pixelCount, std::uint16_t* linear) {
+  const auto& table = srgbToLinearTable();
+  for (size_t i = 0; i < pixelCount * 4u; i += 4u) {
+    linear[i + 0] = table[pixels[i + 0]];
+    linear[i + 1] = table[pixels[i + 1]];
+    linear[i + 2] = table[pixels[i + 2]];
+    linear[i + 3] = static_cast<std::uint16_t>(pixels[i + 3] << AlphaShift);
+  }
+}
+
+void fromLinear(const std::uint16_t* linear, const size_t pixelCount, unsigned char* pixels) {
+  const auto& table = linearToSrgbTable();
+  for (size_t i = 0; i < pixelCount * 4u; i += 4u) {
+    pixels[i + 0] = table[linear[i + 0]];
+    pixels[i + 1] = table[linear[i + 1]];
+    pixels[i + 2] = table[linear[i + 2]];
+    pixels[i + 3] = static_cast<unsigned char>(
+      std::min((linear[i + 3] + (1u << (AlphaShift - 1u))) >> AlphaShift, 255u));
+  }
+}
+
+/**
+ * Computes the next mip level from the given level by averaging blocks of 2x2 pixels. If the source
+ * level has an odd width or height, its last column or row is ignored, unless the source level is
+ * only one pixel wide or high.
+ */
+void downsample(
+  const std::uint16_t* src, const size_t srcWidth, const size_t srcHeight, std::uint16_t* dst,
+  const size_t dstWidth, const size_t dstHeight) {
+  for (size_t y = 0; y < dstHeight; ++y) {
+    const auto* row0 = src + std::min(2u * y, srcHeight - 1u) * srcWidth * 4u;
+    const auto* row1 = src + std::min(2u * y + 1u, srcHeight - 1u) * srcWidth * 4u;
+    auto* out = dst + y * dstWidth * 4u;
+
+    size_t x = 0;
+#ifdef TB_SSE2
+    if (srcWidth >= 2u) {
+      // every register holds two pixels, so four source pixels of each row yield two pixels
+      const auto rounding = _mm_set1_epi16(2);
+      for (; x + 2u <= dstWidth; x += 2u) {
+        const auto a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8u));
+        const auto a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8u + 8u));
+        const auto b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8u));
+        const auto b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8u + 8u));
+
+        const auto sum0 = _mm_add_epi16(a0, b0);
+        const auto sum1 = _mm_add_epi16(a1, b1);
+        const auto sum = _mm_add_epi16(
+          _mm_unpacklo_epi64(sum0, sum1), _mm_unpackhi_epi64(sum0, sum1));
+        _mm_storeu_si128(
+          reinterpret_cast<__m128i*>(out + x * 4u),
+          _mm_srli_epi16(_mm_add_epi16(sum, rounding), 2));
+      }
+    }
+#endif
+
+    for (; x < dstWidth; ++x) {
+      const auto x0 = std::min(2u * x, srcWidth - 1u) * 4u;
+      const auto x1 = std::min(2u * x + 1u, srcWidth - 1u) * 4u;
+      for (size_t c = 0; c < 4u; ++c) {
+        const auto sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+        out[x * 4u + c] = static_cast<std::uint16_t>((sum + 2u) >> 2u);
+      }
+    }
+  }
+}
+} // namespace
+
 TextureBuffer::TextureBuffer()
   : m_buffer()
   , m_size(0) {}
@@ -87,6 +200,39 @@ void setMipBufferSize(
   }
 }
 
+size_t mipLevelCount(const size_t width, const size_t height) {
+  auto result = size_t(1);
+  for (auto size = std::max(width, height); size > 1u; size >>= 1u) {
+    ++result;
+  }
+  return result;
+}
+
+void generateMipmaps(
+  TextureBufferList& buffers, const size_t mipLevels, const size_t width, const size_t height,
+  const GLenum format) {
+  ensure(bytesPerPixelForFormat(format) == 4u, "expected RGBA or BGRA");
+  ensure(!buffers.empty(), "expected a base level");
+
+  auto srcSize = vm::vec2s{width, height};
+  auto src = std::vector<std::uint16_t>(srcSize.x() * srcSize.y() * 4u);
+  toLinear(buffers[0].data(), srcSize.x() * srcSize.y(), src.data());
+
+  auto dst = std::vector<std::uint16_t>{};
+  buffers.resize(mipLevels);
+  for (size_t level = 1u; level < mipLevels; ++level) {
+    const auto dstSize = sizeAtMipLevel(width, height, level);
+    dst.resize(dstSize.x() * dstSize.y() * 4u);
+    downsample(src.data(), srcSize.x(), srcSize.y(), dst.data(), dstSize.x(), dstSize.y());
+
+    buffers[level] = TextureBuffer(dst.size());
+    fromLinear(dst.data(), dstSize.x() * dstSize.y(), buffers[level].data());
+
+    std::swap(src, dst);
+    srcSize = dstSize;
+  }
+}
+
 void resizeMips(TextureBufferList& buffers, const vm::vec2s& oldSize, const vm::vec2s& newSize) {
   if (oldSize == newSize)
     return;
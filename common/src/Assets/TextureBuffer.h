@@ -49,6 +49,20 @@ size_t bytesPerPixelForFormat(GLenum format);
 void setMipBufferSize(
   TextureBufferList& buffers, size_t mipLevels, size_t width, size_t height, GLenum format);
 
+/**
+ * Returns the number of mip levels down to a size of 1x1 for a texture of the given size.
+ */
+size_t mipLevelCount(size_t width, size_t height);
+
+/**
+ * Computes the mip levels 1 to `mipLevels - 1` of a texture in RGBA or BGRA format from its first
+ * buffer, resizing the given buffer list as necessary. Every pixel of a mip level is the average of
+ * 2x2 pixels of the previous level. The color channels are averaged in linear space, assuming that
+ * they are sRGB encoded, and the alpha channel is averaged as is.
+ */
+void generateMipmaps(
+  TextureBufferList& buffers, size_t mipLevels, size_t width, size_t height, GLenum format);
+
 void resizeMips(TextureBufferList& buffers, const vm::vec2s& oldSize, const vm::vec2s& newSize);
 } // namespace Assets
 } // namespace TrenchBroom
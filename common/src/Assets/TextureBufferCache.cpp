@@ -0,0 +1,84 @@
+/*
+ Copyright (C) 2023 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TextureBufferCache.h"
+
+#include "Assets/Texture.h"
+#include "Ensure.h"
+
+namespace TrenchBroom {
+namespace Assets {
+TextureBufferCache::TextureBufferCache(const size_t capacity)
+  : m_capacity{capacity}
+  , m_size{0} {}
+
+size_t TextureBufferCache::capacity() const {
+  return m_capacity;
+}
+
+void TextureBufferCache::setCapacity(const size_t capacity) {
+  m_capacity = capacity;
+}
+
+size_t TextureBufferCache::size() const {
+  return m_size;
+}
+
+void TextureBufferCache::add(Texture& texture) {
+  ensure(texture.bufferLoader() != nullptr, "texture has a buffer loader");
+
+  const auto size = texture.bufferSize();
+  m_entries.push_back(Entry{&texture, size});
+  m_size += size;
+}
+
+void TextureBufferCache::clear() {
+  m_entries.clear();
+  m_size = 0;
+}
+
+void TextureBufferCache::evict() {
+  if (m_size <= m_capacity) {
+    return;
+  }
+
+  const auto removeIf = [&](const auto& predicate) {
+    for (auto it = m_entries.begin(); it != m_entries.end() && m_size > m_capacity;) {
+      if (predicate(*it->texture)) {
+        it->texture->discardBuffers();
+        m_size -= it->size;
+        it = m_entries.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  };
+
+  removeIf([](const Texture& texture) {
+    return !texture.hasBuffers();
+  });
+  removeIf([](const Texture& texture) {
+    return texture.usageCount() == 0u;
+  });
+  removeIf([](const Texture&) {
+    return true;
+  });
+}
+} // namespace Assets
+} // namespace TrenchBroom
@@ -0,0 +1,72 @@
+/*
+ Copyright (C) 2023 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+
+namespace TrenchBroom {
+namespace Assets {
+class Texture;
+
+/**
+ * Bounds the memory used by decoded texture buffers that have not been uploaded yet.
+ *
+ * When the cache is evicted, the buffers of the textures that were added first are discarded until
+ * the cache fits its capacity, starting with the textures that are not used by any face. The
+ * discarded buffers of an unused texture are prefetched on a worker thread once it is used, and
+ * those of a used texture are decoded again when it is uploaded. Textures that have been uploaded
+ * in the meantime no longer hold any buffers and are removed from the cache first.
+ *
+ * Only textures that have a buffer loader may be added. The cache does not own the textures, so
+ * it must be cleared before any of them are destroyed.
+ */
+class TextureBufferCache {
+private:
+  struct Entry {
+    Texture* texture;
+    size_t size;
+  };
+
+  size_t m_capacity;
+  size_t m_size;
+  std::list<Entry> m_entries;
+
+public:
+  explicit TextureBufferCache(size_t capacity);
+
+  size_t capacity() const;
+  void setCapacity(size_t capacity);
+
+  /**
+   * Returns the number of bytes of the buffers of the cached textures.
+   */
+  size_t size() const;
+
+  void add(Texture& texture);
+  void clear();
+
+  /**
+   * Discards the buffers of cached textures until the cache fits its capacity.
+   */
+  void evict();
+};
+} // namespace Assets
+} // namespace TrenchBroom
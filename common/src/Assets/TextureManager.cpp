@@ -22,16 +22,22 @@
 #include "Assets/Texture.h"
 #include "Assets/TextureCollection.h"
 #include "Exceptions.h"
+#include "IO/Path.h"
 #include "IO/TextureLoader.h"
 #include "Logger.h"
 
 #include <kdl/map_utils.h>
 #include <kdl/string_format.h>
+#include <kdl/thread_pool.h>
 #include <kdl/vector_utils.h>
 
 #include <algorithm>
 #include <chrono>
+#include <condition_variable>
+#include <exception>
 #include <iterator>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -56,13 +62,77 @@ public:
   }
 };
 
+/**
+ * The state shared between a texture manager and the tasks that read its collections in the
+ * background.
+ */
+struct TextureManager::BackgroundLoad {
+  struct Result {
+    size_t index;
+    IO::Path path;
+    bool reportError;
+    std::optional<TextureCollection> collection;
+    std::string error;
+    std::chrono::milliseconds duration;
+  };
+
+  std::shared_ptr<IO::TextureLoader> loader;
+  bool lazy = false;
+
+  std::mutex mutex;
+  std::condition_variable done;
+  size_t pending = 0;
+  size_t running = 0;
+  bool cancelled = false;
+  std::vector<Result> results;
+
+  void read(size_t index, const IO::Path& path, bool reportError);
+};
+
+void TextureManager::BackgroundLoad::read(
+  const size_t index, const IO::Path& path, const bool reportError) {
+  auto lock = std::unique_lock{mutex};
+  if (cancelled) {
+    return;
+  }
+  ++running;
+  auto textureLoader = loader;
+  lock.unlock();
+
+  auto result = Result{index, path, reportError, std::nullopt, "", {}};
+  try {
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    result.collection = textureLoader->readTextureCollection(path, lazy);
+    const auto endTime = std::chrono::high_resolution_clock::now();
+    result.duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
+  } catch (const std::exception& e) {
+    result.error = e.what();
+  }
+  textureLoader.reset();
+
+  lock.lock();
+  results.push_back(std::move(result));
+  --pending;
+  --running;
+  done.notify_all();
+}
+
 TextureManager::TextureManager(int magFilter, int minFilter, Logger& logger)
   : m_logger(logger)
   , m_minFilter(minFilter)
   , m_magFilter(magFilter)
-  , m_resetTextureMode(false) {}
+  , m_resetTextureMode(false)
+  , m_lazyLoading(false)
+  , m_bufferCache(0) {}
 
-TextureManager::~TextureManager() = default;
+TextureManager::~TextureManager() {
+  cancelLoadingInBackground();
+}
+
+void TextureManager::setLazyLoading(const bool lazyLoading, const size_t bufferCacheCapacity) {
+  m_lazyLoading = lazyLoading;
+  m_bufferCache.setCapacity(bufferCacheCapacity);
+}
 
 void TextureManager::setTextureCollections(
   const std::vector<IO::Path>& paths, IO::TextureLoader& loader) {
@@ -77,7 +147,7 @@ void TextureManager::setTextureCollections(
     if (it == std::end(collections) || !it->loaded()) {
       try {
         const auto startTime = std::chrono::high_resolution_clock::now();
-        auto collection = loader.loadTextureCollection(path);
+        auto collection = loader.loadTextureCollection(path, m_lazyLoading);
         const auto endTime = std::chrono::high_resolution_clock::now();
 
         m_logger.info()
@@ -110,18 +180,142 @@ void TextureManager::setTextureCollections(std::vector<TextureCollection> collec
   updateTextures();
 }
 
+void TextureManager::loadTextureCollectionsInBackground(
+  const std::vector<IO::Path>& paths, std::shared_ptr<IO::TextureLoader> loader) {
+  auto collections = std::move(m_collections);
+  clear();
+
+  auto load = std::make_shared<BackgroundLoad>();
+  load->loader = std::move(loader);
+  load->lazy = m_lazyLoading;
+
+  for (const auto& path : paths) {
+    const auto it =
+      std::find_if(std::begin(collections), std::end(collections), [&](const auto& c) {
+        return c.path() == path;
+      });
+    if (it == std::end(collections) || !it->loaded()) {
+      const auto index = m_collections.size();
+      const auto reportError = it == std::end(collections);
+      addTextureCollection(Assets::TextureCollection(path));
+
+      ++load->pending;
+      kdl::thread_pool::shared().submit([load, index, path, reportError]() {
+        load->read(index, path, reportError);
+      });
+    } else {
+      addTextureCollection(std::move(*it));
+    }
+    if (it != std::end(collections)) {
+      collections.erase(it);
+    }
+  }
+
+  m_backgroundLoad = std::move(load);
+  updateTextures();
+  m_toRemove = kdl::vec_concat(std::move(m_toRemove), std::move(collections));
+}
+
+bool TextureManager::publishLoadedCollections() {
+  if (!m_backgroundLoad) {
+    return false;
+  }
+
+  auto& load = *m_backgroundLoad;
+  auto results = std::vector<BackgroundLoad::Result>{};
+  auto finished = false;
+  {
+    auto lock = std::lock_guard{load.mutex};
+    results = std::move(load.results);
+    load.results.clear();
+    finished = load.pending == 0u;
+  }
+  load.loader->flushLog();
+
+  for (auto& result : results) {
+    if (result.collection) {
+      m_logger.info() << "Loaded texture collection '" << result.path << "' in "
+                      << result.duration.count() << "ms";
+      m_collections[result.index] = std::move(*result.collection);
+      m_toPrepare.push_back(result.index);
+      addToBufferCache(m_collections[result.index]);
+    } else if (result.reportError) {
+      m_logger.error() << "Could not load texture collection '" << result.path
+                       << "': " << result.error;
+    }
+  }
+
+  if (finished) {
+    m_backgroundLoad.reset();
+  }
+  if (results.empty()) {
+    return false;
+  }
+
+  updateTextures();
+  return true;
+}
+
+bool TextureManager::loadingInBackground() const {
+  return m_backgroundLoad != nullptr;
+}
+
+void TextureManager::finishLoadingInBackground() {
+  if (m_backgroundLoad) {
+    auto& load = *m_backgroundLoad;
+    {
+      auto lock = std::unique_lock{load.mutex};
+      load.done.wait(lock, [&]() {
+        return load.pending == 0u;
+      });
+    }
+    publishLoadedCollections();
+  }
+}
+
+/**
+ * Discards the collections that were loaded in the background but not published yet. Waits for the
+ * collections that are currently being read, and the tasks that have not started yet do nothing.
+ */
+void TextureManager::cancelLoadingInBackground() {
+  if (m_backgroundLoad) {
+    auto& load = *m_backgroundLoad;
+    {
+      auto lock = std::unique_lock{load.mutex};
+      load.cancelled = true;
+      load.done.wait(lock, [&]() {
+        return load.running == 0u;
+      });
+      load.results.clear();
+      load.loader.reset();
+    }
+    m_backgroundLoad.reset();
+  }
+}
+
 void TextureManager::addTextureCollection(Assets::TextureCollection collection) {
   const auto index = m_collections.size();
   m_collections.push_back(std::move(collection));
 
   if (m_collections[index].loaded() && !m_collections[index].prepared()) {
     m_toPrepare.push_back(index);
+    addToBufferCache(m_collections[index]);
   }
 
   m_logger.debug() << "Added texture collection " << m_collections[index].path();
 }
 
+void TextureManager::addToBufferCache(TextureCollection& collection) {
+  for (auto& texture : collection.textures()) {
+    if (texture.bufferLoader() && texture.hasBuffers()) {
+      m_bufferCache.add(texture);
+    }
+  }
+}
+
 void TextureManager::clear() {
+  cancelLoadingInBackground();
+  m_bufferCache.clear();
   m_collections.clear();
 
   m_toPrepare.clear();
@@ -138,6 +332,8 @@ void TextureManager::setTextureMode(const int minFilter, const int magFilter) {
 }
 
 void TextureManager::commitChanges() {
+  // faces have been assigned their textures by now, so the usage counts are up to date
+  m_bufferCache.evict();
   resetTextureMode();
   prepare();
   m_toRemove.clear();
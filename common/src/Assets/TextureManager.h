@@ -19,9 +19,11 @@
 
 #pragma once
 
+#include "Assets/TextureBufferCache.h"
 #include "Assets/TextureCollection.h"
 
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -55,15 +57,64 @@ private:
   int m_magFilter;
   bool m_resetTextureMode;
 
+  bool m_lazyLoading;
+  TextureBufferCache m_bufferCache;
+
+  struct BackgroundLoad;
+  std::shared_ptr<BackgroundLoad> m_backgroundLoad;
+
 public:
   TextureManager(int magFilter, int minFilter, Logger& logger);
   ~TextureManager();
 
+  /**
+   * If lazy loading is enabled, texture collections that are loaded afterwards keep at most the
+   * given number of bytes of decoded buffers in memory until their textures are uploaded. The
+   * remaining buffers are decoded again once their textures are used.
+   */
+  void setLazyLoading(bool lazyLoading, size_t bufferCacheCapacity);
+
   void setTextureCollections(const std::vector<IO::Path>& paths, IO::TextureLoader& loader);
   void setTextureCollections(std::vector<TextureCollection> collections);
 
+  /**
+   * Loads the texture collections with the given paths like setTextureCollections, but reads them
+   * on the shared thread pool, one task per collection, and returns immediately.
+   *
+   * Until a collection has been read, an unloaded placeholder collection with the same path takes
+   * its place, so faces that refer to its textures have no texture yet. The loaded collections are
+   * published by publishLoadedCollections, which must be called regularly by the owner of this
+   * manager.
+   */
+  void loadTextureCollectionsInBackground(
+    const std::vector<IO::Path>& paths, std::shared_ptr<IO::TextureLoader> loader);
+
+  /**
+   * Replaces the placeholders of the collections that were loaded in the background since the last
+   * call with the loaded collections and logs the messages of the loader. The textures of the
+   * published collections are prepared in commitChanges.
+   *
+   * Returns true if any collection was published. Once the last collection has been published,
+   * loadingInBackground returns false.
+   */
+  bool publishLoadedCollections();
+
+  /**
+   * Returns true if collections are being loaded in the background or have not been published yet.
+   */
+  bool loadingInBackground() const;
+
+  /**
+   * Blocks until all collections that are being loaded in the background have been loaded and
+   * publishes them. This must be called before the file system that the collections are read
+   * from is changed.
+   */
+  void finishLoadingInBackground();
+
 private:
   void addTextureCollection(Assets::TextureCollection collection);
+  void addToBufferCache(TextureCollection& collection);
+  void cancelLoadingInBackground();
 
 public:
   void clear();
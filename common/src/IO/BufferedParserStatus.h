@@ -0,0 +1,70 @@
+/*
+ Copyright (C) 2021 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "IO/ParserStatus.h"
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace TrenchBroom {
+namespace IO {
+/**
+ * Records the messages logged by a parser that runs on a worker thread. The messages are formatted
+ * like the target status would format them and can be forwarded to the target later, which must
+ * happen on the thread that owns the target.
+ */
+class BufferedParserStatus : public ParserStatus {
+public:
+  using Message = std::tuple<LogLevel, std::string>;
+
+private:
+  ParserStatus& m_target;
+  std::vector<Message> m_messages;
+  bool m_forwardProgress;
+
+public:
+  /**
+   * Creates a status that forwards to the given target. The given messages are recorded as if they
+   * had been logged to this status, which allows replaying messages that were recorded earlier.
+   *
+   * Progress is forwarded to the target immediately if `forwardProgress` is true, which is only
+   * allowed if this status is used on the thread that owns the target. Otherwise, it is dropped.
+   */
+  explicit BufferedParserStatus(
+    ParserStatus& target, std::vector<Message> messages = {}, bool forwardProgress = false);
+
+  /**
+   * Returns the messages that were recorded since the last flush.
+   */
+  const std::vector<Message>& messages() const;
+
+  /**
+   * Forwards all recorded messages to the target status in the order in which they were logged.
+   */
+  void flush();
+
+private:
+  void doProgress(double progress) override;
+  void doLog(LogLevel level, const std::string& str) override;
+};
+} // namespace IO
+} // namespace TrenchBroom
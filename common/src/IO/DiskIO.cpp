@@ -139,7 +139,7 @@ std::shared_ptr<File> openFile(const Path& path) {
     throw FileNotFoundException(fixedPath.asString());
   }
 
-  return std::make_shared<CFile>(fixedPath);
+  return std::make_shared<MappedFile>(fixedPath);
 }
 
 std::string readTextFile(const Path& path) {
@@ -20,7 +20,9 @@
 #include "File.h"
 
 #include "Exceptions.h"
-#include "IO/IOUtils.h"
+#include "IO/PathQt.h"
+
+#include <QFile>
 
 namespace TrenchBroom {
 namespace IO {
@@ -64,31 +66,53 @@ size_t NonOwningBufferFile::size() const {
   return static_cast<size_t>(m_end - m_begin);
 }
 
-CFile::CFile(const Path& path)
-  : File(path) {
-  m_file = openPathAsFILE(path, "rb");
-  if (m_file == nullptr) {
+MappedFile::MappedFile(const Path& path)
+  : File(path)
+  , m_file(std::make_unique<QFile>(pathAsQString(path)))
+  , m_begin(nullptr)
+  , m_end(nullptr) {
+  if (!m_file->open(QIODevice::ReadOnly)) {
     throw FileSystemException("Cannot open file " + path.asString());
   }
-  m_size = fileSize(m_file);
-}
 
-CFile::~CFile() {
-  if (m_file != nullptr) {
-    std::fclose(m_file);
+  const auto size = m_file->size();
+  if (size > 0) {
+    if (const auto* mapped = m_file->map(0, size)) {
+      m_begin = reinterpret_cast<const char*>(mapped);
+    } else {
+      // mapping can fail for special files or if the address space is exhausted
+      m_buffer = std::make_unique<char[]>(static_cast<size_t>(size));
+      if (m_file->read(m_buffer.get(), size) != size) {
+        throw FileSystemException("Cannot read file " + path.asString());
+      }
+      m_begin = m_buffer.get();
+    }
+    m_end = m_begin + size;
+  }
+
+  if (m_buffer || size <= 0) {
+    // nothing is mapped, so the file can be closed right away
+    m_file.reset();
   }
 }
 
-Reader CFile::reader() const {
-  return Reader::from(m_file);
+// destroying the QFile (if any) unmaps and closes the file
+MappedFile::~MappedFile() = default;
+
+Reader MappedFile::reader() const {
+  return Reader::from(m_begin, m_end);
 }
 
-size_t CFile::size() const {
-  return m_size;
+size_t MappedFile::size() const {
+  return static_cast<size_t>(m_end - m_begin);
+}
+
+const char* MappedFile::begin() const {
+  return m_begin;
 }
 
-std::FILE* CFile::file() const {
-  return m_file;
+const char* MappedFile::end() const {
+  return m_end;
 }
 
 FileView::FileView(
@@ -105,5 +129,9 @@ Reader FileView::reader() const {
 size_t FileView::size() const {
   return m_length;
 }
+
+size_t FileView::offset() const {
+  return m_offset;
+}
 } // namespace IO
 } // namespace TrenchBroom
@@ -22,9 +22,10 @@
 #include "IO/Path.h"
 #include "IO/Reader.h"
 
-#include <cstdio>
 #include <memory>
 
+class QFile;
+
 namespace TrenchBroom {
 namespace IO {
 /**
@@ -110,32 +111,47 @@ public:
 };
 
 /**
- * A file that is backed by a physical file on the disk. The file is opened in the constructor and
- * closed in the destructor.
+ * A file that is backed by a physical file on the disk which is mapped into memory. The file is
+ * opened and mapped in the constructor and unmapped and closed in the destructor.
+ *
+ * Readers created by this file read directly from the mapped memory, so reading or buffering the
+ * contents of this file (or a portion thereof) does not copy any data, and only the pages that are
+ * actually accessed are loaded into memory. If the file cannot be mapped, its contents are read into
+ * a memory buffer instead.
+ *
+ * A mapped file must not be truncated by another process while it is mapped, because accessing the
+ * truncated pages crashes this process.
  */
-class CFile : public File {
+class MappedFile : public File {
 private:
-  std::FILE* m_file;
-  size_t m_size;
+  std::unique_ptr<QFile> m_file;
+  std::unique_ptr<char[]> m_buffer;
+  const char* m_begin;
+  const char* m_end;
 
 public:
   /**
-   * Creates a new file with the given path and opens the file for reading.
+   * Creates a new file with the given path, opens the file for reading and maps it into memory.
    *
    * @param path the path of the file
    *
-   * @throw FileSystemException if the file cannot be opened
+   * @throw FileSystemException if the file cannot be opened or read
    */
-  explicit CFile(const Path& path);
-  ~CFile() override;
+  explicit MappedFile(const Path& path);
+  ~MappedFile() override;
 
   Reader reader() const override;
   size_t size() const override;
 
   /**
-   * Returns the underlying file.
+   * Returns the beginning of the memory region that holds the contents of this file.
    */
-  std::FILE* file() const;
+  const char* begin() const;
+
+  /**
+   * Returns the end of the memory region that holds the contents of this file.
+   */
+  const char* end() const;
 };
 
 /**
@@ -160,6 +176,11 @@ public:
 
   Reader reader() const override;
   size_t size() const override;
+
+  /**
+   * Returns the offset of this file in its host file.
+   */
+  size_t offset() const;
 };
 
 // TODO: get rid of this, it's evil
@@ -137,6 +137,12 @@ Assets::Texture FreeImageTextureReader::doReadTexture(std::shared_ptr<File> file
   const auto textureType = Assets::Texture::selectTextureType(masked);
   const Color averageColor = getAverageColor(buffers.at(0), format);
 
+  // masked textures are only uploaded with their first level, see Texture::upload
+  if (textureType == Assets::TextureType::Opaque) {
+    Assets::generateMipmaps(
+      buffers, Assets::mipLevelCount(imageWidth, imageHeight), imageWidth, imageHeight, format);
+  }
+
   return Assets::Texture(
     textureName(path), imageWidth, imageHeight, averageColor, std::move(buffers), format,
     textureType);
@@ -27,6 +27,9 @@
 #include <vecmath/forward.h>
 #include <vecmath/vec.h>
 
+#include <QSaveFile>
+
+#include <array>
 #include <iostream>
 #include <streambuf>
 #include <string>
@@ -68,6 +71,85 @@ std::ifstream openPathAsInputStream(const Path& path, const std::ios::openmode m
 #endif
 }
 
+namespace {
+/**
+ * A stream buffer that writes to a Qt IO device and supports seeking.
+ */
+class DeviceStreamBuf : public std::streambuf {
+private:
+  QIODevice& m_device;
+  std::array<char, 64u * 1024u> m_buffer;
+
+public:
+  explicit DeviceStreamBuf(QIODevice& device)
+    : m_device{device} {
+    setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+  }
+
+protected:
+  int_type overflow(const int_type c) override {
+    if (!writeBuffer()) {
+      return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+    }
+    return traits_type::not_eof(c);
+  }
+
+  int sync() override { return writeBuffer() ? 0 : -1; }
+
+  pos_type seekoff(
+    const off_type offset, const std::ios::seekdir dir, const std::ios::openmode which) override {
+    if ((which & std::ios::out) == 0 || !writeBuffer()) {
+      return pos_type{off_type{-1}};
+    }
+
+    const auto base = dir == std::ios::beg   ? qint64{0}
+                      : dir == std::ios::cur ? m_device.pos()
+                                             : m_device.size();
+    if (!m_device.seek(base + static_cast<qint64>(offset))) {
+      return pos_type{off_type{-1}};
+    }
+    return pos_type{static_cast<off_type>(m_device.pos())};
+  }
+
+  pos_type seekpos(const pos_type position, const std::ios::openmode which) override {
+    return seekoff(off_type{position}, std::ios::beg, which);
+  }
+
+private:
+  bool writeBuffer() {
+    const auto size = static_cast<qint64>(pptr() - pbase());
+    if (size > 0 && m_device.write(pbase(), size) != size) {
+      return false;
+    }
+    setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+    return true;
+  }
+};
+} // namespace
+
+bool writeFileAtomically(
+  const Path& path, const std::function<void(std::ostream&)>& writeContents) {
+  auto saveFile = QSaveFile{pathAsQString(path)};
+  if (!saveFile.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+
+  auto streamBuf = DeviceStreamBuf{saveFile};
+  auto stream = std::ostream{&streamBuf};
+  writeContents(stream);
+  stream.flush();
+
+  if (!stream) {
+    saveFile.cancelWriting();
+    return false;
+  }
+  return saveFile.commit();
+}
+
 size_t fileSize(std::FILE* file) {
   ensure(file != nullptr, "file is null");
   const auto pos = std::ftell(file);
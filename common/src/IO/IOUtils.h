@@ -23,6 +23,7 @@
 
 #include <cstdio> // for FILE
 #include <fstream>
+#include <functional>
 #include <iosfwd>
 #include <string>
 
@@ -34,6 +35,20 @@ FILE* openPathAsFILE(const Path& path, const std::string& mode);
 std::ofstream openPathAsOutputStream(const Path& path, std::ios::openmode mode = std::ios::out);
 std::ifstream openPathAsInputStream(const Path& path, std::ios::openmode mode = std::ios::in);
 
+/**
+ * Writes the binary file at the given path by passing an output stream to the given function.
+ *
+ * The contents are written to a temporary file in the same directory, which atomically replaces the
+ * file at the given path once the function has returned and all data was written. Therefore, other
+ * processes never see a partially written file, and a file which another process has mapped into
+ * memory is not truncated. The written stream supports seeking.
+ *
+ * Returns false if the file could not be written, in which case the file at the given path is left
+ * unchanged.
+ */
+bool writeFileAtomically(
+  const Path& path, const std::function<void(std::ostream&)>& writeContents);
+
 size_t fileSize(std::FILE* file);
 
 std::string readGameComment(std::istream& stream);
@@ -204,7 +204,7 @@ std::shared_ptr<File> ImageFileSystemBase::doOpenFile(const Path& path) const {
 
 ImageFileSystem::ImageFileSystem(std::shared_ptr<FileSystem> next, const Path& path)
   : ImageFileSystemBase(std::move(next), path)
-  , m_file(std::make_shared<CFile>(path)) {
+  , m_file(std::make_shared<MappedFile>(path)) {
   ensure(m_path.isAbsolute(), "path must be absolute");
 }
 } // namespace IO
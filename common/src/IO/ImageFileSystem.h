@@ -29,7 +29,7 @@
 
 namespace TrenchBroom {
 namespace IO {
-class CFile;
+class MappedFile;
 class File;
 
 class ImageFileSystemBase : public FileSystem {
@@ -128,7 +128,7 @@ private:
 
 class ImageFileSystem : public ImageFileSystemBase {
 protected:
-  std::shared_ptr<CFile> m_file;
+  std::shared_ptr<MappedFile> m_file;
 
 protected:
   ImageFileSystem(std::shared_ptr<FileSystem> next, const Path& path);
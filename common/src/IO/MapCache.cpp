@@ -0,0 +1,563 @@
+/*
+ Copyright (C) 2023 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MapCache.h"
+
+#include "Color.h"
+#include "Exceptions.h"
+#include "IO/DiskIO.h"
+#include "IO/File.h"
+#include "IO/IOUtils.h"
+#include "IO/PathQt.h"
+#include "IO/Reader.h"
+#include "Logger.h"
+#include "Model/Brush.h"
+#include "Model/BrushFace.h"
+#include "Model/BrushFaceAttributes.h"
+#include "Model/EntityProperties.h"
+#include "Model/MapFormat.h"
+#include "Model/ParallelTexCoordSystem.h"
+#include "Model/ParaxialTexCoordSystem.h"
+#include "Model/TexCoordSystem.h"
+
+#include <kdl/overload.h>
+
+#include <vecmath/vec.h>
+
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <variant>
+
+#include <QDateTime>
+#include <QFileInfo>
+
+namespace TrenchBroom {
+namespace IO {
+namespace {
+const char Magic[] = {'T', 'B', 'C', 'A', 'C', 'H', 'E', '\0'};
+const std::uint32_t Version = 1;
+
+enum class ObjectType : std::uint8_t
+{
+  Entity = 0,
+  Brush = 1,
+  Patch = 2,
+};
+
+std::uint64_t hashContents(const std::string_view contents) {
+  // FNV-1a, applied to 8 bytes at a time
+  const std::uint64_t prime = 0x100000001b3ull;
+  std::uint64_t hash = 0xcbf29ce484222325ull;
+
+  size_t i = 0u;
+  for (; i + sizeof(std::uint64_t) <= contents.size(); i += sizeof(std::uint64_t)) {
+    std::uint64_t word;
+    std::memcpy(&word, contents.data() + i, sizeof(word));
+    hash = (hash ^ word) * prime;
+  }
+  for (; i < contents.size(); ++i) {
+    hash = (hash ^ static_cast<unsigned char>(contents[i])) * prime;
+  }
+  return hash;
+}
+
+class CacheWriter {
+private:
+  std::ostream& m_stream;
+
+public:
+  explicit CacheWriter(std::ostream& stream)
+    : m_stream{stream} {}
+
+  template <typename T> void write(const T value) {
+    m_stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  void writeSize(const size_t value) { write(static_cast<std::uint64_t>(value)); }
+
+  void writeString(const std::string& str) {
+    writeSize(str.size());
+    m_stream.write(str.data(), static_cast<std::streamsize>(str.size()));
+  }
+
+  void writeVec(const vm::vec3& vec) {
+    write(vec.x());
+    write(vec.y());
+    write(vec.z());
+  }
+
+  template <typename T> void writeOptional(const std::optional<T>& value) {
+    write(static_cast<std::uint8_t>(value.has_value()));
+    if (value) {
+      write(*value);
+    }
+  }
+};
+
+class CacheReader {
+private:
+  Reader& m_reader;
+
+public:
+  explicit CacheReader(Reader& reader)
+    : m_reader{reader} {}
+
+  template <typename T> T read() { return m_reader.read<T, T>(); }
+
+  size_t readSize() { return static_cast<size_t>(read<std::uint64_t>()); }
+
+  /**
+   * Reads a count of elements which take up at least the given number of bytes each and checks
+   * that the remaining input is large enough to hold them, so that corrupt counts are detected
+   * before anything is allocated.
+   */
+  size_t readCount(const size_t minElementSize) {
+    const auto count = readSize();
+    if (count > m_reader.size() || !m_reader.canRead(count * minElementSize)) {
+      throw ReaderException{"Invalid element count"};
+    }
+    return count;
+  }
+
+  std::string readString() { return m_reader.readString(readCount(1u)); }
+
+  vm::vec3 readVec() {
+    const auto x = read<double>();
+    const auto y = read<double>();
+    const auto z = read<double>();
+    return vm::vec3{x, y, z};
+  }
+
+  template <typename T> std::optional<T> readOptional() {
+    if (read<std::uint8_t>() != 0u) {
+      return read<T>();
+    }
+    return std::nullopt;
+  }
+};
+
+void writeBrushFace(
+  CacheWriter& writer, const Model::BrushFace& face, const bool parallelTexCoordSystem) {
+  for (const auto& point : face.points()) {
+    writer.writeVec(point);
+  }
+  writer.writeSize(face.lineNumber());
+
+  const auto& attributes = face.attributes();
+  writer.writeString(attributes.textureName());
+  writer.write(attributes.xOffset());
+  writer.write(attributes.yOffset());
+  writer.write(attributes.xScale());
+  writer.write(attributes.yScale());
+  writer.write(attributes.rotation());
+  writer.writeOptional(attributes.surfaceContents());
+  writer.writeOptional(attributes.surfaceFlags());
+  writer.writeOptional(attributes.surfaceValue());
+
+  writer.write(static_cast<std::uint8_t>(attributes.hasColor()));
+  if (const auto& color = attributes.color()) {
+    writer.write(color->r());
+    writer.write(color->g());
+    writer.write(color->b());
+    writer.write(color->a());
+  }
+
+  if (parallelTexCoordSystem) {
+    writer.writeVec(face.textureXAxis());
+    writer.writeVec(face.textureYAxis());
+  }
+}
+
+Model::BrushFace readBrushFace(CacheReader& reader, const bool parallelTexCoordSystem) {
+  const auto point0 = reader.readVec();
+  const auto point1 = reader.readVec();
+  const auto point2 = reader.readVec();
+  const auto lineNumber = reader.readSize();
+
+  auto attributes = Model::BrushFaceAttributes{reader.readString()};
+  const auto xOffset = reader.read<float>();
+  const auto yOffset = reader.read<float>();
+  attributes.setOffset(vm::vec2f{xOffset, yOffset});
+  const auto xScale = reader.read<float>();
+  const auto yScale = reader.read<float>();
+  attributes.setScale(vm::vec2f{xScale, yScale});
+  attributes.setRotation(reader.read<float>());
+  attributes.setSurfaceContents(reader.readOptional<int>());
+  attributes.setSurfaceFlags(reader.readOptional<int>());
+  attributes.setSurfaceValue(reader.readOptional<float>());
+
+  if (reader.read<std::uint8_t>() != 0u) {
+    const auto r = reader.read<float>();
+    const auto g = reader.read<float>();
+    const auto b = reader.read<float>();
+    const auto a = reader.read<float>();
+    attributes.setColor(Color{r, g, b, a});
+  }
+
+  auto texCoordSystem = std::unique_ptr<Model::TexCoordSystem>{};
+  if (parallelTexCoordSystem) {
+    const auto xAxis = reader.readVec();
+    const auto yAxis = reader.readVec();
+    texCoordSystem = std::make_unique<Model::ParallelTexCoordSystem>(xAxis, yAxis);
+  } else {
+    texCoordSystem =
+      std::make_unique<Model::ParaxialTexCoordSystem>(point0, point1, point2, attributes);
+  }
+
+  return Model::BrushFace::create(point0, point1, point2, attributes, std::move(texCoordSystem))
+    .visit(kdl::overload(
+      [&](Model::BrushFace&& face) {
+        face.setFilePosition(lineNumber, 1u);
+        return std::move(face);
+      },
+      [](const Model::BrushError) -> Model::BrushFace {
+        throw ReaderException{"Invalid brush face"};
+      }));
+}
+
+void writeBrushGeometry(CacheWriter& writer, const MapReader::BrushGeometryInfo& geometry) {
+  writer.writeSize(geometry.vertexPositions.size());
+  for (const auto& position : geometry.vertexPositions) {
+    writer.writeVec(position);
+  }
+  writer.writeSize(geometry.faceSizes.size());
+  for (const auto faceSize : geometry.faceSizes) {
+    writer.write(static_cast<std::uint32_t>(faceSize));
+  }
+  writer.writeSize(geometry.faceIndices.size());
+  for (const auto faceIndex : geometry.faceIndices) {
+    writer.write(static_cast<std::uint32_t>(faceIndex));
+  }
+}
+
+MapReader::BrushGeometryInfo readBrushGeometry(CacheReader& reader) {
+  auto result = MapReader::BrushGeometryInfo{};
+
+  const auto vertexCount = reader.readCount(3u * sizeof(double));
+  result.vertexPositions.reserve(vertexCount);
+  for (size_t i = 0u; i < vertexCount; ++i) {
+    result.vertexPositions.push_back(reader.readVec());
+  }
+
+  const auto faceCount = reader.readCount(sizeof(std::uint32_t));
+  result.faceSizes.reserve(faceCount);
+  for (size_t i = 0u; i < faceCount; ++i) {
+    result.faceSizes.push_back(reader.read<std::uint32_t>());
+  }
+
+  const auto indexCount = reader.readCount(sizeof(std::uint32_t));
+  result.faceIndices.reserve(indexCount);
+  for (size_t i = 0u; i < indexCount; ++i) {
+    result.faceIndices.push_back(reader.read<std::uint32_t>());
+  }
+
+  return result;
+}
+
+void writeParentIndex(CacheWriter& writer, const std::optional<size_t>& parentIndex) {
+  writer.writeOptional(
+    parentIndex ? std::optional<std::uint64_t>{*parentIndex} : std::optional<std::uint64_t>{});
+}
+
+std::optional<size_t> readParentIndex(CacheReader& reader) {
+  if (const auto parentIndex = reader.readOptional<std::uint64_t>()) {
+    return static_cast<size_t>(*parentIndex);
+  }
+  return std::nullopt;
+}
+
+void writeObjectInfo(
+  CacheWriter& writer, const MapReader::ObjectInfo& objectInfo,
+  const bool parallelTexCoordSystem) {
+  std::visit(
+    kdl::overload(
+      [&](const MapReader::EntityInfo& entityInfo) {
+        writer.write(ObjectType::Entity);
+        writer.writeSize(entityInfo.startLine);
+        writer.writeSize(entityInfo.lineCount);
+        writer.writeSize(entityInfo.properties.size());
+        for (const auto& property : entityInfo.properties) {
+          writer.writeString(property.key());
+          writer.writeString(property.value());
+        }
+      },
+      [&](const MapReader::BrushInfo& brushInfo) {
+        writer.write(ObjectType::Brush);
+        writer.writeSize(brushInfo.startLine);
+        writer.writeSize(brushInfo.lineCount);
+        writeParentIndex(writer, brushInfo.parentIndex);
+        writer.writeSize(brushInfo.faces.size());
+        for (const auto& face : brushInfo.faces) {
+          writeBrushFace(writer, face, parallelTexCoordSystem);
+        }
+        writer.write(static_cast<std::uint8_t>(brushInfo.geometry.has_value()));
+        if (brushInfo.geometry) {
+          writeBrushGeometry(writer, *brushInfo.geometry);
+        }
+      },
+      [&](const MapReader::PatchInfo& patchInfo) {
+        writer.write(ObjectType::Patch);
+        writer.writeSize(patchInfo.startLine);
+        writer.writeSize(patchInfo.lineCount);
+        writeParentIndex(writer, patchInfo.parentIndex);
+        writer.writeSize(patchInfo.rowCount);
+        writer.writeSize(patchInfo.columnCount);
+        writer.writeSize(patchInfo.controlPoints.size());
+        for (const auto& controlPoint : patchInfo.controlPoints) {
+          for (size_t i = 0u; i < 5u; ++i) {
+            writer.write(controlPoint[i]);
+          }
+        }
+        writer.writeString(patchInfo.textureName);
+      }),
+    objectInfo);
+}
+
+MapReader::ObjectInfo readObjectInfo(CacheReader& reader, const bool parallelTexCoordSystem) {
+  const auto type = reader.read<ObjectType>();
+  const auto startLine = reader.readSize();
+  const auto lineCount = reader.readSize();
+
+  switch (type) {
+    case ObjectType::Entity: {
+      const auto propertyCount = reader.readCount(2u * sizeof(std::uint64_t));
+      auto properties = std::vector<Model::EntityProperty>{};
+      properties.reserve(propertyCount);
+      for (size_t i = 0u; i < propertyCount; ++i) {
+        auto key = reader.readString();
+        auto value = reader.readString();
+        properties.emplace_back(key, value);
+      }
+      return MapReader::EntityInfo{std::move(properties), startLine, lineCount};
+    }
+    case ObjectType::Brush: {
+      auto parentIndex = readParentIndex(reader);
+      const auto faceCount = reader.readCount(9u * sizeof(double));
+      auto faces = std::vector<Model::BrushFace>{};
+      faces.reserve(faceCount);
+      for (size_t i = 0u; i < faceCount; ++i) {
+        faces.push_back(readBrushFace(reader, parallelTexCoordSystem));
+      }
+      auto geometry = reader.read<std::uint8_t>() != 0u
+                        ? std::optional<MapReader::BrushGeometryInfo>{readBrushGeometry(reader)}
+                        : std::nullopt;
+      return MapReader::BrushInfo{
+        std::move(faces), startLine, lineCount, std::move(parentIndex), std::move(geometry)};
+    }
+    case ObjectType::Patch: {
+      auto parentIndex = readParentIndex(reader);
+      const auto rowCount = reader.readSize();
+      const auto columnCount = reader.readSize();
+      const auto controlPointCount = reader.readCount(5u * sizeof(double));
+      auto controlPoints = std::vector<vm::vec<FloatType, 5>>{};
+      controlPoints.reserve(controlPointCount);
+      for (size_t i = 0u; i < controlPointCount; ++i) {
+        auto controlPoint = vm::vec<FloatType, 5>{};
+        for (size_t j = 0u; j < 5u; ++j) {
+          controlPoint[j] = reader.read<double>();
+        }
+        controlPoints.push_back(controlPoint);
+      }
+      auto textureName = reader.readString();
+      return MapReader::PatchInfo{
+        rowCount,  columnCount, std::move(controlPoints), std::move(textureName),
+        startLine, lineCount,   std::move(parentIndex)};
+    }
+    default:
+      throw ReaderException{"Unknown object type"};
+  }
+}
+
+/**
+ * Checks that every parent index refers to an entity info that precedes the object info, which is
+ * how MapReader records them. MapReader does not check the parent indices it reads from the cache.
+ */
+bool checkParentIndices(const std::vector<MapReader::ObjectInfo>& objectInfos) {
+  for (size_t i = 0u; i < objectInfos.size(); ++i) {
+    const auto parentIndex = std::visit(
+      kdl::overload(
+        [](const MapReader::EntityInfo&) -> std::optional<size_t> {
+          return std::nullopt;
+        },
+        [](const MapReader::BrushInfo& brushInfo) {
+          return brushInfo.parentIndex;
+        },
+        [](const MapReader::PatchInfo& patchInfo) {
+          return patchInfo.parentIndex;
+        }),
+      objectInfos[i]);
+    if (
+      parentIndex &&
+      (*parentIndex >= i ||
+       !std::holds_alternative<MapReader::EntityInfo>(objectInfos[*parentIndex]))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void writeHeader(
+  CacheWriter& writer, const MapCacheKey& key, const Model::MapFormat sourceMapFormat,
+  const Model::MapFormat targetMapFormat, const vm::bbox3& worldBounds) {
+  for (const auto c : Magic) {
+    writer.write(c);
+  }
+  writer.write(Version);
+  writer.write(key.fileSize);
+  writer.write(key.modificationTime);
+  writer.write(key.contentHash);
+  writer.write(static_cast<std::uint32_t>(sourceMapFormat));
+  writer.write(static_cast<std::uint32_t>(targetMapFormat));
+  writer.writeVec(worldBounds.min);
+  writer.writeVec(worldBounds.max);
+}
+
+bool readAndCheckHeader(
+  CacheReader& reader, const MapCacheKey& key, const Model::MapFormat sourceMapFormat,
+  const Model::MapFormat targetMapFormat, const vm::bbox3& worldBounds) {
+  for (const auto c : Magic) {
+    if (reader.read<char>() != c) {
+      return false;
+    }
+  }
+  if (reader.read<std::uint32_t>() != Version) {
+    return false;
+  }
+
+  auto cachedKey = MapCacheKey{};
+  cachedKey.fileSize = reader.read<std::uint64_t>();
+  cachedKey.modificationTime = reader.read<std::int64_t>();
+  cachedKey.contentHash = reader.read<std::uint64_t>();
+  if (cachedKey != key) {
+    return false;
+  }
+
+  if (
+    reader.read<std::uint32_t>() != static_cast<std::uint32_t>(sourceMapFormat) ||
+    reader.read<std::uint32_t>() != static_cast<std::uint32_t>(targetMapFormat)) {
+    return false;
+  }
+
+  const auto min = reader.readVec();
+  const auto max = reader.readVec();
+  return min == worldBounds.min && max == worldBounds.max;
+}
+} // namespace
+
+MapCacheKey MapCacheKey::forMapFile(const Path& mapPath, const std::string_view mapContents) {
+  const auto fileInfo = QFileInfo{pathAsQString(mapPath)};
+  return MapCacheKey{
+    static_cast<std::uint64_t>(mapContents.size()),
+    static_cast<std::int64_t>(fileInfo.lastModified().toMSecsSinceEpoch()),
+    hashContents(mapContents)};
+}
+
+bool operator==(const MapCacheKey& lhs, const MapCacheKey& rhs) {
+  return lhs.fileSize == rhs.fileSize && lhs.modificationTime == rhs.modificationTime &&
+         lhs.contentHash == rhs.contentHash;
+}
+
+bool operator!=(const MapCacheKey& lhs, const MapCacheKey& rhs) {
+  return !(lhs == rhs);
+}
+
+const std::string MapCache::FileExtension = "tbcache";
+
+MapCache MapCache::forMapFile(const Path& mapPath, const std::string_view mapContents) {
+  return MapCache{
+    mapPath.addExtension(FileExtension), MapCacheKey::forMapFile(mapPath, mapContents)};
+}
+
+MapCache::MapCache(Path path, const MapCacheKey key)
+  : m_path{std::move(path)}
+  , m_key{key} {}
+
+const Path& MapCache::path() const {
+  return m_path;
+}
+
+const MapCacheKey& MapCache::key() const {
+  return m_key;
+}
+
+std::optional<MapCacheContents> MapCache::read(
+  const Model::MapFormat sourceMapFormat, const Model::MapFormat targetMapFormat,
+  const vm::bbox3& worldBounds) const {
+  if (!Disk::fileExists(m_path)) {
+    return std::nullopt;
+  }
+
+  try {
+    const auto file = Disk::openFile(m_path);
+    auto fileReader = file->reader();
+    auto reader = CacheReader{fileReader};
+
+    if (!readAndCheckHeader(reader, m_key, sourceMapFormat, targetMapFormat, worldBounds)) {
+      return std::nullopt;
+    }
+
+    auto result = MapCacheContents{};
+    const auto messageCount = reader.readCount(sizeof(std::uint32_t) + sizeof(std::uint64_t));
+    result.messages.reserve(messageCount);
+    for (size_t i = 0u; i < messageCount; ++i) {
+      const auto level = static_cast<LogLevel>(reader.read<std::uint32_t>());
+      result.messages.emplace_back(level, reader.readString());
+    }
+
+    const auto parallelTexCoordSystem = Model::isParallelTexCoordSystem(targetMapFormat);
+    const auto objectCount = reader.readCount(1u + 2u * sizeof(std::uint64_t));
+    result.objectInfos.reserve(objectCount);
+    for (size_t i = 0u; i < objectCount; ++i) {
+      result.objectInfos.push_back(readObjectInfo(reader, parallelTexCoordSystem));
+    }
+
+    if (!checkParentIndices(result.objectInfos)) {
+      return std::nullopt;
+    }
+
+    return result;
+  } catch (const Exception&) {
+    return std::nullopt;
+  }
+}
+
+bool MapCache::write(
+  const Model::MapFormat sourceMapFormat, const Model::MapFormat targetMapFormat,
+  const vm::bbox3& worldBounds, const MapCacheContents& contents) const {
+  // the cache file is replaced atomically because another instance may have it mapped into memory
+  return writeFileAtomically(m_path, [&](std::ostream& stream) {
+    auto writer = CacheWriter{stream};
+    writeHeader(writer, m_key, sourceMapFormat, targetMapFormat, worldBounds);
+
+    writer.writeSize(contents.messages.size());
+    for (const auto& [level, message] : contents.messages) {
+      writer.write(static_cast<std::uint32_t>(level));
+      writer.writeString(message);
+    }
+
+    const auto parallelTexCoordSystem = Model::isParallelTexCoordSystem(targetMapFormat);
+    writer.writeSize(contents.objectInfos.size());
+    for (const auto& objectInfo : contents.objectInfos) {
+      writeObjectInfo(writer, objectInfo, parallelTexCoordSystem);
+    }
+  });
+}
+} // namespace IO
+} // namespace TrenchBroom
@@ -0,0 +1,112 @@
+/*
+ Copyright (C) 2023 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "IO/BufferedParserStatus.h"
+#include "IO/MapReader.h"
+#include "IO/Path.h"
+
+#include <vecmath/bbox.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace TrenchBroom {
+namespace Model {
+class Brush;
+enum class MapFormat;
+} // namespace Model
+
+namespace IO {
+/**
+ * Identifies the contents of the map file from which a map cache was written.
+ */
+struct MapCacheKey {
+  std::uint64_t fileSize;
+  std::int64_t modificationTime;
+  std::uint64_t contentHash;
+
+  /**
+   * Creates the key for the map file at the given path with the given contents.
+   */
+  static MapCacheKey forMapFile(const Path& mapPath, std::string_view mapContents);
+
+  friend bool operator==(const MapCacheKey& lhs, const MapCacheKey& rhs);
+  friend bool operator!=(const MapCacheKey& lhs, const MapCacheKey& rhs);
+};
+
+/**
+ * The data stored in a map cache: the object infos recorded by a MapReader after the faces and
+ * geometries of the brushes were computed, and the messages that were logged while parsing.
+ */
+struct MapCacheContents {
+  std::vector<BufferedParserStatus::Message> messages;
+  std::vector<MapReader::ObjectInfo> objectInfos;
+};
+
+/**
+ * A binary sidecar file that stores the result of parsing a map file so that the map file can be
+ * reopened without tokenizing it and without computing the brush geometries again.
+ *
+ * The cache is only valid for the map file contents it was written for, which is checked using a
+ * key made of the file's size, modification time and a hash of its contents, and for the map
+ * formats and world bounds it was written with. If any of these don't match or if the cache file
+ * cannot be read, the cache is ignored.
+ */
+class MapCache {
+public:
+  static const std::string FileExtension;
+
+private:
+  Path m_path;
+  MapCacheKey m_key;
+
+public:
+  /**
+   * Creates a cache for the given map file, which is stored next to the map file.
+   */
+  static MapCache forMapFile(const Path& mapPath, std::string_view mapContents);
+
+  MapCache(Path path, MapCacheKey key);
+
+  const Path& path() const;
+  const MapCacheKey& key() const;
+
+  /**
+   * Reads the cache contents if the cache file exists and is valid for the given parameters and if
+   * all parent indices in it are valid.
+   */
+  std::optional<MapCacheContents> read(
+    Model::MapFormat sourceMapFormat, Model::MapFormat targetMapFormat,
+    const vm::bbox3& worldBounds) const;
+
+  /**
+   * Writes the given contents to the cache file. The file is replaced atomically, so that other
+   * instances that are reading it are not affected. Returns false if the file could not be written.
+   */
+  bool write(
+    Model::MapFormat sourceMapFormat, Model::MapFormat targetMapFormat,
+    const vm::bbox3& worldBounds, const MapCacheContents& contents) const;
+};
+} // namespace IO
+} // namespace TrenchBroom
@@ -33,15 +33,18 @@
 #include "Model/WorldNode.h"
 
 #include <kdl/overload.h>
-#include <kdl/parallel.h>
 #include <kdl/string_format.h>
+#include <kdl/thread_pool.h>
 #include <kdl/vector_utils.h>
 
 #include <fmt/format.h>
 
+#include <algorithm>
+#include <cassert>
 #include <iterator> // for std::ostreambuf_iterator
 #include <memory>
-#include <sstream>
+#include <ostream>
+#include <streambuf>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -211,7 +214,7 @@ private:
   }
 };
 
-std::unique_ptr<NodeSerializer> MapFileSerializer::create(
+std::unique_ptr<MapFileSerializer> MapFileSerializer::create(
   const Model::MapFormat format, std::ostream& stream) {
   switch (format) {
     case Model::MapFormat::Standard:
@@ -236,60 +239,96 @@ std::unique_ptr<NodeSerializer> MapFileSerializer::create(
   }
 }
 
+const size_t MapFileSerializer::DefaultWindowSize = 1u << 12;
+
 MapFileSerializer::MapFileSerializer(std::ostream& stream)
   : m_line(1)
-  , m_stream(stream) {}
+  , m_stream(stream)
+  , m_windowSize(DefaultWindowSize)
+  , m_nextNodeToWrite(0) {}
+
+MapFileSerializer::~MapFileSerializer() {
+  // the background task refers to this serializer
+  if (m_nextWindowFormatted.valid()) {
+    m_nextWindowFormatted.wait();
+  }
+}
+
+void MapFileSerializer::setWindowSize(const size_t windowSize) {
+  m_windowSize = windowSize;
+}
+
+/**
+ * Collects the brushes and patches of the given node in the order in which NodeWriter writes them:
+ * the node's own brushes and patches come first, followed by those of its groups and entities.
+ */
+void MapFileSerializer::collectChildNodesToSerialize(
+  const Model::Node* node, const bool exporting, std::vector<NodeToSerialize>& result) {
+  node->visitChildren(kdl::overload(
+    [](const Model::WorldNode*) {}, [](const Model::LayerNode*) {}, [](const Model::GroupNode*) {},
+    [](const Model::EntityNode*) {},
+    [&](const Model::BrushNode* brush) {
+      result.push_back(brush);
+    },
+    [&](const Model::PatchNode* patchNode) {
+      result.push_back(patchNode);
+    }));
+  node->visitChildren(kdl::overload(
+    [](const Model::WorldNode*) {}, [](const Model::LayerNode*) {},
+    [&](const Model::GroupNode* group) {
+      collectNodesToSerialize(group, exporting, result);
+    },
+    [&](const Model::EntityNode* entity) {
+      collectNodesToSerialize(entity, exporting, result);
+    },
+    [](const Model::BrushNode*) {}, [](const Model::PatchNode*) {}));
+}
+
+void MapFileSerializer::collectNodesToSerialize(
+  const Model::Node* node, const bool exporting, std::vector<NodeToSerialize>& result) {
+  node->accept(kdl::overload(
+    [&](const Model::WorldNode* world) {
+      collectNodesToSerialize(world->defaultLayer(), exporting, result);
+      for (const auto* layer : world->customLayers()) {
+        collectNodesToSerialize(layer, exporting, result);
+      }
+    },
+    [&](const Model::LayerNode* layer) {
+      if (!(exporting && layer->layer().omitFromExport())) {
+        collectChildNodesToSerialize(layer, exporting, result);
+      }
+    },
+    [&](const Model::GroupNode* group) {
+      collectChildNodesToSerialize(group, exporting, result);
+    },
+    [&](const Model::EntityNode* entity) {
+      collectChildNodesToSerialize(entity, exporting, result);
+    },
+    [&](const Model::BrushNode* brush) {
+      result.push_back(brush);
+    },
+    [&](const Model::PatchNode* patchNode) {
+      result.push_back(patchNode);
+    }));
+}
 
 void MapFileSerializer::doBeginFile(const std::vector<const Model::Node*>& rootNodes) {
-  ensure(m_nodeToPrecomputedString.empty(), "MapFileSerializer may not be reused");
-
-  // collect nodes
-  std::vector<std::variant<const Model::BrushNode*, const Model::PatchNode*>> nodesToSerialize;
-  nodesToSerialize.reserve(rootNodes.size());
-
-  Model::Node::visitAll(
-    rootNodes, kdl::overload(
-                 [](auto&& thisLambda, const Model::WorldNode* world) {
-                   world->visitChildren(thisLambda);
-                 },
-                 [](auto&& thisLambda, const Model::LayerNode* layer) {
-                   layer->visitChildren(thisLambda);
-                 },
-                 [](auto&& thisLambda, const Model::GroupNode* group) {
-                   group->visitChildren(thisLambda);
-                 },
-                 [](auto&& thisLambda, const Model::EntityNode* entity) {
-                   entity->visitChildren(thisLambda);
-                 },
-                 [&](const Model::BrushNode* brush) {
-                   nodesToSerialize.push_back(brush);
-                 },
-                 [&](const Model::PatchNode* patchNode) {
-                   nodesToSerialize.push_back(patchNode);
-                 }));
-
-  // serialize brushes to strings in parallel
-  using Entry = std::pair<const Model::Node*, PrecomputedString>;
-  std::vector<Entry> result =
-    kdl::vec_parallel_transform(std::move(nodesToSerialize), [&](const auto& node) {
-      return std::visit(
-        kdl::overload(
-          [&](const Model::BrushNode* brushNode) {
-            return Entry{brushNode, writeBrushFaces(brushNode->brush())};
-          },
-          [&](const Model::PatchNode* patchNode) {
-            return Entry{patchNode, writePatch(patchNode->patch())};
-          }),
-        node);
-    });
+  ensure(m_nodesToSerialize.empty(), "MapFileSerializer may not be reused");
+
+  for (const auto* node : rootNodes) {
+    collectNodesToSerialize(node, exporting(), m_nodesToSerialize);
+  }
 
-  // move strings into a map
-  for (auto& entry : result) {
-    m_nodeToPrecomputedString.insert(std::move(entry));
+  if (m_windowSize == 0u) {
+    formatWindow(m_currentWindow, 0u, m_nodesToSerialize.size());
+  } else {
+    formatNextWindowInBackground();
   }
 }
 
-void MapFileSerializer::doEndFile() {}
+void MapFileSerializer::doEndFile() {
+  assert(m_nextNodeToWrite == m_nodesToSerialize.size());
+}
 
 void MapFileSerializer::doBeginEntity(const Model::Node* /* node */) {
   fmt::format_to(std::ostreambuf_iterator<char>(m_stream), "// entity {}\n", entityNo());
@@ -320,13 +359,7 @@ void MapFileSerializer::doBrush(const Model::BrushNode* brush) {
   ++m_line;
 
   // write pre-serialized brush faces
-  auto it = m_nodeToPrecomputedString.find(brush);
-  ensure(
-    it != std::end(m_nodeToPrecomputedString),
-    "attempted to serialize a brush which was not passed to doBeginFile");
-  const PrecomputedString& precomputedString = it->second;
-  m_stream << precomputedString.string;
-  m_line += precomputedString.lineCount;
+  writeFormattedNode(brush);
 
   fmt::format_to(std::ostreambuf_iterator<char>(m_stream), "}}\n");
   ++m_line;
@@ -346,13 +379,7 @@ void MapFileSerializer::doPatch(const Model::PatchNode* patchNode) {
   m_startLineStack.push_back(m_line);
 
   // write pre-serialized patch
-  auto it = m_nodeToPrecomputedString.find(patchNode);
-  ensure(
-    it != std::end(m_nodeToPrecomputedString),
-    "attempted to serialize a patch which was not passed to doBeginFile");
-  const PrecomputedString& precomputedString = it->second;
-  m_stream << precomputedString.string;
-  m_line += precomputedString.lineCount;
+  writeFormattedNode(patchNode);
 
   setFilePosition(patchNode);
 }
@@ -369,22 +396,128 @@ size_t MapFileSerializer::startLine() {
   return result;
 }
 
+void MapFileSerializer::writeFormattedNode(const Model::Node* node) {
+  ensure(
+    m_nextNodeToWrite < m_nodesToSerialize.size(),
+    "attempted to serialize a node which was not passed to doBeginFile");
+  assert(
+    std::visit(
+      [](const auto* nodeToWrite) -> const Model::Node* {
+        return nodeToWrite;
+      },
+      m_nodesToSerialize[m_nextNodeToWrite]) == node);
+  unused(node);
+
+  if (m_nextNodeToWrite == m_currentWindow.last) {
+    advanceWindow();
+  }
+
+  const auto& formattedNode = m_currentWindow.nodes[m_nextNodeToWrite - m_currentWindow.first];
+  const auto& chunk = m_currentWindow.chunks[formattedNode.chunk];
+  m_stream.write(
+    chunk.data() + formattedNode.offset, static_cast<std::streamsize>(formattedNode.length));
+  m_line += formattedNode.lineCount;
+  ++m_nextNodeToWrite;
+}
+
+/**
+ * Makes the window that was formatted in the background the current window and starts formatting
+ * the window after it into the buffers of the previous window.
+ */
+void MapFileSerializer::advanceWindow() {
+  assert(m_nextWindowFormatted.valid());
+  m_nextWindowFormatted.get();
+
+  std::swap(m_currentWindow, m_nextWindow);
+  formatNextWindowInBackground();
+}
+
+void MapFileSerializer::formatNextWindowInBackground() {
+  const auto first = m_currentWindow.last;
+  const auto last = std::min(first + m_windowSize, m_nodesToSerialize.size());
+  if (first < last) {
+    m_nextWindowFormatted = std::async(std::launch::async, [this, first, last]() {
+      formatWindow(m_nextWindow, first, last);
+    });
+  }
+}
+
+namespace {
+/**
+ * Appends everything that is written to it to a string.
+ */
+class StringAppendBuffer : public std::streambuf {
+private:
+  std::string& m_string;
+
+public:
+  explicit StringAppendBuffer(std::string& string)
+    : m_string(string) {}
+
+protected:
+  int_type overflow(const int_type c) override {
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      m_string.push_back(traits_type::to_char_type(c));
+    }
+    return traits_type::not_eof(c);
+  }
+
+  std::streamsize xsputn(const char* s, const std::streamsize count) override {
+    m_string.append(s, static_cast<size_t>(count));
+    return count;
+  }
+};
+} // namespace
+
+/**
+ * Threadsafe
+ */
+void MapFileSerializer::formatWindow(Window& window, const size_t first, const size_t last) const {
+  auto& pool = kdl::thread_pool::shared();
+  const auto count = last - first;
+  const auto maxChunkCount = (pool.worker_count() + 1u) * 4u;
+  const auto chunkSize = std::max((count + maxChunkCount - 1u) / maxChunkCount, size_t(1));
+
+  window.first = first;
+  window.last = last;
+  window.chunks.resize(std::max(window.chunks.size(), (count + chunkSize - 1u) / chunkSize));
+  window.nodes.resize(count);
+
+  pool.for_each_chunk(count, chunkSize, [&](const size_t begin, const size_t end) {
+    const auto chunkIndex = begin / chunkSize;
+    auto& chunk = window.chunks[chunkIndex];
+    chunk.clear();
+
+    auto buffer = StringAppendBuffer{chunk};
+    auto stream = std::ostream{&buffer};
+    for (size_t i = begin; i < end; ++i) {
+      const auto offset = chunk.size();
+      const auto lineCount = std::visit(
+        kdl::overload(
+          [&](const Model::BrushNode* brushNode) {
+            return writeBrushFaces(stream, brushNode->brush());
+          },
+          [&](const Model::PatchNode* patchNode) {
+            return writePatch(stream, patchNode->patch());
+          }),
+        m_nodesToSerialize[first + i]);
+      window.nodes[i] = FormattedNode{chunkIndex, offset, chunk.size() - offset, lineCount};
+    }
+  });
+}
+
 /**
  * Threadsafe
  */
-MapFileSerializer::PrecomputedString MapFileSerializer::writeBrushFaces(
-  const Model::Brush& brush) const {
-  std::stringstream stream;
+size_t MapFileSerializer::writeBrushFaces(std::ostream& stream, const Model::Brush& brush) const {
   for (const Model::BrushFace& face : brush.faces()) {
     doWriteBrushFace(stream, face);
   }
-  return PrecomputedString{stream.str(), brush.faces().size()};
+  return brush.faces().size();
 }
 
-MapFileSerializer::PrecomputedString MapFileSerializer::writePatch(
-  const Model::BezierPatch& patch) const {
+size_t MapFileSerializer::writePatch(std::ostream& stream, const Model::BezierPatch& patch) const {
   size_t lineCount = 0u;
-  std::stringstream stream;
 
   fmt::format_to(std::ostreambuf_iterator<char>(stream), "{{\n");
   ++lineCount;
@@ -420,7 +553,7 @@ MapFileSerializer::PrecomputedString MapFileSerializer::writePatch(
   fmt::format_to(std::ostreambuf_iterator<char>(stream), "}}\n");
   ++lineCount;
 
-  return PrecomputedString{stream.str(), lineCount};
+  return lineCount;
 }
 } // namespace IO
 } // namespace TrenchBroom
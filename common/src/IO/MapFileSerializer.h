@@ -22,8 +22,11 @@
 #include "IO/NodeSerializer.h"
 #include "Model/MapFormat.h"
 
+#include <future>
 #include <iosfwd>
 #include <memory>
+#include <string>
+#include <variant>
 #include <vector>
 
 namespace TrenchBroom {
@@ -38,25 +41,73 @@ class PatchNode;
 } // namespace Model
 
 namespace IO {
+/**
+ * Serializes nodes to the map file format.
+ *
+ * The brushes and patches passed to beginFile are formatted in parallel. To bound the memory
+ * required for the formatted text, they are not formatted all at once, but in windows of
+ * consecutive nodes in the order in which they are going to be written. While the nodes of one
+ * window are written to the output stream, the next window is formatted in the background, so at
+ * most two windows are held in memory. The buffers of a window are reused for the window after
+ * next.
+ *
+ * The nodes must be written in the order in which beginFile collects them from the given root
+ * nodes.
+ */
 class MapFileSerializer : public NodeSerializer {
+public:
+  /**
+   * The default number of brushes and patches that are formatted in parallel.
+   */
+  static const size_t DefaultWindowSize;
+
 private:
   using LineStack = std::vector<size_t>;
   LineStack m_startLineStack;
   size_t m_line;
   std::ostream& m_stream;
+  size_t m_windowSize;
 
-  struct PrecomputedString {
-    std::string string;
+  using NodeToSerialize = std::variant<const Model::BrushNode*, const Model::PatchNode*>;
+  std::vector<NodeToSerialize> m_nodesToSerialize;
+  size_t m_nextNodeToWrite;
+
+  struct FormattedNode {
+    size_t chunk;
+    size_t offset;
+    size_t length;
     size_t lineCount;
   };
-  std::unordered_map<const Model::Node*, PrecomputedString> m_nodeToPrecomputedString;
+
+  /**
+   * The formatted text of the nodes in the range `[first, last)` of m_nodesToSerialize. Every chunk
+   * of consecutive nodes is formatted into its own buffer by one thread.
+   */
+  struct Window {
+    size_t first = 0;
+    size_t last = 0;
+    std::vector<std::string> chunks;
+    std::vector<FormattedNode> nodes;
+  };
+  Window m_currentWindow;
+  Window m_nextWindow;
+  std::future<void> m_nextWindowFormatted;
 
 public:
-  static std::unique_ptr<NodeSerializer> create(Model::MapFormat format, std::ostream& stream);
+  static std::unique_ptr<MapFileSerializer> create(Model::MapFormat format, std::ostream& stream);
 
 protected:
   explicit MapFileSerializer(std::ostream& stream);
 
+public:
+  ~MapFileSerializer() override;
+
+  /**
+   * Sets the number of brushes and patches that are formatted in parallel ahead of being written.
+   * Passing 0 formats all of them at once when the file is begun.
+   */
+  void setWindowSize(size_t windowSize);
+
 private:
   void doBeginFile(const std::vector<const Model::Node*>& rootNodes) override;
   void doEndFile() override;
@@ -73,10 +124,20 @@ private:
   void setFilePosition(const Model::Node* node);
   size_t startLine();
 
+  static void collectNodesToSerialize(
+    const Model::Node* node, bool exporting, std::vector<NodeToSerialize>& result);
+  static void collectChildNodesToSerialize(
+    const Model::Node* node, bool exporting, std::vector<NodeToSerialize>& result);
+
+  void writeFormattedNode(const Model::Node* node);
+  void advanceWindow();
+  void formatNextWindowInBackground();
+
 private: // threadsafe
+  void formatWindow(Window& window, size_t first, size_t last) const;
   virtual void doWriteBrushFace(std::ostream& stream, const Model::BrushFace& face) const = 0;
-  PrecomputedString writeBrushFaces(const Model::Brush& brush) const;
-  PrecomputedString writePatch(const Model::BezierPatch& patch) const;
+  size_t writeBrushFaces(std::ostream& stream, const Model::Brush& brush) const;
+  size_t writePatch(std::ostream& stream, const Model::BezierPatch& patch) const;
 };
 } // namespace IO
 } // namespace TrenchBroom
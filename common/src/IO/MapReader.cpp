@@ -19,6 +19,9 @@
 
 #include "MapReader.h"
 
+#include "Exceptions.h"
+#include "IO/BufferedParserStatus.h"
+#include "IO/MapCache.h"
 #include "IO/ParserStatus.h"
 #include "Model/BrushError.h"
 #include "Model/BrushFace.h"
@@ -31,12 +34,14 @@
 #include "Model/LockState.h"
 #include "Model/MapFormat.h"
 #include "Model/PatchNode.h"
+#include "Model/Polyhedron.h"
 #include "Model/VisibilityState.h"
 #include "Model/WorldNode.h"
 
 #include <vecmath/mat.h>
 #include <vecmath/mat_io.h>
 
+#include <kdl/overload.h>
 #include <kdl/parallel.h>
 #include <kdl/result.h>
 #include <kdl/result_for_each.h>
@@ -44,25 +49,51 @@
 #include <kdl/string_utils.h>
 #include <kdl/vector_utils.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <memory>
 #include <optional>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
 namespace TrenchBroom {
 namespace IO {
+const size_t MapReader::DefaultParallelChunkSize = 1u << 20;
+
 MapReader::MapReader(
   std::string_view str, const Model::MapFormat sourceMapFormat,
   const Model::MapFormat targetMapFormat, const Model::EntityPropertyConfig& entityPropertyConfig)
-  : StandardMapParser(std::move(str), sourceMapFormat, targetMapFormat)
-  , m_entityPropertyConfig{entityPropertyConfig} {}
+  : StandardMapParser(str, sourceMapFormat, targetMapFormat)
+  , m_str{str}
+  , m_entityPropertyConfig{entityPropertyConfig}
+  , m_parallelChunkSize{DefaultParallelChunkSize} {}
+
+MapReader::~MapReader() = default;
+
+void MapReader::setParallelChunkSize(const size_t parallelChunkSize) {
+  m_parallelChunkSize = parallelChunkSize;
+}
+
+void MapReader::setCache(std::unique_ptr<MapCache> cache) {
+  m_cache = std::move(cache);
+}
 
 void MapReader::readEntities(const vm::bbox3& worldBounds, ParserStatus& status) {
   m_worldBounds = worldBounds;
-  parseEntities(status);
-  createNodes(status);
+  if (m_cache) {
+    if (!readEntitiesFromCache(status)) {
+      readAndCacheEntities(status);
+    }
+  } else {
+    if (!parseEntitiesInParallel(status)) {
+      parseEntities(status);
+    }
+    createNodes(status);
+  }
 }
 
 void MapReader::readBrushes(const vm::bbox3& worldBounds, ParserStatus& status) {
@@ -76,51 +107,108 @@ void MapReader::readBrushFaces(const vm::bbox3& worldBounds, ParserStatus& statu
   parseBrushFaces(status);
 }
 
+// helpers for recording object infos, shared by MapReader and EntityChunkReader
+
+static void beginEntity(
+  std::vector<MapReader::ObjectInfo>& objectInfos, std::optional<size_t>& currentEntityInfo,
+  std::vector<Model::EntityProperty> properties) {
+  currentEntityInfo = objectInfos.size();
+  objectInfos.push_back(MapReader::EntityInfo{std::move(properties), 0, 0});
+}
+
+static void endEntity(
+  std::vector<MapReader::ObjectInfo>& objectInfos, std::optional<size_t>& currentEntityInfo,
+  const size_t startLine, const size_t lineCount) {
+  assert(currentEntityInfo != std::nullopt);
+  assert(std::holds_alternative<MapReader::EntityInfo>(objectInfos[*currentEntityInfo]));
+
+  MapReader::EntityInfo& entity = std::get<MapReader::EntityInfo>(objectInfos[*currentEntityInfo]);
+  entity.startLine = startLine;
+  entity.lineCount = lineCount;
+
+  currentEntityInfo = std::nullopt;
+}
+
+static void beginBrush(
+  std::vector<MapReader::ObjectInfo>& objectInfos,
+  const std::optional<size_t>& currentEntityInfo) {
+  objectInfos.push_back(MapReader::BrushInfo{{}, 0, 0, currentEntityInfo, std::nullopt});
+}
+
+static void endBrush(
+  std::vector<MapReader::ObjectInfo>& objectInfos, const size_t startLine,
+  const size_t lineCount) {
+  assert(std::holds_alternative<MapReader::BrushInfo>(objectInfos.back()));
+
+  MapReader::BrushInfo& brush = std::get<MapReader::BrushInfo>(objectInfos.back());
+  brush.startLine = startLine;
+  brush.lineCount = lineCount;
+}
+
+static void addBrushFace(std::vector<MapReader::ObjectInfo>& objectInfos, Model::BrushFace face) {
+  assert(std::holds_alternative<MapReader::BrushInfo>(objectInfos.back()));
+
+  MapReader::BrushInfo& brush = std::get<MapReader::BrushInfo>(objectInfos.back());
+  brush.faces.push_back(std::move(face));
+}
+
+static void addPatch(
+  std::vector<MapReader::ObjectInfo>& objectInfos, const std::optional<size_t>& currentEntityInfo,
+  const size_t startLine, const size_t lineCount, const size_t rowCount, const size_t columnCount,
+  std::vector<vm::vec<FloatType, 5>> controlPoints, std::string textureName) {
+  objectInfos.push_back(MapReader::PatchInfo{
+    rowCount, columnCount, std::move(controlPoints), std::move(textureName), startLine, lineCount,
+    currentEntityInfo});
+}
+
+/**
+ * Passes the created face to the given function, or logs an error if the face could not be created.
+ */
+template <typename F>
+static void handleBrushFace(
+  const size_t line, kdl::result<Model::BrushFace, Model::BrushError> faceResult,
+  ParserStatus& status, const F& onBrushFace) {
+  std::move(faceResult)
+    .and_then([&](Model::BrushFace&& face) {
+      face.setFilePosition(line, 1u);
+      onBrushFace(std::move(face));
+    })
+    .handle_errors([&](const Model::BrushError e) {
+      status.error(line, kdl::str_to_string("Skipping face: ", e));
+    });
+}
+
 // implement MapParser interface
 
 void MapReader::onBeginEntity(
   const size_t /* line */, std::vector<Model::EntityProperty> properties,
   ParserStatus& /* status */) {
-  m_currentEntityInfo = m_objectInfos.size();
-  m_objectInfos.push_back(EntityInfo{std::move(properties), 0, 0});
+  beginEntity(m_objectInfos, m_currentEntityInfo, std::move(properties));
 }
 
 void MapReader::onEndEntity(
   const size_t startLine, const size_t lineCount, ParserStatus& /* status */) {
-  assert(m_currentEntityInfo != std::nullopt);
-  assert(std::holds_alternative<EntityInfo>(m_objectInfos[*m_currentEntityInfo]));
-
-  EntityInfo& entity = std::get<EntityInfo>(m_objectInfos[*m_currentEntityInfo]);
-  entity.startLine = startLine;
-  entity.lineCount = lineCount;
-
-  m_currentEntityInfo = std::nullopt;
+  endEntity(m_objectInfos, m_currentEntityInfo, startLine, lineCount);
 }
 
 void MapReader::onBeginBrush(const size_t /* line */, ParserStatus& /* status */) {
-  m_objectInfos.push_back(BrushInfo{{}, 0, 0, m_currentEntityInfo});
+  beginBrush(m_objectInfos, m_currentEntityInfo);
 }
 
 void MapReader::onEndBrush(
   const size_t startLine, const size_t lineCount, ParserStatus& /* status */) {
-  assert(std::holds_alternative<BrushInfo>(m_objectInfos.back()));
-
-  BrushInfo& brush = std::get<BrushInfo>(m_objectInfos.back());
-  brush.startLine = startLine;
-  brush.lineCount = lineCount;
+  endBrush(m_objectInfos, startLine, lineCount);
 }
 
 void MapReader::onStandardBrushFace(
   const size_t line, const Model::MapFormat targetMapFormat, const vm::vec3& point1,
   const vm::vec3& point2, const vm::vec3& point3, const Model::BrushFaceAttributes& attribs,
   ParserStatus& status) {
-  Model::BrushFace::createFromStandard(point1, point2, point3, attribs, targetMapFormat)
-    .and_then([&](Model::BrushFace&& face) {
-      face.setFilePosition(line, 1u);
+  handleBrushFace(
+    line,
+    Model::BrushFace::createFromStandard(point1, point2, point3, attribs, targetMapFormat),
+    status, [&](Model::BrushFace&& face) {
       onBrushFace(std::move(face), status);
-    })
-    .handle_errors([&](const Model::BrushError e) {
-      status.error(line, kdl::str_to_string("Skipping face: ", e));
     });
 }
 
@@ -128,14 +216,12 @@ void MapReader::onValveBrushFace(
   const size_t line, const Model::MapFormat targetMapFormat, const vm::vec3& point1,
   const vm::vec3& point2, const vm::vec3& point3, const Model::BrushFaceAttributes& attribs,
   const vm::vec3& texAxisX, const vm::vec3& texAxisY, ParserStatus& status) {
-  Model::BrushFace::createFromValve(
-    point1, point2, point3, attribs, texAxisX, texAxisY, targetMapFormat)
-    .and_then([&](Model::BrushFace&& face) {
-      face.setFilePosition(line, 1u);
+  handleBrushFace(
+    line,
+    Model::BrushFace::createFromValve(
+      point1, point2, point3, attribs, texAxisX, texAxisY, targetMapFormat),
+    status, [&](Model::BrushFace&& face) {
       onBrushFace(std::move(face), status);
-    })
-    .handle_errors([&](const Model::BrushError e) {
-      status.error(line, kdl::str_to_string("Skipping face: ", e));
     });
 }
 
@@ -143,14 +229,96 @@ void MapReader::onPatch(
   const size_t startLine, const size_t lineCount, Model::MapFormat, const size_t rowCount,
   const size_t columnCount, std::vector<vm::vec<FloatType, 5>> controlPoints,
   std::string textureName, ParserStatus&) {
-  m_objectInfos.push_back(PatchInfo{
-    rowCount, columnCount, std::move(controlPoints), std::move(textureName), startLine, lineCount,
-    m_currentEntityInfo});
+  addPatch(
+    m_objectInfos, m_currentEntityInfo, startLine, lineCount, rowCount, columnCount,
+    std::move(controlPoints), std::move(textureName));
 }
 
 // helper methods
 
 namespace {
+/**
+ * Parses a chunk of complete top level entities on a worker thread and records the object infos in
+ * the same way as MapReader. Parent indices of the recorded object infos refer to this chunk only.
+ */
+class EntityChunkReader : public StandardMapParser {
+private:
+  std::vector<MapReader::ObjectInfo> m_objectInfos;
+  std::optional<size_t> m_currentEntityInfo;
+
+public:
+  EntityChunkReader(
+    const MapChunk& chunk, const Model::MapFormat sourceMapFormat,
+    const Model::MapFormat targetMapFormat)
+    : StandardMapParser{chunk, sourceMapFormat, targetMapFormat} {}
+
+  std::vector<MapReader::ObjectInfo> read(ParserStatus& status) {
+    parseEntities(status);
+    return std::move(m_objectInfos);
+  }
+
+private: // implement MapParser interface
+  void onBeginEntity(
+    const size_t /* line */, std::vector<Model::EntityProperty> properties,
+    ParserStatus& /* status */) override {
+    beginEntity(m_objectInfos, m_currentEntityInfo, std::move(properties));
+  }
+
+  void onEndEntity(
+    const size_t startLine, const size_t lineCount, ParserStatus& /* status */) override {
+    endEntity(m_objectInfos, m_currentEntityInfo, startLine, lineCount);
+  }
+
+  void onBeginBrush(const size_t /* line */, ParserStatus& /* status */) override {
+    beginBrush(m_objectInfos, m_currentEntityInfo);
+  }
+
+  void onEndBrush(
+    const size_t startLine, const size_t lineCount, ParserStatus& /* status */) override {
+    endBrush(m_objectInfos, startLine, lineCount);
+  }
+
+  void onStandardBrushFace(
+    const size_t line, const Model::MapFormat targetMapFormat, const vm::vec3& point1,
+    const vm::vec3& point2, const vm::vec3& point3, const Model::BrushFaceAttributes& attribs,
+    ParserStatus& status) override {
+    handleBrushFace(
+      line,
+      Model::BrushFace::createFromStandard(point1, point2, point3, attribs, targetMapFormat),
+      status, [&](Model::BrushFace&& face) {
+        addBrushFace(m_objectInfos, std::move(face));
+      });
+  }
+
+  void onValveBrushFace(
+    const size_t line, const Model::MapFormat targetMapFormat, const vm::vec3& point1,
+    const vm::vec3& point2, const vm::vec3& point3, const Model::BrushFaceAttributes& attribs,
+    const vm::vec3& texAxisX, const vm::vec3& texAxisY, ParserStatus& status) override {
+    handleBrushFace(
+      line,
+      Model::BrushFace::createFromValve(
+        point1, point2, point3, attribs, texAxisX, texAxisY, targetMapFormat),
+      status, [&](Model::BrushFace&& face) {
+        addBrushFace(m_objectInfos, std::move(face));
+      });
+  }
+
+  void onPatch(
+    const size_t startLine, const size_t lineCount, Model::MapFormat, const size_t rowCount,
+    const size_t columnCount, std::vector<vm::vec<FloatType, 5>> controlPoints,
+    std::string textureName, ParserStatus&) override {
+    addPatch(
+      m_objectInfos, m_currentEntityInfo, startLine, lineCount, rowCount, columnCount,
+      std::move(controlPoints), std::move(textureName));
+  }
+};
+
+/** The object infos and messages recorded while parsing a chunk. */
+struct ParsedChunk {
+  std::vector<MapReader::ObjectInfo> objectInfos;
+  std::unique_ptr<BufferedParserStatus> status;
+};
+
 /** The type of a node's container. */
 enum class ContainerType
 {
@@ -459,13 +627,36 @@ static CreateNodeResult createNodeFromEntityInfo(
   }
 }
 
+/**
+ * Creates a brush from the given brush info, either from its cached geometry or by computing the
+ * geometry from the brush faces.
+ */
+static kdl::result<Model::Brush, Model::BrushError> createBrush(
+  MapReader::BrushInfo& brushInfo, const vm::bbox3& worldBounds) {
+  if (brushInfo.geometry) {
+    const auto facePlanes = kdl::vec_transform(brushInfo.faces, [](const Model::BrushFace& face) {
+      return face.boundary();
+    });
+    if (
+      auto geometry = Model::BrushGeometry::fromFaces(
+        brushInfo.geometry->vertexPositions, facePlanes, brushInfo.geometry->faceSizes,
+        brushInfo.geometry->faceIndices)) {
+      return Model::Brush::createFromGeometry(std::move(brushInfo.faces), std::move(*geometry));
+    }
+  }
+  return Model::Brush::create(worldBounds, std::move(brushInfo.faces));
+}
+
 /**
  * Creates a brush node from the given brush info. Returns an error if the brush could not be
  * created.
+ *
+ * If the brush info contains a geometry, the brush is created from it. If the geometry is invalid,
+ * the brush geometry is computed from the brush faces as usual.
  */
 static CreateNodeResult createBrushNode(
   MapReader::BrushInfo brushInfo, const vm::bbox3& worldBounds) {
-  return Model::Brush::create(worldBounds, std::move(brushInfo.faces))
+  return createBrush(brushInfo, worldBounds)
     .and_then([&](Model::Brush&& brush) {
       auto brushNode = std::make_unique<Model::BrushNode>(std::move(brush));
       brushNode->setFilePosition(brushInfo.startLine, brushInfo.lineCount);
@@ -502,29 +693,32 @@ static CreateNodeResult createPatchNode(MapReader::PatchInfo patchInfo) {
  * Transforms the given object infos into a vector of node infos. The returned vector is sparse,
  * that is, it contains empty optionals in place of nodes that we failed to create. We need the
  * indices to remain correct because we use them to refer to parent nodes later.
+ *
+ * If `keepObjectInfos` is false, the data is moved out of the given object infos. Otherwise, each
+ * object info is copied by the thread that creates its node.
  */
 static std::vector<std::optional<NodeInfo>> createNodesFromObjectInfos(
   const Model::EntityPropertyConfig& entityPropertyConfig,
-  std::vector<MapReader::ObjectInfo> objectInfos, const vm::bbox3& worldBounds,
-  const Model::MapFormat mapFormat, ParserStatus& status) {
-  // create nodes in parallel, moving data out of objectInfos
-  // we store optionals in the result vector to make the elements default constructible, which is a
-  // requirement for parallel transform
-  std::vector<CreateNodeResult> createNodeResults =
-    kdl::vec_parallel_transform(std::move(objectInfos), [&](auto&& objectInfo) -> CreateNodeResult {
-      return std::visit(
-        kdl::overload(
-          [&](MapReader::EntityInfo&& entityInfo) {
-            return createNodeFromEntityInfo(entityPropertyConfig, std::move(entityInfo), mapFormat);
-          },
-          [&](MapReader::BrushInfo&& brushInfo) {
-            return createBrushNode(std::move(brushInfo), worldBounds);
-          },
-          [&](MapReader::PatchInfo&& patchInfo) {
-            return createPatchNode(std::move(patchInfo));
-          }),
-        std::move(objectInfo));
-    });
+  std::vector<MapReader::ObjectInfo>& objectInfos, const bool keepObjectInfos,
+  const vm::bbox3& worldBounds, const Model::MapFormat mapFormat, ParserStatus& status) {
+  // create nodes in parallel
+  // we store optionals in the result vector to make the elements default constructible
+  auto createNodeResults = std::vector<std::optional<CreateNodeResult>>(objectInfos.size());
+  kdl::parallel_for(objectInfos.size(), [&](const size_t i) {
+    auto objectInfo = keepObjectInfos ? objectInfos[i] : std::move(objectInfos[i]);
+    createNodeResults[i] = std::visit(
+      kdl::overload(
+        [&](MapReader::EntityInfo&& entityInfo) {
+          return createNodeFromEntityInfo(entityPropertyConfig, std::move(entityInfo), mapFormat);
+        },
+        [&](MapReader::BrushInfo&& brushInfo) {
+          return createBrushNode(std::move(brushInfo), worldBounds);
+        },
+        [&](MapReader::PatchInfo&& patchInfo) {
+          return createPatchNode(std::move(patchInfo));
+        }),
+      std::move(objectInfo));
+  });
 
   return kdl::vec_transform(
     std::move(createNodeResults),
@@ -543,6 +737,28 @@ static std::vector<std::optional<NodeInfo>> createNodesFromObjectInfos(
     });
 }
 
+/**
+ * Replaces the faces of the given brush infos with the faces of the brushes that were created from
+ * them, and records the brush geometries. Brush infos for which no brush could be created are left
+ * unchanged so that they fail in the same way when they are read from the cache.
+ */
+static void cacheBrushGeometries(
+  std::vector<MapReader::ObjectInfo>& objectInfos,
+  const std::vector<std::optional<NodeInfo>>& nodeInfos) {
+  assert(objectInfos.size() == nodeInfos.size());
+
+  for (size_t i = 0u; i < objectInfos.size(); ++i) {
+    auto* brushInfo = std::get_if<MapReader::BrushInfo>(&objectInfos[i]);
+    const auto* brushNode =
+      nodeInfos[i] ? dynamic_cast<const Model::BrushNode*>(nodeInfos[i]->node.get()) : nullptr;
+    if (brushInfo && brushNode) {
+      const auto& brush = brushNode->brush();
+      brushInfo->faces = brush.faces();
+      brushInfo->geometry = brush.flattenGeometry();
+    }
+  }
+}
+
 /**
  * Validates the given node infos.
  *
@@ -697,6 +913,132 @@ static NodeToParentMap buildNodeToParentMap(
   return nodeToParentMap;
 }
 
+/**
+ * Splits the input into chunks of complete entities and parses them in parallel. The recorded
+ * object infos are appended to m_objectInfos in file order, adjusting the parent indices of brushes
+ * and patches, and the messages logged for each chunk are forwarded to the given status in the same
+ * order.
+ *
+ * Returns false if the input should be parsed on the calling thread instead, either because it is
+ * too small, because it could not be split, or because parsing a chunk failed. In the latter case,
+ * parsing the entire input again reports the error with the correct context.
+ */
+bool MapReader::parseEntitiesInParallel(ParserStatus& status) {
+  if (m_parallelChunkSize == 0 || m_str.size() <= m_parallelChunkSize) {
+    return false;
+  }
+
+  auto chunks = splitIntoEntityChunks(m_str, m_parallelChunkSize);
+  if (chunks.size() < 2) {
+    return false;
+  }
+
+  // the given status must only be used on this thread, so the progress of all chunks is summed up
+  // and reported whenever this thread has finished parsing a chunk
+  const auto callingThread = std::this_thread::get_id();
+  const auto totalSize = static_cast<double>(m_str.size());
+  auto parsedSize = std::atomic<size_t>{0};
+
+  // exceptions must not escape the worker threads, so failed chunks are returned as empty optionals
+  auto parsedChunks = kdl::vec_parallel_transform(
+    std::move(chunks), [&](MapChunk&& chunk) -> std::optional<ParsedChunk> {
+      auto chunkStatus = std::make_unique<BufferedParserStatus>(status);
+      try {
+        EntityChunkReader reader{chunk, m_sourceMapFormat, m_targetMapFormat};
+        auto objectInfos = reader.read(*chunkStatus);
+
+        const auto size = parsedSize += chunk.str.size();
+        if (std::this_thread::get_id() == callingThread) {
+          status.progress(std::min(static_cast<double>(size) / totalSize, 1.0));
+        }
+        return ParsedChunk{std::move(objectInfos), std::move(chunkStatus)};
+      } catch (const ParserException&) {
+        return std::nullopt;
+      }
+    });
+
+  if (std::any_of(
+        std::begin(parsedChunks), std::end(parsedChunks),
+        [](const std::optional<ParsedChunk>& parsedChunk) {
+          return !parsedChunk.has_value();
+        })) {
+    return false;
+  }
+
+  for (auto& parsedChunk : parsedChunks) {
+    const auto offset = m_objectInfos.size();
+    for (auto& objectInfo : parsedChunk->objectInfos) {
+      std::visit(
+        kdl::overload(
+          [](EntityInfo&) {},
+          [&](BrushInfo& brushInfo) {
+            if (brushInfo.parentIndex) {
+              *brushInfo.parentIndex += offset;
+            }
+          },
+          [&](PatchInfo& patchInfo) {
+            if (patchInfo.parentIndex) {
+              *patchInfo.parentIndex += offset;
+            }
+          }),
+        objectInfo);
+      m_objectInfos.push_back(std::move(objectInfo));
+    }
+    parsedChunk->status->flush();
+  }
+  status.progress(1.0);
+
+  return true;
+}
+
+/**
+ * Reads the object infos and the messages logged while parsing from the map cache. Returns false if
+ * the cache is not valid for the input.
+ */
+bool MapReader::readEntitiesFromCache(ParserStatus& status) {
+  assert(m_cache != nullptr);
+
+  auto contents = m_cache->read(m_sourceMapFormat, m_targetMapFormat, m_worldBounds);
+  if (!contents) {
+    return false;
+  }
+
+  auto cachedStatus = BufferedParserStatus{status, std::move(contents->messages)};
+  cachedStatus.flush();
+
+  m_objectInfos = std::move(contents->objectInfos);
+  createNodes(status);
+  return true;
+}
+
+/**
+ * Parses the input and writes the map cache. The cache records the object infos with the faces and
+ * geometries of the brushes that were created from them, so that the brush geometries need not be
+ * computed when the cache is read.
+ */
+void MapReader::readAndCacheEntities(ParserStatus& status) {
+  assert(m_cache != nullptr);
+
+  // this status is used on the calling thread only, so it can forward the progress
+  auto parserStatus = BufferedParserStatus{status, {}, true};
+  try {
+    if (!parseEntitiesInParallel(parserStatus)) {
+      parseEntities(parserStatus);
+    }
+  } catch (const ParserException&) {
+    parserStatus.flush();
+    throw;
+  }
+
+  auto contents = MapCacheContents{parserStatus.messages(), {}};
+  parserStatus.flush();
+
+  createNodes(status, &contents.objectInfos);
+  if (!m_cache->write(m_sourceMapFormat, m_targetMapFormat, m_worldBounds, contents)) {
+    status.warn("Could not write map cache file '" + m_cache->path().asString() + "'");
+  }
+}
+
 /**
  * Creates nodes from the recorded object infos and resolves parent / child relationships.
  *
@@ -713,11 +1055,21 @@ static NodeToParentMap buildNodeToParentMap(
  *
  * Nodes for which the parent node is not known (e.g. when parsing only brushes) are added to a
  * default parent, which is returned from the `onWorldNode` callback.
+ *
+ * If objectInfosToCache is not null, the brush infos in it are updated with the faces and the
+ * geometries of the created brushes.
  */
-void MapReader::createNodes(ParserStatus& status) {
-  // create nodes from the recorded object infos
+void MapReader::createNodes(ParserStatus& status, std::vector<ObjectInfo>* objectInfosToCache) {
+  // create nodes from the recorded object infos, which are only kept if they are cached
   auto nodeInfos = createNodesFromObjectInfos(
-    m_entityPropertyConfig, std::move(m_objectInfos), m_worldBounds, m_targetMapFormat, status);
+    m_entityPropertyConfig, m_objectInfos, objectInfosToCache != nullptr, m_worldBounds,
+    m_targetMapFormat, status);
+
+  if (objectInfosToCache) {
+    *objectInfosToCache = std::move(m_objectInfos);
+    cacheBrushGeometries(*objectInfosToCache, nodeInfos);
+  }
+  m_objectInfos.clear();
 
   // call onWorldNode for the first world node, remember the default parent and clear out all other
   // world nodes the brushes belonging to redundant world nodes will be added to the default parent
@@ -777,10 +1129,7 @@ void MapReader::createNodes(ParserStatus& status) {
  * Overridden in BrushFaceReader (which doesn't use m_brushInfos) to collect the faces directly
  */
 void MapReader::onBrushFace(Model::BrushFace face, ParserStatus& /* status */) {
-  assert(std::holds_alternative<BrushInfo>(m_objectInfos.back()));
-
-  BrushInfo& brush = std::get<BrushInfo>(m_objectInfos.back());
-  brush.faces.push_back(std::move(face));
+  addBrushFace(m_objectInfos, std::move(face));
 }
 } // namespace IO
 } // namespace TrenchBroom
@@ -32,6 +32,7 @@
 #include <vecmath/bbox.h>
 #include <vecmath/forward.h>
 
+#include <memory>
 #include <optional>
 #include <string_view>
 #include <variant>
@@ -51,6 +52,7 @@ class WorldNode;
 } // namespace Model
 
 namespace IO {
+class MapCache;
 class ParserStatus;
 
 /**
@@ -62,12 +64,16 @@ class ParserStatus;
  *
  * The flow of control is:
  *
- * 1. MapParser callbacks get called with the raw data, which we just store (m_objectInfos).
+ * 1. MapParser callbacks get called with the raw data, which we just store (m_objectInfos). Large
+ *    inputs are split into chunks of complete entities which are parsed in parallel.
  * 2. Convert the raw data to nodes in parallel (createNodes) and record any additional information
  *    necessary to restore the parent / child relationships.
  * 3. Validate the created nodes.
  * 4. Post process the nodes to find the correct parent nodes (createNodes).
  * 5. Call the appropriate callbacks (onWorldspawn, onLayer, ...).
+ *
+ * If a map cache is set, the object infos recorded in step 1 are read from the cache instead if it
+ * is valid, and otherwise written to it together with the created brush geometries.
  */
 class MapReader : public StandardMapParser {
 public: // only public so that helper methods can see these declarations
@@ -77,11 +83,21 @@ public: // only public so that helper methods can see these declarations
     size_t lineCount;
   };
 
+  /**
+   * The geometry of a brush as stored in a map cache, see Model::Brush::flattenGeometry.
+   */
+  using BrushGeometryInfo = Model::FlatBrushGeometry;
+
   struct BrushInfo {
     std::vector<Model::BrushFace> faces;
     size_t startLine;
     size_t lineCount;
     std::optional<size_t> parentIndex;
+    /**
+     * If set, the brush is created from this geometry instead of by clipping. The geometry's faces
+     * correspond to the brush faces by index.
+     */
+    std::optional<BrushGeometryInfo> geometry;
   };
 
   struct PatchInfo {
@@ -96,9 +112,17 @@ public: // only public so that helper methods can see these declarations
 
   using ObjectInfo = std::variant<EntityInfo, BrushInfo, PatchInfo>;
 
+  /**
+   * The default approximate size of the chunks that readEntities splits its input into.
+   */
+  static const size_t DefaultParallelChunkSize;
+
 private:
+  std::string_view m_str;
   Model::EntityPropertyConfig m_entityPropertyConfig;
   vm::bbox3 m_worldBounds;
+  size_t m_parallelChunkSize;
+  std::unique_ptr<MapCache> m_cache;
 
 private: // data populated in response to MapParser callbacks
   std::vector<ObjectInfo> m_objectInfos;
@@ -118,9 +142,32 @@ protected:
     std::string_view str, Model::MapFormat sourceMapFormat, Model::MapFormat targetMapFormat,
     const Model::EntityPropertyConfig& entityPropertyConfig);
 
+public:
+  ~MapReader() override;
+
+  /**
+   * Sets the approximate size of the chunks that readEntities splits its input into in order to
+   * parse them on multiple threads. If the input is not larger than the given size, it is parsed on
+   * the calling thread. Passing 0 disables parallel parsing.
+   */
+  void setParallelChunkSize(size_t parallelChunkSize);
+
+  /**
+   * Sets the cache to use when reading entities. If the cache is valid, the entities are read from
+   * it instead of being parsed. Otherwise, the entities are parsed and the cache is written
+   * afterwards.
+   */
+  void setCache(std::unique_ptr<MapCache> cache);
+
+protected:
   /**
    * Attempts to parse as one or more entities.
    *
+   * If the input is large enough, it is split into chunks of complete entities which are parsed in
+   * parallel. The results are then combined in file order, so that the created nodes and the logged
+   * messages are the same as if the entire input had been parsed at once. If a chunk fails to
+   * parse, the entire input is parsed again on the calling thread to report the error.
+   *
    * @throws ParserException if parsing fails
    */
   void readEntities(const vm::bbox3& worldBounds, ParserStatus& status);
@@ -157,7 +204,10 @@ protected: // implement MapParser interface
     ParserStatus& status) override;
 
 private: // helper methods
-  void createNodes(ParserStatus& status);
+  bool parseEntitiesInParallel(ParserStatus& status);
+  bool readEntitiesFromCache(ParserStatus& status);
+  void readAndCacheEntities(ParserStatus& status);
+  void createNodes(ParserStatus& status, std::vector<ObjectInfo>* objectInfosToCache = nullptr);
 
 private: // subclassing interface - these will be called in the order that nodes should be inserted
   /**
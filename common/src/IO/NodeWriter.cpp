@@ -121,8 +121,6 @@ void NodeWriter::writeCustomLayer(const Model::LayerNode* layerNode) {
 }
 
 void NodeWriter::writeNodes(const std::vector<Model::Node*>& nodes) {
-  m_serializer->beginFile(kdl::vec_element_cast<const Model::Node*>(nodes));
-
   // Assort nodes according to their type and, in case of brushes, whether they are entity or world
   // brushes.
   std::vector<Model::Node*> groups;
@@ -149,6 +147,17 @@ void NodeWriter::writeNodes(const std::vector<Model::Node*>& nodes) {
       [](Model::PatchNode*) {}));
   }
 
+  // the serializer expects the nodes in the order in which they are written
+  auto rootNodes = kdl::vec_element_cast<const Model::Node*>(worldBrushes);
+  for (const auto& [entityNode, brushes] : entityBrushes) {
+    rootNodes = kdl::vec_concat(
+      std::move(rootNodes), kdl::vec_element_cast<const Model::Node*>(brushes));
+  }
+  rootNodes = kdl::vec_concat(
+    std::move(rootNodes), kdl::vec_element_cast<const Model::Node*>(groups),
+    kdl::vec_element_cast<const Model::Node*>(entities));
+  m_serializer->beginFile(rootNodes);
+
   writeWorldBrushes(worldBrushes);
   writeEntityBrushes(entityBrushes);
 
@@ -28,6 +28,8 @@ enum class LogLevel;
 namespace IO {
 class ParserStatus {
 private:
+  friend class BufferedParserStatus;
+
   Logger& m_logger;
   std::string m_prefix;
 
@@ -22,6 +22,7 @@
 #include "IO/ParserStatus.h"
 #include "Model/BrushFace.h"
 #include "Model/EntityProperties.h"
+#include "Sse2.h"
 
 #include <kdl/invoke.h>
 #include <kdl/vector_set.h>
@@ -29,18 +30,172 @@
 #include <vecmath/plane.h>
 #include <vecmath/vec.h>
 
+#include <array>
+#include <cassert>
 #include <string>
+#include <tuple>
 #include <vector>
 
+#if defined(TB_SSE2) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 namespace TrenchBroom {
 namespace IO {
-const std::string& QuakeMapTokenizer::NumberDelim() {
-  static const std::string numberDelim(Whitespace() + ")");
-  return numberDelim;
+namespace {
+namespace CharClass {
+using Type = unsigned char;
+constexpr Type Blank = 1 << 0;       // space or tab
+constexpr Type LineBreak = 1 << 1;   // line feed or carriage return
+constexpr Type Digit = 1 << 2;       // 0-9
+constexpr Type Sign = 1 << 3;        // + or -
+constexpr Type NumberDelim = 1 << 4; // whitespace or closing parenthesis
+constexpr Type Whitespace = Blank | LineBreak;
+} // namespace CharClass
+
+constexpr auto CharClasses = []() {
+  auto result = std::array<CharClass::Type, 256>{};
+  result[static_cast<unsigned char>(' ')] = CharClass::Blank | CharClass::NumberDelim;
+  result[static_cast<unsigned char>('\t')] = CharClass::Blank | CharClass::NumberDelim;
+  result[static_cast<unsigned char>('\n')] = CharClass::LineBreak | CharClass::NumberDelim;
+  result[static_cast<unsigned char>('\r')] = CharClass::LineBreak | CharClass::NumberDelim;
+  result[static_cast<unsigned char>(')')] = CharClass::NumberDelim;
+  result[static_cast<unsigned char>('+')] = CharClass::Sign;
+  result[static_cast<unsigned char>('-')] = CharClass::Sign;
+  for (auto c = '0'; c <= '9'; ++c) {
+    result[static_cast<unsigned char>(c)] = CharClass::Digit;
+  }
+  return result;
+}();
+
+bool hasCharClass(const char c, const CharClass::Type charClass) {
+  return (CharClasses[static_cast<unsigned char>(c)] & charClass) != 0;
+}
+
+#ifdef TB_SSE2
+size_t findFirstSetBit(const unsigned int mask) {
+  assert(mask != 0u);
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return static_cast<size_t>(index);
+#else
+  return static_cast<size_t>(__builtin_ctz(mask));
+#endif
 }
+#endif
+
+/**
+ * Returns a pointer to the first character in [cur, end) that is neither a space nor a tab.
+ */
+const char* findNonBlank(const char* cur, const char* end) {
+  // most runs of blanks are a single space, so check the first character before using SIMD
+  if (cur == end || !hasCharClass(*cur, CharClass::Blank)) {
+    return cur;
+  }
 
-QuakeMapTokenizer::QuakeMapTokenizer(std::string_view str)
-  : Tokenizer(std::move(str), "\"", '\\')
+#ifdef TB_SSE2
+  const auto spaces = _mm_set1_epi8(' ');
+  const auto tabs = _mm_set1_epi8('\t');
+  while (end - cur >= 16) {
+    const auto chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur));
+    const auto blanks = _mm_or_si128(_mm_cmpeq_epi8(chars, spaces), _mm_cmpeq_epi8(chars, tabs));
+    const auto mask = static_cast<unsigned int>(_mm_movemask_epi8(blanks));
+    if (mask != 0xFFFFu) {
+      return cur + findFirstSetBit(~mask & 0xFFFFu);
+    }
+    cur += 16;
+  }
+#endif
+
+  while (cur < end && hasCharClass(*cur, CharClass::Blank)) {
+    ++cur;
+  }
+  return cur;
+}
+
+/**
+ * Returns a pointer to the first line feed or carriage return in [cur, end), or end if there is
+ * none.
+ */
+const char* findLineBreak(const char* cur, const char* end) {
+#ifdef TB_SSE2
+  const auto lineFeeds = _mm_set1_epi8('\n');
+  const auto carriageReturns = _mm_set1_epi8('\r');
+  while (end - cur >= 16) {
+    const auto chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur));
+    const auto lineBreaks =
+      _mm_or_si128(_mm_cmpeq_epi8(chars, lineFeeds), _mm_cmpeq_epi8(chars, carriageReturns));
+    const auto mask = static_cast<unsigned int>(_mm_movemask_epi8(lineBreaks));
+    if (mask != 0u) {
+      return cur + findFirstSetBit(mask);
+    }
+    cur += 16;
+  }
+#endif
+
+  while (cur < end && !hasCharClass(*cur, CharClass::LineBreak)) {
+    ++cur;
+  }
+  return cur;
+}
+
+const char* skipDigits(const char* cur, const char* end) {
+  while (cur < end && hasCharClass(*cur, CharClass::Digit)) {
+    ++cur;
+  }
+  return cur;
+}
+
+bool isNumberEnd(const char* cur, const char* end) {
+  return cur == end || hasCharClass(*cur, CharClass::NumberDelim);
+}
+
+/**
+ * Scans the integer, decimal or word that begins at the given position and returns its type and
+ * end. Accepts the same integers and decimals as Tokenizer::readInteger and Tokenizer::readDecimal,
+ * and words end at the first whitespace character like with Tokenizer::readUntil.
+ */
+std::tuple<QuakeMapToken::Type, const char*> scanNumberOrWord(const char* begin, const char* end) {
+  assert(begin < end);
+
+  if (hasCharClass(*begin, CharClass::Sign | CharClass::Digit)) {
+    const auto* cur = skipDigits(begin + 1, end);
+    if (isNumberEnd(cur, end)) {
+      return {QuakeMapToken::Integer, cur};
+    }
+  }
+
+  if (hasCharClass(*begin, CharClass::Sign | CharClass::Digit) || *begin == '.') {
+    const auto* cur = begin;
+    if (*cur != '.') {
+      cur = skipDigits(cur + 1, end);
+    }
+    if (cur < end && *cur == '.') {
+      cur = skipDigits(cur + 1, end);
+    }
+    if (cur < end && *cur == 'e') {
+      ++cur;
+      if (cur < end && hasCharClass(*cur, CharClass::Sign | CharClass::Digit)) {
+        cur = skipDigits(cur + 1, end);
+      }
+    }
+    if (isNumberEnd(cur, end)) {
+      return {QuakeMapToken::Decimal, cur};
+    }
+  }
+
+  const auto* cur = begin + 1;
+  while (cur < end && !hasCharClass(*cur, CharClass::Whitespace)) {
+    ++cur;
+  }
+  return {QuakeMapToken::String, cur};
+}
+} // namespace
+
+QuakeMapTokenizer::QuakeMapTokenizer(
+  std::string_view str, const size_t line, const size_t column)
+  : Tokenizer(std::move(str), "\"", '\\', line, column)
   , m_skipEol(true) {}
 
 void QuakeMapTokenizer::setSkipEol(bool skipEol) {
@@ -61,14 +216,14 @@ QuakeMapTokenizer::Token QuakeMapTokenizer::emitToken() {
             advance();
             return Token(QuakeMapToken::Comment, c, c + 3, offset(c), startLine, startColumn);
           }
-          discardUntil("\n\r");
+          discardUntilLineBreak();
         }
         break;
       case ';':
         // Heretic2 allows semicolon to start a line comment.
         // QuArK writes comments in this format when saving a Heretic2 .map.
         advance();
-        discardUntil("\n\r");
+        discardUntilLineBreak();
         break;
       case '{':
         advance();
@@ -109,30 +264,156 @@ QuakeMapTokenizer::Token QuakeMapTokenizer::emitToken() {
         switchFallthrough();
       case ' ':
       case '\t':
-        discardWhile(Whitespace());
+        discardWhitespace();
         break;
-      default: { // whitespace, integer, decimal or word
-        const auto* e = readInteger(NumberDelim());
-        if (e != nullptr) {
-          return Token(QuakeMapToken::Integer, c, e, offset(c), startLine, startColumn);
-        }
+      default: { // integer, decimal or word
+        // numbers and words never contain line breaks
+        const auto [type, e] = scanNumberOrWord(c, m_end);
+        advanceWithinLine(static_cast<size_t>(e - c));
+        return Token(type, c, e, offset(c), startLine, startColumn);
+      }
+    }
+  }
+  return Token(QuakeMapToken::Eof, nullptr, nullptr, length(), line(), column());
+}
 
-        e = readDecimal(NumberDelim());
-        if (e != nullptr) {
-          return Token(QuakeMapToken::Decimal, c, e, offset(c), startLine, startColumn);
-        }
+void QuakeMapTokenizer::discardWhitespace() {
+  while (!eof()) {
+    const auto* blankEnd = findNonBlank(curPos(), m_end);
+    advanceWithinLine(static_cast<size_t>(blankEnd - curPos()));
+    if (eof() || !hasCharClass(curChar(), CharClass::LineBreak)) {
+      break;
+    }
+    advance();
+  }
+}
 
-        e = readUntil(Whitespace());
-        if (e == nullptr) {
-          throw ParserException(
-            startLine, startColumn, "Unexpected character: " + std::string(c, 1));
-        }
+void QuakeMapTokenizer::discardUntilLineBreak() {
+  const auto* lineBreak = findLineBreak(curPos(), m_end);
+  advanceWithinLine(static_cast<size_t>(lineBreak - curPos()));
+}
 
-        return Token(QuakeMapToken::String, c, e, offset(c), startLine, startColumn);
+std::vector<MapChunk> splitIntoEntityChunks(const std::string_view str, const size_t minChunkSize) {
+  auto result = std::vector<MapChunk>{};
+
+  const char* cur = str.data();
+  const char* end = str.data() + str.size();
+
+  // line and column counting must match TokenizerBase::advance
+  size_t line = 1;
+  const char* lineBegin = cur;
+
+  const auto advance = [&]() {
+    if (*cur == '\n' || (*cur == '\r' && (cur + 1 == end || *(cur + 1) != '\n'))) {
+      ++line;
+      lineBegin = cur + 1;
+    }
+    ++cur;
+  };
+
+  const auto discardUntilEol = [&]() {
+    while (cur < end && *cur != '\n' && *cur != '\r') {
+      advance();
+    }
+  };
+
+  const auto discardWord = [&]() {
+    while (cur < end && !hasCharClass(*cur, CharClass::Whitespace)) {
+      advance();
+    }
+  };
+
+  const char* chunkBegin = cur;
+  size_t chunkLine = 1;
+  size_t chunkColumn = 1;
+  size_t depth = 0;
+
+  while (cur < end) {
+    switch (*cur) {
+      case ' ':
+      case '\t':
+      case '\n':
+      case '\r':
+      case '(':
+      case ')':
+      case '[':
+      case ']':
+        advance();
+        break;
+      case '/':
+        // see QuakeMapTokenizer::emitToken: "/// " is a comment token, other comments are discarded
+        advance();
+        if (cur < end && *cur == '/') {
+          advance();
+          if (cur + 1 < end && *cur == '/' && *(cur + 1) == ' ') {
+            advance();
+          } else {
+            discardUntilEol();
+          }
+        }
+        break;
+      case ';':
+        discardUntilEol();
+        break;
+      case '"': {
+        advance();
+        auto escaped = false;
+        while (cur < end && (*cur != '"' || escaped)) {
+          // see the hack for trailing backslashes in Tokenizer::readQuotedString
+          if (*cur == '"' && cur + 1 < end && (*(cur + 1) == '\n' || *(cur + 1) == '}')) {
+            break;
+          }
+          escaped = *cur == '\\' ? !escaped : false;
+          advance();
+        }
+        if (cur == end) {
+          return {};
+        }
+        advance();
+        break;
       }
+      case '{':
+        advance();
+        if (
+          cur == end || hasCharClass(*cur, CharClass::Whitespace) || *cur == '{' ||
+          *cur == '}' || *cur == '(' || *cur == '"' || *cur == '/') {
+          ++depth;
+        } else {
+          // a word that begins with a brace, e.g. a Half-Life texture name such as {BLUE
+          discardWord();
+        }
+        break;
+      case '}':
+        advance();
+        if (depth == 0) {
+          return {};
+        }
+        if (--depth == 0 && static_cast<size_t>(cur - chunkBegin) >= minChunkSize) {
+          result.push_back(MapChunk{
+            std::string_view{chunkBegin, static_cast<size_t>(cur - chunkBegin)}, chunkLine,
+            chunkColumn});
+          chunkBegin = cur;
+          chunkLine = line;
+          chunkColumn = static_cast<size_t>(cur - lineBegin) + 1u;
+        }
+        break;
+      default:
+        discardWord();
+        break;
     }
   }
-  return Token(QuakeMapToken::Eof, nullptr, nullptr, length(), line(), column());
+
+  if (depth != 0) {
+    return {};
+  }
+
+  if (chunkBegin < end) {
+    result.push_back(MapChunk{
+      std::string_view{chunkBegin, static_cast<size_t>(end - chunkBegin)}, chunkLine,
+      chunkColumn});
+  }
+
+  return result;
 }
 
 const std::string StandardMapParser::BrushPrimitiveId = "brushDef";
@@ -141,7 +422,12 @@ const std::string StandardMapParser::PatchId = "patchDef2";
 StandardMapParser::StandardMapParser(
   std::string_view str, const Model::MapFormat sourceMapFormat,
   const Model::MapFormat targetMapFormat)
-  : m_tokenizer(QuakeMapTokenizer(std::move(str)))
+  : StandardMapParser(MapChunk{str, 1u, 1u}, sourceMapFormat, targetMapFormat) {}
+
+StandardMapParser::StandardMapParser(
+  const MapChunk& chunk, const Model::MapFormat sourceMapFormat,
+  const Model::MapFormat targetMapFormat)
+  : m_tokenizer(QuakeMapTokenizer(chunk.str, chunk.line, chunk.column))
   , m_sourceMapFormat(sourceMapFormat)
   , m_targetMapFormat(targetMapFormat) {
   assert(m_sourceMapFormat != Model::MapFormat::Unknown);
@@ -155,6 +441,7 @@ void StandardMapParser::parseEntities(ParserStatus& status) {
   while (token.type() != QuakeMapToken::Eof) {
     expect(QuakeMapToken::OBrace, token);
     parseEntity(status);
+    status.progress(m_tokenizer.progress());
     token = m_tokenizer.peekToken();
   }
 }
@@ -54,20 +54,55 @@ static const Type Eol = 1 << 11;         // end of line
 static const Type Number = Integer | Decimal;
 } // namespace QuakeMapToken
 
+/**
+ * Tokenizer for Quake map files.
+ *
+ * Since map files can be very large, this tokenizer does not use the generic character matching
+ * functions of Tokenizer. Instead, it classifies characters using a lookup table, skips runs of
+ * whitespace and comments using SIMD instructions where available, and scans numbers and words in
+ * a single pass before advancing over them at once.
+ */
 class QuakeMapTokenizer : public Tokenizer<QuakeMapToken::Type> {
 private:
-  static const std::string& NumberDelim();
   bool m_skipEol;
 
 public:
-  explicit QuakeMapTokenizer(std::string_view str);
+  explicit QuakeMapTokenizer(std::string_view str, size_t line = 1, size_t column = 1);
 
   void setSkipEol(bool skipEol);
 
 private:
   Token emitToken() override;
+
+  void discardWhitespace();
+  void discardUntilLineBreak();
 };
 
+/**
+ * A part of a map file that consists of complete top level entities.
+ */
+struct MapChunk {
+  std::string_view str;
+  size_t line;
+  size_t column;
+};
+
+/**
+ * Splits the given map file into chunks of complete top level entities so that the chunks can be
+ * parsed independently of each other. Each chunk except for the last one has at least the given
+ * size. The chunks are returned in file order and cover the entire string.
+ *
+ * Entity boundaries are found by tracking the brace depth, skipping quoted strings, comments and
+ * words such as texture names that begin with a brace. Returns an empty vector if the braces or
+ * quotes in the given string are unbalanced; such a file must be parsed in one piece to report the
+ * error.
+ *
+ * @param str the map file to split
+ * @param minChunkSize the minimum size of each chunk in bytes
+ * @return the chunks
+ */
+std::vector<MapChunk> splitIntoEntityChunks(std::string_view str, size_t minChunkSize);
+
 class StandardMapParser : public MapParser, public Parser<QuakeMapToken::Type> {
 private:
   using Token = QuakeMapTokenizer::Token;
@@ -94,6 +129,17 @@ public:
   StandardMapParser(
     std::string_view str, Model::MapFormat sourceMapFormat, Model::MapFormat targetMapFormat);
 
+  /**
+   * Creates a new parser for the given chunk of a map file. The positions of the parsed objects are
+   * reported relative to the start of the file the chunk was taken from.
+   *
+   * @param chunk the chunk to parse
+   * @param sourceMapFormat the expected format of the given chunk
+   * @param targetMapFormat the format to convert the created objects to
+   */
+  StandardMapParser(
+    const MapChunk& chunk, Model::MapFormat sourceMapFormat, Model::MapFormat targetMapFormat);
+
   ~StandardMapParser() override;
 
 protected:
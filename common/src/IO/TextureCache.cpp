@@ -0,0 +1,347 @@
+/*
+ Copyright (C) 2023 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TextureCache.h"
+
+#include "Assets/Texture.h"
+#include "Assets/TextureBuffer.h"
+#include "Color.h"
+#include "Exceptions.h"
+#include "IO/DiskIO.h"
+#include "IO/File.h"
+#include "IO/IOUtils.h"
+#include "IO/PathQt.h"
+#include "IO/Reader.h"
+
+#include <vecmath/vec.h>
+
+#include <sstream>
+#include <string>
+#include <variant>
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+
+namespace TrenchBroom {
+namespace IO {
+namespace {
+const char Magic[] = {'T', 'B', 'T', 'E', 'X', 'C', 'A', '\0'};
+// version 2: textures read by FreeImage have a full mip chain
+const std::uint32_t Version = 2;
+
+std::uint64_t hashString(const std::string& str) {
+  // FNV-1a
+  const std::uint64_t prime = 0x100000001b3ull;
+  std::uint64_t hash = 0xcbf29ce484222325ull;
+  for (const auto c : str) {
+    hash = (hash ^ static_cast<unsigned char>(c)) * prime;
+  }
+  return hash;
+}
+
+template <typename T> void writeValue(std::ostream& stream, const T value) {
+  stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void writeSize(std::ostream& stream, const size_t value) {
+  writeValue(stream, static_cast<std::uint64_t>(value));
+}
+
+void writeString(std::ostream& stream, const std::string& str) {
+  writeSize(stream, str.size());
+  stream.write(str.data(), static_cast<std::streamsize>(str.size()));
+}
+
+size_t readSize(Reader& reader) {
+  return static_cast<size_t>(reader.read<std::uint64_t, std::uint64_t>());
+}
+
+/**
+ * Reads a size and checks that the remaining input holds at least that many bytes.
+ */
+size_t readLength(Reader& reader) {
+  const auto length = readSize(reader);
+  if (!reader.canRead(length)) {
+    throw ReaderException{"Invalid length"};
+  }
+  return length;
+}
+
+std::string readString(Reader& reader) {
+  return reader.readString(readLength(reader));
+}
+
+void writeKey(std::ostream& stream, const TextureCacheKey& key) {
+  writeString(stream, key.sourcePath);
+  writeString(stream, key.entryName);
+  writeValue(stream, key.entrySize);
+  writeValue(stream, key.modificationTime);
+}
+
+TextureCacheKey readKey(Reader& reader) {
+  auto key = TextureCacheKey{};
+  key.sourcePath = readString(reader);
+  key.entryName = readString(reader);
+  key.entrySize = reader.read<std::uint64_t, std::uint64_t>();
+  key.modificationTime = reader.read<std::int64_t, std::int64_t>();
+  return key;
+}
+
+void writeTextureData(std::ostream& stream, const Assets::Texture& texture) {
+  writeString(stream, texture.name());
+  writeSize(stream, texture.width());
+  writeSize(stream, texture.height());
+  for (size_t i = 0; i < 4; ++i) {
+    writeValue(stream, texture.averageColor()[i]);
+  }
+  writeValue(stream, static_cast<std::uint32_t>(texture.format()));
+  writeValue(stream, static_cast<std::uint8_t>(texture.type()));
+
+  if (const auto* q2Data = std::get_if<Assets::Q2Data>(&texture.gameData())) {
+    writeValue(stream, std::uint8_t(1));
+    writeValue(stream, static_cast<std::int32_t>(q2Data->flags));
+    writeValue(stream, static_cast<std::int32_t>(q2Data->contents));
+    writeValue(stream, static_cast<std::int32_t>(q2Data->value));
+  } else {
+    writeValue(stream, std::uint8_t(0));
+  }
+
+  const auto& buffers = texture.buffersIfUnprepared();
+  writeSize(stream, buffers.size());
+  for (const auto& buffer : buffers) {
+    writeSize(stream, buffer.size());
+    stream.write(
+      reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+  }
+}
+
+Assets::Texture readTextureData(Reader& reader) {
+  auto name = readString(reader);
+  const auto width = readSize(reader);
+  const auto height = readSize(reader);
+  auto averageColor = Color{};
+  for (size_t i = 0; i < 4; ++i) {
+    averageColor[i] = reader.read<float, float>();
+  }
+
+  const auto format = static_cast<GLenum>(reader.read<std::uint32_t, std::uint32_t>());
+  if (format != GL_RGB && format != GL_BGR && format != GL_RGBA && format != GL_BGRA) {
+    throw ReaderException{"Invalid texture format"};
+  }
+  const auto type = reader.read<std::uint8_t, std::uint8_t>() != 0u
+                      ? Assets::TextureType::Masked
+                      : Assets::TextureType::Opaque;
+
+  auto gameData = Assets::GameData{};
+  if (reader.read<std::uint8_t, std::uint8_t>() != 0u) {
+    const auto flags = reader.read<std::int32_t, int>();
+    const auto contents = reader.read<std::int32_t, int>();
+    const auto value = reader.read<std::int32_t, int>();
+    gameData = Assets::Q2Data{flags, contents, value};
+  }
+
+  if (width == 0u || height == 0u) {
+    throw ReaderException{"Invalid texture size"};
+  }
+
+  const auto bytesPerPixel = Assets::bytesPerPixelForFormat(format);
+  const auto bufferCount = readSize(reader);
+  // a texture cannot have more mip levels than its size has bits
+  if (bufferCount > 8u * sizeof(size_t) || !reader.canRead(bufferCount * sizeof(std::uint64_t))) {
+    throw ReaderException{"Invalid buffer count"};
+  }
+
+  auto buffers = Assets::TextureBufferList{};
+  buffers.reserve(bufferCount);
+  for (size_t level = 0; level < bufferCount; ++level) {
+    const auto size = readLength(reader);
+    const auto mipSize = Assets::sizeAtMipLevel(width, height, level);
+    if (size < bytesPerPixel * mipSize.x() * mipSize.y()) {
+      throw ReaderException{"Invalid buffer size"};
+    }
+
+    auto& buffer = buffers.emplace_back(size);
+    reader.read(buffer.data(), size);
+  }
+
+  return Assets::Texture{
+    std::move(name), width, height, averageColor, std::move(buffers), format, type,
+    std::move(gameData)};
+}
+} // namespace
+
+std::optional<TextureCacheKey> TextureCacheKey::forFile(
+  const Path& sourcePath, const Path& entryPath, const size_t entrySize) {
+  if (sourcePath.isEmpty()) {
+    return std::nullopt;
+  }
+
+  const auto fileInfo = QFileInfo{pathAsQString(sourcePath)};
+  if (!fileInfo.isFile()) {
+    return std::nullopt;
+  }
+
+  return TextureCacheKey{
+    sourcePath.asString("/"),
+    entryPath.asString("/"),
+    static_cast<std::uint64_t>(entrySize),
+    static_cast<std::int64_t>(fileInfo.lastModified().toMSecsSinceEpoch())};
+}
+
+bool operator==(const TextureCacheKey& lhs, const TextureCacheKey& rhs) {
+  return lhs.sourcePath == rhs.sourcePath && lhs.entryName == rhs.entryName &&
+         lhs.entrySize == rhs.entrySize && lhs.modificationTime == rhs.modificationTime;
+}
+
+bool operator!=(const TextureCacheKey& lhs, const TextureCacheKey& rhs) {
+  return !(lhs == rhs);
+}
+
+const std::string TextureCache::FileExtension = "tbtex";
+
+TextureCache TextureCache::forCollection(
+  const Path& cacheDirectory, const Path& collectionPath, const std::string& context) {
+  // the collection path is part of the context so that hash collisions are detected
+  auto fullContext = collectionPath.asString("/") + "\n" + context;
+
+  auto fileName = std::stringstream{};
+  fileName << std::hex << hashString(fullContext) << "." << FileExtension;
+  return TextureCache{cacheDirectory + Path{fileName.str()}, std::move(fullContext)};
+}
+
+TextureCache::TextureCache(Path path, std::string context)
+  : m_path{std::move(path)}
+  , m_context{std::move(context)} {}
+
+const Path& TextureCache::path() const {
+  return m_path;
+}
+
+const std::string& TextureCache::context() const {
+  return m_context;
+}
+
+bool TextureCache::load() {
+  unload();
+  if (!Disk::fileExists(m_path)) {
+    return false;
+  }
+
+  try {
+    m_file = Disk::openFile(m_path);
+    auto reader = m_file->reader();
+
+    for (const auto c : Magic) {
+      if (reader.readChar<char>() != c) {
+        unload();
+        return false;
+      }
+    }
+    if (reader.readUnsignedInt<std::uint32_t>() != Version || readString(reader) != m_context) {
+      unload();
+      return false;
+    }
+
+    const auto entryCount = readSize(reader);
+    for (size_t i = 0; i < entryCount; ++i) {
+      auto key = readKey(reader);
+      const auto length = readLength(reader);
+      const auto offset = reader.position();
+      reader.seekForward(length);
+
+      auto entryName = key.entryName;
+      m_entries.emplace(std::move(entryName), Entry{std::move(key), offset, length});
+    }
+    return true;
+  } catch (const Exception&) {
+    unload();
+    return false;
+  }
+}
+
+void TextureCache::unload() {
+  m_entries.clear();
+  m_file.reset();
+}
+
+size_t TextureCache::size() const {
+  return m_entries.size();
+}
+
+std::optional<Assets::Texture> TextureCache::readTexture(const TextureCacheKey& key) const {
+  const auto it = m_entries.find(key.entryName);
+  if (it == m_entries.end() || it->second.key != key) {
+    return std::nullopt;
+  }
+
+  try {
+    const auto& entry = it->second;
+    auto reader = m_file->reader().subReaderFromBegin(entry.offset, entry.length);
+    return readTextureData(reader);
+  } catch (const Exception&) {
+    return std::nullopt;
+  }
+}
+
+bool TextureCache::write(std::vector<std::pair<TextureCacheKey, Assets::Texture>> textures) const {
+  return writeFileAtomically(m_path, [&](std::ostream& stream) {
+    for (const auto c : Magic) {
+      writeValue(stream, c);
+    }
+    writeValue(stream, Version);
+    writeString(stream, m_context);
+
+    writeSize(stream, textures.size());
+    for (auto& [key, texture] : textures) {
+      writeKey(stream, key);
+
+      // write a placeholder for the length of the texture data and fill it in afterwards
+      const auto lengthPosition = stream.tellp();
+      writeSize(stream, 0u);
+      writeTextureData(stream, texture);
+      const auto endPosition = stream.tellp();
+
+      stream.seekp(lengthPosition);
+      writeSize(stream, static_cast<size_t>(endPosition - lengthPosition) - sizeof(std::uint64_t));
+      stream.seekp(endPosition);
+
+      texture.releaseBuffers();
+    }
+  });
+}
+
+void TextureCache::prune(const Path& cacheDirectory, const size_t maxSize) {
+  const auto dir = QDir{pathAsQString(cacheDirectory)};
+  const auto files = dir.entryInfoList(
+    QStringList{QString::fromStdString("*." + FileExtension)}, QDir::Files, QDir::Time);
+
+  // the files are sorted by their modification time, the most recently written file first
+  auto size = size_t(0);
+  for (int i = 0; i < files.size(); ++i) {
+    size += static_cast<size_t>(files[i].size());
+    if (i > 0 && size > maxSize) {
+      QFile::remove(files[i].absoluteFilePath());
+    }
+  }
+}
+} // namespace IO
+} // namespace TrenchBroom
@@ -0,0 +1,142 @@
+/*
+ Copyright (C) 2023 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "IO/Path.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace TrenchBroom {
+namespace Assets {
+class Texture;
+}
+
+namespace IO {
+class File;
+
+/**
+ * Identifies the source of a cached texture: the path of the source file on the disk, the texture
+ * file's path within its source, the size of the texture file, and the modification time of the
+ * source file. The source file is either the texture file itself or the archive that contains it.
+ */
+struct TextureCacheKey {
+  std::string sourcePath;
+  std::string entryName;
+  std::uint64_t entrySize;
+  std::int64_t modificationTime;
+
+  /**
+   * Creates the key for a texture file of the given size which is read from the given source file.
+   * Returns an empty optional if the source file does not exist on the disk.
+   */
+  static std::optional<TextureCacheKey> forFile(
+    const Path& sourcePath, const Path& entryPath, size_t entrySize);
+
+  friend bool operator==(const TextureCacheKey& lhs, const TextureCacheKey& rhs);
+  friend bool operator!=(const TextureCacheKey& lhs, const TextureCacheKey& rhs);
+};
+
+/**
+ * A binary file in a cache directory that stores the decoded textures of a texture collection so
+ * that the collection can be loaded again without decoding its texture files.
+ *
+ * Every cached texture is stored with the key of the file it was decoded from, and it is only used
+ * if that key still matches. The cache file is also tied to the collection path and to a context
+ * string that identifies the settings the textures were decoded with, e.g. the texture format and
+ * the palette. If the cache file cannot be read, it is ignored.
+ *
+ * Once loaded, the cache file remains mapped into memory until the cache is unloaded, and cached
+ * textures are copied directly from the mapped memory. Reading textures is thread safe.
+ */
+class TextureCache {
+public:
+  static const std::string FileExtension;
+
+private:
+  struct Entry {
+    TextureCacheKey key;
+    size_t offset;
+    size_t length;
+  };
+
+  Path m_path;
+  std::string m_context;
+  std::shared_ptr<File> m_file;
+  std::unordered_map<std::string, Entry> m_entries;
+
+public:
+  /**
+   * Creates a cache for the given texture collection which is stored in the given directory.
+   */
+  static TextureCache forCollection(
+    const Path& cacheDirectory, const Path& collectionPath, const std::string& context);
+
+  TextureCache(Path path, std::string context);
+
+  const Path& path() const;
+  const std::string& context() const;
+
+  /**
+   * Maps the cache file into memory and reads its index. Returns false if the cache file does not
+   * exist or is not valid for the context of this cache, in which case the cache is empty.
+   */
+  bool load();
+
+  /**
+   * Releases the cache file. Must be called before the cache file is written, because a file that
+   * is mapped into memory cannot be replaced on all platforms.
+   */
+  void unload();
+
+  /**
+   * Returns the number of textures in the loaded cache file.
+   */
+  size_t size() const;
+
+  /**
+   * Returns the cached texture for the given key, or an empty optional if there is no texture with
+   * a matching key or if it cannot be read.
+   */
+  std::optional<Assets::Texture> readTexture(const TextureCacheKey& key) const;
+
+  /**
+   * Replaces the cache file with a file that stores the given textures, which must hold their
+   * buffers. The textures are written to the disk one after another, and the buffers of each
+   * texture are released as soon as it has been written.
+   *
+   * The file is replaced atomically, so other instances that have mapped the cache file into memory
+   * keep reading the old file. Returns false if the file could not be written.
+   */
+  bool write(std::vector<std::pair<TextureCacheKey, Assets::Texture>> textures) const;
+
+  /**
+   * Deletes the least recently written cache files in the given directory until the remaining files
+   * take up at most the given number of bytes. The most recently written file is always kept.
+   */
+  static void prune(const Path& cacheDirectory, size_t maxSize);
+};
+} // namespace IO
+} // namespace TrenchBroom
@@ -19,16 +19,29 @@
 
 #include "TextureCollectionLoader.h"
 
+#include "Assets/Texture.h"
+#include "Assets/TextureBuffer.h"
 #include "Assets/TextureCollection.h"
+#include "Exceptions.h"
 #include "IO/DiskIO.h"
 #include "IO/File.h"
 #include "IO/FileMatcher.h"
 #include "IO/FileSystem.h"
+#include "IO/TextureCache.h"
 #include "IO/TextureReader.h"
 #include "IO/WadFileSystem.h"
 #include "Logger.h"
 
+#include <kdl/parallel.h>
+#include <kdl/thread_pool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <functional>
 #include <memory>
+#include <optional>
+#include <utility>
 #include <vector>
 
 namespace TrenchBroom {
@@ -40,6 +53,11 @@ TextureCollectionLoader::TextureCollectionLoader(
 
 TextureCollectionLoader::~TextureCollectionLoader() = default;
 
+void TextureCollectionLoader::setCacheDirectory(const Path& cacheDirectory, std::string context) {
+  m_cacheDirectory = cacheDirectory;
+  m_cacheContext = std::move(context);
+}
+
 bool TextureCollectionLoader::shouldExclude(const std::string& textureName) {
   for (const auto& pattern : m_textureExclusions) {
     if (kdl::ci::str_matches_glob(textureName, pattern)) {
@@ -49,6 +67,165 @@ bool TextureCollectionLoader::shouldExclude(const std::string& textureName) {
   return false;
 }
 
+namespace {
+// the cache directory is pruned to this size whenever a cache file was written
+constexpr size_t MaxCacheDirectorySize = size_t(1) << 30;
+} // namespace
+
+/**
+ * Cache files are written one after another on a background thread. Pending writes are finished
+ * when the application exits.
+ */
+static kdl::thread_pool& cacheWriter() {
+  static auto pool = kdl::thread_pool{1u};
+  return pool;
+}
+
+static Assets::TextureBufferLoader makeBufferLoader(
+  std::function<std::shared_ptr<File>()> openFile,
+  std::shared_ptr<const TextureReader> textureReader, const Assets::Texture& texture) {
+  return [openFile = std::move(openFile),
+          textureReader = std::move(textureReader),
+          width = texture.width(),
+          height = texture.height(),
+          format = texture.format()]() {
+    try {
+      auto reloaded = textureReader->readTexture(openFile());
+      // if the texture cannot be read anymore, the reader returns a default texture instead
+      if (reloaded.width() != width || reloaded.height() != height || reloaded.format() != format) {
+        return Assets::TextureBufferList{};
+      }
+      return reloaded.releaseBuffers();
+    } catch (const Exception&) {
+      // the file has been removed or changed since the collection was loaded
+      return Assets::TextureBufferList{};
+    }
+  };
+}
+
+/**
+ * Files on the disk are reopened by their absolute path. Files in archives have no absolute path,
+ * but they do not hold a file descriptor of their own either, so they are kept.
+ */
+static std::function<std::shared_ptr<File>()> makeFileOpener(
+  const Path& absolutePath, std::shared_ptr<File> file) {
+  if (!absolutePath.isEmpty()) {
+    return [absolutePath]() {
+      return Disk::openFile(absolutePath);
+    };
+  }
+  return [file = std::move(file)]() {
+    return file;
+  };
+}
+
+/**
+ * The entries of a WAD file are views of the WAD file, so they are reopened by mapping the WAD file
+ * again. The mapping is released once the entry has been read.
+ */
+static std::function<std::shared_ptr<File>()> makeWadEntryOpener(
+  const Path& wadPath, std::shared_ptr<File> file) {
+  if (const auto* fileView = dynamic_cast<const FileView*>(file.get())) {
+    return [wadPath, path = file->path(), offset = fileView->offset(), length = file->size()]() {
+      return std::make_shared<FileView>(path, Disk::openFile(wadPath), offset, length);
+    };
+  }
+  return [file = std::move(file)]() {
+    return file;
+  };
+}
+
+/**
+ * Returns a copy of the given texture for writing it to a cache file. The buffers are copied
+ * because the texture still needs them for the upload.
+ */
+static Assets::Texture makeCacheEntry(const Assets::Texture& texture) {
+  auto buffers = Assets::TextureBufferList{};
+  for (const auto& buffer : texture.buffersIfUnprepared()) {
+    auto& copy = buffers.emplace_back(buffer.size());
+    std::copy_n(buffer.data(), buffer.size(), copy.data());
+  }
+
+  return Assets::Texture{
+    texture.name(), texture.width(), texture.height(), texture.averageColor(), std::move(buffers),
+    texture.format(), texture.type(), texture.gameData()};
+}
+
+std::vector<std::optional<Assets::Texture>> TextureCollectionLoader::readTextures(
+  const Path& collectionPath, FileList files, const std::vector<Path>& sourcePaths,
+  const std::shared_ptr<const TextureReader>& textureReader,
+  std::vector<FileOpener> fileOpeners) {
+  assert(files.size() == sourcePaths.size());
+  assert(fileOpeners.empty() || fileOpeners.size() == files.size());
+
+  const auto lazy = !fileOpeners.empty();
+  auto cache = std::optional<TextureCache>{};
+  auto cacheKeys = std::vector<std::optional<TextureCacheKey>>(files.size());
+  if (!m_cacheDirectory.isEmpty()) {
+    cache = TextureCache::forCollection(m_cacheDirectory, collectionPath, m_cacheContext);
+    cache->load();
+    for (size_t i = 0; i < files.size(); ++i) {
+      cacheKeys[i] = TextureCacheKey::forFile(sourcePaths[i], files[i]->path(), files[i]->size());
+    }
+  }
+
+  auto result = std::vector<std::optional<Assets::Texture>>(files.size());
+  auto cachedCount = std::atomic<size_t>{0};
+  auto decodedCount = std::atomic<size_t>{0};
+  kdl::parallel_for(files.size(), [&](const size_t i) {
+    try {
+      auto texture = cacheKeys[i] ? cache->readTexture(*cacheKeys[i]) : std::nullopt;
+      if (texture) {
+        ++cachedCount;
+      } else {
+        texture = textureReader->readTexture(files[i]);
+        if (cacheKeys[i]) {
+          ++decodedCount;
+        }
+      }
+
+      if (lazy) {
+        texture->setBufferLoader(
+          makeBufferLoader(std::move(fileOpeners[i]), textureReader, *texture));
+      }
+      result[i] = std::move(texture);
+    } catch (const std::exception& e) { m_logger.warn() << e.what(); }
+  });
+
+  // rewrite the cache if it misses textures or contains textures that were not used
+  if (cache && (decodedCount > 0u || cache->size() != cachedCount)) {
+    cache->unload();
+
+    auto entries = std::vector<std::pair<TextureCacheKey, Assets::Texture>>{};
+    for (size_t i = 0; i < files.size(); ++i) {
+      if (cacheKeys[i] && result[i]) {
+        entries.emplace_back(*cacheKeys[i], makeCacheEntry(*result[i]));
+      }
+    }
+
+    try {
+      if (!Disk::directoryExists(m_cacheDirectory)) {
+        Disk::createDirectory(m_cacheDirectory);
+      }
+
+      // writing the file is slow because it is synced to the disk before it replaces the old file,
+      // so the textures are handed over to the writer thread, which releases their buffers as soon
+      // as they have been written; a cache file that cannot be written is simply rebuilt the next
+      // time
+      cacheWriter().submit(
+        [cache = std::move(*cache),
+         entries = std::make_shared<decltype(entries)>(std::move(entries)),
+         cacheDirectory = m_cacheDirectory]() {
+          if (cache.write(std::move(*entries))) {
+            TextureCache::prune(cacheDirectory, MaxCacheDirectorySize);
+          }
+        });
+    } catch (const FileSystemException& e) { m_logger.warn() << e.what(); }
+  }
+
+  return result;
+}
+
 FileTextureCollectionLoader::FileTextureCollectionLoader(
   Logger& logger, const std::vector<IO::Path>& searchPaths,
   const std::vector<std::string>& exclusions)
@@ -57,13 +234,13 @@ FileTextureCollectionLoader::FileTextureCollectionLoader(
 
 Assets::TextureCollection FileTextureCollectionLoader::loadTextureCollection(
   const Path& path, const std::vector<std::string>& textureExtensions,
-  const TextureReader& textureReader) {
+  const std::shared_ptr<const TextureReader>& textureReader, const bool lazy) {
   const auto wadPath = Disk::resolvePath(m_searchPaths, path);
   WadFileSystem wadFS(wadPath, m_logger);
 
   const auto texturePaths = wadFS.findItems(Path(""), FileExtensionMatcher(textureExtensions));
-  auto textures = std::vector<Assets::Texture>();
-  textures.reserve(texturePaths.size());
+  auto files = FileList{};
+  files.reserve(texturePaths.size());
 
   for (const auto& texturePath : texturePaths) {
     try {
@@ -72,10 +249,28 @@ Assets::TextureCollection FileTextureCollectionLoader::loadTextureCollection(
       if (shouldExclude(name)) {
         continue;
       }
-      textures.push_back(textureReader.readTexture(file));
+      files.push_back(std::move(file));
     } catch (const std::exception& e) { m_logger.warn() << e.what(); }
   }
 
+  auto fileOpeners = std::vector<FileOpener>{};
+  if (lazy) {
+    fileOpeners.reserve(files.size());
+    for (const auto& file : files) {
+      fileOpeners.push_back(makeWadEntryOpener(wadPath, file));
+    }
+  }
+
+  // all textures are read from the WAD file, so its modification time is used for all of them
+  const auto sourcePaths = std::vector<Path>(files.size(), wadPath);
+  auto textures = std::vector<Assets::Texture>();
+  for (auto& texture : readTextures(
+         wadPath, std::move(files), sourcePaths, textureReader, std::move(fileOpeners))) {
+    if (texture) {
+      textures.push_back(std::move(*texture));
+    }
+  }
+
   return Assets::TextureCollection(path, std::move(textures));
 }
 
@@ -86,10 +281,14 @@ DirectoryTextureCollectionLoader::DirectoryTextureCollectionLoader(
 
 Assets::TextureCollection DirectoryTextureCollectionLoader::loadTextureCollection(
   const Path& path, const std::vector<std::string>& textureExtensions,
-  const TextureReader& textureReader) {
+  const std::shared_ptr<const TextureReader>& textureReader, const bool lazy) {
   const auto texturePaths = m_gameFS.findItems(path, FileExtensionMatcher(textureExtensions));
-  auto textures = std::vector<Assets::Texture>();
-  textures.reserve(texturePaths.size());
+  auto files = FileList{};
+  auto absolutePaths = std::vector<Path>{};
+  auto relativePaths = std::vector<Path>{};
+  files.reserve(texturePaths.size());
+  absolutePaths.reserve(texturePaths.size());
+  relativePaths.reserve(texturePaths.size());
 
   for (const auto& texturePath : texturePaths) {
     try {
@@ -105,13 +304,41 @@ Assets::TextureCollection DirectoryTextureCollectionLoader::loadTextureCollectio
       if (shouldExclude(name)) {
         continue;
       }
-      auto texture = textureReader.readTexture(file);
-      texture.setAbsolutePath(absolutePath);
-      texture.setRelativePath(texturePath);
-      textures.push_back(std::move(texture));
+      files.push_back(std::move(file));
+      absolutePaths.push_back(absolutePath);
+      relativePaths.push_back(texturePath);
     } catch (const std::exception& e) { m_logger.warn() << e.what(); }
   }
 
+  // the cache is identified by the absolute path of the collection because different games may
+  // have collections with the same path, and files in archives have no absolute path and are not
+  // cached
+  auto collectionPath = path;
+  if (!m_cacheDirectory.isEmpty()) {
+    try {
+      collectionPath = m_gameFS.makeAbsolute(path);
+    } catch (const FileSystemException& e) { m_logger.debug() << e.what(); }
+  }
+
+  auto fileOpeners = std::vector<FileOpener>{};
+  if (lazy) {
+    fileOpeners.reserve(files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+      fileOpeners.push_back(makeFileOpener(absolutePaths[i], files[i]));
+    }
+  }
+
+  auto textures = std::vector<Assets::Texture>();
+  auto readResults = readTextures(
+    collectionPath, std::move(files), absolutePaths, textureReader, std::move(fileOpeners));
+  for (size_t i = 0; i < readResults.size(); ++i) {
+    if (auto& texture = readResults[i]) {
+      texture->setAbsolutePath(absolutePaths[i]);
+      texture->setRelativePath(relativePaths[i]);
+      textures.push_back(std::move(*texture));
+    }
+  }
+
   return Assets::TextureCollection(path, std::move(textures));
 }
 } // namespace IO
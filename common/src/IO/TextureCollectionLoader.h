@@ -19,7 +19,11 @@
 
 #pragma once
 
+#include "IO/Path.h"
+
+#include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -27,22 +31,31 @@ namespace TrenchBroom {
 class Logger;
 
 namespace Assets {
+class Texture;
 class TextureCollection;
-}
+} // namespace Assets
 
 namespace IO {
 class File;
 class FileSystem;
-class Path;
 class TextureReader;
 
 class TextureCollectionLoader {
 protected:
   using FileList = std::vector<std::shared_ptr<File>>;
 
+  /**
+   * Opens a texture file again so that a lazily loaded texture can decode its buffers when it is
+   * used. The files are not kept open in the meantime because every file that is mapped into
+   * memory holds a file descriptor.
+   */
+  using FileOpener = std::function<std::shared_ptr<File>()>;
+
 protected:
   Logger& m_logger;
   const std::vector<std::string> m_textureExclusions;
+  Path m_cacheDirectory;
+  std::string m_cacheContext;
 
 protected:
   explicit TextureCollectionLoader(Logger& logger, const std::vector<std::string>& exclusions);
@@ -51,12 +64,44 @@ public:
   virtual ~TextureCollectionLoader();
 
 public:
+  /**
+   * Stores the decoded textures of the loaded collections in the given directory and reuses them
+   * when a collection is loaded again, see TextureCache. The given context must identify the
+   * settings that the textures are decoded with.
+   */
+  void setCacheDirectory(const Path& cacheDirectory, std::string context);
+
+  /**
+   * Loads the texture collection at the given path. If `lazy` is true, the textures keep the given
+   * reader to decode their buffers again after they have been discarded.
+   */
   virtual Assets::TextureCollection loadTextureCollection(
     const Path& path, const std::vector<std::string>& textureExtensions,
-    const TextureReader& textureReader) = 0;
+    const std::shared_ptr<const TextureReader>& textureReader, bool lazy) = 0;
 
 protected:
   bool shouldExclude(const std::string& textureName);
+
+  /**
+   * Reads the textures from the given files in parallel. The returned vector contains one element
+   * for each file, which is empty if the texture could not be read.
+   *
+   * If a cache directory is set, the textures are read from the cache of the given collection if
+   * possible. The collection path should be absolute so that it identifies the collection. For
+   * each file, the source path is the path of the file on the disk that contains it, i.e. the file
+   * itself or its archive, and it is used to check whether the cached texture is still valid. Files
+   * with an empty source path are not cached.
+   *
+   * If file openers are given, one for each file, the textures are loaded lazily and reopen their
+   * files with them once their buffers have been discarded.
+   *
+   * Since the textures are read on worker threads, the logger of this loader and of the given
+   * texture reader must be safe to use from any thread.
+   */
+  std::vector<std::optional<Assets::Texture>> readTextures(
+    const Path& collectionPath, FileList files, const std::vector<Path>& sourcePaths,
+    const std::shared_ptr<const TextureReader>& textureReader,
+    std::vector<FileOpener> fileOpeners);
 };
 
 class FileTextureCollectionLoader : public TextureCollectionLoader {
@@ -71,7 +116,7 @@ public:
 private:
   Assets::TextureCollection loadTextureCollection(
     const Path& path, const std::vector<std::string>& textureExtensions,
-    const TextureReader& textureReader);
+    const std::shared_ptr<const TextureReader>& textureReader, bool lazy) override;
 };
 
 class DirectoryTextureCollectionLoader : public TextureCollectionLoader {
@@ -85,7 +130,7 @@ public:
 private:
   Assets::TextureCollection loadTextureCollection(
     const Path& path, const std::vector<std::string>& textureExtensions,
-    const TextureReader& textureReader);
+    const std::shared_ptr<const TextureReader>& textureReader, bool lazy) override;
 };
 } // namespace IO
 } // namespace TrenchBroom
@@ -20,9 +20,12 @@
 #include "TextureLoader.h"
 
 #include "Assets/Palette.h"
+#include "Assets/Texture.h"
 #include "Assets/TextureCollection.h"
 #include "Assets/TextureManager.h"
 #include "Ensure.h"
+#include "Exceptions.h"
+#include "IO/File.h"
 #include "IO/FileSystem.h"
 #include "IO/FreeImageTextureReader.h"
 #include "IO/HlMipTextureReader.h"
@@ -30,27 +33,49 @@
 #include "IO/M8TextureReader.h"
 #include "IO/Path.h"
 #include "IO/Quake3ShaderTextureReader.h"
+#include "IO/Reader.h"
 #include "IO/TextureCollectionLoader.h"
 #include "IO/WalTextureReader.h"
 #include "Logger.h"
 #include "Model/GameConfig.h"
 
+#include <kdl/invoke.h>
 #include <kdl/overload.h>
 
+#include <functional>
+#include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace TrenchBroom {
 namespace IO {
+/**
+ * Lazily loaded textures keep the texture reader alive after this loader has been destroyed, so the
+ * reader must also keep alive the logger it was created with.
+ */
+static std::shared_ptr<const TextureReader> shareTextureReader(
+  std::unique_ptr<TextureReader> textureReader, std::shared_ptr<BufferedLogger> logger) {
+  return std::shared_ptr<const TextureReader>{
+    textureReader.release(), [logger = std::move(logger)](const TextureReader* reader) {
+      delete reader;
+    }};
+}
+
 TextureLoader::TextureLoader(
   const FileSystem& gameFS, const std::vector<IO::Path>& fileSearchPaths,
   const Model::TextureConfig& textureConfig, Logger& logger)
-  : m_textureExtensions(getTextureExtensions(textureConfig))
-  , m_textureReader(createTextureReader(gameFS, textureConfig, logger))
+  : m_logger(logger)
+  , m_readerLogger(std::make_shared<BufferedLogger>())
+  , m_textureExtensions(getTextureExtensions(textureConfig))
+  , m_textureReader(shareTextureReader(
+      createTextureReader(gameFS, textureConfig, *m_readerLogger), m_readerLogger))
   , m_textureCollectionLoader(
-      createTextureCollectionLoader(gameFS, fileSearchPaths, textureConfig, logger)) {
+      createTextureCollectionLoader(gameFS, fileSearchPaths, textureConfig, *m_readerLogger))
+  , m_cacheContext(getCacheContext(gameFS, textureConfig)) {
   ensure(m_textureReader != nullptr, "textureReader is null");
   ensure(m_textureCollectionLoader != nullptr, "textureCollectionLoader is null");
+  m_readerLogger->flush(m_logger);
 }
 
 TextureLoader::~TextureLoader() = default;
@@ -117,9 +142,72 @@ std::unique_ptr<TextureCollectionLoader> TextureLoader::createTextureCollectionL
     textureConfig.package);
 }
 
-Assets::TextureCollection TextureLoader::loadTextureCollection(const Path& path) {
-  return m_textureCollectionLoader->loadTextureCollection(
-    path, m_textureExtensions, *m_textureReader);
+std::optional<std::string> TextureLoader::getCacheContext(
+  const FileSystem& gameFS, const Model::TextureConfig& textureConfig) {
+  if (textureConfig.format.format == "q3shader") {
+    return std::nullopt;
+  }
+
+  // the texture config determines how the textures are decoded and named
+  auto context = std::stringstream{};
+  context << textureConfig;
+
+  // the palette file can be replaced without changing the texture config
+  if (!textureConfig.palette.isEmpty()) {
+    context << "\npalette";
+    try {
+      context << " " << gameFS.makeAbsolute(textureConfig.palette);
+    } catch (const FileSystemException&) {
+      // palettes in archives have no absolute path, but their contents identify them
+    }
+    try {
+      const auto file = gameFS.openFile(textureConfig.palette);
+      const auto contents = file->reader().buffer();
+      context << " " << file->size() << " "
+              << std::hash<std::string_view>{}(contents.stringView());
+    } catch (const Exception&) {
+      // the palette is missing, so the textures are decoded with the default palette
+    }
+  }
+
+  return context.str();
+}
+
+void TextureLoader::setCacheDirectory(const Path& cacheDirectory, const Path& gamePath) {
+  if (m_cacheContext) {
+    m_textureCollectionLoader->setCacheDirectory(
+      cacheDirectory, *m_cacheContext + "\ngame " + gamePath.asString("/"));
+  }
+}
+
+Assets::TextureCollection TextureLoader::loadTextureCollection(const Path& path, const bool lazy) {
+  auto flushLogLater = kdl::invoke_later{[&]() {
+    flushLog();
+  }};
+  return readTextureCollection(path, lazy);
+}
+
+Assets::TextureCollection TextureLoader::readTextureCollection(const Path& path, const bool lazy) {
+  auto collection = m_textureCollectionLoader->loadTextureCollection(
+    path, m_textureExtensions, m_textureReader, lazy);
+
+  if (lazy) {
+    // the reader logs to the buffered logger when a texture is decoded again, possibly on a worker
+    // thread, so the messages are forwarded once the texture has taken over its buffers
+    for (auto& texture : collection.textures()) {
+      if (texture.bufferLoader()) {
+        texture.setBuffersReloaded([readerLogger = m_readerLogger, &logger = m_logger]() {
+          readerLogger->flush(logger);
+        });
+      }
+    }
+  }
+
+  return collection;
+}
+
+void TextureLoader::flushLog() {
+  m_readerLogger->flush(m_logger);
 }
 
 void TextureLoader::loadTextures(
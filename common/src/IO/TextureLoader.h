@@ -19,15 +19,15 @@
 
 #pragma once
 
+#include "Logger.h"
 #include "Macros.h"
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
 namespace TrenchBroom {
-class Logger;
-
 namespace Assets {
 class Palette;
 class TextureCollection;
@@ -44,11 +44,22 @@ class Path;
 class TextureCollectionLoader;
 class TextureReader;
 
+/**
+ * Loads texture collections. The textures of a collection are read in parallel; messages logged
+ * while reading them are forwarded to the logger passed to the constructor once the collection has
+ * been loaded.
+ *
+ * Collections can also be read on other threads, see readTextureCollection and
+ * Assets::TextureManager::loadTextureCollectionsInBackground.
+ */
 class TextureLoader {
 private:
+  Logger& m_logger;
+  std::shared_ptr<BufferedLogger> m_readerLogger;
   std::vector<std::string> m_textureExtensions;
-  std::unique_ptr<TextureReader> m_textureReader;
+  std::shared_ptr<const TextureReader> m_textureReader;
   std::unique_ptr<TextureCollectionLoader> m_textureCollectionLoader;
+  std::optional<std::string> m_cacheContext;
 
 public:
   TextureLoader(
@@ -65,9 +76,38 @@ private:
   static std::unique_ptr<TextureCollectionLoader> createTextureCollectionLoader(
     const FileSystem& gameFS, const std::vector<Path>& fileSearchPaths,
     const Model::TextureConfig& textureConfig, Logger& logger);
+  static std::optional<std::string> getCacheContext(
+    const FileSystem& gameFS, const Model::TextureConfig& textureConfig);
 
 public:
-  Assets::TextureCollection loadTextureCollection(const Path& path);
+  /**
+   * Stores the decoded textures in the given directory so that they need not be decoded again when
+   * their collections are loaded the next time. Has no effect for Quake 3 shaders, since the cache
+   * does not store their surface parameters.
+   *
+   * The cached textures are only used for the same texture config, palette and game path.
+   */
+  void setCacheDirectory(const Path& cacheDirectory, const Path& gamePath);
+
+  /**
+   * Loads the texture collection at the given path. If `lazy` is true, the textures may discard
+   * their buffers and decode them again when they are used, and they forward the messages logged
+   * meanwhile to the logger passed to the constructor, which must therefore outlive them.
+   */
+  Assets::TextureCollection loadTextureCollection(const Path& path, bool lazy);
+
+  /**
+   * Reads the texture collection at the given path like loadTextureCollection, but keeps the
+   * messages logged meanwhile until flushLog is called. This function is threadsafe.
+   */
+  Assets::TextureCollection readTextureCollection(const Path& path, bool lazy);
+
+  /**
+   * Forwards the messages logged while reading texture collections to the logger passed to the
+   * constructor. Must be called on the thread that owns that logger.
+   */
+  void flushLog();
+
   void loadTextures(const std::vector<Path>& paths, Assets::TextureManager& textureManager);
 
   deleteCopyAndMove(TextureLoader);
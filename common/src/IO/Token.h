@@ -20,7 +20,9 @@
 #pragma once
 
 #include <cassert>
+#include <charconv>
 #include <string>
+#include <system_error>
 
 #include <kdl/string_utils.h>
 
@@ -75,12 +77,37 @@ public:
   size_t column() const { return m_column; }
 
   template <typename T> T toFloat() const {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    auto result = 0.0;
+    const auto [ptr, ec] = std::from_chars(numberBegin(), m_end, result);
+    if (ec == std::errc{} && ptr == m_end) {
+      return static_cast<T>(result);
+    }
+#endif
+    // fall back for tokens that from_chars cannot parse completely
     return static_cast<T>(kdl::str_to_double(std::string(m_begin, m_end)).value_or(0.0));
   }
 
   template <typename T> T toInteger() const {
+    auto result = 0l;
+    const auto [ptr, ec] = std::from_chars(numberBegin(), m_end, result);
+    if (ec == std::errc{} && ptr == m_end) {
+      return static_cast<T>(result);
+    }
     return static_cast<T>(kdl::str_to_long(std::string(m_begin, m_end)).value_or(0l));
   }
+
+private:
+  /**
+   * Returns the beginning of this token without a leading plus sign, which from_chars does not
+   * accept.
+   */
+  const char* numberBegin() const {
+    if (length() > 1 && *m_begin == '+' && *(m_begin + 1) != '+' && *(m_begin + 1) != '-') {
+      return m_begin + 1;
+    }
+    return m_begin;
+  }
 };
 } // namespace IO
 } // namespace TrenchBroom
@@ -144,6 +144,31 @@ protected:
     ++m_state.cur;
   }
 
+  /**
+   * Advances by the given number of characters at once. The caller must ensure that none of these
+   * characters is a line break and that the end of the input is not exceeded. Has the same effect
+   * as calling advance() for each of the characters.
+   */
+  void advanceWithinLine(const size_t count) {
+    assert(m_state.cur + count <= m_end);
+
+    const char* end = m_state.cur + count;
+    size_t trailingEscapeChars = 0;
+    while (trailingEscapeChars < count && *(end - trailingEscapeChars - 1) == m_escapeChar) {
+      ++trailingEscapeChars;
+    }
+
+    const auto oddEscapeChars = trailingEscapeChars % 2u == 1u;
+    if (trailingEscapeChars == count) {
+      m_state.escaped = m_state.escaped != oddEscapeChars;
+    } else {
+      m_state.escaped = oddEscapeChars;
+    }
+
+    m_state.column += count;
+    m_state.cur = end;
+  }
+
   void errorIfEof() const {
     if (eof()) {
       throw ParserException("Unexpected end of file");
@@ -59,9 +59,9 @@ Assets::Texture WalTextureReader::doReadTexture(std::shared_ptr<File> file) cons
 
 Assets::Texture WalTextureReader::readQ2Wal(BufferedReader& reader, const Path& path) const {
   static const size_t MaxMipLevels = 4;
-  static Color averageColor;
-  static Assets::TextureBufferList buffers(MaxMipLevels);
-  static size_t offsets[MaxMipLevels];
+  Color averageColor;
+  Assets::TextureBufferList buffers(MaxMipLevels);
+  size_t offsets[MaxMipLevels];
 
   // https://github.com/id-Software/Quake-2-Tools/blob/master/qe4/qfiles.h#L142
 
@@ -97,9 +97,9 @@ Assets::Texture WalTextureReader::readQ2Wal(BufferedReader& reader, const Path&
 
 Assets::Texture WalTextureReader::readDkWal(BufferedReader& reader, const Path& path) const {
   static const size_t MaxMipLevels = 9;
-  static Color averageColor;
-  static Assets::TextureBufferList buffers(MaxMipLevels);
-  static size_t offsets[MaxMipLevels];
+  Color averageColor;
+  Assets::TextureBufferList buffers(MaxMipLevels);
+  size_t offsets[MaxMipLevels];
 
   // https://gist.github.com/DanielGibson/a53c74b10ddd0a1f3d6ab42909d5b7e1
 
@@ -166,7 +166,7 @@ bool WalTextureReader::readMips(
   const size_t width, const size_t height, BufferedReader& reader,
   Assets::TextureBufferList& buffers, Color& averageColor,
   const Assets::PaletteTransparency transparency) {
-  static Color tempColor;
+  Color tempColor;
 
   auto hasTransparency = false;
   for (size_t i = 0; i < mipLevels; ++i) {
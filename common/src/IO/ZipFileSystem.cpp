@@ -69,8 +69,8 @@ ZipFileSystem::~ZipFileSystem() {
 void ZipFileSystem::doReadDirectory() {
   mz_zip_zero_struct(&m_archive);
 
-  if (mz_zip_reader_init_cfile(&m_archive, m_file->file(), m_file->size(), 0) != MZ_TRUE) {
-    throw FileSystemException("Error calling mz_zip_reader_init_cfile");
+  if (mz_zip_reader_init_mem(&m_archive, m_file->begin(), m_file->size(), 0) != MZ_TRUE) {
+    throw FileSystemException("Error calling mz_zip_reader_init_mem");
   }
 
   const mz_uint numFiles = mz_zip_reader_get_num_files(&m_archive);
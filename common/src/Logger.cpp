@@ -120,4 +120,26 @@ void Logger::log(const LogLevel level, const QString& message) {
 
 void NullLogger::doLog(const LogLevel /* level */, const std::string& /* message */) {}
 void NullLogger::doLog(const LogLevel /* level */, const QString& /* message */) {}
+
+void BufferedLogger::flush(Logger& logger) {
+  auto messages = std::vector<std::pair<LogLevel, std::string>>{};
+  {
+    auto lock = std::lock_guard{m_mutex};
+    messages = std::move(m_messages);
+    m_messages.clear();
+  }
+
+  for (const auto& [level, message] : messages) {
+    logger.log(level, message);
+  }
+}
+
+void BufferedLogger::doLog(const LogLevel level, const std::string& message) {
+  auto lock = std::lock_guard{m_mutex};
+  m_messages.emplace_back(level, message);
+}
+
+void BufferedLogger::doLog(const LogLevel level, const QString& message) {
+  doLog(level, message.toStdString());
+}
 } // namespace TrenchBroom
@@ -19,8 +19,11 @@
 
 #pragma once
 
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 class QString;
 
@@ -88,4 +91,24 @@ private:
   void doLog(LogLevel level, const std::string& message) override;
   void doLog(LogLevel level, const QString& message) override;
 };
+
+/**
+ * Collects logged messages until they are flushed to another logger. Messages can be logged from
+ * any thread, but they are only forwarded on the thread that calls flush.
+ */
+class BufferedLogger : public Logger {
+private:
+  std::mutex m_mutex;
+  std::vector<std::pair<LogLevel, std::string>> m_messages;
+
+public:
+  /**
+   * Forwards all collected messages to the given logger in the order in which they were logged.
+   */
+  void flush(Logger& logger);
+
+private:
+  void doLog(LogLevel level, const std::string& message) override;
+  void doLog(LogLevel level, const QString& message) override;
+};
 } // namespace TrenchBroom
@@ -19,6 +19,7 @@
 
 #include "Brush.h"
 
+#include "AABBTree.h"
 #include "Exceptions.h"
 #include "FloatType.h"
 #include "Model/BrushError.h"
@@ -28,25 +29,40 @@
 #include "Model/TexCoordSystem.h"
 #include "Polyhedron.h"
 #include "Polyhedron_Matcher.h"
+#include "Sse2.h"
 
+#include <kdl/parallel.h>
 #include <kdl/result.h>
 #include <kdl/result_for_each.h>
 #include <kdl/string_utils.h>
 #include <kdl/vector_utils.h>
 
+#include <vecmath/bbox.h>
+#include <vecmath/constants.h>
 #include <vecmath/intersection.h>
 #include <vecmath/mat.h>
 #include <vecmath/mat_ext.h>
+#include <vecmath/plane.h>
 #include <vecmath/polygon.h>
+#include <vecmath/scalar.h>
 #include <vecmath/segment.h>
 #include <vecmath/util.h>
 #include <vecmath/vec.h>
 #include <vecmath/vec_ext.h>
 
+#include <algorithm>
+#include <functional>
 #include <iterator>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <optional>
 #include <set>
 #include <string>
+#include <tuple>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace TrenchBroom {
@@ -58,13 +74,284 @@ public:
   }
 };
 
+/**
+ * Returns the smallest and the largest value of `a[i] * u.x() + b[i] * u.y() + c[i] * u.z() - d(i)`
+ * for all i < count, where d(i) is `offsets[i]` if offsets is not null and `offset` otherwise.
+ *
+ * The compiler does not vectorize floating point min / max reductions without relaxed floating
+ * point semantics, so SSE2 is used explicitly where available. The expression is evaluated in the
+ * same order in both branches, so both return identical results.
+ */
+static std::pair<FloatType, FloatType> signedDistanceRange(
+  const FloatType* a, const FloatType* b, const FloatType* c, const FloatType* offsets,
+  const FloatType offset, const size_t count, const vm::vec3& u) {
+  auto minDistance = std::numeric_limits<FloatType>::max();
+  auto maxDistance = std::numeric_limits<FloatType>::lowest();
+  auto i = size_t(0);
+
+#ifdef TB_SSE2
+  if constexpr (std::is_same_v<FloatType, double>) {
+    const auto ux = _mm_set1_pd(u.x());
+    const auto uy = _mm_set1_pd(u.y());
+    const auto uz = _mm_set1_pd(u.z());
+    const auto o = _mm_set1_pd(offset);
+
+    auto minDistances = _mm_set1_pd(minDistance);
+    auto maxDistances = _mm_set1_pd(maxDistance);
+    for (; i + 2u <= count; i += 2u) {
+      const auto ax = _mm_mul_pd(_mm_loadu_pd(a + i), ux);
+      const auto by = _mm_mul_pd(_mm_loadu_pd(b + i), uy);
+      const auto cz = _mm_mul_pd(_mm_loadu_pd(c + i), uz);
+      const auto d = offsets ? _mm_loadu_pd(offsets + i) : o;
+      const auto distances = _mm_sub_pd(_mm_add_pd(_mm_add_pd(ax, by), cz), d);
+      minDistances = _mm_min_pd(minDistances, distances);
+      maxDistances = _mm_max_pd(maxDistances, distances);
+    }
+
+    minDistance = _mm_cvtsd_f64(
+      _mm_min_sd(minDistances, _mm_unpackhi_pd(minDistances, minDistances)));
+    maxDistance = _mm_cvtsd_f64(
+      _mm_max_sd(maxDistances, _mm_unpackhi_pd(maxDistances, maxDistances)));
+  }
+#endif
+
+  for (; i < count; ++i) {
+    const auto d = offsets ? offsets[i] : offset;
+    const auto distance = a[i] * u.x() + b[i] * u.y() + c[i] * u.z() - d;
+    minDistance = std::min(minDistance, distance);
+    maxDistance = std::max(maxDistance, distance);
+  }
+
+  return {minDistance, maxDistance};
+}
+
+/**
+ * Stores the components of the face plane normals, the face plane distances and the components of
+ * the vertex positions of a brush geometry in separate contiguous arrays, so that the loops over
+ * all planes or all vertices below don't have to follow the pointers of the half edge structure
+ * and can use SIMD instructions, see signedDistanceRange.
+ *
+ * The queries return the same results as the corresponding queries of Polyhedron.
+ */
+class Brush::PackedGeometry {
+private:
+  size_t m_planeCount;
+  size_t m_vertexCount;
+
+  /**
+   * The x, y and z components of the plane normals, the plane distances, and the x, y and z
+   * components of the vertex positions, in this order.
+   */
+  std::vector<FloatType> m_values;
+
+  /**
+   * The indices of the first and the second vertex of every edge.
+   */
+  std::vector<size_t> m_edgeVertexIndices;
+
+public:
+  explicit PackedGeometry(const BrushGeometry& geometry)
+    : m_planeCount{geometry.faceCount()}
+    , m_vertexCount{geometry.vertexCount()}
+    , m_values(4u * m_planeCount + 3u * m_vertexCount) {
+    size_t planeIndex = 0u;
+    for (const auto* face : geometry.faces()) {
+      const auto& plane = face->plane();
+      m_values[planeIndex] = plane.normal.x();
+      m_values[m_planeCount + planeIndex] = plane.normal.y();
+      m_values[2u * m_planeCount + planeIndex] = plane.normal.z();
+      m_values[3u * m_planeCount + planeIndex] = plane.distance;
+      ++planeIndex;
+    }
+
+    // maps every vertex to its index, sorted by vertex address for binary search
+    auto vertexIndices = std::vector<std::pair<const BrushVertex*, size_t>>{};
+    vertexIndices.reserve(m_vertexCount);
+    for (const auto* vertex : geometry.vertices()) {
+      const auto& position = vertex->position();
+      const auto vertexIndex = vertexIndices.size();
+      m_values[4u * m_planeCount + vertexIndex] = position.x();
+      m_values[4u * m_planeCount + m_vertexCount + vertexIndex] = position.y();
+      m_values[4u * m_planeCount + 2u * m_vertexCount + vertexIndex] = position.z();
+      vertexIndices.emplace_back(vertex, vertexIndex);
+    }
+    std::sort(vertexIndices.begin(), vertexIndices.end(), [](const auto& lhs, const auto& rhs) {
+      return std::less<const BrushVertex*>{}(lhs.first, rhs.first);
+    });
+
+    const auto indexOf = [&](const BrushVertex* vertex) {
+      const auto it = std::lower_bound(
+        vertexIndices.begin(), vertexIndices.end(), vertex, [](const auto& entry, const auto* v) {
+          return std::less<const BrushVertex*>{}(entry.first, v);
+        });
+      assert(it != vertexIndices.end() && it->first == vertex);
+      return it->second;
+    };
+
+    m_edgeVertexIndices.reserve(2u * geometry.edgeCount());
+    for (const auto* edge : geometry.edges()) {
+      m_edgeVertexIndices.push_back(indexOf(edge->firstVertex()));
+      m_edgeVertexIndices.push_back(indexOf(edge->secondVertex()));
+    }
+  }
+
+  bool hasVertex(const vm::vec3& position, const FloatType epsilon) const {
+    const auto* x = vertexComponents(0);
+    const auto* y = vertexComponents(1);
+    const auto* z = vertexComponents(2);
+
+    for (size_t i = 0; i < m_vertexCount; ++i) {
+      if (
+        vm::abs(x[i] - position.x()) <= epsilon && vm::abs(y[i] - position.y()) <= epsilon &&
+        vm::abs(z[i] - position.z()) <= epsilon) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  vm::vec3 findClosestVertexPosition(const vm::vec3& position) const {
+    const auto* x = vertexComponents(0);
+    const auto* y = vertexComponents(1);
+    const auto* z = vertexComponents(2);
+
+    auto closestDistance2 = std::numeric_limits<FloatType>::max();
+    auto closestIndex = size_t(0);
+    for (size_t i = 0; i < m_vertexCount; ++i) {
+      const auto dx = position.x() - x[i];
+      const auto dy = position.y() - y[i];
+      const auto dz = position.z() - z[i];
+      const auto distance2 = dx * dx + dy * dy + dz * dz;
+      if (distance2 < closestDistance2) {
+        closestDistance2 = distance2;
+        closestIndex = i;
+      }
+    }
+    return vertexPosition(closestIndex);
+  }
+
+  /**
+   * Indicates whether the given point is not above any of the planes.
+   */
+  bool containsPoint(const vm::vec3& point) const {
+    const auto epsilon = vm::constants<FloatType>::point_status_epsilon();
+    const auto [minDistance, maxDistance] = signedDistanceRange(
+      planeComponents(0), planeComponents(1), planeComponents(2), planeComponents(3),
+      FloatType(0), m_planeCount, point);
+    return maxDistance <= epsilon;
+  }
+
+  /**
+   * Indicates whether none of the vertices of the given geometry is above any of the planes.
+   */
+  bool contains(const PackedGeometry& other) const {
+    const auto epsilon = vm::constants<FloatType>::point_status_epsilon();
+    for (size_t i = 0; i < m_planeCount; ++i) {
+      const auto [minDistance, maxDistance] = other.distanceRange(plane(i));
+      if (maxDistance > epsilon) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Separating axis test, see Polyhedron::polyhedronIntersectsPolyhedron.
+   */
+  bool intersects(const PackedGeometry& other) const {
+    if (separates(other) || other.separates(*this)) {
+      return false;
+    }
+
+    for (size_t i = 0; i < m_edgeVertexIndices.size(); i += 2u) {
+      const auto origin = vertexPosition(m_edgeVertexIndices[i]);
+      const auto vector = vertexPosition(m_edgeVertexIndices[i + 1u]) - origin;
+
+      for (size_t j = 0; j < other.m_edgeVertexIndices.size(); j += 2u) {
+        const auto otherVector = other.vertexPosition(other.m_edgeVertexIndices[j + 1u]) -
+                                 other.vertexPosition(other.m_edgeVertexIndices[j]);
+        const auto direction = vm::cross(vector, otherVector);
+
+        if (!vm::is_zero(direction, vm::constants<FloatType>::almost_zero())) {
+          const auto axis = vm::plane3{origin, direction};
+
+          const auto status = pointStatus(axis);
+          if (status != vm::plane_status::inside) {
+            const auto otherStatus = other.pointStatus(axis);
+            if (otherStatus != vm::plane_status::inside && status != otherStatus) {
+              return false;
+            }
+          }
+        }
+      }
+    }
+
+    return true;
+  }
+
+private:
+  const FloatType* planeComponents(const size_t component) const {
+    return m_values.data() + component * m_planeCount;
+  }
+
+  const FloatType* vertexComponents(const size_t component) const {
+    return m_values.data() + 4u * m_planeCount + component * m_vertexCount;
+  }
+
+  vm::plane3 plane(const size_t index) const {
+    return vm::plane3{
+      planeComponents(3)[index],
+      vm::vec3{
+        planeComponents(0)[index], planeComponents(1)[index], planeComponents(2)[index]}};
+  }
+
+  vm::vec3 vertexPosition(const size_t index) const {
+    return vm::vec3{
+      vertexComponents(0)[index], vertexComponents(1)[index], vertexComponents(2)[index]};
+  }
+
+  /**
+   * Returns the smallest and the largest signed distance of any vertex to the given plane.
+   */
+  std::pair<FloatType, FloatType> distanceRange(const vm::plane3& plane) const {
+    return signedDistanceRange(
+      vertexComponents(0), vertexComponents(1), vertexComponents(2), nullptr, plane.distance,
+      m_vertexCount, plane.normal);
+  }
+
+  /**
+   * Returns the status of all vertices relative to the given plane, see Polyhedron::pointStatus.
+   */
+  vm::plane_status pointStatus(const vm::plane3& plane) const {
+    const auto epsilon = vm::constants<FloatType>::point_status_epsilon();
+    const auto [minDistance, maxDistance] = distanceRange(plane);
+    if (maxDistance > epsilon) {
+      return minDistance < -epsilon ? vm::plane_status::inside : vm::plane_status::above;
+    }
+    return vm::plane_status::below;
+  }
+
+  /**
+   * Indicates whether all vertices of the given geometry are above any of the planes.
+   */
+  bool separates(const PackedGeometry& other) const {
+    for (size_t i = 0; i < m_planeCount; ++i) {
+      if (other.pointStatus(plane(i)) == vm::plane_status::above) {
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
 Brush::Brush() {}
 
 Brush::Brush(const Brush& other)
   : m_faces(other.m_faces)
   , m_geometry(
       other.m_geometry ? std::make_unique<BrushGeometry>(*other.m_geometry, CopyCallback())
-                       : nullptr) {
+                       : nullptr)
+  , m_packedGeometry(other.m_packedGeometry) {
   if (m_geometry) {
     for (BrushFaceGeometry* faceGeometry : m_geometry->faces()) {
       if (const auto faceIndex = faceGeometry->payload()) {
@@ -77,7 +364,8 @@ Brush::Brush(const Brush& other)
 
 Brush::Brush(Brush&& other) noexcept
   : m_faces(std::move(other.m_faces))
-  , m_geometry(std::move(other.m_geometry)) {}
+  , m_geometry(std::move(other.m_geometry))
+  , m_packedGeometry(std::move(other.m_packedGeometry)) {}
 
 Brush& Brush::operator=(Brush other) noexcept {
   using std::swap;
@@ -89,6 +377,7 @@ void swap(Brush& lhs, Brush& rhs) noexcept {
   using std::swap;
   swap(lhs.m_faces, rhs.m_faces);
   swap(lhs.m_geometry, rhs.m_geometry);
+  swap(lhs.m_packedGeometry, rhs.m_packedGeometry);
 }
 
 Brush::~Brush() = default;
@@ -104,21 +393,83 @@ kdl::result<Brush, BrushError> Brush::create(
   });
 }
 
+kdl::result<Brush, BrushError> Brush::createFromGeometry(
+  std::vector<BrushFace> faces, BrushGeometry geometry) {
+  if (faces.size() != geometry.faceCount()) {
+    return BrushError::InvalidBrush;
+  }
+
+  Brush brush(std::move(faces));
+  brush.m_geometry = std::make_unique<BrushGeometry>(std::move(geometry));
+  brush.m_packedGeometry = std::make_shared<const PackedGeometry>(*brush.m_geometry);
+
+  size_t faceIndex = 0u;
+  for (BrushFaceGeometry* faceGeometry : brush.m_geometry->faces()) {
+    brush.m_faces[faceIndex].setGeometry(faceGeometry);
+    faceGeometry->setPayload(faceIndex);
+    ++faceIndex;
+  }
+
+  assert(brush.checkFaceLinks());
+
+  return std::move(brush);
+}
+
+FlatBrushGeometry Brush::flattenGeometry() const {
+  auto result = FlatBrushGeometry{};
+
+  // maps every vertex to its index, sorted by vertex address for binary search
+  auto vertexIndices = std::vector<std::pair<const BrushVertex*, size_t>>{};
+  vertexIndices.reserve(vertexCount());
+  result.vertexPositions.reserve(vertexCount());
+  for (const auto* vertex : vertices()) {
+    vertexIndices.emplace_back(vertex, result.vertexPositions.size());
+    result.vertexPositions.push_back(vertex->position());
+  }
+  std::sort(vertexIndices.begin(), vertexIndices.end(), [](const auto& lhs, const auto& rhs) {
+    return std::less<const BrushVertex*>{}(lhs.first, rhs.first);
+  });
+
+  const auto indexOf = [&](const BrushVertex* vertex) {
+    const auto it = std::lower_bound(
+      vertexIndices.begin(), vertexIndices.end(), vertex, [](const auto& entry, const auto* v) {
+        return std::less<const BrushVertex*>{}(entry.first, v);
+      });
+    assert(it != vertexIndices.end() && it->first == vertex);
+    return it->second;
+  };
+
+  result.faceSizes.reserve(faceCount());
+  result.faceIndices.reserve(2u * edgeCount());
+  for (const auto& face : m_faces) {
+    const auto& boundary = face.geometry()->boundary();
+    result.faceSizes.push_back(boundary.size());
+    for (const auto* halfEdge : boundary) {
+      result.faceIndices.push_back(indexOf(halfEdge->origin()));
+    }
+  }
+
+  return result;
+}
+
 kdl::result<void, BrushError> Brush::updateGeometryFromFaces(const vm::bbox3& worldBounds) {
   // First, add all faces to the brush geometry
   BrushFace::sortFaces(m_faces);
 
-  auto geometry = std::make_unique<BrushGeometry>(worldBounds);
-
-  for (size_t i = 0u; i < m_faces.size(); ++i) {
-    BrushFace& face = m_faces[i];
-    const auto result = geometry->clip(face.boundary());
-    if (result.success()) {
-      BrushFaceGeometry* faceGeometry = result.face();
-      face.setGeometry(faceGeometry);
-      faceGeometry->setPayload(i);
-    } else if (result.empty()) {
-      return BrushError::EmptyBrush;
+  auto geometry = createGeometryFromPlanes(worldBounds);
+  if (!geometry) {
+    geometry = std::make_unique<BrushGeometry>(worldBounds);
+
+    for (size_t i = 0u; i < m_faces.size(); ++i) {
+      BrushFace& face = m_faces[i];
+      const auto result = geometry->clip(face.boundary());
+      if (result.success()) {
+        BrushFaceGeometry* faceGeometry = result.face();
+        face.setGeometry(faceGeometry);
+        faceGeometry->setPayload(i);
+      } else if (result.empty()) {
+        return BrushError::EmptyBrush;
+      }
     }
   }
 
@@ -143,12 +494,47 @@ kdl::result<void, BrushError> Brush::updateGeometryFromFaces(const vm::bbox3& wo
 
   m_faces = std::move(remainingFaces);
   m_geometry = std::move(geometry);
+  m_packedGeometry = std::make_shared<const PackedGeometry>(*m_geometry);
 
   assert(checkFaceLinks());
 
   return kdl::void_success;
 }
 
+std::unique_ptr<BrushGeometry> Brush::createGeometryFromPlanes(const vm::bbox3& worldBounds) {
+  if (m_faces.size() > MaxPlaneIntersectionFaceCount) {
+    return nullptr;
+  }
+
+  const auto planes = kdl::vec_transform(m_faces, [](const BrushFace& face) {
+    return face.boundary();
+  });
+
+  auto facePlaneIndices = std::vector<size_t>{};
+  auto geometry = BrushGeometry::fromPlanes(planes, facePlaneIndices);
+  if (!geometry) {
+    return nullptr;
+  }
+
+  // Clipping leaves a face of the world bounds in place if the brush touches or exceeds it, which
+  // is an error, so we leave such brushes to the clipping algorithm.
+  const auto margin = vm::vec3::fill(vm::constants<FloatType>::point_status_epsilon());
+  if (!vm::bbox3{worldBounds.min + margin, worldBounds.max - margin}.contains(geometry->bounds())) {
+    return nullptr;
+  }
+
+  auto result = std::make_unique<BrushGeometry>(std::move(*geometry));
+
+  auto facePlaneIndex = std::begin(facePlaneIndices);
+  for (BrushFaceGeometry* faceGeometry : result->faces()) {
+    const auto faceIndex = *facePlaneIndex++;
+    m_faces[faceIndex].setGeometry(faceGeometry);
+    faceGeometry->setPayload(faceIndex);
+  }
+
+  return result;
+}
+
 const vm::bbox3& Brush::bounds() const {
   ensure(m_geometry != nullptr, "geometry is null");
   return m_geometry->bounds();
@@ -354,12 +740,12 @@ const std::vector<vm::vec3> Brush::vertexPositions() const {
 
 bool Brush::hasVertex(const vm::vec3& position, const FloatType epsilon) const {
   ensure(m_geometry != nullptr, "geometry is null");
-  return m_geometry->findVertexByPosition(position, epsilon) != nullptr;
+  return m_packedGeometry->hasVertex(position, epsilon);
 }
 
 vm::vec3 Brush::findClosestVertexPosition(const vm::vec3& position) const {
   ensure(m_geometry != nullptr, "geometry is null");
-  return m_geometry->findClosestVertex(position)->position();
+  return m_packedGeometry->findClosestVertexPosition(position);
 }
 
 std::vector<vm::vec3> Brush::findClosestVertexPositions(
@@ -436,16 +822,7 @@ const Brush::EdgeList& Brush::edges() const {
 }
 
 bool Brush::containsPoint(const vm::vec3& point) const {
-  if (!bounds().contains(point)) {
-    return false;
-  } else {
-    for (const auto& face : m_faces) {
-      if (face.boundary().point_status(point) == vm::plane_status::above) {
-        return false;
-      }
-    }
-    return true;
-  }
+  return bounds().contains(point) && m_packedGeometry->containsPoint(point);
 }
 
 std::vector<const BrushFace*> Brush::incidentFaces(const BrushVertex* vertex) const {
@@ -934,15 +1311,191 @@ kdl::result<void, BrushError> Brush::updateFacesFromGeometry(
   return updateGeometryFromFaces(worldBounds);
 }
 
+namespace {
+/**
+ * Indexes fragments by the planes of their faces. The faces of all fragments lie on the planes of
+ * the minuend and the subtrahends, so the number of distinct planes is small.
+ */
+class FragmentPlaneIndex {
+private:
+  std::vector<std::tuple<vm::plane3, std::vector<size_t>>> m_planes;
+
+public:
+  void add(const size_t fragmentIndex, const BrushGeometry& fragment) {
+    for (const auto* face : fragment.faces()) {
+      if (auto* fragmentIndices = find(face->plane())) {
+        fragmentIndices->push_back(fragmentIndex);
+      } else {
+        m_planes.emplace_back(face->plane(), std::vector<size_t>{fragmentIndex});
+      }
+    }
+  }
+
+  /**
+   * Returns the indices of the fragments which have a face opposite to a face of the given
+   * fragment, in ascending order. The result can contain fragments that were merged already.
+   */
+  std::vector<size_t> findOpposites(const BrushGeometry& fragment) {
+    auto result = std::vector<size_t>{};
+    for (const auto* face : fragment.faces()) {
+      if (const auto* fragmentIndices = find(face->plane().flip())) {
+        result = kdl::vec_concat(std::move(result), *fragmentIndices);
+      }
+    }
+    return kdl::vec_sort_and_remove_duplicates(std::move(result));
+  }
+
+private:
+  std::vector<size_t>* find(const vm::plane3& plane) {
+    for (auto& [otherPlane, fragmentIndices] : m_planes) {
+      if (vm::is_equal(plane, otherPlane, vm::C::almost_zero())) {
+        return &fragmentIndices;
+      }
+    }
+    return nullptr;
+  }
+};
+} // namespace
+
+/**
+ * Returns the face of the given fragment which lies on the flipped plane of a face of the other
+ * fragment, or null if there is no such face.
+ */
+static const BrushFaceGeometry* findSharedFace(
+  const BrushGeometry& fragment, const BrushGeometry& other) {
+  for (const auto* face : fragment.faces()) {
+    for (const auto* otherFace : other.faces()) {
+      if (vm::is_equal(face->plane(), otherFace->plane().flip(), vm::C::almost_zero())) {
+        return face;
+      }
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * Checks whether the vertices of the given fragment lie on or behind every face plane of the other
+ * fragment except for the given one.
+ */
+static bool isBehindFaces(
+  const BrushGeometry& fragment, const BrushGeometry& other,
+  const BrushFaceGeometry* excludedFace) {
+  for (const auto* face : other.faces()) {
+    if (face == excludedFace) {
+      continue;
+    }
+    for (const auto* vertex : fragment.vertices()) {
+      if (
+        face->pointStatus(vertex->position(), vm::C::point_status_epsilon())
+        == vm::plane_status::above) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Returns the union of the given fragments if it is convex.
+ *
+ * The fragments lie on opposite sides of their shared plane. If the vertices of each fragment lie
+ * behind all face planes of the other fragment except for the shared one, then the convex hull of
+ * both fragments is bounded by the shared plane and the planes of either fragment on either side of
+ * it, so it contains no point that does not belong to one of the fragments.
+ */
+static std::optional<BrushGeometry> mergeIfConvex(
+  const BrushGeometry& lhs, const BrushGeometry& rhs) {
+  const auto* lhsSharedFace = findSharedFace(lhs, rhs);
+  const auto* rhsSharedFace = lhsSharedFace ? findSharedFace(rhs, lhs) : nullptr;
+  if (
+    !rhsSharedFace || !isBehindFaces(rhs, lhs, lhsSharedFace)
+    || !isBehindFaces(lhs, rhs, rhsSharedFace)) {
+    return std::nullopt;
+  }
+
+  auto merged = BrushGeometry{kdl::vec_concat(lhs.vertexPositions(), rhs.vertexPositions())};
+  if (!merged.polyhedron()) {
+    return std::nullopt;
+  }
+  return merged;
+}
+
+/**
+ * Merges adjacent fragments whose union is convex into a single fragment. Subtracting several
+ * brushes one after another splits the minuend along the planes of each subtrahend, even where a
+ * later subtrahend removes everything that made the split necessary.
+ *
+ * Two fragments are only considered for merging if they have a pair of opposite faces, and these
+ * candidates are looked up by plane. Every pair of unchanged fragments is checked once. A fragment
+ * that absorbed another one is examined again, since it might now be mergeable with candidates it
+ * was checked against before.
+ */
+static std::vector<BrushGeometry> mergeFragments(std::vector<BrushGeometry> fragments) {
+  auto planeIndex = FragmentPlaneIndex{};
+  for (size_t i = 0; i < fragments.size(); ++i) {
+    planeIndex.add(i, fragments[i]);
+  }
+
+  auto removed = std::vector<bool>(fragments.size(), false);
+  auto grown = std::vector<bool>(fragments.size(), false);
+  auto pending = std::vector<size_t>(fragments.size());
+  std::iota(pending.rbegin(), pending.rend(), size_t(0));
+
+  while (!pending.empty()) {
+    const auto i = pending.back();
+    pending.pop_back();
+    if (removed[i]) {
+      continue;
+    }
+
+    for (const auto j : planeIndex.findOpposites(fragments[i])) {
+      // unchanged fragments were already checked against the fragments with lower indices
+      if (
+        j == i || (!grown[i] && j < i) || removed[j]
+        || !fragments[i].bounds().intersects(fragments[j].bounds())) {
+        continue;
+      }
+
+      if (auto merged = mergeIfConvex(fragments[i], fragments[j])) {
+        fragments[i] = std::move(*merged);
+        removed[j] = true;
+        grown[i] = true;
+
+        planeIndex.add(i, fragments[i]);
+        pending.push_back(i);
+        break;
+      }
+    }
+  }
+
+  auto result = std::vector<BrushGeometry>{};
+  for (size_t i = 0; i < fragments.size(); ++i) {
+    if (!removed[i]) {
+      result.push_back(std::move(fragments[i]));
+    }
+  }
+  return result;
+}
+
 std::vector<kdl::result<Brush, BrushError>> Brush::subtract(
   const MapFormat mapFormat, const vm::bbox3& worldBounds, const std::string& defaultTextureName,
   const std::vector<const Brush*>& subtrahends) const {
-  auto result = std::vector<BrushGeometry>{*m_geometry};
+  // subtrahends which do not overlap this brush neither change the result nor contribute any face
+  // attributes
+  const auto overlappingSubtrahends = kdl::vec_filter(subtrahends, [&](const Brush* subtrahend) {
+    return bounds().intersects(subtrahend->bounds());
+  });
 
-  for (const auto* subtrahend : subtrahends) {
+  auto result = std::vector<BrushGeometry>{*m_geometry};
+  for (const auto* subtrahend : overlappingSubtrahends) {
     auto nextResults = std::vector<BrushGeometry>{};
 
-    for (const BrushGeometry& fragment : result) {
+    for (BrushGeometry& fragment : result) {
+      if (!fragment.bounds().intersects(subtrahend->bounds())) {
+        nextResults.push_back(std::move(fragment));
+        continue;
+      }
+
       auto subFragments = fragment.subtract(*subtrahend->m_geometry);
       nextResults = kdl::vec_concat(std::move(nextResults), std::move(subFragments));
     }
@@ -950,8 +1503,13 @@ std::vector<kdl::result<Brush, BrushError>> Brush::subtract(
     result = std::move(nextResults);
   }
 
+  if (overlappingSubtrahends.size() > 1u && result.size() > 1u) {
+    result = mergeFragments(std::move(result));
+  }
+
   return kdl::vec_transform(result, [&](const auto& geometry) {
-    return createBrush(mapFormat, worldBounds, defaultTextureName, geometry, subtrahends);
+    return createBrush(
+      mapFormat, worldBounds, defaultTextureName, geometry, overlappingSubtrahends);
   });
 }
 
@@ -994,7 +1552,10 @@ bool Brush::contains(const vm::bbox3& bounds) const {
 }
 
 bool Brush::contains(const Brush& brush) const {
-  return m_geometry->contains(*brush.m_geometry);
+  if (!m_geometry->polyhedron() || !bounds().contains(brush.bounds())) {
+    return false;
+  }
+  return m_packedGeometry->contains(*brush.m_packedGeometry);
 }
 
 bool Brush::intersects(const vm::bbox3& bounds) const {
@@ -1002,7 +1563,13 @@ bool Brush::intersects(const vm::bbox3& bounds) const {
 }
 
 bool Brush::intersects(const Brush& brush) const {
-  return m_geometry->intersects(*brush.m_geometry);
+  if (!m_geometry->polyhedron() || !brush.m_geometry->polyhedron()) {
+    return m_geometry->intersects(*brush.m_geometry);
+  }
+  if (!bounds().intersects(brush.bounds())) {
+    return false;
+  }
+  return m_packedGeometry->intersects(*brush.m_packedGeometry);
 }
 
 kdl::result<Brush, BrushError> Brush::createBrush(
@@ -1109,5 +1676,29 @@ bool operator==(const Brush& lhs, const Brush& rhs) {
 bool operator!=(const Brush& lhs, const Brush& rhs) {
   return !(lhs == rhs);
 }
+
+std::vector<std::vector<kdl::result<Brush, BrushError>>> subtractBrushes(
+  const MapFormat mapFormat, const vm::bbox3& worldBounds, const std::string& defaultTextureName,
+  const std::vector<const Brush*>& minuends, const std::vector<const Brush*>& subtrahends) {
+  auto subtrahendIndices = std::vector<size_t>(subtrahends.size());
+  std::iota(subtrahendIndices.begin(), subtrahendIndices.end(), size_t(0));
+
+  const auto getSubtrahendBounds = [&](const size_t index) {
+    return subtrahends[index]->bounds();
+  };
+  const auto subtrahendTree =
+    AABBTree<FloatType, 3, size_t>{subtrahendIndices, getSubtrahendBounds};
+
+  return kdl::vec_parallel_transform(minuends, [&](const Brush* minuend) {
+    // keep the order in which the subtrahends were given to get deterministic results
+    auto candidateIndices = subtrahendTree.findIntersectors(minuend->bounds());
+    std::sort(candidateIndices.begin(), candidateIndices.end());
+
+    const auto candidates = kdl::vec_transform(candidateIndices, [&](const size_t index) {
+      return subtrahends[index];
+    });
+    return minuend->subtract(mapFormat, worldBounds, defaultTextureName, candidates);
+  });
+}
 } // namespace Model
 } // namespace TrenchBroom
@@ -26,6 +26,7 @@
 #include <kdl/result_forward.h>
 
 #include <vecmath/forward.h>
+#include <vecmath/vec.h>
 
 #include <memory>
 #include <optional>
@@ -39,15 +40,38 @@ template <typename P> class PolyhedronMatcher;
 enum class BrushError;
 enum class MapFormat;
 
+/**
+ * The geometry of a brush as flat arrays in the layout expected by BrushGeometry::fromFaces.
+ */
+struct FlatBrushGeometry {
+  std::vector<vm::vec3> vertexPositions;
+  /**
+   * The number of vertices of each face, in the order of the faces.
+   */
+  std::vector<size_t> faceSizes;
+  /**
+   * The indices of the vertices of each face in counter clockwise order, concatenated in the order
+   * of the faces.
+   */
+  std::vector<size_t> faceIndices;
+};
+
 class Brush {
 private:
   class CopyCallback;
+  class PackedGeometry;
 
   /**
    * Epsilon value to use when finding a vertex after applying a vertex operation
    */
   constexpr static FloatType CloseVertexEpsilon = static_cast<FloatType>(0.01);
 
+  /**
+   * Brushes with at most this many faces are built by intersecting their face planes directly
+   * instead of clipping a cube of the size of the world bounds with every face.
+   */
+  constexpr static size_t MaxPlaneIntersectionFaceCount = 16u;
+
 public:
   using VertexList = BrushVertexList;
   using EdgeList = BrushEdgeList;
@@ -56,6 +80,13 @@ private:
   std::vector<BrushFace> m_faces;
   std::unique_ptr<BrushGeometry> m_geometry;
 
+  /**
+   * A copy of the face planes, vertices and edges of m_geometry in contiguous arrays for the
+   * containment and intersection queries. Rebuilt whenever m_geometry is replaced and shared
+   * between copies of this brush.
+   */
+  std::shared_ptr<const PackedGeometry> m_packedGeometry;
+
 public:
   Brush();
 
@@ -70,11 +101,35 @@ public:
   static kdl::result<Brush, BrushError> create(
     const vm::bbox3& worldBounds, std::vector<BrushFace> faces);
 
+  /**
+   * Creates a brush from the given faces and a geometry that was previously computed from them,
+   * without clipping the geometry again. The faces of the given geometry must correspond to the
+   * given faces by index, as is the case for the faces of the geometry of a brush created by
+   * Brush::create.
+   *
+   * Returns BrushError::InvalidBrush if the number of faces does not match.
+   */
+  static kdl::result<Brush, BrushError> createFromGeometry(
+    std::vector<BrushFace> faces, BrushGeometry geometry);
+
+  /**
+   * Returns the geometry of this brush as flat arrays whose faces correspond to the faces of this
+   * brush by index. Restoring the geometry with BrushGeometry::fromFaces and passing it to
+   * createFromGeometry together with the faces of this brush yields a copy of this brush.
+   */
+  FlatBrushGeometry flattenGeometry() const;
+
 private:
   Brush(std::vector<BrushFace> faces);
 
   kdl::result<void, BrushError> updateGeometryFromFaces(const vm::bbox3& worldBounds);
 
+  /**
+   * Builds the geometry by intersecting the face planes and links the faces to it. Returns null if
+   * the brush has too many faces or if the result might differ from clipping the world bounds.
+   */
+  std::unique_ptr<BrushGeometry> createGeometryFromPlanes(const vm::bbox3& worldBounds);
+
 public:
   const vm::bbox3& bounds() const;
 
@@ -325,5 +380,17 @@ private:
 
 bool operator==(const Brush& lhs, const Brush& rhs);
 bool operator!=(const Brush& lhs, const Brush& rhs);
+
+/**
+ * Subtracts the given subtrahends from each of the given minuends.
+ *
+ * Only the subtrahends whose bounds intersect the bounds of a minuend are subtracted from it. These
+ * are found using an AABB tree of the subtrahends, and the minuends are processed in parallel.
+ *
+ * @return for each minuend, the results of subtracting the subtrahends from it, see Brush::subtract
+ */
+std::vector<std::vector<kdl::result<Brush, BrushError>>> subtractBrushes(
+  MapFormat mapFormat, const vm::bbox3& worldBounds, const std::string& defaultTextureName,
+  const std::vector<const Brush*>& minuends, const std::vector<const Brush*>& subtrahends);
 } // namespace Model
 } // namespace TrenchBroom
@@ -25,39 +25,79 @@
 
 #include <kdl/opt_utils.h>
 
+#include <memory>
+#include <mutex>
 #include <ostream>
+#include <shared_mutex>
 #include <string>
+#include <unordered_map>
 
 namespace TrenchBroom {
 namespace Model {
+namespace {
+/**
+ * Returns the unique copy of the given texture name. The copies are never freed, so the returned
+ * string remains valid for the lifetime of the program.
+ */
+const std::string* internTextureName(const std::string_view textureName) {
+  using TextureNameMap = std::unordered_map<std::string_view, std::unique_ptr<std::string>>;
+
+  static auto mutex = std::shared_mutex{};
+  // never destroyed so that attributes which outlive the static destruction remain valid
+  static auto* textureNames = new TextureNameMap{};
+
+  {
+    auto lock = std::shared_lock{mutex};
+    if (const auto it = textureNames->find(textureName); it != textureNames->end()) {
+      return it->second.get();
+    }
+  }
+
+  auto lock = std::unique_lock{mutex};
+  if (const auto it = textureNames->find(textureName); it != textureNames->end()) {
+    return it->second.get();
+  }
+
+  auto interned = std::make_unique<std::string>(textureName);
+  const auto* result = interned.get();
+  textureNames->emplace(*result, std::move(interned));
+  return result;
+}
+} // namespace
+
+struct BrushFaceAttributes::Values {
+  const std::string* textureName;
+
+  vm::vec2f offset;
+  vm::vec2f scale;
+  float rotation;
+
+  std::optional<int> surfaceContents;
+  std::optional<int> surfaceFlags;
+  std::optional<float> surfaceValue;
+
+  std::optional<Color> color;
+
+  explicit Values(const std::string* i_textureName)
+    : textureName(i_textureName)
+    , offset(vm::vec2f::zero())
+    , scale(vm::vec2f(1.0f, 1.0f))
+    , rotation(0.0f) {}
+};
+
 const std::string BrushFaceAttributes::NoTextureName = "__TB_empty";
 
 BrushFaceAttributes::BrushFaceAttributes(std::string_view textureName)
-  : m_textureName(textureName)
-  , m_offset(vm::vec2f::zero())
-  , m_scale(vm::vec2f(1.0f, 1.0f))
-  , m_rotation(0.0f) {}
+  : m_values(std::make_shared<Values>(internTextureName(textureName))) {}
 
 BrushFaceAttributes::BrushFaceAttributes(const BrushFaceAttributes& other)
-  : m_textureName(other.m_textureName)
-  , m_offset(other.m_offset)
-  , m_scale(other.m_scale)
-  , m_rotation(other.m_rotation)
-  , m_surfaceContents(other.m_surfaceContents)
-  , m_surfaceFlags(other.m_surfaceFlags)
-  , m_surfaceValue(other.m_surfaceValue)
-  , m_color(other.m_color) {}
+  : m_values(other.m_values) {}
 
 BrushFaceAttributes::BrushFaceAttributes(
   std::string_view textureName, const BrushFaceAttributes& other)
-  : m_textureName(textureName)
-  , m_offset(other.m_offset)
-  , m_scale(other.m_scale)
-  , m_rotation(other.m_rotation)
-  , m_surfaceContents(other.m_surfaceContents)
-  , m_surfaceFlags(other.m_surfaceFlags)
-  , m_surfaceValue(other.m_surfaceValue)
-  , m_color(other.m_color) {}
+  : m_values(std::make_shared<Values>(*other.m_values)) {
+  m_values->textureName = internTextureName(textureName);
+}
 
 BrushFaceAttributes& BrushFaceAttributes::operator=(BrushFaceAttributes other) {
   using std::swap;
@@ -66,11 +106,16 @@ BrushFaceAttributes& BrushFaceAttributes::operator=(BrushFaceAttributes other) {
 }
 
 bool operator==(const BrushFaceAttributes& lhs, const BrushFaceAttributes& rhs) {
+  if (lhs.m_values == rhs.m_values) {
+    return true;
+  }
+
+  const auto& l = *lhs.m_values;
+  const auto& r = *rhs.m_values;
   return (
-    lhs.m_textureName == rhs.m_textureName && lhs.m_offset == rhs.m_offset &&
-    lhs.m_scale == rhs.m_scale && lhs.m_rotation == rhs.m_rotation &&
-    lhs.m_surfaceContents == rhs.m_surfaceContents && lhs.m_surfaceFlags == rhs.m_surfaceFlags &&
-    lhs.m_surfaceValue == rhs.m_surfaceValue && lhs.m_color == rhs.m_color);
+    l.textureName == r.textureName && l.offset == r.offset && l.scale == r.scale &&
+    l.rotation == r.rotation && l.surfaceContents == r.surfaceContents &&
+    l.surfaceFlags == r.surfaceFlags && l.surfaceValue == r.surfaceValue && l.color == r.color);
 }
 
 bool operator!=(const BrushFaceAttributes& lhs, const BrushFaceAttributes& rhs) {
@@ -79,43 +124,36 @@ bool operator!=(const BrushFaceAttributes& lhs, const BrushFaceAttributes& rhs)
 
 std::ostream& operator<<(std::ostream& str, const BrushFaceAttributes& attrs) {
   str << "BrushFaceAttributes{"
-      << "textureName: " << attrs.m_textureName << ", "
-      << "offset: " << attrs.m_offset << ", "
-      << "scale: " << attrs.m_scale << ", "
-      << "rotation: " << attrs.m_rotation << ", "
-      << "surfaceContents: " << kdl::opt_to_string(attrs.m_surfaceContents) << ", "
-      << "surfaceFlags: " << kdl::opt_to_string(attrs.m_surfaceFlags) << ", "
-      << "surfaceValue: " << kdl::opt_to_string(attrs.m_surfaceValue) << ", "
-      << "color: " << kdl::opt_to_string(attrs.m_color) << "}";
+      << "textureName: " << attrs.textureName() << ", "
+      << "offset: " << attrs.offset() << ", "
+      << "scale: " << attrs.scale() << ", "
+      << "rotation: " << attrs.rotation() << ", "
+      << "surfaceContents: " << kdl::opt_to_string(attrs.surfaceContents()) << ", "
+      << "surfaceFlags: " << kdl::opt_to_string(attrs.surfaceFlags()) << ", "
+      << "surfaceValue: " << kdl::opt_to_string(attrs.surfaceValue()) << ", "
+      << "color: " << kdl::opt_to_string(attrs.color()) << "}";
   return str;
 }
 
 void swap(BrushFaceAttributes& lhs, BrushFaceAttributes& rhs) {
   using std::swap;
-  swap(lhs.m_textureName, rhs.m_textureName);
-  swap(lhs.m_offset, rhs.m_offset);
-  swap(lhs.m_scale, rhs.m_scale);
-  swap(lhs.m_rotation, rhs.m_rotation);
-  swap(lhs.m_surfaceContents, rhs.m_surfaceContents);
-  swap(lhs.m_surfaceFlags, rhs.m_surfaceFlags);
-  swap(lhs.m_surfaceValue, rhs.m_surfaceValue);
-  swap(lhs.m_color, rhs.m_color);
+  swap(lhs.m_values, rhs.m_values);
 }
 
 const std::string& BrushFaceAttributes::textureName() const {
-  return m_textureName;
+  return *m_values->textureName;
 }
 
 const vm::vec2f& BrushFaceAttributes::offset() const {
-  return m_offset;
+  return m_values->offset;
 }
 
 float BrushFaceAttributes::xOffset() const {
-  return m_offset.x();
+  return m_values->offset.x();
 }
 
 float BrushFaceAttributes::yOffset() const {
-  return m_offset.y();
+  return m_values->offset.y();
 }
 
 vm::vec2f BrushFaceAttributes::modOffset(
@@ -124,156 +162,163 @@ vm::vec2f BrushFaceAttributes::modOffset(
 }
 
 const vm::vec2f& BrushFaceAttributes::scale() const {
-  return m_scale;
+  return m_values->scale;
 }
 
 float BrushFaceAttributes::xScale() const {
-  return m_scale.x();
+  return m_values->scale.x();
 }
 
 float BrushFaceAttributes::yScale() const {
-  return m_scale.y();
+  return m_values->scale.y();
 }
 
 float BrushFaceAttributes::rotation() const {
-  return m_rotation;
+  return m_values->rotation;
 }
 
 bool BrushFaceAttributes::hasSurfaceAttributes() const {
-  return m_surfaceContents || m_surfaceFlags || m_surfaceValue;
+  return m_values->surfaceContents || m_values->surfaceFlags || m_values->surfaceValue;
 }
 
 const std::optional<int>& BrushFaceAttributes::surfaceContents() const {
-  return m_surfaceContents;
+  return m_values->surfaceContents;
 }
 
 const std::optional<int>& BrushFaceAttributes::surfaceFlags() const {
-  return m_surfaceFlags;
+  return m_values->surfaceFlags;
 }
 
 const std::optional<float>& BrushFaceAttributes::surfaceValue() const {
-  return m_surfaceValue;
+  return m_values->surfaceValue;
 }
 
 bool BrushFaceAttributes::hasColor() const {
-  return m_color.has_value();
+  return m_values->color.has_value();
 }
 
 const std::optional<Color>& BrushFaceAttributes::color() const {
-  return m_color;
+  return m_values->color;
 }
 
 bool BrushFaceAttributes::valid() const {
-  return !vm::is_zero(m_scale.x(), vm::Cf::almost_zero()) &&
-         !vm::is_zero(m_scale.y(), vm::Cf::almost_zero());
+  return !vm::is_zero(m_values->scale.x(), vm::Cf::almost_zero()) &&
+         !vm::is_zero(m_values->scale.y(), vm::Cf::almost_zero());
 }
 
 bool BrushFaceAttributes::setTextureName(const std::string& textureName) {
-  if (textureName == m_textureName) {
+  if (textureName == *m_values->textureName) {
     return false;
   } else {
-    m_textureName = textureName;
+    mutableValues().textureName = internTextureName(textureName);
     return true;
   }
 }
 
 bool BrushFaceAttributes::setOffset(const vm::vec2f& offset) {
-  if (offset == m_offset) {
+  if (offset == m_values->offset) {
     return false;
   } else {
-    m_offset = offset;
+    mutableValues().offset = offset;
     return true;
   }
 }
 
 bool BrushFaceAttributes::setXOffset(const float xOffset) {
-  if (xOffset == m_offset.x()) {
+  if (xOffset == m_values->offset.x()) {
     return false;
   } else {
-    m_offset[0] = xOffset;
+    mutableValues().offset[0] = xOffset;
     return true;
   }
 }
 
 bool BrushFaceAttributes::setYOffset(const float yOffset) {
-  if (yOffset == m_offset.y()) {
+  if (yOffset == m_values->offset.y()) {
     return false;
   } else {
-    m_offset[1] = yOffset;
+    mutableValues().offset[1] = yOffset;
     return true;
   }
 }
 
 bool BrushFaceAttributes::setScale(const vm::vec2f& scale) {
-  if (scale == m_scale) {
+  if (scale == m_values->scale) {
     return false;
   } else {
-    m_scale = scale;
+    mutableValues().scale = scale;
     return true;
   }
 }
 
 bool BrushFaceAttributes::setXScale(const float xScale) {
-  if (xScale == m_scale.x()) {
+  if (xScale == m_values->scale.x()) {
     return false;
   } else {
-    m_scale[0] = xScale;
+    mutableValues().scale[0] = xScale;
     return true;
   }
 }
 
 bool BrushFaceAttributes::setYScale(const float yScale) {
-  if (yScale == m_scale.y()) {
+  if (yScale == m_values->scale.y()) {
     return false;
   } else {
-    m_scale[1] = yScale;
+    mutableValues().scale[1] = yScale;
     return true;
   }
 }
 
 bool BrushFaceAttributes::setRotation(const float rotation) {
-  if (rotation == m_rotation) {
+  if (rotation == m_values->rotation) {
     return false;
   } else {
-    m_rotation = rotation;
+    mutableValues().rotation = rotation;
     return true;
   }
 }
 
 bool BrushFaceAttributes::setSurfaceContents(const std::optional<int>& surfaceContents) {
-  if (surfaceContents == m_surfaceContents) {
+  if (surfaceContents == m_values->surfaceContents) {
     return false;
   } else {
-    m_surfaceContents = surfaceContents;
+    mutableValues().surfaceContents = surfaceContents;
     return true;
   }
 }
 
 bool BrushFaceAttributes::setSurfaceFlags(const std::optional<int>& surfaceFlags) {
-  if (surfaceFlags == m_surfaceFlags) {
+  if (surfaceFlags == m_values->surfaceFlags) {
     return false;
   } else {
-    m_surfaceFlags = surfaceFlags;
+    mutableValues().surfaceFlags = surfaceFlags;
     return true;
   }
 }
 
 bool BrushFaceAttributes::setSurfaceValue(const std::optional<float>& surfaceValue) {
-  if (surfaceValue == m_surfaceValue) {
+  if (surfaceValue == m_values->surfaceValue) {
     return false;
   } else {
-    m_surfaceValue = surfaceValue;
+    mutableValues().surfaceValue = surfaceValue;
     return true;
   }
 }
 
 bool BrushFaceAttributes::setColor(const std::optional<Color>& color) {
-  if (color == m_color) {
+  if (color == m_values->color) {
     return false;
   } else {
-    m_color = color;
+    mutableValues().color = color;
     return true;
   }
 }
+
+BrushFaceAttributes::Values& BrushFaceAttributes::mutableValues() {
+  if (m_values.use_count() > 1) {
+    m_values = std::make_shared<Values>(*m_values);
+  }
+  return *m_values;
+}
 } // namespace Model
 } // namespace TrenchBroom
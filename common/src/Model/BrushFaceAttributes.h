@@ -24,6 +24,7 @@
 #include <vecmath/forward.h>
 
 #include <iosfwd>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -34,22 +35,21 @@ class Texture;
 }
 
 namespace Model {
+/**
+ * The texture related attributes of a brush face.
+ *
+ * The attribute values are stored in a reference counted block which is shared between copies and
+ * only copied when one of the copies is modified, so copying brush faces and comparing the
+ * attributes of copies is cheap. Texture names are interned, so all attributes with the same
+ * texture name refer to the same string.
+ */
 class BrushFaceAttributes {
 public:
   static const std::string NoTextureName;
 
 private:
-  std::string m_textureName;
-
-  vm::vec2f m_offset;
-  vm::vec2f m_scale;
-  float m_rotation;
-
-  std::optional<int> m_surfaceContents;
-  std::optional<int> m_surfaceFlags;
-  std::optional<float> m_surfaceValue;
-
-  std::optional<Color> m_color;
+  struct Values;
+  std::shared_ptr<Values> m_values;
 
 public:
   explicit BrushFaceAttributes(std::string_view textureName);
@@ -98,6 +98,13 @@ public:
   bool setSurfaceFlags(const std::optional<int>& surfaceFlags);
   bool setSurfaceValue(const std::optional<float>& surfaceValue);
   bool setColor(const std::optional<Color>& color);
+
+private:
+  /**
+   * Returns the values of these attributes for modification, copying them first if they are
+   * shared with other attributes.
+   */
+  Values& mutableValues();
 };
 } // namespace Model
 } // namespace TrenchBroom
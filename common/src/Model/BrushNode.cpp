@@ -341,12 +341,16 @@ void BrushNode::doAccept(ConstNodeVisitor& visitor) const {
 void BrushNode::doPick(
   const EditorContext& editorContext, const vm::ray3& ray, PickResult& pickResult) {
   if (editorContext.visible(this)) {
-    if (const auto hit = findFaceHit(ray)) {
-      const auto [distance, faceIndex] = *hit;
-      ensure(!vm::is_nan(distance), "nan hit distance");
-      const auto hitPoint = vm::point_at_distance(ray, distance);
-      pickResult.addHit(Hit(BrushHitType, distance, hitPoint, BrushFaceHandle(this, faceIndex)));
-    }
+    doPickVisible(ray, pickResult);
+  }
+}
+
+void BrushNode::doPickVisible(const vm::ray3& ray, PickResult& pickResult) {
+  if (const auto hit = findFaceHit(ray)) {
+    const auto [distance, faceIndex] = *hit;
+    ensure(!vm::is_nan(distance), "nan hit distance");
+    const auto hitPoint = vm::point_at_distance(ray, distance);
+    pickResult.addHit(Hit(BrushHitType, distance, hitPoint, BrushFaceHandle(this, faceIndex)));
   }
 }
 
@@ -119,6 +119,7 @@ private: // implement Node interface
 private: // implement Object interface
   void doPick(
     const EditorContext& editorContext, const vm::ray3& ray, PickResult& pickResult) override;
+  void doPickVisible(const vm::ray3& ray, PickResult& pickResult) override;
   void doFindNodesContaining(const vm::vec3& point, std::vector<Node*>& result) override;
 
   std::optional<std::tuple<FloatType, size_t>> findFaceHit(const vm::ray3& ray) const;
@@ -0,0 +1,67 @@
+/*
+ Copyright (C) 2023 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BrushSnapshot.h"
+
+#include "Model/Brush.h"
+#include "Model/BrushGeometry.h"
+#include "Model/Polyhedron.h"
+
+#include <kdl/result.h>
+#include <kdl/vector_utils.h>
+
+#include <utility>
+
+namespace TrenchBroom {
+namespace Model {
+BrushSnapshot::BrushSnapshot(const Brush& brush)
+  : m_faces(brush.faces())
+  , m_geometry(brush.flattenGeometry()) {}
+
+const std::vector<BrushFace>& BrushSnapshot::faces() const {
+  return m_faces;
+}
+
+const std::vector<vm::vec3>& BrushSnapshot::vertexPositions() const {
+  return m_geometry.vertexPositions;
+}
+
+const std::vector<size_t>& BrushSnapshot::faceSizes() const {
+  return m_geometry.faceSizes;
+}
+
+const std::vector<size_t>& BrushSnapshot::faceIndices() const {
+  return m_geometry.faceIndices;
+}
+
+kdl::result<Brush, BrushError> BrushSnapshot::restore() const {
+  const auto facePlanes = kdl::vec_transform(m_faces, [](const BrushFace& face) {
+    return face.boundary();
+  });
+
+  auto geometry = BrushGeometry::fromFaces(
+    m_geometry.vertexPositions, facePlanes, m_geometry.faceSizes, m_geometry.faceIndices);
+  if (!geometry) {
+    return BrushError::InvalidBrush;
+  }
+
+  return Brush::createFromGeometry(m_faces, std::move(*geometry));
+}
+} // namespace Model
+} // namespace TrenchBroom
@@ -0,0 +1,76 @@
+/*
+ Copyright (C) 2023 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "FloatType.h"
+#include "Model/Brush.h"
+#include "Model/BrushError.h"
+#include "Model/BrushFace.h"
+
+#include <kdl/result_forward.h>
+
+#include <vecmath/vec.h>
+
+#include <vector>
+
+namespace TrenchBroom {
+namespace Model {
+/**
+ * An immutable, compact copy of a brush. The geometry is stored as flat arrays of the vertex
+ * positions and the vertex indices of every face instead of a half edge data structure, so it needs
+ * a fraction of the memory of the brush geometry and can be created and destroyed without
+ * allocating the elements of a polyhedron.
+ *
+ * The faces are copied as they are, including their attributes and texture references, so the
+ * snapshot does not save any memory on them.
+ *
+ * A snapshot can be restored into a brush without clipping its geometry again.
+ */
+class BrushSnapshot {
+private:
+  std::vector<BrushFace> m_faces;
+  FlatBrushGeometry m_geometry;
+
+public:
+  explicit BrushSnapshot(const Brush& brush);
+
+  const std::vector<BrushFace>& faces() const;
+  const std::vector<vm::vec3>& vertexPositions() const;
+
+  /**
+   * The number of vertices of each face, in the order of the faces.
+   */
+  const std::vector<size_t>& faceSizes() const;
+
+  /**
+   * The indices of the vertices of each face in counter clockwise order, concatenated in the order
+   * of the faces.
+   */
+  const std::vector<size_t>& faceIndices() const;
+
+  /**
+   * Creates a brush with the faces and the geometry of this snapshot.
+   *
+   * Returns BrushError::InvalidBrush if the geometry cannot be restored.
+   */
+  kdl::result<Brush, BrushError> restore() const;
+};
+} // namespace Model
+} // namespace TrenchBroom
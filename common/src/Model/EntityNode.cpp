@@ -160,31 +160,39 @@ bool EntityNode::doSelectable() const {
 void EntityNode::doPick(
   const EditorContext& editorContext, const vm::ray3& ray, PickResult& pickResult) {
   if (!hasChildren() && editorContext.visible(this)) {
-    const vm::bbox3& myBounds = logicalBounds();
-    if (!myBounds.contains(ray.origin)) {
-      const FloatType distance = vm::intersect_ray_bbox(ray, myBounds);
-      if (!vm::is_nan(distance)) {
-        const vm::vec3 hitPoint = vm::point_at_distance(ray, distance);
-        pickResult.addHit(Hit(EntityHitType, distance, hitPoint, this));
-        return;
-      }
+    doPickVisible(ray, pickResult);
+  }
+}
+
+void EntityNode::doPickVisible(const vm::ray3& ray, PickResult& pickResult) {
+  if (hasChildren()) {
+    return;
+  }
+
+  const vm::bbox3& myBounds = logicalBounds();
+  if (!myBounds.contains(ray.origin)) {
+    const FloatType distance = vm::intersect_ray_bbox(ray, myBounds);
+    if (!vm::is_nan(distance)) {
+      const vm::vec3 hitPoint = vm::point_at_distance(ray, distance);
+      pickResult.addHit(Hit(EntityHitType, distance, hitPoint, this));
+      return;
     }
+  }
 
-    // only if the bbox hit test failed do we hit test the model
-    if (m_entity.model() != nullptr) {
-      // we transform the ray into the model's space
-      const auto transform = m_entity.modelTransformation();
-      const auto [invertible, inverse] = vm::invert(transform);
-      if (invertible) {
-        const auto transformedRay = vm::ray3f(ray.transform(inverse));
-        const auto distance = m_entity.model()->intersect(transformedRay);
-        if (!vm::is_nan(distance)) {
-          // transform back to world space
-          const auto transformedHitPoint = vm::vec3(point_at_distance(transformedRay, distance));
-          const auto hitPoint = transform * transformedHitPoint;
-          pickResult.addHit(Hit(EntityHitType, static_cast<FloatType>(distance), hitPoint, this));
-          return;
-        }
+  // only if the bbox hit test failed do we hit test the model
+  if (m_entity.model() != nullptr) {
+    // we transform the ray into the model's space
+    const auto transform = m_entity.modelTransformation();
+    const auto [invertible, inverse] = vm::invert(transform);
+    if (invertible) {
+      const auto transformedRay = vm::ray3f(ray.transform(inverse));
+      const auto distance = m_entity.model()->intersect(transformedRay);
+      if (!vm::is_nan(distance)) {
+        // transform back to world space
+        const auto transformedHitPoint = vm::vec3(point_at_distance(transformedRay, distance));
+        const auto hitPoint = transform * transformedHitPoint;
+        pickResult.addHit(Hit(EntityHitType, static_cast<FloatType>(distance), hitPoint, this));
+        return;
       }
     }
   }
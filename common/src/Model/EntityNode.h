@@ -92,6 +92,7 @@ private: // implement Node interface
 
   void doPick(
     const EditorContext& editorContext, const vm::ray3& ray, PickResult& pickResult) override;
+  void doPickVisible(const vm::ray3& ray, PickResult& pickResult) override;
   void doFindNodesContaining(const vm::vec3& point, std::vector<Node*>& result) override;
 
   void doGenerateIssues(const IssueGenerator* generator, std::vector<Issue*>& issues) override;
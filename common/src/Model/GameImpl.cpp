@@ -22,6 +22,7 @@
 #include "Assets/EntityDefinitionFileSpec.h"
 #include "Assets/EntityModel.h"
 #include "Assets/Palette.h"
+#include "Assets/TextureManager.h"
 #include "Ensure.h"
 #include "Exceptions.h"
 #include "IO/AseParser.h"
@@ -39,6 +40,7 @@
 #include "IO/GameConfigParser.h"
 #include "IO/IOUtils.h"
 #include "IO/ImageSpriteParser.h"
+#include "IO/MapCache.h"
 #include "IO/Md2Parser.h"
 #include "IO/Md3Parser.h"
 #include "IO/MdlParser.h"
@@ -62,6 +64,8 @@
 #include "Model/GameConfig.h"
 #include "Model/LayerNode.h"
 #include "Model/WorldNode.h"
+#include "PreferenceManager.h"
+#include "Preferences.h"
 
 #include <kdl/overload.h>
 #include <kdl/result.h>
@@ -73,6 +77,7 @@
 #include <vecmath/vec_io.h>
 
 #include <fstream>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -204,6 +209,10 @@ std::unique_ptr<WorldNode> GameImpl::doLoadMap(
       fileReader.stringView(), possibleFormats, worldBounds, entityPropertyConfig, parserStatus);
   } else {
     IO::WorldReader worldReader(fileReader.stringView(), format, entityPropertyConfig);
+    if (pref(Preferences::UseMapCache)) {
+      worldReader.setCache(std::make_unique<IO::MapCache>(
+        IO::MapCache::forMapFile(IO::Disk::fixPath(path), fileReader.stringView())));
+    }
     return worldReader.read(worldBounds, parserStatus);
   }
 }
@@ -299,8 +308,18 @@ void GameImpl::doLoadTextureCollections(
   const auto paths = extractTextureCollections(entity);
 
   const auto fileSearchPaths = textureCollectionSearchPaths(documentPath);
-  IO::TextureLoader textureLoader(m_fs, fileSearchPaths, m_config.textureConfig, logger);
-  textureLoader.loadTextures(paths, textureManager);
+  auto textureLoader =
+    std::make_shared<IO::TextureLoader>(m_fs, fileSearchPaths, m_config.textureConfig, logger);
+  if (pref(Preferences::UseTextureCache)) {
+    textureLoader->setCacheDirectory(
+      IO::SystemPaths::userDataDirectory() + IO::Path{"TextureCache"}, m_gamePath);
+  }
+
+  if (pref(Preferences::BackgroundTextureLoading)) {
+    textureManager.loadTextureCollectionsInBackground(paths, std::move(textureLoader));
+  } else {
+    textureLoader->loadTextures(paths, textureManager);
+  }
 }
 
 std::vector<IO::Path> GameImpl::textureCollectionSearchPaths(const IO::Path& documentPath) const {
@@ -44,7 +44,10 @@
 
 #include <vecmath/ray.h>
 
+#include <algorithm>
+#include <cassert>
 #include <functional>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -72,6 +75,43 @@ static std::vector<const Node*> collectNodesToCloneAndTransform(const Node& node
   return result;
 }
 
+/**
+ * Returns a copy of the contents of the given node, transformed by the given transformation.
+ */
+static kdl::result<NodeContents, BrushError> transformNodeContents(
+  const Node& node, const vm::bbox3& worldBounds, const vm::mat4x4& transformation) {
+  using TransformResult = kdl::result<NodeContents, BrushError>;
+
+  return node.accept(kdl::overload(
+    [](const WorldNode*) -> TransformResult {
+      ensure(false, "Linked group structure is valid");
+    },
+    [](const LayerNode*) -> TransformResult {
+      ensure(false, "Linked group structure is valid");
+    },
+    [&](const GroupNode* groupNode) -> TransformResult {
+      auto group = groupNode->group();
+      group.transform(transformation);
+      return NodeContents{std::move(group)};
+    },
+    [&](const EntityNode* entityNode) -> TransformResult {
+      auto entity = entityNode->entity();
+      entity.transform(entityNode->entityPropertyConfig(), transformation);
+      return NodeContents{std::move(entity)};
+    },
+    [&](const BrushNode* brushNode) -> TransformResult {
+      auto brush = brushNode->brush();
+      return brush.transform(worldBounds, transformation, true).and_then([&]() -> TransformResult {
+        return NodeContents{std::move(brush)};
+      });
+    },
+    [&](const PatchNode* patchNode) -> TransformResult {
+      auto patch = patchNode->patch();
+      patch.transform(transformation);
+      return NodeContents{std::move(patch)};
+    }));
+}
+
 /**
  * Given a node, clones its children recursively and applies the given transform.
  *
@@ -88,35 +128,10 @@ cloneAndTransformChildren(
   // `nodesToClone`
   const auto transformResults =
     kdl::vec_parallel_transform(nodesToClone, [&](const Node* nodeToTransform) {
-      return nodeToTransform->accept(kdl::overload(
-        [](const WorldNode*) -> TransformResult {
-          ensure(false, "Linked group structure is valid");
-        },
-        [](const LayerNode*) -> TransformResult {
-          ensure(false, "Linked group structure is valid");
-        },
-        [&](const GroupNode* groupNode) -> TransformResult {
-          auto group = groupNode->group();
-          group.transform(transformation);
-          return std::make_pair(nodeToTransform, NodeContents{std::move(group)});
-        },
-        [&](const EntityNode* entityNode) -> TransformResult {
-          auto entity = entityNode->entity();
-          entity.transform(entityNode->entityPropertyConfig(), transformation);
-          return std::make_pair(nodeToTransform, NodeContents{std::move(entity)});
-        },
-        [&](const BrushNode* brushNode) -> TransformResult {
-          auto brush = brushNode->brush();
-          return brush.transform(worldBounds, transformation, true)
-            .and_then([&]() -> TransformResult {
-              return std::make_pair(nodeToTransform, NodeContents{std::move(brush)});
-            });
-        },
-        [&](const PatchNode* patchNode) -> TransformResult {
-          auto patch = patchNode->patch();
-          patch.transform(transformation);
-          return std::make_pair(nodeToTransform, NodeContents{std::move(patch)});
-        }));
+      return transformNodeContents(*nodeToTransform, worldBounds, transformation)
+        .and_then([&](NodeContents&& transformedContents) -> TransformResult {
+          return std::make_pair(nodeToTransform, std::move(transformedContents));
+        });
     });
 
   bool transformFailed = false;
@@ -224,22 +239,13 @@ static void preserveGroupNames(
 }
 
 static void preserveEntityProperties(
-  EntityNode& clonedEntityNode, const EntityNode& correspondingEntityNode) {
-  if (
-    clonedEntityNode.entity().protectedProperties().empty() &&
-    correspondingEntityNode.entity().protectedProperties().empty()) {
-    return;
-  }
-
-  auto clonedEntity = clonedEntityNode.entity();
-  const auto& correspondingEntity = correspondingEntityNode.entity();
-
+  const EntityPropertyConfig& entityPropertyConfig, Entity& clonedEntity,
+  const Entity& correspondingEntity) {
   const auto allProtectedProperties = kdl::vec_sort_and_remove_duplicates(
     kdl::vec_concat(clonedEntity.protectedProperties(), correspondingEntity.protectedProperties()));
 
   clonedEntity.setProtectedProperties(correspondingEntity.protectedProperties());
 
-  const auto entityPropertyConfig = clonedEntityNode.entityPropertyConfig();
   for (const auto& propertyKey : allProtectedProperties) {
     // this can change the order of properties
     clonedEntity.removeProperty(entityPropertyConfig, propertyKey);
@@ -247,7 +253,19 @@ static void preserveEntityProperties(
       clonedEntity.addOrUpdateProperty(entityPropertyConfig, propertyKey, *propertyValue);
     }
   }
+}
+
+static void preserveEntityProperties(
+  EntityNode& clonedEntityNode, const EntityNode& correspondingEntityNode) {
+  if (
+    clonedEntityNode.entity().protectedProperties().empty() &&
+    correspondingEntityNode.entity().protectedProperties().empty()) {
+    return;
+  }
 
+  auto clonedEntity = clonedEntityNode.entity();
+  preserveEntityProperties(
+    clonedEntityNode.entityPropertyConfig(), clonedEntity, correspondingEntityNode.entity());
   clonedEntityNode.setEntity(std::move(clonedEntity));
 }
 
@@ -309,6 +327,191 @@ kdl::result<UpdateLinkedGroupsResult, UpdateLinkedGroupsError> updateLinkedGroup
   });
 }
 
+/**
+ * Returns the indices of the children on the path from the given ancestor to the given node, or an
+ * empty optional if the node is not a descendant of the ancestor.
+ */
+static std::optional<std::vector<size_t>> findChildIndexPath(
+  const Node& ancestor, const Node& node) {
+  auto path = std::vector<size_t>{};
+  for (const auto* current = &node; current != &ancestor; current = current->parent()) {
+    const auto* parent = current->parent();
+    if (parent == nullptr) {
+      return std::nullopt;
+    }
+
+    const auto index = kdl::vec_index_of(parent->children(), current);
+    assert(index);
+    path.push_back(*index);
+  }
+
+  std::reverse(std::begin(path), std::end(path));
+  return path;
+}
+
+static Node* resolveChildIndexPath(Node& ancestor, const std::vector<size_t>& path) {
+  auto* current = &ancestor;
+  for (const auto index : path) {
+    current = current->children()[index];
+  }
+  return current;
+}
+
+/**
+ * Checks whether the given nodes have the same number of children, recursively.
+ */
+static bool haveSameStructure(const Node& lhs, const Node& rhs) {
+  if (lhs.childCount() != rhs.childCount()) {
+    return false;
+  }
+
+  for (size_t i = 0u; i < lhs.childCount(); ++i) {
+    if (!haveSameStructure(*lhs.children()[i], *rhs.children()[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Prepares the given transformed contents of a source node to replace the contents of the given
+ * corresponding target node. Preserves the name of a group and the protected properties of an
+ * entity, and checks that the contents are still within the world bounds.
+ *
+ * Returns false if the type of the contents does not match the type of the target node.
+ */
+static bool prepareContentsForTargetNode(
+  NodeContents& contents, const Node& targetNode, const vm::bbox3& worldBounds,
+  bool& worldBoundsExceeded) {
+  return targetNode.accept(kdl::overload(
+    [](const WorldNode*) {
+      return false;
+    },
+    [](const LayerNode*) {
+      return false;
+    },
+    [&](const GroupNode* targetGroupNode) {
+      auto* group = std::get_if<Group>(&contents.get());
+      if (group == nullptr) {
+        return false;
+      }
+      group->setName(targetGroupNode->group().name());
+      return true;
+    },
+    [&](const EntityNode* targetEntityNode) {
+      auto* entity = std::get_if<Entity>(&contents.get());
+      if (entity == nullptr) {
+        return false;
+      }
+      if (
+        !entity->protectedProperties().empty() ||
+        !targetEntityNode->entity().protectedProperties().empty()) {
+        preserveEntityProperties(
+          targetEntityNode->entityPropertyConfig(), *entity, targetEntityNode->entity());
+      }
+      if (!worldBounds.contains(entity->origin())) {
+        worldBoundsExceeded = true;
+      }
+      return true;
+    },
+    [&](const BrushNode*) {
+      const auto* brush = std::get_if<Brush>(&contents.get());
+      if (brush == nullptr) {
+        return false;
+      }
+      if (!worldBounds.contains(brush->bounds())) {
+        worldBoundsExceeded = true;
+      }
+      return true;
+    },
+    [&](const PatchNode*) {
+      const auto* patch = std::get_if<BezierPatch>(&contents.get());
+      if (patch == nullptr) {
+        return false;
+      }
+      if (!worldBounds.contains(patch->bounds())) {
+        worldBoundsExceeded = true;
+      }
+      return true;
+    }));
+}
+
+kdl::result<UpdateLinkedGroupNodesResult, UpdateLinkedGroupsError> updateLinkedGroupNodes(
+  const GroupNode& sourceGroupNode, const std::vector<Model::GroupNode*>& targetGroupNodes,
+  const std::vector<const Node*>& changedNodes, const vm::bbox3& worldBounds) {
+  const auto replaceAllChildren = [&]() {
+    return updateLinkedGroups(sourceGroupNode, targetGroupNodes, worldBounds)
+      .and_then(
+        [](UpdateLinkedGroupsResult&& replacedChildren)
+          -> kdl::result<UpdateLinkedGroupNodesResult, UpdateLinkedGroupsError> {
+          return UpdateLinkedGroupNodesResult{std::move(replacedChildren), {}};
+        });
+  };
+
+  // if the source group itself changed, its transformation may have changed, too
+  if (kdl::vec_contains(changedNodes, &sourceGroupNode)) {
+    return replaceAllChildren();
+  }
+
+  const auto& sourceGroup = sourceGroupNode.group();
+  const auto [success, invertedSourceTransformation] = vm::invert(sourceGroup.transformation());
+  if (!success) {
+    return UpdateLinkedGroupsError::TransformIsNotInvertible;
+  }
+
+  auto changedSourceNodes = std::vector<const Node*>{};
+  auto changedSourceNodePaths = std::vector<std::vector<size_t>>{};
+  for (const auto* changedNode : changedNodes) {
+    if (auto path = findChildIndexPath(sourceGroupNode, *changedNode)) {
+      changedSourceNodes.push_back(changedNode);
+      changedSourceNodePaths.push_back(std::move(*path));
+    }
+  }
+
+  auto result = UpdateLinkedGroupNodesResult{};
+  if (changedSourceNodes.empty()) {
+    return {std::move(result)};
+  }
+
+  using TransformResult = kdl::result<NodeContents, BrushError>;
+
+  const auto targetGroupNodesToUpdate = kdl::vec_erase(targetGroupNodes, &sourceGroupNode);
+  for (auto* targetGroupNode : targetGroupNodesToUpdate) {
+    // nodes were added or removed, so the nodes of the target group cannot be matched
+    if (!haveSameStructure(sourceGroupNode, *targetGroupNode)) {
+      return replaceAllChildren();
+    }
+
+    const auto transformation =
+      targetGroupNode->group().transformation() * invertedSourceTransformation;
+    auto transformResults = kdl::vec_parallel_transform(
+      changedSourceNodes, [&](const Node* changedSourceNode) -> TransformResult {
+        return transformNodeContents(*changedSourceNode, worldBounds, transformation);
+      });
+
+    bool worldBoundsExceeded = false;
+    for (size_t i = 0u; i < changedSourceNodes.size(); ++i) {
+      if (transformResults[i].is_error()) {
+        return UpdateLinkedGroupsError::TransformFailed;
+      }
+
+      auto contents = std::move(transformResults[i]).value();
+      auto* targetNode = resolveChildIndexPath(*targetGroupNode, changedSourceNodePaths[i]);
+      if (!prepareContentsForTargetNode(contents, *targetNode, worldBounds, worldBoundsExceeded)) {
+        return replaceAllChildren();
+      }
+
+      result.swappedContents.emplace_back(targetNode, std::move(contents));
+    }
+
+    if (worldBoundsExceeded) {
+      return UpdateLinkedGroupsError::UpdateExceedsWorldBounds;
+    }
+  }
+
+  return {std::move(result)};
+}
+
 GroupNode::GroupNode(Group group)
   : m_group(std::move(group))
   , m_editState(EditState::Closed)
@@ -24,6 +24,7 @@
 #include "Model/Group.h"
 #include "Model/IdType.h"
 #include "Model/Node.h"
+#include "Model/NodeContents.h"
 #include "Model/Object.h"
 
 #include <kdl/result_forward.h>
@@ -69,6 +70,41 @@ kdl::result<UpdateLinkedGroupsResult, UpdateLinkedGroupsError> updateLinkedGroup
   const GroupNode& sourceGroupNode, const std::vector<Model::GroupNode*>& targetGroupNodes,
   const vm::bbox3& worldBounds);
 
+/**
+ * The result of updating linked groups by means of `updateLinkedGroupNodes`.
+ */
+struct UpdateLinkedGroupNodesResult {
+  /**
+   * The target group nodes whose children must be replaced, together with their new children.
+   */
+  UpdateLinkedGroupsResult replacedChildren;
+
+  /**
+   * The nodes in the target groups whose contents must be replaced, together with their new
+   * contents.
+   */
+  std::vector<std::pair<Node*, NodeContents>> swappedContents;
+};
+
+/**
+ * Updates the given target group nodes from the given source group node after the contents of the
+ * given nodes have changed.
+ *
+ * Only the contents of the changed nodes that are descendants of the source group node are
+ * transformed, and each of them replaces the contents of the node at the same position in every
+ * target group node. Group names and protected entity properties are preserved as described for
+ * `updateLinkedGroups`.
+ *
+ * If the source group node itself has changed, or if the nodes of a target group node do not
+ * match the nodes of the source group node, then the children of all target group nodes are
+ * replaced by means of `updateLinkedGroups` instead.
+ *
+ * Returns the same errors as `updateLinkedGroups`.
+ */
+kdl::result<UpdateLinkedGroupNodesResult, UpdateLinkedGroupsError> updateLinkedGroupNodes(
+  const GroupNode& sourceGroupNode, const std::vector<Model::GroupNode*>& targetGroupNodes,
+  const std::vector<const Node*>& changedNodes, const vm::bbox3& worldBounds);
+
 /**
  * A group of nodes that can be edited as one.
  *
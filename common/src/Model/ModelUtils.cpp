@@ -19,6 +19,7 @@
 
 #include "ModelUtils.h"
 
+#include "AABBTree.h"
 #include "Ensure.h"
 #include "Model/Brush.h"
 #include "Model/BrushFace.h"
@@ -33,8 +34,13 @@
 #include "Polyhedron.h"
 
 #include <kdl/overload.h>
+#include <kdl/parallel.h>
+#include <kdl/vector_set.h>
 #include <kdl/vector_utils.h>
 
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
 #include <vector>
 
 namespace TrenchBroom {
@@ -318,6 +324,34 @@ std::vector<Node*> collectNodes(const std::vector<Node*>& nodes) {
   return allNodes;
 }
 
+/**
+ * Returns the given candidates for which the given predicate evaluates to true for any of the
+ * brushes returned by the given function for the index of the candidate. The predicate is evaluated
+ * in parallel for different candidates.
+ */
+template <typename F, typename P>
+static std::vector<Node*> filterMatchingNodes(
+  const std::vector<Node*>& candidates, const F& findNearbyBrushes, const P& predicate) {
+  auto candidateIndices = std::vector<size_t>(candidates.size());
+  std::iota(candidateIndices.begin(), candidateIndices.end(), size_t(0));
+  const auto matches =
+    kdl::vec_parallel_transform(std::move(candidateIndices), [&](const size_t candidateIndex) {
+      const auto* candidate = candidates[candidateIndex];
+      const auto& nearbyBrushes = findNearbyBrushes(candidateIndex);
+      return std::any_of(nearbyBrushes.begin(), nearbyBrushes.end(), [&](const auto* brush) {
+        return predicate(candidate, brush);
+      });
+    });
+
+  auto result = std::vector<Model::Node*>{};
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    if (matches[i]) {
+      result.push_back(candidates[i]);
+    }
+  }
+  return result;
+}
+
 /**
  * Recursively collect brushes and entities from the given vector of node trees such that
  * the returned nodes match the given predicate. A matching brush is only returned if it
@@ -325,21 +359,15 @@ std::vector<Node*> collectNodes(const std::vector<Node*>& nodes) {
  * in the given vector of brushes such that the predicate evaluates to true for that pair of
  * node and brush.
  *
- * The given predicate must be a function that maps a node and a brush to true or false.
+ * The given predicate must be a function that maps a node and a brush to true or false. It is only
+ * evaluated for pairs of nodes and brushes whose bounds intersect, and it is evaluated in
+ * parallel for different nodes.
  */
 template <typename P>
 static std::vector<Node*> collectMatchingNodes(
   const std::vector<Node*>& nodes, const std::vector<BrushNode*>& brushes, const P& predicate) {
-  auto result = std::vector<Model::Node*>{};
-
-  const auto collectIfMatching = [&](auto* node) {
-    for (const auto* brush : brushes) {
-      if (predicate(node, brush)) {
-        result.push_back(node);
-        return;
-      }
-    }
-  };
+  const auto queryBrushes = kdl::vector_set<const BrushNode*>{brushes.begin(), brushes.end()};
+  auto candidates = std::vector<Model::Node*>{};
 
   for (auto* node : nodes) {
     node->accept(kdl::overload(
@@ -353,29 +381,100 @@ static std::vector<Node*> collectMatchingNodes(
         if (group->opened() || group->hasOpenedDescendant()) {
           group->visitChildren(thisLambda);
         } else {
-          collectIfMatching(group);
+          candidates.push_back(group);
         }
       },
       [&](auto&& thisLambda, Model::EntityNode* entity) {
         if (entity->hasChildren()) {
           entity->visitChildren(thisLambda);
         } else {
-          collectIfMatching(entity);
+          candidates.push_back(entity);
         }
       },
       [&](Model::BrushNode* brush) {
         // if `brush` is one of the search query nodes, don't count it as touching
-        if (!kdl::vec_contains(brushes, brush)) {
-          collectIfMatching(brush);
+        if (queryBrushes.count(brush) == 0u) {
+          candidates.push_back(brush);
         }
       },
       [&](Model::PatchNode* patch) {
         // if `patch` is one of the search query nodes, don't count it as touching
-        collectIfMatching(patch);
+        candidates.push_back(patch);
       }));
   }
 
-  return result;
+  // groups and entities compute their bounds lazily, so this must happen before the candidates are
+  // tested in parallel
+  const auto candidateBounds = kdl::vec_transform(candidates, [](const Node* node) {
+    return node->logicalBounds();
+  });
+
+  const auto getBrushBounds = [](const BrushNode* brush) {
+    return brush->logicalBounds();
+  };
+  const auto brushTree = AABBTree<FloatType, 3, BrushNode*>{brushes, getBrushBounds};
+
+  return filterMatchingNodes(
+    candidates,
+    [&](const size_t candidateIndex) {
+      return brushTree.findIntersectors(candidateBounds[candidateIndex]);
+    },
+    predicate);
+}
+
+/**
+ * Like collectMatchingNodes above, but only the nodes whose bounds intersect the bounds of any of
+ * the given brushes are taken from the spatial index of the given world instead of visiting every
+ * node of the world.
+ *
+ * Like above, nodes in closed groups are represented by their outermost closed group and entities
+ * with children by their children. Since groups are not in the spatial index, a closed group is
+ * only found if one of its descendants intersects the bounds of a brush.
+ */
+template <typename P>
+static std::vector<Node*> collectMatchingNodes(
+  WorldNode& world, const std::vector<BrushNode*>& brushes, const P& predicate) {
+  const auto queryBrushes = kdl::vector_set<const BrushNode*>{brushes.begin(), brushes.end()};
+
+  auto candidates = std::vector<Node*>{};
+  auto candidateIndices = std::unordered_map<const Node*, size_t>{};
+  auto nearbyBrushes = std::vector<std::vector<const BrushNode*>>{};
+  for (const auto* brush : brushes) {
+    for (auto* node : world.nodeTree().findIntersectors(brush->logicalBounds())) {
+      // only entities in the spatial index can have children, and they are represented by their
+      // children; if `node` is one of the search query nodes, don't count it as touching
+      if (node->hasChildren() || queryBrushes.count(dynamic_cast<const BrushNode*>(node)) != 0u) {
+        continue;
+      }
+
+      Node* candidate = findOutermostClosedGroup(node);
+      if (!candidate) {
+        candidate = node;
+      }
+
+      const auto [it, inserted] = candidateIndices.emplace(candidate, candidates.size());
+      if (inserted) {
+        // groups and entities compute their bounds lazily, so this must happen before the
+        // candidates are tested in parallel
+        candidate->logicalBounds();
+        candidates.push_back(candidate);
+        nearbyBrushes.emplace_back();
+      }
+
+      // a closed group is found once for every descendant that intersects the bounds of a brush
+      auto& candidateBrushes = nearbyBrushes[it->second];
+      if (candidateBrushes.empty() || candidateBrushes.back() != brush) {
+        candidateBrushes.push_back(brush);
+      }
+    }
+  }
+
+  return filterMatchingNodes(
+    candidates,
+    [&](const size_t candidateIndex) -> const std::vector<const BrushNode*>& {
+      return nearbyBrushes[candidateIndex];
+    },
+    predicate);
 }
 
 std::vector<Node*> collectTouchingNodes(
@@ -385,6 +484,12 @@ std::vector<Node*> collectTouchingNodes(
   });
 }
 
+std::vector<Node*> collectTouchingNodes(WorldNode& world, const std::vector<BrushNode*>& brushes) {
+  return collectMatchingNodes(world, brushes, [](const auto* node, const auto* brush) {
+    return brush->intersects(node);
+  });
+}
+
 std::vector<Node*> collectContainedNodes(
   const std::vector<Node*>& nodes, const std::vector<BrushNode*>& brushes) {
   return collectMatchingNodes(nodes, brushes, [](const auto* node, const auto* brush) {
@@ -392,6 +497,12 @@ std::vector<Node*> collectContainedNodes(
   });
 }
 
+std::vector<Node*> collectContainedNodes(WorldNode& world, const std::vector<BrushNode*>& brushes) {
+  return collectMatchingNodes(world, brushes, [](const auto* node, const auto* brush) {
+    return brush->contains(node);
+  });
+}
+
 std::vector<Node*> collectSelectedNodes(const std::vector<Node*>& nodes) {
   auto selectedNodes = std::vector<Model::Node*>{};
 
@@ -77,6 +77,14 @@ std::vector<Node*> collectTouchingNodes(
 std::vector<Node*> collectContainedNodes(
   const std::vector<Node*>& nodes, const std::vector<BrushNode*>& brushes);
 
+/**
+ * Like the functions above for the given world, but the candidates are found by querying the
+ * spatial index of the world with the bounds of the given brushes, so the node tree must be up to
+ * date.
+ */
+std::vector<Node*> collectTouchingNodes(WorldNode& world, const std::vector<BrushNode*>& brushes);
+std::vector<Node*> collectContainedNodes(WorldNode& world, const std::vector<BrushNode*>& brushes);
+
 std::vector<Node*> collectSelectedNodes(const std::vector<Node*>& nodes);
 
 std::vector<Node*> collectSelectableNodes(
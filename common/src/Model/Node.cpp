@@ -700,6 +700,10 @@ void Node::pick(const EditorContext& editorContext, const vm::ray3& ray, PickRes
   doPick(editorContext, ray, pickResult);
 }
 
+void Node::pickVisible(const vm::ray3& ray, PickResult& pickResult) {
+  doPickVisible(ray, pickResult);
+}
+
 void Node::findNodesContaining(const vm::vec3& point, std::vector<Node*>& result) {
   doFindNodesContaining(point, result);
 }
@@ -806,6 +810,8 @@ void Node::doChildDidChange(Node* /* node */) {}
 void Node::doDescendantWillChange(Node* /* node */) {}
 void Node::doDescendantDidChange(Node* /* node */) {}
 
+void Node::doPickVisible(const vm::ray3& /* ray */, PickResult& /* pickResult */) {}
+
 const EntityPropertyConfig& Node::doGetEntityPropertyConfig() const {
   if (m_parent != nullptr) {
     return m_parent->entityPropertyConfig();
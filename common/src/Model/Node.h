@@ -342,6 +342,14 @@ public: // visibility, locking
 
 public: // picking
   void pick(const EditorContext& editorContext, const vm::ray3& ray, PickResult& result);
+
+  /**
+   * Adds the hits of the given ray with this node to the given pick result, assuming that this
+   * node is visible. Unlike pick, this doesn't consult an editor context and thereby the
+   * preferences, so it can be called from worker threads once the visibility of this node was
+   * determined on the main thread.
+   */
+  void pickVisible(const vm::ray3& ray, PickResult& result);
   void findNodesContaining(const vm::vec3& point, std::vector<Node*>& result);
 
 public: // file position
@@ -512,6 +520,7 @@ private: // subclassing interface
 
   virtual void doPick(
     const EditorContext& editorContext, const vm::ray3& ray, PickResult& pickResult) = 0;
+  virtual void doPickVisible(const vm::ray3& ray, PickResult& pickResult);
   virtual void doFindNodesContaining(const vm::vec3& point, std::vector<Node*>& result) = 0;
 
   virtual void doGenerateIssues(const IssueGenerator* generator, std::vector<Issue*>& issues) = 0;
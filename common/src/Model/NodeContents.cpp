@@ -22,6 +22,9 @@
 #include "Model/BrushFace.h"
 
 #include <kdl/overload.h>
+#include <kdl/result.h>
+
+#include <cassert>
 
 namespace TrenchBroom {
 namespace Model {
@@ -42,11 +45,35 @@ NodeContents::NodeContents(std::variant<Layer, Group, Entity, Brush, BezierPatch
     m_contents);
 }
 
+void NodeContents::compact() {
+  if (const auto* brush = std::get_if<Brush>(&m_contents); brush && !m_brushSnapshot) {
+    m_brushSnapshot = BrushSnapshot{*brush};
+    m_contents = Brush{};
+  }
+}
+
+kdl::result<void, BrushError> NodeContents::restore() {
+  if (!m_brushSnapshot) {
+    return kdl::void_success;
+  }
+
+  return m_brushSnapshot->restore().and_then([&](Brush&& brush) {
+    m_contents = std::move(brush);
+    m_brushSnapshot = std::nullopt;
+  });
+}
+
+bool NodeContents::compacted() const {
+  return m_brushSnapshot.has_value();
+}
+
 const std::variant<Layer, Group, Entity, Brush, BezierPatch>& NodeContents::get() const {
+  assert(!compacted());
   return m_contents;
 }
 
 std::variant<Layer, Group, Entity, Brush, BezierPatch>& NodeContents::get() {
+  assert(!compacted());
   return m_contents;
 }
 } // namespace Model
@@ -21,10 +21,15 @@
 
 #include "Model/BezierPatch.h"
 #include "Model/Brush.h"
+#include "Model/BrushError.h"
+#include "Model/BrushSnapshot.h"
 #include "Model/Entity.h"
 #include "Model/Group.h"
 #include "Model/Layer.h"
 
+#include <kdl/result_forward.h>
+
+#include <optional>
 #include <variant>
 
 namespace TrenchBroom {
@@ -33,6 +38,9 @@ class NodeContents {
 private:
   std::variant<Layer, Group, Entity, Brush, BezierPatch> m_contents;
 
+  // if set, m_contents holds an empty brush which is replaced by the restored snapshot in restore
+  std::optional<BrushSnapshot> m_brushSnapshot;
+
 public:
   /** Unsets cached and derived information of the given objects, i.e.
    *  - for entities, unsets the entity definition and the model
@@ -40,6 +48,30 @@ public:
    */
   explicit NodeContents(std::variant<Layer, Group, Entity, Brush, BezierPatch> contents);
 
+  /**
+   * Replaces a brush by a compact snapshot of it to save memory while these contents are not used,
+   * e.g. while they are stored for undo. The brush must be restored by calling restore before the
+   * contents are accessed again. Does nothing if these contents do not contain a brush.
+   */
+  void compact();
+
+  /**
+   * Restores a brush that was replaced by a snapshot in compact. Does nothing if these contents
+   * were not compacted.
+   *
+   * Returns BrushError::InvalidBrush if the brush cannot be restored. In that case, these contents
+   * remain compacted.
+   */
+  kdl::result<void, BrushError> restore();
+
+  /**
+   * Returns whether these contents hold a snapshot which must be restored before they are accessed.
+   */
+  bool compacted() const;
+
+  /**
+   * Returns the contents. The contents must not be compacted.
+   */
   const std::variant<Layer, Group, Entity, Brush, BezierPatch>& get() const;
   std::variant<Layer, Group, Entity, Brush, BezierPatch>& get();
 };
@@ -376,9 +376,12 @@ bool PatchNode::doSelectable() const {
 
 void PatchNode::doPick(
   const EditorContext& editorContext, const vm::ray3& pickRay, PickResult& pickResult) {
-  if (!editorContext.visible(this)) {
-    return;
+  if (editorContext.visible(this)) {
+    doPickVisible(pickRay, pickResult);
   }
+}
+
+void PatchNode::doPickVisible(const vm::ray3& pickRay, PickResult& pickResult) {
   const auto pickTriangle = [&](const auto& p0, const auto& p1, const auto& p2) {
     if (const auto distance = vm::intersect_ray_triangle(pickRay, p0, p1, p2);
         !vm::is_nan(distance)) {
@@ -29,6 +29,7 @@
 #include <vecmath/util.h>
 #include <vecmath/vec.h>
 
+#include <cstddef>
 #include <initializer_list>
 #include <limits>
 #include <optional>
@@ -105,6 +106,16 @@ private:
   explicit Polyhedron_Vertex(const vm::vec<T, 3>& position);
 
 public:
+  /**
+   * Allocates the memory for a vertex from a pool that is shared by all vertices of this type.
+   */
+  static void* operator new(std::size_t size);
+
+  /**
+   * Returns the memory of a vertex to the pool.
+   */
+  static void operator delete(void* ptr);
+
   /**
    * Returns the position of this vertex.
    */
@@ -245,6 +256,16 @@ private:
   Polyhedron_Edge(HalfEdge* first, HalfEdge* second = nullptr);
 
 public:
+  /**
+   * Allocates the memory for a edge from a pool that is shared by all edges of this type.
+   */
+  static void* operator new(std::size_t size);
+
+  /**
+   * Returns the memory of a edge to the pool.
+   */
+  static void operator delete(void* ptr);
+
   /**
    * Returns the origin of the first half edge.
    */
@@ -542,6 +563,16 @@ private:
   Polyhedron_HalfEdge(Vertex* origin);
 
 public:
+  /**
+   * Allocates the memory for a half edge from a pool that is shared by all half edges of this type.
+   */
+  static void* operator new(std::size_t size);
+
+  /**
+   * Returns the memory of a half edge to the pool.
+   */
+  static void operator delete(void* ptr);
+
   /**
    * Returns the origin vertex of this half edge.
    */
@@ -759,6 +790,16 @@ private:
   explicit Polyhedron_Face(HalfEdgeList&& boundary, const vm::plane<T, 3>& plane);
 
 public:
+  /**
+   * Allocates the memory for a face from a pool that is shared by all faces of this type.
+   */
+  static void* operator new(std::size_t size);
+
+  /**
+   * Returns the memory of a face to the pool.
+   */
+  static void operator delete(void* ptr);
+
   /**
    * Returns the circular list of half edges that make up the boundary of this face.
    */
@@ -1168,6 +1209,53 @@ public: // Constructors
    */
   Polyhedron(Polyhedron<T, FP, VP>&& other) noexcept;
 
+  /**
+   * Creates a polyhedron from the given vertices and faces without computing their convex hull,
+   * e.g. to restore a polyhedron that was previously stored in a flat representation.
+   *
+   * The boundary vertices of all faces are given by their indices into the given positions in one
+   * flat array of indices, in the order in which they appear in the boundary of each face. The
+   * number of boundary vertices of each face is given by its size. The planes of the faces are not
+   * validated.
+   *
+   * The faces of the created polyhedron are in the given order, and so are its vertices.
+   *
+   * @param positions the vertex positions
+   * @param facePlanes the face planes
+   * @param faceSizes the number of boundary vertices of each face
+   * @param faceIndices the indices of the boundary vertices of all faces
+   * @return the polyhedron or an empty optional if the given faces do not form a closed polyhedron
+   */
+  static std::optional<Polyhedron<T, FP, VP>> fromFaces(
+    const std::vector<vm::vec<T, 3>>& positions, const std::vector<vm::plane<T, 3>>& facePlanes,
+    const std::vector<size_t>& faceSizes, const std::vector<size_t>& faceIndices);
+
+  /**
+   * Creates the polyhedron that is the intersection of the half spaces below the given planes.
+   *
+   * The vertices are computed directly by intersecting every triple of planes and keeping the
+   * intersection points which are on or below all planes. Every plane which contains at least three
+   * of the vertices becomes a face, unless an earlier plane already contains the same vertices.
+   * Since this takes O(n^4) time for n planes, it is only faster than clipping for few planes.
+   *
+   * The faces of the created polyhedron are in the order of their planes. For each face, the index
+   * of its plane is stored in the given vector.
+   *
+   * The vertex positions are computed directly from their planes and may differ from the
+   * positions computed by clipping by rounding errors. Both are snapped by correctVertexPositions
+   * in the same way, so every coordinate that snaps is identical for both methods.
+   *
+   * Returns an empty optional if the planes do not bound a polyhedron or if the result is ambiguous
+   * because some of its vertices are almost coincident or some of its faces are almost degenerate.
+   * In that case, the caller should clip a bounding polyhedron with the planes instead.
+   *
+   * @param planes the planes
+   * @param facePlaneIndices stores the index of the plane of each face
+   * @return the polyhedron or an empty optional if it cannot be created reliably
+   */
+  static std::optional<Polyhedron<T, FP, VP>> fromPlanes(
+    const std::vector<vm::plane<T, 3>>& planes, std::vector<size_t>& facePlaneIndices);
+
 public: // copy and move assignment
   /**
    * Copy assignment operator.
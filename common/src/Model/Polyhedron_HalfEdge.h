@@ -19,8 +19,14 @@
 
 #pragma once
 
+#include "Macros.h"
 #include "Polyhedron.h"
 
+#include <kdl/object_pool.h>
+
+#include <cassert>
+#include <cstddef>
+
 namespace TrenchBroom {
 namespace Model {
 template <typename T, typename FP, typename VP>
@@ -56,6 +62,18 @@ Polyhedron_HalfEdge<T, FP, VP>::Polyhedron_HalfEdge(Vertex* origin)
   setAsLeaving();
 }
 
+template <typename T, typename FP, typename VP>
+void* Polyhedron_HalfEdge<T, FP, VP>::operator new(const std::size_t size) {
+  assert(size == sizeof(Polyhedron_HalfEdge));
+  unused(size);
+  return kdl::object_pool<Polyhedron_HalfEdge>::allocate();
+}
+
+template <typename T, typename FP, typename VP>
+void Polyhedron_HalfEdge<T, FP, VP>::operator delete(void* ptr) {
+  kdl::object_pool<Polyhedron_HalfEdge>::deallocate(ptr);
+}
+
 template <typename T, typename FP, typename VP>
 typename Polyhedron_HalfEdge<T, FP, VP>::Vertex* Polyhedron_HalfEdge<T, FP, VP>::origin() const {
   return m_origin;
@@ -24,6 +24,7 @@
 #include <kdl/vector_utils.h>
 
 #include <vecmath/bbox.h>
+#include <vecmath/constants.h>
 #include <vecmath/plane.h>
 #include <vecmath/ray.h>
 #include <vecmath/scalar.h>
@@ -31,9 +32,14 @@
 #include <vecmath/vec.h>
 #include <vecmath/vec_io.h>
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
 #include <sstream>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace TrenchBroom {
 namespace Model {
@@ -215,6 +221,230 @@ Polyhedron<T, FP, VP>::Polyhedron(Polyhedron<T, FP, VP>&& other) noexcept
   , m_faces(std::move(other.m_faces))
   , m_bounds(std::move(other.m_bounds)) {}
 
+template <typename T, typename FP, typename VP>
+std::optional<Polyhedron<T, FP, VP>> Polyhedron<T, FP, VP>::fromFaces(
+  const std::vector<vm::vec<T, 3>>& positions, const std::vector<vm::plane<T, 3>>& facePlanes,
+  const std::vector<size_t>& faceSizes, const std::vector<size_t>& faceIndices) {
+  if (facePlanes.size() != faceSizes.size()) {
+    return std::nullopt;
+  }
+
+  const auto vertexCount = positions.size();
+  const auto halfEdgeKey = [&](const size_t origin, const size_t destination) {
+    return origin * vertexCount + destination;
+  };
+
+  // validate the faces before creating anything: every index must refer to a vertex, every vertex
+  // must be used, and every half edge must occur only once and must have a twin
+  auto halfEdgeIndices = std::unordered_map<size_t, size_t>{};
+  halfEdgeIndices.reserve(faceIndices.size());
+
+  auto vertexUsed = std::vector<bool>(vertexCount, false);
+  auto offset = size_t(0);
+  for (const auto faceSize : faceSizes) {
+    if (faceSize < 3u || faceSize > faceIndices.size() - offset) {
+      return std::nullopt;
+    }
+
+    for (size_t i = 0u; i < faceSize; ++i) {
+      const auto origin = faceIndices[offset + i];
+      const auto destination = faceIndices[offset + (i + 1u) % faceSize];
+      if (origin >= vertexCount || destination >= vertexCount || origin == destination) {
+        return std::nullopt;
+      }
+      if (!halfEdgeIndices.emplace(halfEdgeKey(origin, destination), offset + i).second) {
+        return std::nullopt;
+      }
+      vertexUsed[origin] = true;
+    }
+    offset += faceSize;
+  }
+
+  if (offset != faceIndices.size()) {
+    return std::nullopt;
+  }
+  if (std::find(std::begin(vertexUsed), std::end(vertexUsed), false) != std::end(vertexUsed)) {
+    return std::nullopt;
+  }
+  for (const auto& [key, index] : halfEdgeIndices) {
+    const auto origin = key / vertexCount;
+    const auto destination = key % vertexCount;
+    if (halfEdgeIndices.count(halfEdgeKey(destination, origin)) == 0u) {
+      return std::nullopt;
+    }
+  }
+
+  auto result = Polyhedron<T, FP, VP>{};
+
+  auto vertices = std::vector<Vertex*>{};
+  vertices.reserve(vertexCount);
+  for (const auto& position : positions) {
+    auto* vertex = new Vertex(position);
+    vertices.push_back(vertex);
+    result.m_vertices.push_back(vertex);
+  }
+
+  auto halfEdges = std::vector<HalfEdge*>(faceIndices.size(), nullptr);
+  offset = 0u;
+  for (size_t i = 0u; i < faceSizes.size(); ++i) {
+    auto boundary = HalfEdgeList{};
+    for (size_t j = 0u; j < faceSizes[i]; ++j) {
+      auto* halfEdge = new HalfEdge(vertices[faceIndices[offset + j]]);
+      halfEdges[offset + j] = halfEdge;
+      boundary.push_back(halfEdge);
+    }
+    result.m_faces.push_back(new Face(std::move(boundary), facePlanes[i]));
+    offset += faceSizes[i];
+  }
+
+  offset = 0u;
+  for (const auto faceSize : faceSizes) {
+    for (size_t i = 0u; i < faceSize; ++i) {
+      auto* halfEdge = halfEdges[offset + i];
+      if (halfEdge->edge() == nullptr) {
+        const auto origin = faceIndices[offset + i];
+        const auto destination = faceIndices[offset + (i + 1u) % faceSize];
+        auto* twin = halfEdges[halfEdgeIndices[halfEdgeKey(destination, origin)]];
+        result.m_edges.push_back(new Edge(halfEdge, twin));
+      }
+    }
+    offset += faceSize;
+  }
+
+  result.updateBounds();
+  return result;
+}
+
+template <typename T, typename FP, typename VP>
+std::optional<Polyhedron<T, FP, VP>> Polyhedron<T, FP, VP>::fromPlanes(
+  const std::vector<vm::plane<T, 3>>& planes, std::vector<size_t>& facePlaneIndices) {
+  constexpr auto epsilon = vm::constants<T>::point_status_epsilon();
+
+  const auto isInside = [&](const vm::vec<T, 3>& position) {
+    return std::all_of(std::begin(planes), std::end(planes), [&](const auto& plane) {
+      return plane.point_distance(position) <= epsilon;
+    });
+  };
+
+  // every vertex is the intersection of three planes and must be on or below all planes
+  auto positions = std::vector<vm::vec<T, 3>>{};
+  for (size_t i = 0u; i < planes.size(); ++i) {
+    const auto& p1 = planes[i];
+    for (size_t j = i + 1u; j < planes.size(); ++j) {
+      const auto& p2 = planes[j];
+      for (size_t k = j + 1u; k < planes.size(); ++k) {
+        const auto& p3 = planes[k];
+
+        const auto c23 = vm::cross(p2.normal, p3.normal);
+        const auto det = vm::dot(p1.normal, c23);
+        if (det == T(0)) {
+          continue;
+        }
+
+        const auto position = (p1.distance * c23 + p2.distance * vm::cross(p3.normal, p1.normal)
+                               + p3.distance * vm::cross(p1.normal, p2.normal))
+                              / det;
+        if (!isInside(position)) {
+          continue;
+        }
+
+        // several triples yield the same vertex if more than three planes meet in it
+        auto isNewVertex = true;
+        for (const auto& other : positions) {
+          const auto distance2 = vm::squared_distance(other, position);
+          if (distance2 <= epsilon * epsilon) {
+            isNewVertex = false;
+            break;
+          }
+          if (distance2 < MinEdgeLength * MinEdgeLength) {
+            return std::nullopt;
+          }
+        }
+
+        if (isNewVertex) {
+          positions.push_back(position);
+        }
+      }
+    }
+  }
+
+  auto facePlanes = std::vector<vm::plane<T, 3>>{};
+  auto faceSizes = std::vector<size_t>{};
+  auto faceIndices = std::vector<size_t>{};
+  auto planeIndices = std::vector<size_t>{};
+  auto faceVertexSets = std::vector<std::vector<size_t>>{};
+
+  auto faceVertices = std::vector<size_t>{};
+  for (size_t i = 0u; i < planes.size(); ++i) {
+    const auto& plane = planes[i];
+
+    faceVertices.clear();
+    for (size_t j = 0u; j < positions.size(); ++j) {
+      if (vm::abs(plane.point_distance(positions[j])) <= epsilon) {
+        faceVertices.push_back(j);
+      }
+    }
+
+    // a plane which touches the polyhedron in an edge or a vertex doesn't create a face
+    if (faceVertices.size() < 3u) {
+      continue;
+    }
+
+    // sort the vertices counter clockwise around the plane normal
+    auto center = vm::vec<T, 3>{};
+    for (const auto index : faceVertices) {
+      center = center + positions[index];
+    }
+    center = center / static_cast<T>(faceVertices.size());
+
+    const auto xAxis = vm::normalize(positions[faceVertices.front()] - center);
+    const auto yAxis = vm::cross(plane.normal, xAxis);
+    const auto angle = [&](const size_t index) {
+      const auto direction = positions[index] - center;
+      return std::atan2(vm::dot(direction, yAxis), vm::dot(direction, xAxis));
+    };
+    std::sort(
+      std::begin(faceVertices), std::end(faceVertices), [&](const auto lhs, const auto rhs) {
+        return angle(lhs) < angle(rhs);
+      });
+
+    // the boundary must be strictly convex, otherwise clipping might produce different faces
+    const auto faceSize = faceVertices.size();
+    for (size_t j = 0u; j < faceSize; ++j) {
+      const auto& p1 = positions[faceVertices[j]];
+      const auto& p2 = positions[faceVertices[(j + 1u) % faceSize]];
+      const auto& p3 = positions[faceVertices[(j + 2u) % faceSize]];
+      if (!(vm::dot(vm::cross(p2 - p1, p3 - p2), plane.normal) > epsilon)) {
+        return std::nullopt;
+      }
+    }
+
+    // if several planes coincide, only the first one creates a face
+    auto vertexSet = faceVertices;
+    std::sort(std::begin(vertexSet), std::end(vertexSet));
+    if (std::find(std::begin(faceVertexSets), std::end(faceVertexSets), vertexSet)
+        != std::end(faceVertexSets)) {
+      continue;
+    }
+    faceVertexSets.push_back(std::move(vertexSet));
+
+    facePlanes.push_back(plane);
+    faceSizes.push_back(faceSize);
+    faceIndices.insert(std::end(faceIndices), std::begin(faceVertices), std::end(faceVertices));
+    planeIndices.push_back(i);
+  }
+
+  if (facePlanes.size() < 4u) {
+    return std::nullopt;
+  }
+
+  auto result = fromFaces(positions, facePlanes, faceSizes, faceIndices);
+  if (result) {
+    facePlaneIndices = std::move(planeIndices);
+  }
+  return result;
+}
+
 template <typename T, typename FP, typename VP>
 Polyhedron<T, FP, VP>& Polyhedron<T, FP, VP>::operator=(const Polyhedron<T, FP, VP>& other) {
   Polyhedron<T, FP, VP> copy(other);
@@ -230,21 +460,50 @@ Polyhedron<T, FP, VP>& Polyhedron<T, FP, VP>::operator=(Polyhedron<T, FP, VP>&&
  */
 template <typename T, typename FP, typename VP> class Polyhedron<T, FP, VP>::Copy {
 private:
-  using VertexMap = std::unordered_map<const Vertex*, Vertex*>;
-  using VertexMapEntry = typename VertexMap::value_type;
+  /**
+   * Maps the elements of the original to their copies. The entries are sorted once all of them
+   * have been inserted, so unlike a hash map, this needs only a single allocation.
+   */
+  template <typename E> class CopyMap {
+  private:
+    using Entry = std::pair<const E*, E*>;
+    std::vector<Entry> m_entries;
+
+  public:
+    void reserve(const size_t count) { m_entries.reserve(count); }
+
+    void insert(const E* original, E* copy) { m_entries.emplace_back(original, copy); }
+
+    void sort() {
+      std::sort(m_entries.begin(), m_entries.end(), [](const Entry& lhs, const Entry& rhs) {
+        return std::less<const E*>{}(lhs.first, rhs.first);
+      });
+      assert(
+        std::adjacent_find(
+          m_entries.begin(), m_entries.end(), [](const Entry& lhs, const Entry& rhs) {
+            return lhs.first == rhs.first;
+          })
+        == m_entries.end());
+    }
 
-  using HalfEdgeMap = std::unordered_map<const HalfEdge*, HalfEdge*>;
-  using HalfEdgeMapEntry = typename HalfEdgeMap::value_type;
+    E* find(const E* original) const {
+      const auto it = std::lower_bound(
+        m_entries.begin(), m_entries.end(), original, [](const Entry& entry, const E* e) {
+          return std::less<const E*>{}(entry.first, e);
+        });
+      return it != m_entries.end() && it->first == original ? it->second : nullptr;
+    }
+  };
 
   /**
    * Maps the vertices of the original to their copies.
    */
-  VertexMap m_vertexMap;
+  CopyMap<Vertex> m_vertexMap;
 
   /**
    * Maps the half edges of the original to their copies.
    */
-  HalfEdgeMap m_halfEdgeMap;
+  CopyMap<HalfEdge> m_halfEdgeMap;
 
   /**
    * The copied vertices.
@@ -282,27 +541,30 @@ public:
     const VertexList& originalVertices, Polyhedron& destination, const CopyCallback& callback)
     : m_destination(destination) {
     copyVertices(originalVertices, callback);
-    copyFaces(originalFaces, callback);
+    copyFaces(originalFaces, originalEdges.size(), callback);
     copyEdges(originalEdges);
     swapContents();
   }
 
 private:
   void copyVertices(const VertexList& originalVertices, const CopyCallback& callback) {
+    m_vertexMap.reserve(originalVertices.size());
     for (const Vertex* currentVertex : originalVertices) {
       Vertex* copy = new Vertex(currentVertex->position());
       callback.vertexWasCopied(currentVertex, copy);
-      assert(m_vertexMap.count(currentVertex) == 0u);
-      m_vertexMap.insert(std::make_pair(currentVertex, copy));
+      m_vertexMap.insert(currentVertex, copy);
       m_vertices.push_back(copy);
-      currentVertex = currentVertex->next();
     }
+    m_vertexMap.sort();
   }
 
-  void copyFaces(const FaceList& originalFaces, const CopyCallback& callback) {
+  void copyFaces(
+    const FaceList& originalFaces, const size_t edgeCount, const CopyCallback& callback) {
+    m_halfEdgeMap.reserve(2u * edgeCount);
     for (const Face* currentFace : originalFaces) {
       copyFace(currentFace, callback);
     }
+    m_halfEdgeMap.sort();
   }
 
   void copyFace(const Face* originalFace, const CopyCallback& callback) {
@@ -318,19 +580,15 @@ private:
   }
 
   HalfEdge* copyHalfEdge(const HalfEdge* original) {
-    const Vertex* originalOrigin = original->origin();
-
-    Vertex* myOrigin = findVertex(originalOrigin);
-    HalfEdge* copy = new HalfEdge(myOrigin);
-    assert(m_halfEdgeMap.count(original) == 0u);
-    m_halfEdgeMap.insert(std::make_pair(original, copy));
+    HalfEdge* copy = new HalfEdge(findVertex(original->origin()));
+    m_halfEdgeMap.insert(original, copy);
     return copy;
   }
 
   Vertex* findVertex(const Vertex* original) {
-    typename VertexMap::iterator it = m_vertexMap.find(original);
-    assert(it != std::end(m_vertexMap));
-    return it->second;
+    Vertex* copy = m_vertexMap.find(original);
+    assert(copy != nullptr);
+    return copy;
   }
 
   void copyEdges(const EdgeList& originalEdges) {
@@ -350,16 +608,13 @@ private:
   }
 
   HalfEdge* findOrCopyHalfEdge(const HalfEdge* original) {
-    auto it = m_halfEdgeMap.find(original);
-    if (it == std::end(m_halfEdgeMap)) {
-      const Vertex* originalOrigin = original->origin();
-      Vertex* myOrigin = findVertex(originalOrigin);
-      HalfEdge* copy = new HalfEdge(myOrigin);
-      m_halfEdgeMap.insert(std::make_pair(original, copy));
+    if (HalfEdge* copy = m_halfEdgeMap.find(original)) {
       return copy;
-    } else {
-      return it->second;
     }
+
+    // a half edge that doesn't belong to a face is only referenced by its edge, so it isn't
+    // necessary to remember its copy
+    return new HalfEdge(findVertex(original->origin()));
   }
 
   void swapContents() {
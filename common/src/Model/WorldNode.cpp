@@ -23,6 +23,7 @@
 #include "Ensure.h"
 #include "Model/BrushFace.h"
 #include "Model/BrushNode.h"
+#include "Model/EditorContext.h"
 #include "Model/EntityNode.h"
 #include "Model/EntityNodeIndex.h"
 #include "Model/GroupNode.h"
@@ -30,16 +31,21 @@
 #include "Model/IssueGeneratorRegistry.h"
 #include "Model/LayerNode.h"
 #include "Model/PatchNode.h"
+#include "Model/PickResult.h"
 #include "Model/TagVisitor.h"
 
 #include <kdl/overload.h>
+#include <kdl/parallel.h>
 #include <kdl/result.h>
 #include <kdl/vector_utils.h>
 
 #include <vecmath/bbox_io.h>
 
+#include <algorithm>
+#include <iterator>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace TrenchBroom {
@@ -179,6 +185,55 @@ void WorldNode::unregisterAllIssueGenerators() {
   invalidateAllIssues();
 }
 
+std::vector<PickResult> WorldNode::pickRays(
+  const EditorContext& editorContext, const std::vector<vm::ray3>& rays) {
+  const auto packetSize = NodeTree::RayPacketSize;
+  const auto packetCount = (rays.size() + packetSize - 1) / packetSize;
+
+  // find the nodes that each ray may hit
+  auto candidates = std::vector<std::vector<Node*>>(rays.size());
+  kdl::parallel_for(packetCount, [&](const size_t packet) {
+    const auto first = packet * packetSize;
+    const auto last = std::min(first + packetSize, rays.size());
+    m_nodeTree->findIntersectors(
+      std::next(rays.begin(), static_cast<std::ptrdiff_t>(first)),
+      std::next(rays.begin(), static_cast<std::ptrdiff_t>(last)),
+      [&](const size_t ray, Node* node) {
+        candidates[first + ray].push_back(node);
+      });
+  });
+
+  // the editor context accesses the preferences, which must happen on the main thread
+  auto visibility = std::unordered_map<Node*, bool>{};
+  for (auto& nodes : candidates) {
+    nodes = kdl::vec_erase_if(std::move(nodes), [&](Node* node) {
+      const auto [it, inserted] = visibility.emplace(node, false);
+      if (inserted) {
+        it->second = editorContext.visible(node);
+      }
+      return !it->second;
+    });
+  }
+
+  auto pickResults = std::vector<PickResult>{};
+  pickResults.reserve(rays.size());
+  for (size_t i = 0; i < rays.size(); ++i) {
+    pickResults.push_back(PickResult::byDistance());
+  }
+
+  kdl::parallel_for(packetCount, [&](const size_t packet) {
+    const auto first = packet * packetSize;
+    const auto last = std::min(first + packetSize, rays.size());
+    for (size_t i = first; i < last; ++i) {
+      for (auto* node : candidates[i]) {
+        node->pickVisible(rays[i], pickResults[i]);
+      }
+    }
+  });
+
+  return pickResults;
+}
+
 void WorldNode::disableNodeTreeUpdates() {
   m_updateNodeTree = false;
 }
@@ -130,6 +130,17 @@ public: // selection
   void registerIssueGenerator(IssueGenerator* issueGenerator);
   void unregisterAllIssueGenerators();
 
+public: // picking
+  /**
+   * Picks the given rays and returns one pick result per ray, in the order of the rays.
+   *
+   * The node tree is traversed once per packet of rays, and the packets are distributed over
+   * multiple threads. The visibility of the hit nodes is determined on the calling thread, which
+   * must therefore be the main thread.
+   */
+  std::vector<PickResult> pickRays(
+    const EditorContext& editorContext, const std::vector<vm::ray3>& rays);
+
 public: // node tree bulk updating
   void disableNodeTreeUpdates();
   void enableNodeTreeUpdates();
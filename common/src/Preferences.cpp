@@ -181,10 +181,17 @@ Preference<Color> GridColor2D(IO::Path("Rendere/Grid/Color2D"), Color(0.8f, 0.8f
 Preference<int> TextureMinFilter(IO::Path("Renderer/Texture mode min filter"), 0x2700);
 Preference<int> TextureMagFilter(IO::Path("Renderer/Texture mode mag filter"), 0x2600);
 Preference<bool> EnableMSAA(IO::Path("Renderer/Enable multisampling"), true);
+Preference<bool> LazyTextureLoading(IO::Path("Renderer/Lazy texture loading"), false);
+// in megabytes
+Preference<int> TextureCacheSize(IO::Path("Renderer/Texture cache size"), 256);
+Preference<bool> UseTextureCache(IO::Path("Renderer/Use texture cache"), false);
+Preference<bool> BackgroundTextureLoading(IO::Path("Renderer/Background texture loading"), false);
 
 Preference<bool> TextureLock(IO::Path("Editor/Texture lock"), true);
 Preference<bool> UVLock(IO::Path("Editor/UV lock"), false);
 
+Preference<bool> UseMapCache(IO::Path("Editor/Use map cache"), false);
+
 Preference<IO::Path>& RendererFontPath() {
   static Preference<IO::Path> fontPath(
     IO::Path("Renderer/Font name"), IO::Path("fonts/SourceSansPro-Regular.otf"));
@@ -361,8 +368,13 @@ const std::vector<PreferenceBase*>& staticPreferences() {
     &GridColor2D,
     &TextureMinFilter,
     &TextureMagFilter,
+    &LazyTextureLoading,
+    &TextureCacheSize,
+    &UseTextureCache,
+    &BackgroundTextureLoading,
     &TextureLock,
     &UVLock,
+    &UseMapCache,
     &RendererFontPath(),
     &RendererFontSize,
     &BrowserFontSize,
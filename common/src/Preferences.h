@@ -125,10 +125,16 @@ extern Preference<Color> GridColor2D;
 extern Preference<int> TextureMinFilter;
 extern Preference<int> TextureMagFilter;
 extern Preference<bool> EnableMSAA;
+extern Preference<bool> LazyTextureLoading;
+extern Preference<int> TextureCacheSize;
+extern Preference<bool> UseTextureCache;
+extern Preference<bool> BackgroundTextureLoading;
 
 extern Preference<bool> TextureLock;
 extern Preference<bool> UVLock;
 
+extern Preference<bool> UseMapCache;
+
 Preference<IO::Path>& RendererFontPath();
 extern Preference<int> RendererFontSize;
 
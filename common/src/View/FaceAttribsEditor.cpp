@@ -506,6 +506,8 @@ void FaceAttribsEditor::connectObservers() {
     document->selectionDidChangeNotifier.connect(this, &FaceAttribsEditor::selectionDidChange);
   m_notifierConnection += document->textureCollectionsDidChangeNotifier.connect(
     this, &FaceAttribsEditor::textureCollectionsDidChange);
+  m_notifierConnection += document->textureCollectionsWereLoadedNotifier.connect(
+    this, &FaceAttribsEditor::textureCollectionsDidChange);
   m_notifierConnection +=
     document->grid().gridDidChangeNotifier.connect(this, &FaceAttribsEditor::updateIncrements);
 }
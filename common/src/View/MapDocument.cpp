@@ -71,6 +71,7 @@
 #include "Model/NodeContents.h"
 #include "Model/NonIntegerVerticesIssueGenerator.h"
 #include "Model/PatchNode.h"
+#include "Model/PickResult.h"
 #include "Model/PointEntityWithBrushesIssueGenerator.h"
 #include "Model/Polyhedron.h"
 #include "Model/Polyhedron3.h"
@@ -333,6 +334,62 @@ static bool applyAndSwap(
   return success;
 }
 
+/**
+ * The result of applying a lambda to the brushes of a number of brush nodes, see
+ * applyToBrushesInParallel.
+ */
+struct AppliedToBrushes {
+  // the new contents of the brush nodes whose brushes were modified, in the order of the nodes
+  std::vector<std::pair<Model::Node*, Model::NodeContents>> nodesToSwap;
+  // the number of brush nodes that were left unchanged
+  size_t unchangedCount = 0u;
+  // the errors, in the order of the nodes for which the lambda failed
+  std::vector<Model::BrushError> errors;
+};
+
+/**
+ * Applies the given lambda to a copy of the brush of each of the given brush nodes. The lambda is
+ * called on the shared thread pool, so it must not access the preferences or any other state that
+ * is not safe to access from several threads at once.
+ *
+ * The lambda L must be callable as
+ * - kdl::result<bool, Model::BrushError> operator()(Model::Brush&);
+ *
+ * and return true if it modified the given brush, or false if the node should remain unchanged.
+ *
+ * The results are collected in the order of the given nodes, so they do not depend on the order in
+ * which the brushes were processed.
+ */
+template <typename L>
+static AppliedToBrushes applyToBrushesInParallel(
+  const std::vector<Model::BrushNode*>& brushNodes, L lambda) {
+  using BrushResult = kdl::result<std::optional<Model::Brush>, Model::BrushError>;
+
+  auto brushResults =
+    kdl::vec_parallel_transform(brushNodes, [&](const Model::BrushNode* brushNode) -> BrushResult {
+      auto brush = brushNode->brush();
+      return lambda(brush).and_then([&](const bool modified) -> BrushResult {
+        return modified ? std::make_optional(std::move(brush)) : std::nullopt;
+      });
+    });
+
+  auto result = AppliedToBrushes{};
+  for (size_t i = 0u; i < brushNodes.size(); ++i) {
+    std::move(brushResults[i])
+      .and_then([&](std::optional<Model::Brush>&& brush) {
+        if (brush) {
+          result.nodesToSwap.emplace_back(brushNodes[i], Model::NodeContents{std::move(*brush)});
+        } else {
+          ++result.unchangedCount;
+        }
+      })
+      .handle_errors([&](const Model::BrushError e) {
+        result.errors.push_back(e);
+      });
+  }
+  return result;
+}
+
 const vm::bbox3 MapDocument::DefaultWorldBounds(-32768.0, 32768.0);
 const std::string MapDocument::DefaultDocumentName("unnamed.map");
 
@@ -1019,8 +1076,7 @@ void MapDocument::selectSiblings() {
 
 void MapDocument::selectTouching(const bool del) {
   const auto nodes = kdl::vec_filter(
-    Model::collectTouchingNodes(
-      std::vector<Model::Node*>{m_world.get()}, m_selectedNodes.brushes()),
+    Model::collectTouchingNodes(*m_world, m_selectedNodes.brushes()),
     [&](Model::Node* node) {
       return m_editorContext->selectable(node);
     });
@@ -1035,8 +1091,7 @@ void MapDocument::selectTouching(const bool del) {
 
 void MapDocument::selectInside(const bool del) {
   const auto nodes = kdl::vec_filter(
-    Model::collectContainedNodes(
-      std::vector<Model::Node*>{m_world.get()}, m_selectedNodes.brushes()),
+    Model::collectContainedNodes(*m_world, m_selectedNodes.brushes()),
     [&](Model::Node* node) {
       return m_editorContext->selectable(node);
     });
@@ -1187,11 +1242,12 @@ void MapDocument::selectTall(const vm::axis::type cameraAxis) {
 
       const auto nodesToSelect = kdl::vec_filter(
         Model::collectContainedNodes(
-          std::vector<Model::Node*>{world()}, kdl::vec_transform(
-                                                tallBrushes,
-                                                [](const auto& b) {
-                                                  return b.get();
-                                                })),
+          *world(),
+          kdl::vec_transform(
+            tallBrushes,
+            [](const auto& b) {
+              return b.get();
+            })),
         [&](const auto* node) {
           return editorContext().selectable(node);
         });
@@ -2560,15 +2616,20 @@ bool MapDocument::csgSubtract() {
     return &subtrahendNode->brush();
   });
 
+  const auto minuends = kdl::vec_transform(minuendNodes, [](const auto* minuendNode) {
+    return &minuendNode->brush();
+  });
+
+  auto subtractionResults = Model::subtractBrushes(
+    m_world->mapFormat(), m_worldBounds, currentTextureName(), minuends, subtrahends);
+
   auto toAdd = std::map<Model::Node*, std::vector<Model::Node*>>{};
   auto toRemove = std::vector<Model::Node*>{std::begin(subtrahendNodes), std::end(subtrahendNodes)};
 
-  for (auto* minuendNode : minuendNodes) {
-    const Model::Brush& minuend = minuendNode->brush();
-    auto currentSubtractionResults =
-      minuend.subtract(m_world->mapFormat(), m_worldBounds, currentTextureName(), subtrahends);
+  for (size_t i = 0; i < minuendNodes.size(); ++i) {
+    auto* minuendNode = minuendNodes[i];
     auto currentBrushes =
-      kdl::collect_values(std::move(currentSubtractionResults), [&](const Model::BrushError& e) {
+      kdl::collect_values(std::move(subtractionResults[i]), [&](const Model::BrushError& e) {
         error() << "Could not create brush: " << e;
       });
 
@@ -3073,46 +3134,33 @@ bool MapDocument::flipTextures(
 }
 
 bool MapDocument::snapVertices(const FloatType snapTo) {
-  size_t succeededBrushCount = 0;
-  size_t failedBrushCount = 0;
+  const auto uvLock = pref(Preferences::UVLock);
 
   const auto allSelectedBrushes = allSelectedBrushNodes();
-  const bool applyAndSwapSuccess = applyAndSwap(
-    *this, "Snap Brush Vertices", allSelectedBrushes,
-    findContainingLinkedGroupsToUpdate(*m_world, allSelectedBrushes),
-    kdl::overload(
-      [](Model::Layer&) {
-        return true;
-      },
-      [](Model::Group&) {
-        return true;
-      },
-      [](Model::Entity&) {
-        return true;
-      },
-      [&](Model::Brush& originalBrush) {
-        if (originalBrush.canSnapVertices(m_worldBounds, snapTo)) {
-          originalBrush.snapVertices(m_worldBounds, snapTo, pref(Preferences::UVLock))
-            .and_then([&]() {
-              succeededBrushCount += 1;
-            })
-            .handle_errors([&](const Model::BrushError e) {
-              error() << "Could not snap vertices: " << e;
-              failedBrushCount += 1;
-            });
-        } else {
-          failedBrushCount += 1;
-        }
-        return true;
-      },
-      [](Model::BezierPatch&) {
+  auto appliedToBrushes = applyToBrushesInParallel(
+    allSelectedBrushes, [&](Model::Brush& brush) -> kdl::result<bool, Model::BrushError> {
+      if (!brush.canSnapVertices(m_worldBounds, snapTo)) {
+        return false;
+      }
+      return brush.snapVertices(m_worldBounds, snapTo, uvLock).and_then([]() {
         return true;
-      }));
+      });
+    });
 
-  if (!applyAndSwapSuccess) {
-    return false;
+  for (const auto e : appliedToBrushes.errors) {
+    error() << "Could not snap vertices: " << e;
   }
+
+  const auto succeededBrushCount = appliedToBrushes.nodesToSwap.size();
+  const auto failedBrushCount = appliedToBrushes.unchangedCount + appliedToBrushes.errors.size();
+
   if (succeededBrushCount > 0) {
+    if (!swapNodeContents(
+          "Snap Brush Vertices", std::move(appliedToBrushes.nodesToSwap),
+          findContainingLinkedGroupsToUpdate(*m_world, allSelectedBrushes))) {
+      return false;
+    }
+
     info(kdl::str_to_string(
       "Snapped vertices of ", succeededBrushCount, " ",
       kdl::str_plural(succeededBrushCount, "brush", "brushes")));
@@ -3533,11 +3581,42 @@ void MapDocument::commitPendingAssets() {
   m_textureManager->commitChanges();
 }
 
+void MapDocument::publishLoadedTextures() {
+  if (!m_textureManager->loadingInBackground()) {
+    return;
+  }
+
+  if (m_textureManager->publishLoadedCollections()) {
+    {
+      const auto nodes = std::vector<Model::Node*>{m_world.get()};
+      NotifyBeforeAndAfter notifyNodes(nodesWillChangeNotifier, nodesDidChangeNotifier, nodes);
+      setTextures();
+    }
+    textureCollectionsWereLoadedNotifier();
+  }
+  if (!m_textureManager->loadingInBackground()) {
+    info("Finished loading texture collections");
+  }
+}
+
 void MapDocument::pick(const vm::ray3& pickRay, Model::PickResult& pickResult) const {
   if (m_world != nullptr)
     m_world->pick(*m_editorContext, pickRay, pickResult);
 }
 
+std::vector<Model::PickResult> MapDocument::pick(const std::vector<vm::ray3>& pickRays) const {
+  if (m_world != nullptr) {
+    return m_world->pickRays(*m_editorContext, pickRays);
+  }
+
+  auto pickResults = std::vector<Model::PickResult>{};
+  pickResults.reserve(pickRays.size());
+  for (size_t i = 0; i < pickRays.size(); ++i) {
+    pickResults.push_back(Model::PickResult::byDistance());
+  }
+  return pickResults;
+}
+
 std::vector<Model::Node*> MapDocument::findNodesContaining(const vm::vec3& point) const {
   std::vector<Model::Node*> result;
   if (m_world != nullptr) {
@@ -3696,6 +3775,9 @@ void MapDocument::reloadTextures() {
 
 void MapDocument::loadTextures() {
   try {
+    const auto cacheSize = static_cast<size_t>(std::max(pref(Preferences::TextureCacheSize), 0));
+    m_textureManager->setLazyLoading(pref(Preferences::LazyTextureLoading), cacheSize << 20);
+
     const IO::Path docDir = m_path.isEmpty() ? IO::Path() : m_path.deleteLastComponent();
     m_game->loadTextureCollections(m_world->entity(), docDir, *m_textureManager, logger());
   } catch (const Exception& e) { error(e.what()); }
@@ -3931,6 +4013,9 @@ std::vector<IO::Path> MapDocument::externalSearchPaths() const {
 }
 
 void MapDocument::updateGameSearchPaths() {
+  // the texture collections are read from the game file system
+  m_textureManager->finishLoadingInBackground();
+
   const std::vector<IO::Path> additionalSearchPaths = IO::Path::asPaths(mods());
   m_game->setAdditionalSearchPaths(additionalSearchPaths, logger());
 }
@@ -4221,6 +4306,8 @@ void MapDocument::connectObservers() {
   m_notifierConnection += modsDidChangeNotifier.connect(this, &MapDocument::updateAllFaceTags);
   m_notifierConnection +=
     textureCollectionsDidChangeNotifier.connect(this, &MapDocument::updateAllFaceTags);
+  m_notifierConnection +=
+    textureCollectionsWereLoadedNotifier.connect(this, &MapDocument::updateAllFaceTags);
 }
 
 void MapDocument::textureCollectionsWillChange() {
@@ -4259,6 +4346,7 @@ void MapDocument::preferenceDidChange(const IO::Path& path) {
   if (isGamePathPreference(path)) {
     const Model::GameFactory& gameFactory = Model::GameFactory::instance();
     const IO::Path newGamePath = gameFactory.gamePath(m_game->gameName());
+    m_textureManager->finishLoadingInBackground();
     m_game->setGamePath(newGamePath, logger());
 
     clearEntityModels();
@@ -180,6 +180,11 @@ public: // notification
 
   Notifier<> textureCollectionsWillChangeNotifier;
   Notifier<> textureCollectionsDidChangeNotifier;
+  /**
+   * Notifies observers that texture collections which were loaded in the background have been
+   * published. Loading has finished once textureManager().loadingInBackground() returns false.
+   */
+  Notifier<> textureCollectionsWereLoadedNotifier;
 
   Notifier<> textureUsageCountsDidChangeNotifier;
 
@@ -627,9 +632,20 @@ private: // subclassing interface for command processing
 
 public: // asset state management
   void commitPendingAssets();
+  /**
+   * Publishes the texture collections that were loaded in the background and assigns their
+   * textures to the faces. Must be called regularly while textures are being loaded.
+   */
+  void publishLoadedTextures();
 
 public: // picking
   void pick(const vm::ray3& pickRay, Model::PickResult& pickResult) const;
+
+  /**
+   * Picks the given rays at once and returns one pick result per ray, in the order of the rays.
+   * The pick results are sorted by distance.
+   */
+  std::vector<Model::PickResult> pick(const std::vector<vm::ray3>& pickRays) const;
   std::vector<Model::Node*> findNodesContaining(const vm::vec3& point) const;
 
 private: // world management
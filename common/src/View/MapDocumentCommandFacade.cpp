@@ -348,8 +348,17 @@ static auto notifySpecialWorldProperties(
   return std::make_tuple(false, false, false);
 }
 
-void MapDocumentCommandFacade::performSwapNodeContents(
+bool MapDocumentCommandFacade::performSwapNodeContents(
   std::vector<std::pair<Model::Node*, Model::NodeContents>>& nodesToSwap) {
+  for (auto& [node, contents] : nodesToSwap) {
+    const auto restored = contents.restore().handle_errors([&](const Model::BrushError& e) {
+      error() << "Could not restore brush: " << e;
+    });
+    if (!restored) {
+      return false;
+    }
+  }
+
   const auto nodes = kdl::vec_transform(nodesToSwap, [](const auto& pair) {
     return pair.first;
   });
@@ -411,6 +420,7 @@ void MapDocumentCommandFacade::performSwapNodeContents(
   }
 
   invalidateSelectionBounds();
+  return true;
 }
 
 std::map<Model::Node*, Model::VisibilityState> MapDocumentCommandFacade::setVisibilityState(
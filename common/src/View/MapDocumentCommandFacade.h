@@ -82,7 +82,13 @@ public: // adding and removing nodes
     std::vector<std::pair<Model::Node*, std::vector<std::unique_ptr<Model::Node>>>> nodes);
 
 public: // swapping node contents
-  void performSwapNodeContents(
+  /**
+   * Swaps the contents of the given nodes with the given contents. Contents that were compacted are
+   * restored first.
+   *
+   * Returns false and swaps nothing if compacted contents cannot be restored.
+   */
+  bool performSwapNodeContents(
     std::vector<std::pair<Model::Node*, Model::NodeContents>>& nodesToSwap);
 
 public: // Node Visibility
@@ -115,6 +115,7 @@ MapFrame::MapFrame(FrameManager* frameManager, std::shared_ptr<MapDocument> docu
   , m_lastInputTime(std::chrono::system_clock::now())
   , m_autosaver(std::make_unique<Autosaver>(m_document))
   , m_autosaveTimer(nullptr)
+  , m_loadedTexturesTimer(nullptr)
   , m_toolBar(nullptr)
   , m_hSplitter(nullptr)
   , m_vSplitter(nullptr)
@@ -157,6 +158,10 @@ MapFrame::MapFrame(FrameManager* frameManager, std::shared_ptr<MapDocument> docu
   m_autosaveTimer = new QTimer(this);
   m_autosaveTimer->start(1000);
 
+  // publishes the texture collections that were loaded in the background
+  m_loadedTexturesTimer = new QTimer(this);
+  m_loadedTexturesTimer->start(100);
+
   connectObservers();
   bindEvents();
 
@@ -813,6 +818,9 @@ void MapFrame::portalFileDidChange() {
 
 void MapFrame::bindEvents() {
   connect(m_autosaveTimer, &QTimer::timeout, this, &MapFrame::triggerAutosave);
+  connect(m_loadedTexturesTimer, &QTimer::timeout, this, [this]() {
+    m_document->publishLoadedTextures();
+  });
   connect(qApp, &QApplication::focusChanged, this, &MapFrame::focusChange);
   connect(m_gridChoice, QOverload<int>::of(&QComboBox::activated), this, [this](const int index) {
     setGridSize(index + Grid::MinSize);
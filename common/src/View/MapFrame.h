@@ -86,6 +86,7 @@ private:
   std::chrono::time_point<std::chrono::system_clock> m_lastInputTime;
   std::unique_ptr<Autosaver> m_autosaver;
   QTimer* m_autosaveTimer;
+  QTimer* m_loadedTexturesTimer;
 
   QToolBar* m_toolBar;
 
@@ -151,6 +151,8 @@ void MapViewBase::connectObservers() {
     document->selectionDidChangeNotifier.connect(this, &MapViewBase::selectionDidChange);
   m_notifierConnection += document->textureCollectionsDidChangeNotifier.connect(
     this, &MapViewBase::textureCollectionsDidChange);
+  m_notifierConnection += document->textureCollectionsWereLoadedNotifier.connect(
+    this, &MapViewBase::textureCollectionsDidChange);
   m_notifierConnection += document->entityDefinitionsDidChangeNotifier.connect(
     this, &MapViewBase::entityDefinitionsDidChange);
   m_notifierConnection +=
@@ -38,13 +38,18 @@ SwapNodeContentsCommand::SwapNodeContentsCommand(
     linkedGroupsToUpdate)
   : UndoableCommand(Type, name, true)
   , m_nodes(std::move(nodes))
-  , m_updateLinkedGroupsHelper(std::move(linkedGroupsToUpdate)) {}
+  , m_updateLinkedGroupsHelper(
+      std::move(linkedGroupsToUpdate), kdl::vec_transform(m_nodes, [](const auto& pair) {
+        return static_cast<const Model::Node*>(pair.first);
+      })) {}
 
 SwapNodeContentsCommand::~SwapNodeContentsCommand() = default;
 
 std::unique_ptr<CommandResult> SwapNodeContentsCommand::doPerformDo(
   MapDocumentCommandFacade* document) {
-  document->performSwapNodeContents(m_nodes);
+  if (!document->performSwapNodeContents(m_nodes)) {
+    return std::make_unique<CommandResult>(false);
+  }
 
   const auto success = m_updateLinkedGroupsHelper.applyLinkedGroupUpdates(*document).handle_errors(
     [&](const Model::UpdateLinkedGroupsError& e) {
@@ -52,16 +57,27 @@ std::unique_ptr<CommandResult> SwapNodeContentsCommand::doPerformDo(
       document->performSwapNodeContents(m_nodes);
     });
 
+  compactNodeContents();
   return std::make_unique<CommandResult>(success);
 }
 
 std::unique_ptr<CommandResult> SwapNodeContentsCommand::doPerformUndo(
   MapDocumentCommandFacade* document) {
-  document->performSwapNodeContents(m_nodes);
+  if (!document->performSwapNodeContents(m_nodes)) {
+    return std::make_unique<CommandResult>(false);
+  }
+
   m_updateLinkedGroupsHelper.undoLinkedGroupUpdates(*document);
+  compactNodeContents();
   return std::make_unique<CommandResult>(true);
 }
 
+void SwapNodeContentsCommand::compactNodeContents() {
+  for (auto& [node, contents] : m_nodes) {
+    contents.compact();
+  }
+}
+
 bool SwapNodeContentsCommand::doCollateWith(UndoableCommand* command) {
   auto* other = static_cast<SwapNodeContentsCommand*>(command);
 
@@ -59,6 +59,12 @@ public:
   bool doCollateWith(UndoableCommand* command) override;
 
   deleteCopyAndMove(SwapNodeContentsCommand);
+
+private:
+  /**
+   * Replaces the brushes that are kept for undo or redo by compact snapshots.
+   */
+  void compactNodeContents();
 };
 } // namespace View
 } // namespace TrenchBroom
@@ -184,6 +184,8 @@ void TextureBrowser::connectObservers() {
     document->brushFacesDidChangeNotifier.connect(this, &TextureBrowser::brushFacesDidChange);
   m_notifierConnection += document->textureCollectionsDidChangeNotifier.connect(
     this, &TextureBrowser::textureCollectionsDidChange);
+  m_notifierConnection += document->textureCollectionsWereLoadedNotifier.connect(
+    this, &TextureBrowser::textureCollectionsDidChange);
   m_notifierConnection += document->currentTextureNameDidChangeNotifier.connect(
     this, &TextureBrowser::currentTextureNameDidChange);
 
@@ -31,6 +31,7 @@
 #include <kdl/result_for_each.h>
 #include <kdl/vector_utils.h>
 
+#include <algorithm>
 #include <cassert>
 #include <map>
 #include <unordered_set>
@@ -59,8 +60,11 @@ const auto compareByAncestry = [](const auto& lhs, const auto& rhs) {
   return rhs.first->isAncestorOf(lhs.first);
 };
 
-UpdateLinkedGroupsHelper::UpdateLinkedGroupsHelper(LinkedGroupsToUpdate linkedGroupsToUpdate)
-  : m_state{kdl::vec_sort(std::move(linkedGroupsToUpdate), compareByAncestry)} {}
+UpdateLinkedGroupsHelper::UpdateLinkedGroupsHelper(
+  LinkedGroupsToUpdate linkedGroupsToUpdate,
+  std::optional<std::vector<const Model::Node*>> changedNodes)
+  : m_state{kdl::vec_sort(std::move(linkedGroupsToUpdate), compareByAncestry)}
+  , m_changedNodes{std::move(changedNodes)} {}
 
 UpdateLinkedGroupsHelper::~UpdateLinkedGroupsHelper() = default;
 
@@ -91,16 +95,32 @@ void UpdateLinkedGroupsHelper::collateWith(UpdateLinkedGroupsHelper& other) {
   auto& myLinkedGroupUpdates = std::get<LinkedGroupUpdates>(m_state);
   auto& theirLinkedGroupUpdates = std::get<LinkedGroupUpdates>(other.m_state);
 
-  for (auto& theirUpdate : theirLinkedGroupUpdates) {
+  auto& myReplacedChildren = myLinkedGroupUpdates.replacedChildren;
+  for (auto& theirUpdate : theirLinkedGroupUpdates.replacedChildren) {
     Model::Node* theirGroupNodeToUpdate = theirUpdate.first;
     std::vector<std::unique_ptr<Model::Node>>& theirOldChildren = theirUpdate.second;
 
     auto myIt = std::find_if(
-      std::begin(myLinkedGroupUpdates), std::end(myLinkedGroupUpdates), [&](const auto& p) {
+      std::begin(myReplacedChildren), std::end(myReplacedChildren), [&](const auto& p) {
         return p.first == theirGroupNodeToUpdate;
       });
-    if (myIt == std::end(myLinkedGroupUpdates)) {
-      myLinkedGroupUpdates.emplace_back(theirGroupNodeToUpdate, std::move(theirOldChildren));
+    if (myIt == std::end(myReplacedChildren)) {
+      myReplacedChildren.emplace_back(theirGroupNodeToUpdate, std::move(theirOldChildren));
+    }
+  }
+
+  // The same applies to the nodes whose contents were swapped: we keep the original contents
+  // stored in this helper.
+  auto& mySwappedContents = myLinkedGroupUpdates.swappedContents;
+  for (auto& theirUpdate : theirLinkedGroupUpdates.swappedContents) {
+    Model::Node* theirNodeToUpdate = theirUpdate.first;
+
+    auto myIt =
+      std::find_if(std::begin(mySwappedContents), std::end(mySwappedContents), [&](const auto& p) {
+        return p.first == theirNodeToUpdate;
+      });
+    if (myIt == std::end(mySwappedContents)) {
+      mySwappedContents.emplace_back(theirNodeToUpdate, std::move(theirUpdate.second));
     }
   }
 }
@@ -110,7 +130,7 @@ kdl::result<void, Model::UpdateLinkedGroupsError> UpdateLinkedGroupsHelper::
   return std::visit(
     kdl::overload(
       [&](const LinkedGroupsToUpdate& linkedGroups) {
-        return computeLinkedGroupUpdates(linkedGroups, document.worldBounds())
+        return computeLinkedGroupUpdates(linkedGroups, m_changedNodes, document.worldBounds())
           .and_then([&](auto&& linkedGroupUpdates) {
             m_state = std::move(linkedGroupUpdates);
           });
@@ -121,24 +141,83 @@ kdl::result<void, Model::UpdateLinkedGroupsError> UpdateLinkedGroupsHelper::
     m_state);
 }
 
+/**
+ * Replaces the children of all given target group nodes with transformed clones of the children of
+ * their source group nodes.
+ */
+static kdl::result<Model::UpdateLinkedGroupsResult, Model::UpdateLinkedGroupsError>
+replaceLinkedGroupChildren(
+  const std::vector<std::pair<const Model::GroupNode*, std::vector<Model::GroupNode*>>>&
+    linkedGroupsToUpdate,
+  const vm::bbox3& worldBounds) {
+  return kdl::for_each_result(
+           linkedGroupsToUpdate,
+           [&](const auto& pair) {
+             return Model::updateLinkedGroups(*pair.first, pair.second, worldBounds);
+           })
+    .and_then(
+      [&](auto&& nestedUpdateLists)
+        -> kdl::result<Model::UpdateLinkedGroupsResult, Model::UpdateLinkedGroupsError> {
+        return kdl::vec_flatten(std::move(nestedUpdateLists));
+      });
+}
+
 kdl::result<UpdateLinkedGroupsHelper::LinkedGroupUpdates, Model::UpdateLinkedGroupsError>
 UpdateLinkedGroupsHelper::computeLinkedGroupUpdates(
-  const LinkedGroupsToUpdate& linkedGroupsToUpdate, const vm::bbox3& worldBounds) {
+  const LinkedGroupsToUpdate& linkedGroupsToUpdate,
+  const std::optional<std::vector<const Model::Node*>>& changedNodes,
+  const vm::bbox3& worldBounds) {
   if (!checkLinkedGroupsToUpdate(kdl::vec_transform(linkedGroupsToUpdate, [](const auto& p) {
         return p.first;
       }))) {
     return Model::UpdateLinkedGroupsError::UpdateIsInconsistent;
   }
 
+  const auto replaceAllChildren = [&]() {
+    return replaceLinkedGroupChildren(linkedGroupsToUpdate, worldBounds)
+      .and_then(
+        [](Model::UpdateLinkedGroupsResult&& replacedChildren)
+          -> kdl::result<LinkedGroupUpdates, Model::UpdateLinkedGroupsError> {
+          return LinkedGroupUpdates{std::move(replacedChildren), {}};
+        });
+  };
+
+  if (!changedNodes) {
+    return replaceAllChildren();
+  }
+
   return kdl::for_each_result(
            linkedGroupsToUpdate,
            [&](const auto& pair) {
-             return Model::updateLinkedGroups(*pair.first, pair.second, worldBounds);
+             return Model::updateLinkedGroupNodes(
+               *pair.first, pair.second, *changedNodes, worldBounds);
            })
     .and_then(
-      [&](auto&& nestedUpdateLists)
+      [&](std::vector<LinkedGroupUpdates>&& updates)
         -> kdl::result<LinkedGroupUpdates, Model::UpdateLinkedGroupsError> {
-        return kdl::vec_flatten(std::move(nestedUpdateLists));
+        // Nested linked groups may contain the same nodes, so swapping the contents of some
+        // nodes cannot be combined with replacing the children of other linked groups.
+        const auto anyChildrenReplaced =
+          std::any_of(std::begin(updates), std::end(updates), [](const auto& update) {
+            return !update.replacedChildren.empty();
+          });
+        if (anyChildrenReplaced) {
+          return replaceAllChildren();
+        }
+
+        // The contents of a node in a nested linked group can be updated from its own source group
+        // and from the source group of an enclosing linked group. The updates of the nested groups
+        // come first, and we keep only the first update of every node.
+        auto result = LinkedGroupUpdates{};
+        auto updatedNodes = std::unordered_set<const Model::Node*>{};
+        for (auto& update : updates) {
+          for (auto& [node, contents] : update.swappedContents) {
+            if (updatedNodes.insert(node).second) {
+              result.swappedContents.emplace_back(node, std::move(contents));
+            }
+          }
+        }
+        return {std::move(result)};
       });
 }
 
@@ -147,7 +226,18 @@ void UpdateLinkedGroupsHelper::doApplyOrUndoLinkedGroupUpdates(MapDocumentComman
     kdl::overload(
       [](const LinkedGroupsToUpdate&) {},
       [&](LinkedGroupUpdates&& linkedGroupUpdates) {
-        m_state = document.performReplaceChildren(std::move(linkedGroupUpdates));
+        auto replacedChildren =
+          document.performReplaceChildren(std::move(linkedGroupUpdates.replacedChildren));
+
+        auto& swappedContents = linkedGroupUpdates.swappedContents;
+        if (!swappedContents.empty()) {
+          document.performSwapNodeContents(swappedContents);
+          for (auto& [node, contents] : swappedContents) {
+            contents.compact();
+          }
+        }
+
+        m_state = LinkedGroupUpdates{std::move(replacedChildren), std::move(swappedContents)};
       }),
     std::move(m_state));
 }
@@ -20,18 +20,18 @@
 #pragma once
 
 #include "FloatType.h"
+#include "Model/GroupNode.h"
 
 #include <kdl/result_forward.h>
 
 #include <memory>
+#include <optional>
 #include <utility>
 #include <variant>
 #include <vector>
 
 namespace TrenchBroom {
 namespace Model {
-class GroupNode;
-class Node;
 enum class UpdateLinkedGroupsError;
 } // namespace Model
 
@@ -55,17 +55,23 @@ bool checkLinkedGroupsToUpdate(const std::vector<const Model::GroupNode*>& linke
  * linked groups are replaced with their replacements. Calling applyLinkedGroupUpdates replaces
  * the replacement nodes with their original corresponding groups again, effectively undoing the
  * change.
+ *
+ * If the helper is given the nodes whose contents were changed by a command, then only the
+ * corresponding nodes in the linked groups are updated by swapping their contents, unless the
+ * structure of a linked group does not match the structure of its source group.
  */
 class UpdateLinkedGroupsHelper {
 private:
   using LinkedGroupsToUpdate =
     std::vector<std::pair<const Model::GroupNode*, std::vector<Model::GroupNode*>>>;
-  using LinkedGroupUpdates =
-    std::vector<std::pair<Model::Node*, std::vector<std::unique_ptr<Model::Node>>>>;
+  using LinkedGroupUpdates = Model::UpdateLinkedGroupNodesResult;
   std::variant<LinkedGroupsToUpdate, LinkedGroupUpdates> m_state;
+  std::optional<std::vector<const Model::Node*>> m_changedNodes;
 
 public:
-  explicit UpdateLinkedGroupsHelper(LinkedGroupsToUpdate linkedGroupsToUpdate);
+  explicit UpdateLinkedGroupsHelper(
+    LinkedGroupsToUpdate linkedGroupsToUpdate,
+    std::optional<std::vector<const Model::Node*>> changedNodes = std::nullopt);
   ~UpdateLinkedGroupsHelper();
 
   kdl::result<void, Model::UpdateLinkedGroupsError> applyLinkedGroupUpdates(
@@ -77,7 +83,9 @@ private:
   kdl::result<void, Model::UpdateLinkedGroupsError> computeLinkedGroupUpdates(
     MapDocumentCommandFacade& document);
   static kdl::result<LinkedGroupUpdates, Model::UpdateLinkedGroupsError> computeLinkedGroupUpdates(
-    const LinkedGroupsToUpdate& linkedGroupsToUpdate, const vm::bbox3& worldBounds);
+    const LinkedGroupsToUpdate& linkedGroupsToUpdate,
+    const std::optional<std::vector<const Model::Node*>>& changedNodes,
+    const vm::bbox3& worldBounds);
 
   void doApplyOrUndoLinkedGroupUpdates(MapDocumentCommandFacade& document);
 };
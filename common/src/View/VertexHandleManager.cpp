@@ -25,6 +25,7 @@
 #include "Preferences.h"
 #include "View/Grid.h"
 
+#include <vecmath/bbox.h>
 #include <vecmath/distance.h>
 #include <vecmath/intersection.h>
 #include <vecmath/plane.h>
@@ -39,15 +40,15 @@ const Model::HitType::Type VertexHandleManager::HandleHitType = Model::HitType::
 
 void VertexHandleManager::pick(
   const vm::ray3& pickRay, const Renderer::Camera& camera, Model::PickResult& pickResult) const {
-  for (const auto& [position, info] : m_handles) {
-    const auto distance = camera.pickPointHandle(
-      pickRay, position, static_cast<FloatType>(pref(Preferences::HandleRadius)));
+  const auto handleRadius = static_cast<FloatType>(pref(Preferences::HandleRadius));
+  forEachHandleNearRay(pickRay, camera, handleRadius, [&](const vm::vec3& position) {
+    const auto distance = camera.pickPointHandle(pickRay, position, handleRadius);
     if (!vm::is_nan(distance)) {
       const auto hitPoint = vm::point_at_distance(pickRay, distance);
       const auto error = vm::squared_distance(pickRay, position).distance;
       pickResult.addHit(Model::Hit::hit(HandleHitType, distance, hitPoint, position, error));
     }
-  }
+  });
 }
 
 void VertexHandleManager::addHandles(const Model::BrushNode* brushNode) {
@@ -68,6 +69,10 @@ Model::HitType::Type VertexHandleManager::hitType() const {
   return HandleHitType;
 }
 
+vm::bbox3 VertexHandleManager::handleBounds(const Handle& handle) const {
+  return vm::bbox3{handle, handle};
+}
+
 bool VertexHandleManager::isIncident(
   const Handle& handle, const Model::BrushNode* brushNode) const {
   const Model::Brush& brush = brushNode->brush();
@@ -79,34 +84,33 @@ const Model::HitType::Type EdgeHandleManager::HandleHitType = Model::HitType::fr
 void EdgeHandleManager::pickGridHandle(
   const vm::ray3& pickRay, const Renderer::Camera& camera, const Grid& grid,
   Model::PickResult& pickResult) const {
-  for (const auto& [position, info] : m_handles) {
-    const FloatType edgeDist = camera.pickLineSegmentHandle(
-      pickRay, position, static_cast<FloatType>(pref(Preferences::HandleRadius)));
+  const auto handleRadius = static_cast<FloatType>(pref(Preferences::HandleRadius));
+  forEachHandleNearRay(pickRay, camera, handleRadius, [&](const vm::segment3& position) {
+    const FloatType edgeDist = camera.pickLineSegmentHandle(pickRay, position, handleRadius);
     if (!vm::is_nan(edgeDist)) {
       const vm::vec3 pointHandle = grid.snap(vm::point_at_distance(pickRay, edgeDist), position);
-      const FloatType pointDist = camera.pickPointHandle(
-        pickRay, pointHandle, static_cast<FloatType>(pref(Preferences::HandleRadius)));
+      const FloatType pointDist = camera.pickPointHandle(pickRay, pointHandle, handleRadius);
       if (!vm::is_nan(pointDist)) {
         const vm::vec3 hitPoint = vm::point_at_distance(pickRay, pointDist);
         pickResult.addHit(
           Model::Hit::hit(HandleHitType, pointDist, hitPoint, HitType(position, pointHandle)));
       }
     }
-  }
+  });
 }
 
 void EdgeHandleManager::pickCenterHandle(
   const vm::ray3& pickRay, const Renderer::Camera& camera, Model::PickResult& pickResult) const {
-  for (const auto& [position, info] : m_handles) {
+  const auto handleRadius = static_cast<FloatType>(pref(Preferences::HandleRadius));
+  forEachHandleNearRay(pickRay, camera, handleRadius, [&](const vm::segment3& position) {
     const vm::vec3 pointHandle = position.center();
 
-    const FloatType pointDist = camera.pickPointHandle(
-      pickRay, pointHandle, static_cast<FloatType>(pref(Preferences::HandleRadius)));
+    const FloatType pointDist = camera.pickPointHandle(pickRay, pointHandle, handleRadius);
     if (!vm::is_nan(pointDist)) {
       const vm::vec3 hitPoint = vm::point_at_distance(pickRay, pointDist);
       pickResult.addHit(Model::Hit::hit(HandleHitType, pointDist, hitPoint, position));
     }
-  }
+  });
 }
 
 void EdgeHandleManager::addHandles(const Model::BrushNode* brushNode) {
@@ -128,6 +132,10 @@ Model::HitType::Type EdgeHandleManager::hitType() const {
   return HandleHitType;
 }
 
+vm::bbox3 EdgeHandleManager::handleBounds(const Handle& handle) const {
+  return vm::bbox3{vm::min(handle.start(), handle.end()), vm::max(handle.start(), handle.end())};
+}
+
 bool EdgeHandleManager::isIncident(const Handle& handle, const Model::BrushNode* brushNode) const {
   const Model::Brush& brush = brushNode->brush();
   return brush.hasEdge(handle);
@@ -138,10 +146,11 @@ const Model::HitType::Type FaceHandleManager::HandleHitType = Model::HitType::fr
 void FaceHandleManager::pickGridHandle(
   const vm::ray3& pickRay, const Renderer::Camera& camera, const Grid& grid,
   Model::PickResult& pickResult) const {
-  for (const auto& [position, info] : m_handles) {
+  const auto handleRadius = static_cast<FloatType>(pref(Preferences::HandleRadius));
+  forEachHandleNearRay(pickRay, camera, handleRadius, [&](const vm::polygon3& position) {
     const auto [valid, plane] = vm::from_points(std::begin(position), std::end(position));
     if (!valid) {
-      continue;
+      return;
     }
 
     const auto distance =
@@ -149,29 +158,28 @@ void FaceHandleManager::pickGridHandle(
     if (!vm::is_nan(distance)) {
       const auto pointHandle = grid.snap(vm::point_at_distance(pickRay, distance), plane);
 
-      const auto pointDist = camera.pickPointHandle(
-        pickRay, pointHandle, static_cast<FloatType>(pref(Preferences::HandleRadius)));
+      const auto pointDist = camera.pickPointHandle(pickRay, pointHandle, handleRadius);
       if (!vm::is_nan(pointDist)) {
         const auto hitPoint = vm::point_at_distance(pickRay, pointDist);
         pickResult.addHit(
           Model::Hit::hit(HandleHitType, pointDist, hitPoint, HitType(position, pointHandle)));
       }
     }
-  }
+  });
 }
 
 void FaceHandleManager::pickCenterHandle(
   const vm::ray3& pickRay, const Renderer::Camera& camera, Model::PickResult& pickResult) const {
-  for (const auto& [position, info] : m_handles) {
+  const auto handleRadius = static_cast<FloatType>(pref(Preferences::HandleRadius));
+  forEachHandleNearRay(pickRay, camera, handleRadius, [&](const vm::polygon3& position) {
     const auto pointHandle = position.center();
 
-    const auto pointDist = camera.pickPointHandle(
-      pickRay, pointHandle, static_cast<FloatType>(pref(Preferences::HandleRadius)));
+    const auto pointDist = camera.pickPointHandle(pickRay, pointHandle, handleRadius);
     if (!vm::is_nan(pointDist)) {
       const auto hitPoint = vm::point_at_distance(pickRay, pointDist);
       pickResult.addHit(Model::Hit::hit(HandleHitType, pointDist, hitPoint, position));
     }
-  }
+  });
 }
 
 void FaceHandleManager::addHandles(const Model::BrushNode* brushNode) {
@@ -192,6 +200,10 @@ Model::HitType::Type FaceHandleManager::hitType() const {
   return HandleHitType;
 }
 
+vm::bbox3 FaceHandleManager::handleBounds(const Handle& handle) const {
+  return vm::bbox3::merge_all(std::begin(handle), std::end(handle));
+}
+
 bool FaceHandleManager::isIncident(const Handle& handle, const Model::BrushNode* brushNode) const {
   const Model::Brush& brush = brushNode->brush();
   return brush.hasFace(handle);
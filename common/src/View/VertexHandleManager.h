@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include "AABBTree.h"
 #include "FloatType.h"
 #include "Model/BrushFace.h"
 #include "Model/BrushNode.h"
@@ -28,10 +29,16 @@
 
 #include <kdl/vector_set.h>
 
+#include <vecmath/bbox.h>
+#include <vecmath/intersection.h>
+#include <vecmath/ray.h>
+#include <vecmath/scalar.h>
 #include <vecmath/segment.h>
 
+#include <algorithm>
 #include <iterator>
 #include <map>
+#include <unordered_set>
 #include <vector>
 
 namespace TrenchBroom {
@@ -154,12 +161,26 @@ protected:
 
   using HandleMap = std::map<H, HandleInfo>;
   using HandleEntry = typename HandleMap::value_type;
+  using HandleTree = AABBTree<FloatType, 3, HandleEntry*>;
 
   /**
    * Maps a handle position to its info.
    */
   HandleMap m_handles;
 
+  /**
+   * Indexes the entries of m_handles by the bounds of their handles, so that the handles near a
+   * point or a pick ray can be found without visiting every handle.
+   *
+   * Added and removed handles are recorded and applied to the tree in one batch when it is queried
+   * next, see updateHandleTree. A drag step of the vertex tool removes and adds the handles of all
+   * changed brushes, so the tree is only updated once per drag step. Handles that are added and
+   * removed again in the same batch never enter the tree.
+   */
+  mutable HandleTree m_handleTree;
+  mutable std::unordered_set<HandleEntry*> m_pendingInserts;
+  mutable std::vector<HandleEntry*> m_pendingRemovals;
+
   /**
    * The total number of selected handles, not counting duplicates.
    */
@@ -300,8 +321,11 @@ public:
    * @param handle the handle to add
    */
   void add(const Handle& handle) {
-    m_handles[handle].inc(); // unknown value gets value constructed, which for HandleInfo means its
-                             // default constructor is called
+    auto [it, inserted] = m_handles.try_emplace(handle);
+    if (inserted) {
+      m_pendingInserts.insert(&*it);
+    }
+    it->second.inc();
   }
 
   /**
@@ -319,6 +343,9 @@ public:
 
       if (info.count == 0) {
         deselect(info);
+        if (m_pendingInserts.erase(&*it) == 0u) {
+          m_pendingRemovals.push_back(&*it);
+        }
         m_handles.erase(it);
       }
       return true;
@@ -331,6 +358,9 @@ public:
    * Removes all handles from this manager.
    */
   void clear() {
+    m_handleTree.clear();
+    m_pendingInserts.clear();
+    m_pendingRemovals.clear();
     m_handles.clear();
     m_selectedHandleCount = 0;
   }
@@ -423,13 +453,55 @@ public:
 private:
   template <typename F> void forEachCloseHandle(const H& otherHandle, F fun) {
     static const auto epsilon = 0.001 * 0.001;
-    for (auto& [handle, info] : m_handles) {
-      if (compare(otherHandle, handle, epsilon) == 0) {
-        fun(info);
+
+    auto candidates = std::vector<HandleEntry*>{};
+    handleTree().findIntersectors(
+      handleBounds(otherHandle).expand(epsilon), std::back_inserter(candidates));
+
+    for (auto* entry : candidates) {
+      if (compare(otherHandle, entry->first, epsilon) == 0) {
+        fun(entry->second);
       }
     }
   }
 
+  /**
+   * Returns the handle tree after applying the pending changes to it. If more than half of the
+   * handles changed, the tree is rebuilt from scratch, which is faster and yields a better tree
+   * than applying the changes one by one.
+   */
+  const HandleTree& handleTree() const {
+    if (m_pendingInserts.empty() && m_pendingRemovals.empty()) {
+      return m_handleTree;
+    }
+
+    const auto getBounds = [&](const HandleEntry* entry) {
+      return handleBounds(entry->first);
+    };
+
+    if (2u * (m_pendingInserts.size() + m_pendingRemovals.size()) > m_handles.size()) {
+      // the tree only gives access to entries owned by this manager, so it is safe to store them as
+      // non const pointers
+      auto entries = std::vector<HandleEntry*>{};
+      entries.reserve(m_handles.size());
+      for (const auto& entry : m_handles) {
+        entries.push_back(const_cast<HandleEntry*>(&entry));
+      }
+      m_handleTree.clearAndBuild(entries, getBounds);
+    } else {
+      for (auto* entry : m_pendingRemovals) {
+        m_handleTree.remove(entry);
+      }
+      for (auto* entry : m_pendingInserts) {
+        m_handleTree.insert(getBounds(entry), entry);
+      }
+    }
+
+    m_pendingInserts.clear();
+    m_pendingRemovals.clear();
+    return m_handleTree;
+  }
+
   void select(HandleInfo& info) {
     if (info.select()) {
       assert(selectedHandleCount() < totalHandleCount());
@@ -454,6 +526,44 @@ private:
     }
   }
 
+protected:
+  /**
+   * Calls the given function with every handle that could be hit by the given pick ray if every
+   * point of the handle is picked as a point handle with the given radius, see
+   * Renderer::Camera::pickPointHandle.
+   *
+   * @tparam F the type of the function to call, must be of type `void(const Handle&)`
+   * @param pickRay the picking ray
+   * @param camera the camera
+   * @param handleRadius the handle radius
+   * @param fun the function to call
+   */
+  template <typename F>
+  void forEachHandleNearRay(
+    const vm::ray3& pickRay, const Renderer::Camera& camera, const FloatType handleRadius,
+    F fun) const {
+    const auto mayBeHit = [&](const vm::bbox3& bounds) {
+      // the scaling factor of a perspective camera depends linearly on the distance along the view
+      // direction, so its largest absolute value within the bounds is found at one of the corners
+      auto scaling = FloatType(0);
+      bounds.for_each_vertex([&](const vm::vec3& vertex) {
+        const auto vertexScaling = camera.perspectiveScalingFactor(vm::vec3f{vertex});
+        scaling = std::max(scaling, vm::abs(static_cast<FloatType>(vertexScaling)));
+      });
+
+      const auto pickBounds = bounds.expand(FloatType(2) * handleRadius * scaling);
+      return pickBounds.contains(pickRay.origin) ||
+             !vm::is_nan(vm::intersect_ray_bbox(pickRay, pickBounds));
+    };
+
+    auto candidates = std::vector<HandleEntry*>{};
+    handleTree().findIf(mayBeHit, std::back_inserter(candidates));
+
+    for (const auto* entry : candidates) {
+      fun(entry->first);
+    }
+  }
+
 public:
   /**
    * Applies the given picking test to all handles in this manager and adds all hits to the given
@@ -532,6 +642,11 @@ public:
   }
 
 private:
+  /**
+   * Returns the bounds of the given handle.
+   */
+  virtual vm::bbox3 handleBounds(const Handle& handle) const = 0;
+
   /**
    * Checks whether the given brush is incident to the given handle.
    *
@@ -572,6 +687,7 @@ public:
   Model::HitType::Type hitType() const override;
 
 private:
+  vm::bbox3 handleBounds(const Handle& handle) const override;
   bool isIncident(const Handle& handle, const Model::BrushNode* brushNode) const override;
 };
 
@@ -625,6 +741,7 @@ public:
   Model::HitType::Type hitType() const override;
 
 private:
+  vm::bbox3 handleBounds(const Handle& handle) const override;
   bool isIncident(const Handle& handle, const Model::BrushNode* brushNode) const override;
 };
 
@@ -678,6 +795,7 @@ public:
   Model::HitType::Type hitType() const override;
 
 private:
+  vm::bbox3 handleBounds(const Handle& handle) const override;
   bool isIncident(const Handle& handle, const Model::BrushNode* brushNode) const override;
 };
 } // namespace View
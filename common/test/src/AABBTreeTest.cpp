@@ -567,6 +567,117 @@ TEST_CASE("AABBTreeTest.findIntersectorsFromInsideRootBBox", "[AABBTreeTest]") {
   assertIntersectors(tree, RAY(VEC(0.0, 0.0, 0.0), VEC::pos_x()), {2u});
 }
 
+TEST_CASE("AABBTreeTest.findIntersectorsAfterChanges", "[AABBTreeTest]") {
+  AABB tree;
+  tree.insert(BOX(VEC(-4.0, -1.0, -1.0), VEC(-2.0, +1.0, +1.0)), 1u);
+  tree.insert(BOX(VEC(+2.0, -1.0, -1.0), VEC(+4.0, +1.0, +1.0)), 2u);
+
+  const auto ray = RAY(VEC(-5.0, 0.0, 0.0), VEC::pos_x());
+  assertIntersectors(tree, ray, {1u, 2u});
+
+  tree.insert(BOX(VEC(-1.0, -1.0, -1.0), VEC(+1.0, +1.0, +1.0)), 3u);
+  assertIntersectors(tree, ray, {1u, 2u, 3u});
+
+  tree.update(BOX(VEC(-1.0, +2.0, -1.0), VEC(+1.0, +4.0, +1.0)), 3u);
+  assertIntersectors(tree, ray, {1u, 2u});
+  assertIntersectors(tree, RAY(VEC(0.0, 0.0, 0.0), VEC::pos_y()), {3u});
+
+  tree.remove(1u);
+  assertIntersectors(tree, ray, {2u});
+
+  tree.clear();
+  assertIntersectors(tree, ray, {});
+}
+
+TEST_CASE("AABBTreeTest.findIntersectorsBeforeAndAfterFlatTreeRebuild", "[AABBTreeTest]") {
+  AABB tree;
+  for (size_t i = 0; i < 20; ++i) {
+    const auto x = static_cast<double>(i) * 4.0;
+    tree.insert(BOX(VEC(x, -1.0, -1.0), VEC(x + 2.0, +1.0, +1.0)), i);
+  }
+
+  const auto ray = RAY(VEC(-1.0, 0.0, 0.0), VEC::pos_x());
+  auto expected = std::set<size_t>{};
+  for (size_t i = 0; i < 20; ++i) {
+    expected.insert(i);
+  }
+
+  const auto checkQueries = [&]() {
+    // the first queries after a change are answered without the flat tree
+    for (size_t i = 0; i < 2 * AABB::FlatTreeRebuildQueryCount; ++i) {
+      auto actual = std::set<size_t>{};
+      tree.findIntersectors(ray, std::inserter(actual, std::end(actual)));
+      CHECK(actual == expected);
+    }
+  };
+
+  checkQueries();
+
+  // refitting updates the flat tree in place
+  tree.refit(std::vector<size_t>{3u}, [](const size_t) {
+    return BOX(VEC(12.0, 2.0, -1.0), VEC(14.0, 4.0, +1.0));
+  });
+  expected.erase(3u);
+  checkQueries();
+
+  tree.remove(5u);
+  expected.erase(5u);
+  checkQueries();
+
+  tree.update(BOX(VEC(12.0, -1.0, -1.0), VEC(14.0, 1.0, 1.0)), 3u);
+  expected.insert(3u);
+  checkQueries();
+}
+
+TEST_CASE("AABBTreeTest.findIntersectorsOfBox", "[AABBTreeTest]") {
+  AABB tree;
+  CHECK(tree.findIntersectors(BOX(VEC(-1.0, -1.0, -1.0), VEC(1.0, 1.0, 1.0))).empty());
+
+  tree.insert(BOX(VEC(-4.0, -1.0, -1.0), VEC(-2.0, +1.0, +1.0)), 1u);
+  tree.insert(BOX(VEC(+2.0, -1.0, -1.0), VEC(+4.0, +1.0, +1.0)), 2u);
+  tree.insert(BOX(VEC(-1.0, -1.0, -1.0), VEC(+1.0, +1.0, +1.0)), 3u);
+
+  CHECK_THAT(
+    tree.findIntersectors(BOX(VEC(-0.5, -0.5, -0.5), VEC(0.5, 0.5, 0.5))),
+    Catch::UnorderedEquals(std::vector<size_t>{3u}));
+  CHECK_THAT(
+    tree.findIntersectors(BOX(VEC(-3.0, -0.5, -0.5), VEC(3.0, 0.5, 0.5))),
+    Catch::UnorderedEquals(std::vector<size_t>{1u, 2u, 3u}));
+  CHECK_THAT(
+    tree.findIntersectors(BOX(VEC(1.0, 1.0, 1.0), VEC(2.0, 2.0, 2.0))),
+    Catch::UnorderedEquals(std::vector<size_t>{2u, 3u}));
+  CHECK_THAT(
+    tree.findIntersectors(BOX(VEC(-1.5, -1.0, -1.0), VEC(-1.25, 1.0, 1.0))),
+    Catch::UnorderedEquals(std::vector<size_t>{}));
+  CHECK_THAT(
+    tree.findIntersectors(BOX(VEC(-3.0, 2.0, -1.0), VEC(3.0, 3.0, 1.0))),
+    Catch::UnorderedEquals(std::vector<size_t>{}));
+}
+
+TEST_CASE("AABBTreeTest.findIf", "[AABBTreeTest]") {
+  AABB tree;
+
+  std::vector<size_t> result;
+  tree.findIf(
+    [](const BOX&) {
+      return true;
+    },
+    std::back_inserter(result));
+  CHECK(result.empty());
+
+  for (size_t i = 0; i < 20; ++i) {
+    const auto x = static_cast<double>(i) * 4.0;
+    tree.insert(BOX(VEC(x, -1.0, -1.0), VEC(x + 2.0, +1.0, +1.0)), i);
+  }
+
+  tree.findIf(
+    [](const BOX& bounds) {
+      return bounds.max.x() >= 30.0 && bounds.min.x() <= 50.0;
+    },
+    std::back_inserter(result));
+  CHECK_THAT(result, Catch::UnorderedEquals(std::vector<size_t>{7u, 8u, 9u, 10u, 11u, 12u}));
+}
+
 TEST_CASE("AABBTreeTest.clear", "[AABBTreeTest]") {
   const BOX bounds1(VEC(0.0, 0.0, 0.0), VEC(2.0, 1.0, 1.0));
   const BOX bounds2(VEC(-1.0, -1.0, -1.0), VEC(1.0, 1.0, 1.0));
@@ -589,4 +700,191 @@ TEST_CASE("AABBTreeTest.clear", "[AABBTreeTest]") {
   REQUIRE_THAT(
     tree.findContainers(vm::vec3d{0.5, 0.5, 0.5}), Catch::UnorderedEquals(std::vector<size_t>{}));
 }
+
+TEST_CASE("AABBTreeTest.clearAndBuild", "[AABBTreeTest]") {
+  const auto bounds = std::vector<BOX>{
+    BOX(VEC(-4.0, -1.0, -1.0), VEC(-2.0, +1.0, +1.0)),
+    BOX(VEC(+2.0, -1.0, -1.0), VEC(+4.0, +1.0, +1.0)),
+    BOX(VEC(-1.0, -1.0, -1.0), VEC(+1.0, +1.0, +1.0)),
+    BOX(VEC(-1.0, -1.0, -1.0), VEC(+1.0, +1.0, +1.0)),
+  };
+  const auto getBounds = [&](const size_t i) {
+    return bounds[i];
+  };
+
+  SECTION("empty list") {
+    AABB tree;
+    tree.insert(bounds[0], 0u);
+
+    tree.clearAndBuild(std::vector<size_t>{}, getBounds);
+    CHECK(tree.empty());
+    CHECK_FALSE(tree.contains(0u));
+  }
+
+  SECTION("non empty list") {
+    AABB tree(std::vector<size_t>{0u, 1u, 2u, 3u}, getBounds);
+
+    CHECK(tree.bounds() == BOX(VEC(-4.0, -1.0, -1.0), VEC(+4.0, +1.0, +1.0)));
+    for (size_t i = 0; i < bounds.size(); ++i) {
+      assertTreeContains(tree, bounds[i], i);
+    }
+
+    assertIntersectors(tree, RAY(VEC(-5.0, 0.0, 0.0), VEC::pos_x()), {0u, 1u, 2u, 3u});
+    assertIntersectors(tree, RAY(VEC(0.0, 0.0, 0.0), VEC::pos_x()), {1u, 2u, 3u});
+    assertIntersectors(tree, RAY(VEC(-3.0, -2.0, 0.0), VEC::pos_y()), {0u});
+    assertIntersectors(tree, RAY(VEC(0.0, 0.0, 2.0), VEC::pos_z()), {});
+
+    tree.remove(2u);
+    assertTreeDoesNotContain(tree, bounds[2], 2u);
+    tree.insert(bounds[2], 2u);
+    assertTreeContains(tree, bounds[2], 2u);
+  }
+
+  SECTION("duplicate data") {
+    AABB tree;
+    CHECK_THROWS_AS(
+      tree.clearAndBuild(std::vector<size_t>{0u, 1u, 0u}, getBounds), NodeTreeException);
+    CHECK(tree.empty());
+    CHECK_FALSE(tree.contains(0u));
+    CHECK_FALSE(tree.contains(1u));
+  }
+
+  SECTION("invalid bounds") {
+    AABB tree;
+    CHECK_THROWS_AS(
+      tree.clearAndBuild(
+        std::vector<size_t>{0u, 1u},
+        [&](const size_t i) {
+          return i == 0u ? bounds[0] : BOX(VEC::nan(), VEC::nan());
+        }),
+      NodeTreeException);
+    CHECK(tree.empty());
+    CHECK_FALSE(tree.contains(0u));
+  }
+}
+
+TEST_CASE("AABBTreeTest.clearAndBuildMatchesInsertion", "[AABBTreeTest]") {
+  // a grid of overlapping boxes of varying sizes, plus a few boxes at the same location
+  auto bounds = std::vector<BOX>{};
+  for (size_t x = 0; x < 16; ++x) {
+    for (size_t y = 0; y < 16; ++y) {
+      for (size_t z = 0; z < 4; ++z) {
+        const auto min = VEC(
+          static_cast<double>(x) * 8.0, static_cast<double>(y) * 8.0,
+          static_cast<double>(z) * 8.0);
+        const auto size = static_cast<double>(1u + (x + y + z) % 12u);
+        bounds.emplace_back(min, min + VEC(size, size, size));
+      }
+    }
+  }
+  for (size_t i = 0; i < 8; ++i) {
+    bounds.emplace_back(VEC(20.0, 20.0, 20.0), VEC(21.0, 21.0, 21.0));
+  }
+
+  auto data = std::vector<size_t>{};
+  for (size_t i = 0; i < bounds.size(); ++i) {
+    data.push_back(i);
+  }
+
+  const auto getBounds = [&](const size_t i) {
+    return bounds[i];
+  };
+
+  AABB builtTree(data, getBounds);
+  AABB insertedTree;
+  for (const auto i : data) {
+    insertedTree.insert(bounds[i], i);
+  }
+
+  CHECK(builtTree.bounds() == insertedTree.bounds());
+
+  for (const auto i : data) {
+    CHECK(builtTree.contains(i));
+  }
+
+  const auto rays = std::vector<RAY>{
+    RAY(VEC(-1.0, -1.0, -1.0), vm::normalize(VEC(1.0, 1.0, 1.0))),
+    RAY(VEC(64.0, -1.0, 12.0), VEC::pos_y()),
+    RAY(VEC(64.0, 64.0, 64.0), vm::normalize(VEC(-1.0, 0.5, -1.0))),
+    RAY(VEC(20.5, 20.5, 40.0), VEC::neg_z()),
+    RAY(VEC(200.0, 0.0, 0.0), VEC::pos_x()),
+  };
+  for (const auto& ray : rays) {
+    CHECK_THAT(
+      builtTree.findIntersectors(ray),
+      Catch::UnorderedEquals(insertedTree.findIntersectors(ray)));
+  }
+
+  const auto points = std::vector<VEC>{
+    VEC(0.5, 0.5, 0.5), VEC(20.5, 20.5, 20.5), VEC(60.0, 61.0, 3.0), VEC(-1.0, 0.0, 0.0)};
+  for (const auto& point : points) {
+    CHECK_THAT(
+      builtTree.findContainers(point),
+      Catch::UnorderedEquals(insertedTree.findContainers(point)));
+  }
+
+  const auto boxes = std::vector<BOX>{
+    BOX(VEC(0.0, 0.0, 0.0), VEC(16.0, 16.0, 16.0)),
+    BOX(VEC(30.0, -8.0, 10.0), VEC(34.0, 200.0, 12.0)),
+    BOX(VEC(20.25, 20.25, 20.25), VEC(20.75, 20.75, 20.75)),
+    BOX(VEC(200.0, 200.0, 200.0), VEC(300.0, 300.0, 300.0)),
+  };
+  for (const auto& box : boxes) {
+    auto expected = std::vector<size_t>{};
+    for (const auto i : data) {
+      if (box.intersects(bounds[i])) {
+        expected.push_back(i);
+      }
+    }
+
+    CHECK_THAT(builtTree.findIntersectors(box), Catch::UnorderedEquals(expected));
+    CHECK_THAT(insertedTree.findIntersectors(box), Catch::UnorderedEquals(expected));
+  }
+}
+
+TEST_CASE("AABBTreeTest.refit", "[AABBTreeTest]") {
+  auto bounds = std::vector<BOX>{
+    BOX(VEC(-4.0, -1.0, -1.0), VEC(-2.0, +1.0, +1.0)),
+    BOX(VEC(+2.0, -1.0, -1.0), VEC(+4.0, +1.0, +1.0)),
+    BOX(VEC(-1.0, -1.0, -1.0), VEC(+1.0, +1.0, +1.0)),
+  };
+  const auto getBounds = [&](const size_t i) {
+    return bounds[i];
+  };
+
+  AABB tree(std::vector<size_t>{0u, 1u, 2u}, getBounds);
+
+  SECTION("Refit moved nodes") {
+    const auto oldBounds = bounds;
+    bounds[0] = bounds[0].translate(VEC(0.0, 0.0, 8.0));
+    bounds[2] = bounds[2].translate(VEC(0.0, -8.0, 0.0));
+
+    tree.refit(std::vector<size_t>{0u, 2u}, getBounds);
+
+    CHECK(tree.bounds() == BOX(VEC(-4.0, -9.0, -1.0), VEC(+4.0, +1.0, +9.0)));
+    for (size_t i = 0; i < bounds.size(); ++i) {
+      assertTreeContains(tree, bounds[i], i);
+    }
+    CHECK(tree.findContainers(oldBounds[0].center()).empty());
+    CHECK(tree.findContainers(oldBounds[2].center()).empty());
+
+    assertIntersectors(tree, RAY(VEC(-5.0, 0.0, 0.0), VEC::pos_x()), {1u});
+    assertIntersectors(tree, RAY(VEC(-3.0, 0.0, 10.0), VEC::neg_z()), {0u});
+    assertIntersectors(tree, RAY(VEC(0.0, -10.0, 0.0), VEC::pos_y()), {2u});
+  }
+
+  SECTION("Refit shrunk node") {
+    bounds[1] = BOX(VEC(+2.0, -1.0, -1.0), VEC(+3.0, +1.0, +1.0));
+
+    tree.refit(std::vector<size_t>{1u}, getBounds);
+
+    CHECK(tree.bounds() == BOX(VEC(-4.0, -1.0, -1.0), VEC(+3.0, +1.0, +1.0)));
+    assertIntersectors(tree, RAY(VEC(3.5, -2.0, 0.0), VEC::pos_y()), {});
+  }
+
+  SECTION("Refit unknown node") {
+    CHECK_THROWS_AS(tree.refit(std::vector<size_t>{0u, 3u}, getBounds), NodeTreeException);
+    CHECK(tree.bounds() == BOX(VEC(-4.0, -1.0, -1.0), VEC(+4.0, +1.0, +1.0)));
+  }
+}
 } // namespace TrenchBroom
@@ -0,0 +1,92 @@
+/*
+ Copyright (C) 2023 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Assets/Palette.h"
+#include "Assets/TextureBuffer.h"
+#include "Color.h"
+#include "IO/Reader.h"
+
+#include <vector>
+
+#include "Catch2.h"
+
+namespace TrenchBroom {
+namespace Assets {
+static Palette makePalette() {
+  auto data = std::vector<unsigned char>(768);
+  for (size_t i = 0; i < 256; ++i) {
+    data[3 * i + 0] = static_cast<unsigned char>(i);
+    data[3 * i + 1] = static_cast<unsigned char>(255 - i);
+    data[3 * i + 2] = static_cast<unsigned char>((i * 7) % 256);
+  }
+  return Palette{data};
+}
+
+TEST_CASE("PaletteTest.indexedToRgba", "[PaletteTest]") {
+  const auto palette = makePalette();
+
+  // cover the vectorized part and the remainder
+  const auto pixelCount = GENERATE(size_t(1), size_t(3), size_t(4), size_t(17), size_t(1000));
+  const auto transparency =
+    GENERATE(PaletteTransparency::Opaque, PaletteTransparency::Index255Transparent);
+  const auto withIndex255 = GENERATE(false, true);
+
+  auto indices = std::vector<char>(pixelCount);
+  for (size_t i = 0; i < pixelCount; ++i) {
+    indices[i] = static_cast<char>((i * 37) % 255);
+  }
+  if (withIndex255) {
+    indices[pixelCount / 2] = static_cast<char>(255);
+  }
+
+  auto reader = IO::Reader::from(indices.data(), indices.data() + indices.size()).buffer();
+  auto rgbaImage = TextureBuffer{4 * pixelCount};
+  auto averageColor = Color{};
+  const auto hasTransparency =
+    palette.indexedToRgba(reader, pixelCount, rgbaImage, transparency, averageColor);
+
+  CHECK(reader.position() == pixelCount);
+  CHECK(
+    hasTransparency ==
+    (withIndex255 && transparency == PaletteTransparency::Index255Transparent));
+
+  double colorSum[3] = {0.0, 0.0, 0.0};
+  for (size_t i = 0; i < pixelCount; ++i) {
+    const auto index = static_cast<size_t>(static_cast<unsigned char>(indices[i]));
+    const auto* pixel = rgbaImage.data() + 4 * i;
+    CHECK(pixel[0] == static_cast<unsigned char>(index));
+    CHECK(pixel[1] == static_cast<unsigned char>(255 - index));
+    CHECK(pixel[2] == static_cast<unsigned char>((index * 7) % 256));
+    CHECK(
+      pixel[3] ==
+      (index == 255 && transparency == PaletteTransparency::Index255Transparent ? 0 : 255));
+
+    colorSum[0] += pixel[0];
+    colorSum[1] += pixel[1];
+    colorSum[2] += pixel[2];
+  }
+
+  const auto divisor = 255.0 * static_cast<double>(pixelCount);
+  CHECK(averageColor.r() == Approx(colorSum[0] / divisor));
+  CHECK(averageColor.g() == Approx(colorSum[1] / divisor));
+  CHECK(averageColor.b() == Approx(colorSum[2] / divisor));
+  CHECK(averageColor.a() == 1.0f);
+}
+} // namespace Assets
+} // namespace TrenchBroom
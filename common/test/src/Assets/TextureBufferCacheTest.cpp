@@ -0,0 +1,90 @@
+/*
+ Copyright (C) 2023 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Assets/Texture.h"
+#include "Assets/TextureBuffer.h"
+#include "Assets/TextureBufferCache.h"
+
+#include <string>
+
+#include "Catch2.h"
+
+namespace TrenchBroom {
+namespace Assets {
+static Texture makeTexture(const std::string& name) {
+  // a 4x4 RGBA texture has 64 bytes
+  auto texture = Texture{name, 4, 4, Color{}, TextureBuffer{64}, GL_RGBA, TextureType::Opaque};
+  texture.setBufferLoader([]() {
+    auto buffers = TextureBufferList{};
+    buffers.emplace_back(64);
+    return buffers;
+  });
+  return texture;
+}
+
+TEST_CASE("TextureBufferCacheTest.evict", "[TextureBufferCacheTest]") {
+  auto texture1 = makeTexture("texture1");
+  auto texture2 = makeTexture("texture2");
+  auto texture3 = makeTexture("texture3");
+
+  auto cache = TextureBufferCache{128};
+  cache.add(texture1);
+  cache.add(texture2);
+  cache.add(texture3);
+  CHECK(cache.size() == 192u);
+
+  SECTION("Oldest textures are discarded first") {
+    cache.evict();
+    CHECK(cache.size() == 128u);
+    CHECK_FALSE(texture1.hasBuffers());
+    CHECK(texture2.hasBuffers());
+    CHECK(texture3.hasBuffers());
+  }
+
+  SECTION("Unused textures are discarded before used textures") {
+    texture1.incUsageCount();
+    cache.evict();
+    CHECK(cache.size() == 128u);
+    CHECK(texture1.hasBuffers());
+    CHECK_FALSE(texture2.hasBuffers());
+    CHECK(texture3.hasBuffers());
+  }
+
+  SECTION("Textures without buffers are removed first") {
+    texture3.discardBuffers();
+    cache.evict();
+    CHECK(cache.size() == 128u);
+    CHECK(texture1.hasBuffers());
+    CHECK(texture2.hasBuffers());
+  }
+
+  SECTION("Used textures are discarded if necessary") {
+    texture1.incUsageCount();
+    texture2.incUsageCount();
+    texture3.incUsageCount();
+    cache.setCapacity(64);
+    cache.evict();
+    CHECK(cache.size() == 64u);
+    CHECK_FALSE(texture1.hasBuffers());
+    CHECK_FALSE(texture2.hasBuffers());
+    CHECK(texture3.hasBuffers());
+  }
+}
+} // namespace Assets
+} // namespace TrenchBroom
@@ -0,0 +1,104 @@
+/*
+ Copyright (C) 2023 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Assets/TextureBuffer.h"
+
+#include <vecmath/vec.h>
+
+#include <cstring>
+#include <vector>
+
+#include "Catch2.h"
+
+namespace TrenchBroom {
+namespace Assets {
+static TextureBufferList makeBaseLevel(
+  const size_t width, const size_t height, const std::vector<unsigned char>& pixels) {
+  auto buffers = TextureBufferList{};
+  buffers.emplace_back(width * height * 4u);
+  std::memcpy(buffers[0].data(), pixels.data(), buffers[0].size());
+  return buffers;
+}
+
+TEST_CASE("TextureBufferTest.mipLevelCount", "[TextureBufferTest]") {
+  CHECK(mipLevelCount(1, 1) == 1u);
+  CHECK(mipLevelCount(2, 1) == 2u);
+  CHECK(mipLevelCount(64, 64) == 7u);
+  CHECK(mipLevelCount(64, 16) == 7u);
+  CHECK(mipLevelCount(5, 3) == 3u);
+}
+
+TEST_CASE("TextureBufferTest.generateMipmaps", "[TextureBufferTest]") {
+  SECTION("Uniform textures keep their color") {
+    const auto width = GENERATE(size_t(1), size_t(4), size_t(5), size_t(16), size_t(33));
+    const auto height = GENERATE(size_t(1), size_t(3), size_t(16));
+
+    auto pixels = std::vector<unsigned char>{};
+    for (size_t i = 0; i < width * height; ++i) {
+      pixels.insert(pixels.end(), {12, 34, 200, 255});
+    }
+
+    auto buffers = makeBaseLevel(width, height, pixels);
+    const auto mipLevels = mipLevelCount(width, height);
+    generateMipmaps(buffers, mipLevels, width, height, GL_RGBA);
+
+    REQUIRE(buffers.size() == mipLevels);
+    for (size_t level = 1; level < mipLevels; ++level) {
+      const auto mipSize = sizeAtMipLevel(width, height, level);
+      REQUIRE(buffers[level].size() == mipSize.x() * mipSize.y() * 4u);
+      for (size_t i = 0; i < buffers[level].size(); i += 4u) {
+        CHECK(buffers[level].data()[i + 0] == 12);
+        CHECK(buffers[level].data()[i + 1] == 34);
+        CHECK(buffers[level].data()[i + 2] == 200);
+        CHECK(buffers[level].data()[i + 3] == 255);
+      }
+    }
+  }
+
+  SECTION("Colors are averaged in linear space") {
+    // a 4x2 texture with a black and white checkerboard pattern on the left and a transparent
+    // pattern on the right
+    // clang-format off
+    const auto pixels = std::vector<unsigned char>{
+      0,   0,   0,   255,   255, 255, 255, 255,   255, 255, 255, 0,     255, 255, 255, 255,
+      255, 255, 255, 255,   0,   0,   0,   255,   255, 255, 255, 255,   255, 255, 255, 0,
+    };
+    // clang-format on
+
+    auto buffers = makeBaseLevel(4, 2, pixels);
+    generateMipmaps(buffers, 3, 4, 2, GL_BGRA);
+
+    REQUIRE(buffers.size() == 3u);
+    REQUIRE(buffers[1].size() == 8u);
+    REQUIRE(buffers[2].size() == 4u);
+
+    // half of the light of white is brighter than 50% gray
+    const auto* level1 = buffers[1].data();
+    CHECK(level1[0] == 188);
+    CHECK(level1[1] == 188);
+    CHECK(level1[2] == 188);
+    CHECK(level1[3] == 255);
+    CHECK(level1[4] == 255);
+    CHECK(level1[5] == 255);
+    CHECK(level1[6] == 255);
+    CHECK(level1[7] == 128);
+  }
+}
+} // namespace Assets
+} // namespace TrenchBroom
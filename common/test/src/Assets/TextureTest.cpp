@@ -0,0 +1,85 @@
+/*
+ Copyright (C) 2023 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Assets/Texture.h"
+#include "Assets/TextureBuffer.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+
+#include "Catch2.h"
+
+namespace TrenchBroom {
+namespace Assets {
+TEST_CASE("TextureTest.discardBuffers", "[TextureTest]") {
+  // a 4x4 RGBA texture has 64 bytes
+  auto texture = Texture{"texture", 4, 4, Color{}, TextureBuffer{64}, GL_RGBA, TextureType::Opaque};
+
+  SECTION("Textures with a buffer loader discard their buffers") {
+    texture.setBufferLoader([]() {
+      auto buffers = TextureBufferList{};
+      buffers.emplace_back(64);
+      return buffers;
+    });
+    texture.discardBuffers();
+    CHECK_FALSE(texture.hasBuffers());
+    CHECK(texture.bufferSize() == 0u);
+  }
+
+  SECTION("Textures without a buffer loader keep their buffers") {
+    texture.discardBuffers();
+    CHECK(texture.hasBuffers());
+    CHECK(texture.bufferSize() == 64u);
+  }
+}
+
+TEST_CASE("TextureTest.prefetchBuffers", "[TextureTest]") {
+  auto texture = Texture{"texture", 4, 4, Color{}, TextureBuffer{64}, GL_RGBA, TextureType::Opaque};
+
+  auto loaderCalls = std::make_shared<std::atomic<size_t>>(0u);
+  auto loaderCalled = std::make_shared<std::promise<void>>();
+  texture.setBufferLoader([=]() {
+    if (loaderCalls->fetch_add(1u) == 0u) {
+      loaderCalled->set_value();
+    }
+    auto buffers = TextureBufferList{};
+    buffers.emplace_back(64);
+    return buffers;
+  });
+
+  SECTION("Discarded buffers are prefetched when the texture is first used") {
+    texture.discardBuffers();
+    texture.incUsageCount();
+    texture.incUsageCount();
+    REQUIRE(
+      loaderCalled->get_future().wait_for(std::chrono::seconds{10}) == std::future_status::ready);
+    CHECK(*loaderCalls == 1u);
+  }
+
+  SECTION("Textures that hold their buffers do not prefetch them") {
+    texture.incUsageCount();
+    CHECK(*loaderCalls == 0u);
+    CHECK(texture.hasBuffers());
+  }
+}
+} // namespace Assets
+} // namespace TrenchBroom
@@ -19,6 +19,7 @@
 
 #include "IO/NodeWriter.h"
 #include "Exceptions.h"
+#include "IO/MapFileSerializer.h"
 #include "Model/BezierPatch.h"
 #include "Model/BrushBuilder.h"
 #include "Model/BrushFace.h"
@@ -36,6 +37,7 @@
 
 #include <kdl/result.h>
 #include <kdl/string_compare.h>
+#include <kdl/vector_utils.h>
 
 #include <vecmath/mat.h>
 #include <vecmath/mat_ext.h>
@@ -47,6 +49,7 @@
 
 #include <iostream>
 #include <sstream>
+#include <tuple>
 #include <vector>
 
 #include "Catch2.h"
@@ -1228,5 +1231,99 @@ common/caulk
   CHECK(actual == expected);
 }
 
+TEST_CASE("NodeWriterTest.writeMapInWindows", "[NodeWriterTest]") {
+  const auto worldBounds = vm::bbox3{8192.0};
+
+  auto map = Model::WorldNode{{}, {}, Model::MapFormat::Standard};
+  auto builder = Model::BrushBuilder{map.mapFormat(), worldBounds};
+
+  auto* layerNode = new Model::LayerNode{Model::Layer{"Custom Layer"}};
+  auto* groupNode = new Model::GroupNode{Model::Group{"Group"}};
+  auto* entityNode = new Model::EntityNode{Model::Entity{}};
+  map.addChild(layerNode);
+  layerNode->addChild(groupNode);
+  map.defaultLayer()->addChild(entityNode);
+
+  auto brushNodes = std::vector<Model::BrushNode*>{};
+  for (auto* parentNode : std::vector<Model::Node*>{
+         map.defaultLayer(), entityNode, map.defaultLayer(), layerNode, groupNode, layerNode}) {
+    auto* brushNode = new Model::BrushNode{
+      builder.createCube(static_cast<FloatType>(brushNodes.size() + 1u) * 8.0, "none").value()};
+    parentNode->addChild(brushNode);
+    brushNodes.push_back(brushNode);
+  }
+
+  auto* patchNode = new Model::PatchNode{Model::BezierPatch{
+    3,
+    3,
+    {{0, 0, 0, 0, 0},
+     {1, 0, 0, 0, 0},
+     {2, 0, 0, 0, 0},
+     {0, 1, 0, 0, 0},
+     {1, 1, 0, 0, 0},
+     {2, 1, 0, 0, 0},
+     {0, 2, 0, 0, 0},
+     {1, 2, 0, 0, 0},
+     {2, 2, 0, 0, 0}},
+    "texture"}};
+  groupNode->addChild(patchNode);
+
+  const auto write = [&](const size_t windowSize) {
+    auto str = std::stringstream{};
+    auto serializer = MapFileSerializer::create(map.mapFormat(), str);
+    serializer->setWindowSize(windowSize);
+
+    auto writer = NodeWriter{map, std::move(serializer)};
+    writer.writeMap();
+
+    auto lineNumbers = kdl::vec_transform(brushNodes, [](const auto* brushNode) {
+      return brushNode->lineNumber();
+    });
+    lineNumbers.push_back(patchNode->lineNumber());
+    return std::make_tuple(str.str(), lineNumbers);
+  };
+
+  const auto windowSize = GENERATE(1u, 2u, 5u);
+  CHECK(write(windowSize) == write(0u));
+}
+
+TEST_CASE("NodeWriterTest.writeNodesInWindows", "[NodeWriterTest]") {
+  const auto worldBounds = vm::bbox3{8192.0};
+
+  auto map = Model::WorldNode{{}, {}, Model::MapFormat::Standard};
+  auto builder = Model::BrushBuilder{map.mapFormat(), worldBounds};
+
+  auto* groupNode = new Model::GroupNode{Model::Group{"Group"}};
+  auto* entityNode = new Model::EntityNode{Model::Entity{}};
+  map.defaultLayer()->addChild(groupNode);
+  map.defaultLayer()->addChild(entityNode);
+
+  auto brushNodes = std::vector<Model::BrushNode*>{};
+  for (auto* parentNode : std::vector<Model::Node*>{
+         groupNode, map.defaultLayer(), entityNode, groupNode, map.defaultLayer()}) {
+    auto* brushNode = new Model::BrushNode{
+      builder.createCube(static_cast<FloatType>(brushNodes.size() + 1u) * 8.0, "none").value()};
+    parentNode->addChild(brushNode);
+    brushNodes.push_back(brushNode);
+  }
+
+  // the nodes are written in a different order than the one in which they are passed
+  const auto nodes = std::vector<Model::Node*>{
+    groupNode, brushNodes[2], brushNodes[1], brushNodes[4]};
+
+  const auto write = [&](const size_t windowSize) {
+    auto str = std::stringstream{};
+    auto serializer = MapFileSerializer::create(map.mapFormat(), str);
+    serializer->setWindowSize(windowSize);
+
+    auto writer = NodeWriter{map, std::move(serializer)};
+    writer.writeNodes(nodes);
+    return str.str();
+  };
+
+  const auto windowSize = GENERATE(1u, 2u, 3u);
+  CHECK(write(windowSize) == write(0u));
+}
+
 } // namespace IO
 } // namespace TrenchBroom
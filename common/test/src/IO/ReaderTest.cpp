@@ -183,5 +183,16 @@ TEST_CASE("BufferReaderTest.subReader", "[BufferReaderTest]") {
 TEST_CASE("FileReaderTest.subReader", "[FileReaderTest]") {
   subReader(file()->reader());
 }
+
+TEST_CASE("FileReaderTest.bufferWithoutCopy", "[FileReaderTest]") {
+  const auto r = file()->reader();
+  const auto first = r.buffer();
+  const auto second = r.subReaderFromBegin(2U, 4U).buffer();
+
+  CHECK(first.stringView() == "abcdefghij");
+  CHECK(second.stringView() == "cdef");
+  CHECK(second.begin() == first.begin() + 2);
+  CHECK(r.buffer().begin() == first.begin());
+}
 } // namespace IO
 } // namespace TrenchBroom
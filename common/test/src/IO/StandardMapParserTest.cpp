@@ -0,0 +1,159 @@
+/*
+ Copyright (C) 2021 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "IO/StandardMapParser.h"
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "Catch2.h"
+
+namespace TrenchBroom {
+namespace IO {
+static std::vector<std::string> chunkStrings(const std::vector<MapChunk>& chunks) {
+  auto result = std::vector<std::string>{};
+  for (const auto& chunk : chunks) {
+    result.emplace_back(chunk.str);
+  }
+  return result;
+}
+
+TEST_CASE("QuakeMapTokenizerTest.emitToken", "[QuakeMapTokenizerTest]") {
+  using TokenInfo = std::tuple<QuakeMapToken::Type, std::string, size_t, size_t>;
+
+  const auto tokenize = [](const std::string& str, const bool skipEol) {
+    auto tokenizer = QuakeMapTokenizer{str};
+    tokenizer.setSkipEol(skipEol);
+
+    auto result = std::vector<TokenInfo>{};
+    for (auto token = tokenizer.nextToken(); !token.hasType(QuakeMapToken::Eof);
+         token = tokenizer.nextToken()) {
+      result.emplace_back(token.type(), token.data(), token.line(), token.column());
+    }
+    return result;
+  };
+
+  SECTION("Numbers and words") {
+    CHECK(
+      tokenize("1 -2 +3 4.5 -.5 1e-3 1e 12) 12a) {BLUE a\\b", true) ==
+      std::vector<TokenInfo>{
+        {QuakeMapToken::Integer, "1", 1, 1},
+        {QuakeMapToken::Integer, "-2", 1, 3},
+        {QuakeMapToken::Integer, "+3", 1, 6},
+        {QuakeMapToken::Decimal, "4.5", 1, 9},
+        {QuakeMapToken::Decimal, "-.5", 1, 13},
+        {QuakeMapToken::Decimal, "1e-3", 1, 17},
+        {QuakeMapToken::Decimal, "1e", 1, 22},
+        {QuakeMapToken::Integer, "12", 1, 25},
+        {QuakeMapToken::CParenthesis, ")", 1, 27},
+        {QuakeMapToken::String, "12a)", 1, 29},
+        {QuakeMapToken::OBrace, "{", 1, 34},
+        {QuakeMapToken::String, "BLUE", 1, 35},
+        {QuakeMapToken::String, "a\\b", 1, 40},
+      });
+  }
+
+  SECTION("Long runs of whitespace and comments") {
+    const auto blanks = std::string(40, ' ') + "\t" + std::string(20, ' ');
+    const auto comment = "// " + std::string(50, 'x') + "\r\n";
+    CHECK(
+      tokenize(blanks + "{" + blanks + "\n" + comment + "; comment\r" + blanks + "}", true) ==
+      std::vector<TokenInfo>{
+        {QuakeMapToken::OBrace, "{", 1, 62},
+        {QuakeMapToken::CBrace, "}", 4, 62},
+      });
+  }
+
+  SECTION("Line ends") {
+    CHECK(
+      tokenize("a\r\nb\rc\n", false) ==
+      std::vector<TokenInfo>{
+        {QuakeMapToken::String, "a", 1, 1},
+        {QuakeMapToken::Eol, "\r", 1, 2},
+        {QuakeMapToken::String, "b", 2, 1},
+        {QuakeMapToken::Eol, "\r", 2, 2},
+        {QuakeMapToken::String, "c", 3, 1},
+        {QuakeMapToken::Eol, "\n", 3, 2},
+      });
+  }
+
+  SECTION("Escaped quotation marks after words") {
+    CHECK(
+      tokenize("a\\ \"b\\\"c\"", true) ==
+      std::vector<TokenInfo>{
+        {QuakeMapToken::String, "a\\", 1, 1},
+        {QuakeMapToken::String, "b\\\"c", 1, 4},
+      });
+  }
+}
+
+TEST_CASE("StandardMapParserTest.splitIntoEntityChunks", "[StandardMapParserTest]") {
+  SECTION("Empty string") {
+    CHECK(splitIntoEntityChunks("", 0u).empty());
+  }
+
+  SECTION("Each entity is a chunk") {
+    const auto str = std::string{"{ \"a\" \"b\" }\n{ { ( 1 2 3 ) } }\n"};
+    const auto chunks = splitIntoEntityChunks(str, 0u);
+    CHECK(
+      chunkStrings(chunks) ==
+      std::vector<std::string>{"{ \"a\" \"b\" }", "\n{ { ( 1 2 3 ) } }", "\n"});
+  }
+
+  SECTION("Chunks have a minimum size") {
+    const auto str = std::string{"{}{}{}{}{}"};
+    CHECK(
+      chunkStrings(splitIntoEntityChunks(str, 4u)) ==
+      std::vector<std::string>{"{}{}", "{}{}", "{}"});
+  }
+
+  SECTION("Braces in strings, comments and texture names are skipped") {
+    const auto str = std::string{R"({
+"message" "}{\" }"
+// }
+; }
+{ ( 1 2 3 ) {BLUE }
+}
+{})"};
+    CHECK(
+      chunkStrings(splitIntoEntityChunks(str, 0u)) ==
+      std::vector<std::string>{str.substr(0, str.size() - 3), "\n{}"});
+  }
+
+  SECTION("Line and column of each chunk") {
+    const auto str = std::string{"{\r\n}  {\n\n}\r{\r\r}"};
+    const auto chunks = splitIntoEntityChunks(str, 0u);
+    REQUIRE(chunks.size() == 3u);
+    CHECK(chunks[0].line == 1u);
+    CHECK(chunks[0].column == 1u);
+    CHECK(chunks[1].line == 2u);
+    CHECK(chunks[1].column == 2u);
+    CHECK(chunks[2].line == 4u);
+    CHECK(chunks[2].column == 2u);
+  }
+
+  SECTION("Unbalanced input") {
+    CHECK(splitIntoEntityChunks("{ { }", 0u).empty());
+    CHECK(splitIntoEntityChunks("{ } }", 0u).empty());
+    CHECK(splitIntoEntityChunks("{ \"unterminated }", 0u).empty());
+  }
+}
+} // namespace IO
+} // namespace TrenchBroom
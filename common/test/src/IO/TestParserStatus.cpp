@@ -44,7 +44,13 @@ const std::vector<std::string>& TestParserStatus::messages(const LogLevel level)
   return it->second;
 }
 
-void TestParserStatus::doProgress(const double) {}
+const std::vector<double>& TestParserStatus::progressValues() const {
+  return m_progressValues;
+}
+
+void TestParserStatus::doProgress(const double progress) {
+  m_progressValues.push_back(progress);
+}
 
 void TestParserStatus::doLog(const LogLevel level, const std::string& str) {
   m_messages[level].push_back(str);
@@ -32,6 +32,7 @@ class TestParserStatus : public ParserStatus {
 private:
   static NullLogger _logger;
   std::map<LogLevel, std::vector<std::string>> m_messages;
+  std::vector<double> m_progressValues;
 
 public:
   TestParserStatus();
@@ -39,6 +40,7 @@ public:
 public:
   size_t countStatus(LogLevel level) const;
   const std::vector<std::string>& messages(LogLevel level) const;
+  const std::vector<double>& progressValues() const;
 
 private:
   void doProgress(double progress) override;
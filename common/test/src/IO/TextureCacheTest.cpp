@@ -0,0 +1,214 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "IO/TextureCache.h"
+#include "Assets/Texture.h"
+#include "Assets/TextureBuffer.h"
+#include "Color.h"
+#include "IO/DiskIO.h"
+#include "IO/File.h"
+#include "IO/IOUtils.h"
+#include "IO/Path.h"
+#include "IO/PathQt.h"
+#include "IO/Reader.h"
+#include "IO/TestEnvironment.h"
+
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+
+#include "Catch2.h"
+
+namespace TrenchBroom {
+namespace IO {
+static Assets::Texture makeTexture(const std::string& name, const unsigned char value) {
+  // a 4x4 RGBA texture with two mip levels
+  auto buffers = Assets::TextureBufferList{};
+  buffers.emplace_back(64);
+  buffers.emplace_back(16);
+  for (auto& buffer : buffers) {
+    std::memset(buffer.data(), value, buffer.size());
+  }
+  return Assets::Texture{
+    name, 4, 4, Color{0.25f, 0.5f, 0.75f, 1.0f}, std::move(buffers), GL_RGBA,
+    Assets::TextureType::Masked, Assets::Q2Data{1, 2, 3}};
+}
+
+TEST_CASE("TextureCacheTest.forFile", "[TextureCacheTest]") {
+  auto env = TestEnvironment{};
+  env.createFile(Path{"textures.wad"}, "some data");
+
+  const auto key = TextureCacheKey::forFile(env.dir() + Path{"textures.wad"}, Path{"tex1"}, 64u);
+  REQUIRE(key);
+  CHECK(key->sourcePath == (env.dir() + Path{"textures.wad"}).asString("/"));
+  CHECK(key->entryName == "tex1");
+  CHECK(key->entrySize == 64u);
+
+  CHECK_FALSE(TextureCacheKey::forFile(env.dir() + Path{"missing.wad"}, Path{"tex1"}, 64u));
+  CHECK_FALSE(TextureCacheKey::forFile(Path{}, Path{"tex1"}, 64u));
+}
+
+TEST_CASE("TextureCacheTest.writeAndRead", "[TextureCacheTest]") {
+  auto env = TestEnvironment{};
+  const auto collectionPath = Path{"textures.wad"};
+  const auto cache = TextureCache::forCollection(env.dir(), collectionPath, "context");
+
+  const auto texture2 = makeTexture("tex2", 2);
+  const auto key1 = TextureCacheKey{"textures.wad", "tex1", 64u, 1000};
+  const auto key2 = TextureCacheKey{"textures.wad", "tex2", 64u, 1000};
+
+  auto entries = std::vector<std::pair<TextureCacheKey, Assets::Texture>>{};
+  entries.emplace_back(key1, makeTexture("tex1", 1));
+  entries.emplace_back(key2, makeTexture("tex2", 2));
+  REQUIRE(cache.write(std::move(entries)));
+  CHECK(Disk::fileExists(cache.path()));
+
+  SECTION("Cached textures are read back") {
+    auto loaded = TextureCache::forCollection(env.dir(), collectionPath, "context");
+    REQUIRE(loaded.load());
+    CHECK(loaded.size() == 2u);
+
+    const auto cached = loaded.readTexture(key2);
+    REQUIRE(cached);
+    CHECK(cached->name() == "tex2");
+    CHECK(cached->width() == 4u);
+    CHECK(cached->height() == 4u);
+    CHECK(cached->averageColor() == texture2.averageColor());
+    CHECK(cached->format() == GLenum(GL_RGBA));
+    CHECK(cached->type() == Assets::TextureType::Masked);
+    CHECK(cached->gameData() == Assets::GameData{Assets::Q2Data{1, 2, 3}});
+
+    const auto& buffers = cached->buffersIfUnprepared();
+    REQUIRE(buffers.size() == 2u);
+    CHECK(buffers[0].size() == 64u);
+    CHECK(buffers[1].size() == 16u);
+    CHECK(std::memcmp(buffers[0].data(), texture2.buffersIfUnprepared()[0].data(), 64u) == 0);
+    CHECK(std::memcmp(buffers[1].data(), texture2.buffersIfUnprepared()[1].data(), 16u) == 0);
+  }
+
+  SECTION("Textures whose source has changed are not read") {
+    auto loaded = TextureCache::forCollection(env.dir(), collectionPath, "context");
+    REQUIRE(loaded.load());
+
+    CHECK_FALSE(loaded.readTexture(TextureCacheKey{"textures.wad", "tex1", 64u, 2000}));
+    CHECK_FALSE(loaded.readTexture(TextureCacheKey{"textures.wad", "tex1", 32u, 1000}));
+    CHECK_FALSE(loaded.readTexture(TextureCacheKey{"other.wad", "tex1", 64u, 1000}));
+    CHECK_FALSE(loaded.readTexture(TextureCacheKey{"textures.wad", "tex3", 64u, 1000}));
+    CHECK(loaded.readTexture(key1));
+  }
+
+  SECTION("The cache is ignored for a different context") {
+    auto loaded = TextureCache{cache.path(), "other context"};
+    CHECK_FALSE(loaded.load());
+    CHECK(loaded.size() == 0u);
+    CHECK_FALSE(loaded.readTexture(key1));
+  }
+
+  SECTION("A truncated cache file is ignored") {
+    const auto contents = [&]() {
+      const auto file = Disk::openFile(cache.path());
+      auto reader = file->reader();
+      auto result = std::string(file->size() / 2u, '\0');
+      reader.read(result.data(), result.size());
+      return result;
+    }();
+    {
+      auto stream = openPathAsOutputStream(cache.path(), std::ios::out | std::ios::binary);
+      stream << contents;
+    }
+
+    auto loaded = TextureCache::forCollection(env.dir(), collectionPath, "context");
+    CHECK_FALSE(loaded.load());
+    CHECK_FALSE(loaded.readTexture(key1));
+  }
+
+#ifndef _WIN32
+  // Windows does not allow replacing a file that is mapped into memory
+  SECTION("A mapped cache file is not changed when it is replaced") {
+    auto loaded = TextureCache::forCollection(env.dir(), collectionPath, "context");
+    REQUIRE(loaded.load());
+
+    auto newEntries = std::vector<std::pair<TextureCacheKey, Assets::Texture>>{};
+    newEntries.emplace_back(key2, makeTexture("tex2", 2));
+    REQUIRE(cache.write(std::move(newEntries)));
+    CHECK(loaded.size() == 2u);
+    CHECK(loaded.readTexture(key1));
+
+    auto reloaded = TextureCache::forCollection(env.dir(), collectionPath, "context");
+    REQUIRE(reloaded.load());
+    CHECK(reloaded.size() == 1u);
+  }
+#endif
+}
+
+TEST_CASE("TextureCacheTest.prune", "[TextureCacheTest]") {
+  auto env = TestEnvironment{};
+  const auto key = TextureCacheKey{"textures.wad", "tex1", 64u, 1000};
+
+  // write three cache files, the first one being the most recently written
+  auto paths = std::vector<Path>{};
+  const auto now = QDateTime::currentDateTime();
+  for (int i = 0; i < 3; ++i) {
+    const auto collectionPath = Path{"textures" + std::to_string(i) + ".wad"};
+    const auto cache = TextureCache::forCollection(env.dir(), collectionPath, "context");
+    auto entries = std::vector<std::pair<TextureCacheKey, Assets::Texture>>{};
+    entries.emplace_back(key, makeTexture("tex1", 1));
+    REQUIRE(cache.write(std::move(entries)));
+
+    auto file = QFile{pathAsQString(cache.path())};
+    REQUIRE(file.open(QIODevice::ReadWrite));
+    REQUIRE(file.setFileTime(now.addSecs(-60 * i), QFileDevice::FileModificationTime));
+    paths.push_back(cache.path());
+  }
+  env.createFile(Path{"other.txt"}, "some data");
+
+  const auto fileSize = static_cast<size_t>(QFileInfo{pathAsQString(paths[0])}.size());
+
+  SECTION("Files that fit are kept") {
+    TextureCache::prune(env.dir(), 3u * fileSize);
+    CHECK(Disk::fileExists(paths[0]));
+    CHECK(Disk::fileExists(paths[1]));
+    CHECK(Disk::fileExists(paths[2]));
+  }
+
+  SECTION("The least recently written files are deleted first") {
+    TextureCache::prune(env.dir(), 2u * fileSize);
+    CHECK(Disk::fileExists(paths[0]));
+    CHECK(Disk::fileExists(paths[1]));
+    CHECK_FALSE(Disk::fileExists(paths[2]));
+  }
+
+  SECTION("The most recently written file is always kept") {
+    TextureCache::prune(env.dir(), 0u);
+    CHECK(Disk::fileExists(paths[0]));
+    CHECK_FALSE(Disk::fileExists(paths[1]));
+    CHECK_FALSE(Disk::fileExists(paths[2]));
+  }
+
+  CHECK(env.fileExists(Path{"other.txt"}));
+}
+} // namespace IO
+} // namespace TrenchBroom
@@ -26,6 +26,7 @@
 #include "Logger.h"
 #include "Model/GameConfig.h"
 
+#include <memory>
 #include <string>
 
 #include "Catch2.h"
@@ -124,5 +125,44 @@ TEST_CASE("TextureLoaderTest.testLoadExclusions", "[TextureLoaderTest]") {
     CHECK(texture->height() == height);
   }
 }
+
+TEST_CASE("TextureLoaderTest.testLoadInBackground", "[TextureLoaderTest]") {
+  const std::vector<IO::Path> paths({Path("fixture/test/IO/Wad/cr8_czg.wad")});
+
+  const IO::Path root = IO::Disk::getCurrentWorkingDir();
+  const std::vector<IO::Path> fileSearchPaths{root};
+  const IO::DiskFileSystem fileSystem(root, true);
+
+  const Model::TextureConfig textureConfig{
+    Model::TextureFilePackageConfig{Model::PackageFormatConfig{{"wad"}, "idmip"}},
+    Model::PackageFormatConfig{{"D"}, "idmip"},
+    IO::Path{"fixture/test/palette.lmp"},
+    "wad",
+    IO::Path{},
+    {}};
+
+  auto logger = NullLogger();
+  auto textureManager = Assets::TextureManager(0, 0, logger);
+
+  auto textureLoader =
+    std::make_shared<IO::TextureLoader>(fileSystem, fileSearchPaths, textureConfig, logger);
+  textureManager.loadTextureCollectionsInBackground(paths, std::move(textureLoader));
+
+  // the collection is replaced by a placeholder until it has been published
+  CHECK(textureManager.loadingInBackground());
+  REQUIRE(textureManager.collections().size() == 1u);
+  CHECK(textureManager.collections().front().path() == paths.front());
+
+  textureManager.finishLoadingInBackground();
+  CHECK_FALSE(textureManager.loadingInBackground());
+  REQUIRE(textureManager.collections().size() == 1u);
+  CHECK(textureManager.collections().front().loaded());
+  CHECK(textureManager.textures().size() == 21u);
+
+  const auto* texture = textureManager.texture("cr8_czg_3");
+  REQUIRE(texture != nullptr);
+  CHECK(texture->width() == 64u);
+  CHECK(texture->height() == 128u);
+}
 } // namespace IO
 } // namespace TrenchBroom
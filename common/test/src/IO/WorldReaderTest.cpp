@@ -20,6 +20,9 @@
 #include "IO/WorldReader.h"
 #include "IO/DiskIO.h"
 #include "IO/File.h"
+#include "IO/MapCache.h"
+#include "IO/NodeWriter.h"
+#include "IO/TestEnvironment.h"
 #include "IO/TestParserStatus.h"
 #include "Model/BezierPatch.h"
 #include "Model/BrushFace.h"
@@ -39,7 +42,14 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <sstream>
 #include <string>
+#include <tuple>
+#include <variant>
+#include <vector>
 
 #include "Catch2.h"
 #include "TestUtils.h"
@@ -1659,5 +1669,288 @@ TEST_CASE("WorldReaderTest.parseUnknownFormatEmptyMap", "[WorldReaderTest]") {
   REQUIRE(world != nullptr);
   CHECK(world->mapFormat() == Model::MapFormat::Standard);
 }
+
+static void collectLineNumbers(const Model::Node& node, std::vector<size_t>& lineNumbers) {
+  lineNumbers.push_back(node.lineNumber());
+  for (const auto* child : node.children()) {
+    collectLineNumbers(*child, lineNumbers);
+  }
+}
+
+TEST_CASE("WorldReaderTest.parseInParallel", "[WorldReaderTest]") {
+  const std::string data(R"(
+// entity 0
+{
+"classname" "worldspawn"
+"message" "parallel"
+// brush 0
+{
+( -0 -0 -16 ) ( -0 -0  -0 ) ( 64 -0 -16 ) tex1 1 2 3 4 5
+( -0 -0 -16 ) ( -0 64 -16 ) ( -0 -0  -0 ) tex2 0 0 0 1 1
+( -0 -0 -16 ) ( 64 -0 -16 ) ( -0 64 -16 ) tex3 0 0 0 1 1
+( 64 64  -0 ) ( -0 64  -0 ) ( 64 64 -16 ) tex4 0 0 0 1 1
+( 64 64  -0 ) ( 64 64 -16 ) ( 64 -0  -0 ) tex5 0 0 0 1 1
+( 64 64  -0 ) ( 64 -0  -0 ) ( -0 64  -0 ) tex6 0 0 0 1 1
+}
+}
+// entity 1
+{
+"classname" "func_group"
+"_tb_type" "_tb_layer"
+"_tb_name" "My Layer"
+"_tb_id" "1"
+{
+( -0 -0 -16 ) ( -0 -0  -0 ) ( 64 -0 -16 ) {BLUE 0 0 0 1 1
+( -0 -0 -16 ) ( -0 64 -16 ) ( -0 -0  -0 ) {BLUE 0 0 0 1 1
+( -0 -0 -16 ) ( 64 -0 -16 ) ( -0 64 -16 ) {BLUE 0 0 0 1 1
+( 64 64  -0 ) ( -0 64  -0 ) ( 64 64 -16 ) {BLUE 0 0 0 1 1
+( 64 64  -0 ) ( 64 64 -16 ) ( 64 -0  -0 ) {BLUE 0 0 0 1 1
+( 64 64  -0 ) ( 64 -0  -0 ) ( -0 64  -0 ) {BLUE 0 0 0 1 1
+}
+}
+// entity 2
+{
+"classname" "func_group"
+"_tb_type" "_tb_group"
+"_tb_name" "My Group"
+"_tb_id" "2"
+"_tb_layer" "1"
+}
+// entity 3
+{
+"classname" "info_player_start"
+"message" "a } in a { string"
+"message" "duplicate"
+"_tb_group" "2"
+}
+// entity 4
+{
+"classname" "func_door"
+{
+( 0 0 0 ) ( 0 0 0 ) ( 0 0 0 ) degenerate 0 0 0 1 1
+( -0 -0 -16 ) ( -0 -0  -0 ) ( 64 -0 -16 ) tex1 0 0 0 1 1
+( -0 -0 -16 ) ( -0 64 -16 ) ( -0 -0  -0 ) tex2 0 0 0 1 1
+( -0 -0 -16 ) ( 64 -0 -16 ) ( -0 64 -16 ) tex3 0 0 0 1 1
+( 64 64  -0 ) ( -0 64  -0 ) ( 64 64 -16 ) tex4 0 0 0 1 1
+( 64 64  -0 ) ( 64 64 -16 ) ( 64 -0  -0 ) tex5 0 0 0 1 1
+( 64 64  -0 ) ( 64 -0  -0 ) ( -0 64  -0 ) tex6 0 0 0 1 1
+}
+}
+)");
+
+  const vm::bbox3 worldBounds(8192.0);
+
+  const auto read = [&](const size_t parallelChunkSize) {
+    IO::TestParserStatus status;
+    WorldReader reader(data, Model::MapFormat::Standard, {});
+    reader.setParallelChunkSize(parallelChunkSize);
+
+    auto world = reader.read(worldBounds, status);
+
+    auto str = std::stringstream{};
+    NodeWriter writer(*world, str);
+    writer.writeMap();
+
+    auto lineNumbers = std::vector<size_t>{};
+    collectLineNumbers(*world, lineNumbers);
+
+    // progress is reported in increasing order, and the parallel parser reports completion
+    const auto& progressValues = status.progressValues();
+    CHECK_FALSE(progressValues.empty());
+    CHECK(std::is_sorted(progressValues.begin(), progressValues.end()));
+    if (parallelChunkSize > 0u) {
+      CHECK(progressValues.back() == 1.0);
+    }
+
+    return std::make_tuple(
+      str.str(), lineNumbers, status.messages(LogLevel::Warn), status.messages(LogLevel::Error));
+  };
+
+  const auto [expectedMap, expectedLineNumbers, expectedWarnings, expectedErrors] = read(0u);
+  CHECK(expectedWarnings.size() == 1u);
+  CHECK(expectedErrors.size() == 1u);
+
+  const auto parallelChunkSize = GENERATE(1u, 64u, 256u);
+  CAPTURE(parallelChunkSize);
+
+  const auto [actualMap, actualLineNumbers, actualWarnings, actualErrors] =
+    read(parallelChunkSize);
+  CHECK(actualMap == expectedMap);
+  CHECK(actualLineNumbers == expectedLineNumbers);
+  CHECK(actualWarnings == expectedWarnings);
+  CHECK(actualErrors == expectedErrors);
+}
+
+TEST_CASE("WorldReaderTest.parseInParallelReportsErrors", "[WorldReaderTest]") {
+  const std::string data(R"(
+{
+"classname" "worldspawn"
+}
+{
+"classname" "info_player_start"
+"origin"
+}
+)");
+
+  const vm::bbox3 worldBounds(8192.0);
+
+  IO::TestParserStatus status;
+  WorldReader reader(data, Model::MapFormat::Standard, {});
+  reader.setParallelChunkSize(1u);
+
+  CHECK_THROWS_AS(reader.read(worldBounds, status), ParserException);
+}
+TEST_CASE("WorldReaderTest.readWithMapCache", "[WorldReaderTest]") {
+  using T = std::tuple<std::string, Model::MapFormat>;
+
+  // clang-format off
+  const auto dataAndMapFormat = GENERATE(values<T>({
+  {R"(
+// entity 0
+{
+"classname" "worldspawn"
+// brush 0
+{
+( -0 -0 -16 ) ( -0 -0  -0 ) ( 64 -0 -16 ) tex1 1 2 3 4 5
+( -0 -0 -16 ) ( -0 64 -16 ) ( -0 -0  -0 ) tex2 0 0 0 1 1
+( -0 -0 -16 ) ( 64 -0 -16 ) ( -0 64 -16 ) tex3 0 0 0 1 1
+( 64 64  -0 ) ( -0 64  -0 ) ( 64 64 -16 ) tex4 0 0 0 1 1
+( 64 64  -0 ) ( 64 64 -16 ) ( 64 -0  -0 ) tex5 0 0 0 1 1
+( 64 64  -0 ) ( 64 -0  -0 ) ( -0 64  -0 ) tex6 0 0 0 1 1
+( 32 32  -0 ) ( 32 -0  -0 ) ( -0 32  -0 ) tex7 0 0 0 1 1
+}
+}
+// entity 1
+{
+"classname" "func_group"
+"_tb_type" "_tb_group"
+"_tb_name" "My Group"
+"_tb_id" "2"
+}
+// entity 2
+{
+"classname" "func_door"
+"_tb_group" "2"
+{
+( 0 0 0 ) ( 0 0 0 ) ( 0 0 0 ) degenerate 0 0 0 1 1
+( -0 -0 -16 ) ( -0 -0  -0 ) ( 64 -0 -16 ) tex1 0 0 0 1 1
+( -0 -0 -16 ) ( -0 64 -16 ) ( -0 -0  -0 ) tex2 0 0 0 1 1
+( -0 -0 -16 ) ( 64 -0 -16 ) ( -0 64 -16 ) tex3 0 0 0 1 1
+( 64 64  -0 ) ( -0 64  -0 ) ( 64 64 -16 ) tex4 0 0 0 1 1
+( 64 64  -0 ) ( 64 64 -16 ) ( 64 -0  -0 ) tex5 0 0 0 1 1
+( 64 64  -0 ) ( 64 -0  -0 ) ( -0 64  -0 ) tex6 0 0 0 1 1
+}
+{
+( -0 -0 -16 ) ( -0 -0  -0 ) ( 64 -0 -16 ) tex1 0 0 0 1 1
+( -0 -0 -16 ) ( -0 64 -16 ) ( -0 -0  -0 ) tex2 0 0 0 1 1
+}
+}
+)", Model::MapFormat::Standard},
+  {R"(
+{
+"classname" "worldspawn"
+"mapversion" "220"
+// brush 0
+{
+( 208 190 80 ) ( 208 -62 80 ) ( 208 190 -176 ) gothic_block/blocks18c_3 [ -0.625 1 0 34 ] [ 0 0 -1 0 ] 32.6509 0.25 0.25 0 0 0
+( 224 200 80 ) ( 208 190 80 ) ( 224 200 -176 ) gothic_block/blocks18c_3 [ -1 0 0 32 ] [ 0 0 -1 0 ] 35.6251 0.25 0.25 0 1 0
+( 224 200 -176 ) ( 208 190 -176 ) ( 224 -52 -176 ) gothic_block/blocks18c_3 [ -1 0 0 32 ] [ 0.625 -1 0 -4 ] 35.6251 0.25 0.25 0 0 0
+( 224 -52 80 ) ( 208 -62 80 ) ( 224 200 80 ) gothic_block/blocks18c_3 [ 1 0 0 -32 ] [ 0.625 -1 0 -4 ] 324.375 0.25 0.25 0 0 0
+( 224 -52 -176 ) ( 208 -62 -176 ) ( 224 -52 80 ) gothic_block/blocks18c_3 [ 1 0 0 -23.7303 ] [ 0 0 -1 0 ] 35.6251 0.25 0.25 0 0 0
+( 224 -52 80 ) ( 224 200 80 ) ( 224 -52 -176 ) gothic_block/blocks18c_3 [ -0.625 1 0 44 ] [ 0 0 -1 0 ] 32.6509 0.25 0.25 0 0 0
+}
+// patch 0
+{
+patchDef2
+{
+common/caulk
+( 5 3 0 0 0 )
+(
+( (-64 -64 4 0   0 ) (-64 0 4 0   -0.25 ) (-64 64 4 0   -0.5 ) )
+( (  0 -64 4 0.2 0 ) (  0 0 4 0.2 -0.25 ) (  0 64 4 0.2 -0.5 ) )
+( ( 64 -64 4 0.4 0 ) ( 64 0 4 0.4 -0.25 ) ( 64 64 4 0.4 -0.5 ) )
+( (128 -64 4 0.6 0 ) (128 0 4 0.6 -0.25 ) (128 64 4 0.6 -0.5 ) )
+( (192 -64 4 0.8 0 ) (192 0 4 0.8 -0.25 ) (192 64 4 0.8 -0.5 ) )
+)
+}
+}
+})", Model::MapFormat::Quake3_Valve},
+  }));
+  // clang-format on
+
+  // structured bindings cannot be captured by the lambda below
+  const auto& data = std::get<0>(dataAndMapFormat);
+  const auto mapFormat = std::get<1>(dataAndMapFormat);
+  CAPTURE(mapFormat);
+
+  const vm::bbox3 worldBounds(8192.0);
+
+  auto env = TestEnvironment{};
+  const auto mapPath = env.dir() + Path{"test.map"};
+  env.createFile(Path{"test.map"}, data);
+  const auto cachePath = mapPath.addExtension(MapCache::FileExtension);
+  const auto key = MapCacheKey::forMapFile(mapPath, data);
+
+  const auto read = [&](const std::string& str, std::optional<MapCacheKey> cacheKey) {
+    IO::TestParserStatus status;
+    WorldReader reader(str, mapFormat, {});
+    if (cacheKey) {
+      reader.setCache(std::make_unique<MapCache>(cachePath, *cacheKey));
+    }
+
+    auto world = reader.read(worldBounds, status);
+
+    auto mapStr = std::stringstream{};
+    NodeWriter writer(*world, mapStr);
+    writer.writeMap();
+
+    auto lineNumbers = std::vector<size_t>{};
+    collectLineNumbers(*world, lineNumbers);
+
+    return std::make_tuple(
+      mapStr.str(), lineNumbers, status.messages(LogLevel::Warn),
+      status.messages(LogLevel::Error));
+  };
+
+  const auto expected = read(data, std::nullopt);
+  CHECK_FALSE(Disk::fileExists(cachePath));
+
+  // parses the input and writes the cache
+  CHECK(read(data, key) == expected);
+  REQUIRE(Disk::fileExists(cachePath));
+
+  SECTION("Reading from a valid cache does not parse the input") {
+    CHECK(read("", key) == expected);
+  }
+
+  SECTION("A stale cache is ignored and rewritten") {
+    auto staleKey = key;
+    staleKey.contentHash += 1u;
+
+    CHECK(read(data, staleKey) == expected);
+    CHECK(read("", staleKey) == expected);
+  }
+
+  SECTION("A corrupt cache is ignored") {
+    env.createFile(Path{"test.map.tbcache"}, "TBCACHE garbage");
+    CHECK(read(data, key) == expected);
+  }
+
+  SECTION("A cache with invalid parent indices is ignored") {
+    const auto cache = MapCache{cachePath, key};
+    auto contents = cache.read(mapFormat, mapFormat, worldBounds);
+    REQUIRE(contents.has_value());
+
+    for (auto& objectInfo : contents->objectInfos) {
+      if (auto* brushInfo = std::get_if<MapReader::BrushInfo>(&objectInfo)) {
+        brushInfo->parentIndex = contents->objectInfos.size();
+      }
+    }
+    REQUIRE(cache.write(mapFormat, mapFormat, worldBounds, *contents));
+
+    CHECK_FALSE(cache.read(mapFormat, mapFormat, worldBounds).has_value());
+    CHECK(read(data, key) == expected);
+  }
+}
 } // namespace IO
 } // namespace TrenchBroom
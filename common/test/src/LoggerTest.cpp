@@ -0,0 +1,127 @@
+/*
+ Copyright (C) 2023 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Logger.h"
+
+#include <QString>
+
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Catch2.h"
+
+namespace TrenchBroom {
+namespace {
+class RecordingLogger : public Logger {
+public:
+  std::vector<std::pair<LogLevel, std::string>> messages;
+
+private:
+  void doLog(const LogLevel level, const std::string& message) override {
+    messages.emplace_back(level, message);
+  }
+
+  void doLog(const LogLevel level, const QString& message) override {
+    doLog(level, message.toStdString());
+  }
+};
+} // namespace
+
+TEST_CASE("BufferedLoggerTest.flushInOrder", "[BufferedLoggerTest]") {
+  auto bufferedLogger = BufferedLogger{};
+  auto target = RecordingLogger{};
+
+  bufferedLogger.info("first");
+  bufferedLogger.warn() << "second " << 2;
+  bufferedLogger.error(QString{"third"});
+  bufferedLogger.info(std::string{"fourth"});
+
+  // nothing is forwarded before flushing
+  CHECK(target.messages.empty());
+
+  bufferedLogger.flush(target);
+  CHECK(
+    target.messages == std::vector<std::pair<LogLevel, std::string>>{
+                         {LogLevel::Info, "first"},
+                         {LogLevel::Warn, "second 2"},
+                         {LogLevel::Error, "third"},
+                         {LogLevel::Info, "fourth"},
+                       });
+}
+
+TEST_CASE("BufferedLoggerTest.flushClearsBuffer", "[BufferedLoggerTest]") {
+  auto bufferedLogger = BufferedLogger{};
+  auto target = RecordingLogger{};
+
+  bufferedLogger.info("first");
+  bufferedLogger.flush(target);
+  REQUIRE(target.messages.size() == 1u);
+
+  // flushing again forwards nothing
+  bufferedLogger.flush(target);
+  CHECK(target.messages.size() == 1u);
+
+  // messages logged after a flush are forwarded by the next flush
+  bufferedLogger.info("second");
+  bufferedLogger.flush(target);
+  CHECK(
+    target.messages == std::vector<std::pair<LogLevel, std::string>>{
+                         {LogLevel::Info, "first"},
+                         {LogLevel::Info, "second"},
+                       });
+}
+
+TEST_CASE("BufferedLoggerTest.logFromSeveralThreads", "[BufferedLoggerTest]") {
+  constexpr auto threadCount = size_t(4);
+  constexpr auto messageCount = size_t(1000);
+
+  auto bufferedLogger = BufferedLogger{};
+
+  auto threads = std::vector<std::thread>{};
+  for (size_t i = 0; i < threadCount; ++i) {
+    threads.emplace_back([&, i]() {
+      for (size_t j = 0; j < messageCount; ++j) {
+        bufferedLogger.info(std::to_string(i) + " " + std::to_string(j));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  auto target = RecordingLogger{};
+  bufferedLogger.flush(target);
+  REQUIRE(target.messages.size() == threadCount * messageCount);
+
+  // the messages of every thread are forwarded in the order in which that thread logged them
+  auto nextMessages = std::vector<size_t>(threadCount, 0u);
+  for (const auto& [level, message] : target.messages) {
+    CHECK(level == LogLevel::Info);
+
+    const auto separator = message.find(' ');
+    const auto thread = std::stoul(message.substr(0, separator));
+    const auto index = std::stoul(message.substr(separator + 1u));
+    REQUIRE(thread < threadCount);
+    CHECK(index == nextMessages[thread]);
+    nextMessages[thread] = index + 1u;
+  }
+}
+} // namespace TrenchBroom
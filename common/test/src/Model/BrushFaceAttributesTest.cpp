@@ -0,0 +1,78 @@
+/*
+ Copyright (C) 2023 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Model/BrushFaceAttributes.h"
+
+#include <vecmath/vec.h>
+
+#include "Catch2.h"
+
+namespace TrenchBroom {
+namespace Model {
+TEST_CASE("BrushFaceAttributesTest.textureNamesAreInterned", "[BrushFaceAttributesTest]") {
+  const auto a = BrushFaceAttributes{"some_texture"};
+  const auto b = BrushFaceAttributes{"some_texture"};
+  const auto c = BrushFaceAttributes{"other_texture"};
+
+  CHECK(&a.textureName() == &b.textureName());
+  CHECK(&a.textureName() != &c.textureName());
+
+  auto d = BrushFaceAttributes{"other_texture"};
+  d.setTextureName("some_texture");
+  CHECK(&d.textureName() == &a.textureName());
+}
+
+TEST_CASE("BrushFaceAttributesTest.copyOnWrite", "[BrushFaceAttributesTest]") {
+  auto original = BrushFaceAttributes{"some_texture"};
+  original.setRotation(45.0f);
+
+  auto copy = original;
+  CHECK(copy == original);
+
+  SECTION("Setting an unchanged value does not affect the original") {
+    CHECK_FALSE(copy.setRotation(45.0f));
+    CHECK(copy == original);
+  }
+
+  SECTION("Modifying a copy does not affect the original") {
+    CHECK(copy.setRotation(90.0f));
+    CHECK(copy.setOffset(vm::vec2f{1.0f, 2.0f}));
+    CHECK(copy.setSurfaceFlags(3));
+    CHECK(copy.setTextureName("other_texture"));
+
+    CHECK(copy.rotation() == 90.0f);
+    CHECK(copy.offset() == vm::vec2f{1.0f, 2.0f});
+    CHECK(copy.surfaceFlags() == 3);
+    CHECK(copy.textureName() == "other_texture");
+
+    CHECK(original.rotation() == 45.0f);
+    CHECK(original.offset() == vm::vec2f::zero());
+    CHECK(original.surfaceFlags() == std::nullopt);
+    CHECK(original.textureName() == "some_texture");
+    CHECK(copy != original);
+  }
+
+  SECTION("Attributes with equal values are equal") {
+    auto other = BrushFaceAttributes{"some_texture"};
+    other.setRotation(45.0f);
+    CHECK(other == original);
+  }
+}
+} // namespace Model
+} // namespace TrenchBroom
@@ -0,0 +1,108 @@
+/*
+ Copyright (C) 2023 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Model/BrushSnapshot.h"
+#include "Model/Brush.h"
+#include "Model/BrushBuilder.h"
+#include "Model/BrushFace.h"
+#include "Model/BrushGeometry.h"
+#include "Model/MapFormat.h"
+#include "Model/NodeContents.h"
+
+#include <kdl/result.h>
+
+#include <vecmath/bbox.h>
+#include <vecmath/vec.h>
+
+#include <variant>
+#include <vector>
+
+#include "Catch2.h"
+
+namespace TrenchBroom {
+namespace Model {
+static void checkSameGeometry(const Brush& actual, const Brush& expected) {
+  CHECK(actual == expected);
+  CHECK(actual.bounds() == expected.bounds());
+  CHECK_THAT(actual.vertexPositions(), Catch::UnorderedEquals(expected.vertexPositions()));
+  CHECK(actual.edgeCount() == expected.edgeCount());
+  for (size_t i = 0u; i < actual.faceCount(); ++i) {
+    const auto& actualFace = actual.face(i);
+    const auto& expectedFace = expected.face(i);
+    REQUIRE(actualFace.geometry() != nullptr);
+    CHECK_THAT(
+      actualFace.vertexPositions(),
+      Catch::UnorderedEquals(expectedFace.vertexPositions()));
+  }
+}
+
+TEST_CASE("BrushSnapshotTest.restore", "[BrushSnapshotTest]") {
+  const auto worldBounds = vm::bbox3{4096.0};
+  const auto builder = BrushBuilder{MapFormat::Standard, worldBounds};
+
+  SECTION("cube") {
+    const auto brush = builder.createCube(64.0, "texture").value();
+    const auto snapshot = BrushSnapshot{brush};
+
+    CHECK(snapshot.faces() == brush.faces());
+    CHECK(snapshot.vertexPositions().size() == 8u);
+    CHECK(snapshot.faceSizes() == std::vector<size_t>(6u, 4u));
+    CHECK(snapshot.faceIndices().size() == 24u);
+
+    const auto restored = snapshot.restore().value();
+    checkSameGeometry(restored, brush);
+  }
+
+  SECTION("brush with triangular faces") {
+    auto brush = builder.createCube(64.0, "texture").value();
+    REQUIRE(brush
+              .moveVertices(
+                worldBounds, {vm::vec3{32.0, 32.0, 32.0}}, vm::vec3{-16.0, -16.0, -16.0})
+              .is_success());
+
+    const auto snapshot = BrushSnapshot{brush};
+    const auto restored = snapshot.restore().value();
+    checkSameGeometry(restored, brush);
+  }
+}
+
+TEST_CASE("BrushSnapshotTest.compactNodeContents", "[BrushSnapshotTest]") {
+  const auto worldBounds = vm::bbox3{4096.0};
+  const auto brush =
+    BrushBuilder{MapFormat::Standard, worldBounds}.createCube(64.0, "texture").value();
+
+  auto contents = NodeContents{brush};
+  contents.compact();
+  CHECK(contents.compacted());
+
+  // compacting twice has no effect
+  contents.compact();
+
+  CHECK(contents.restore().is_success());
+  CHECK_FALSE(contents.compacted());
+
+  const auto& restored = std::get<Brush>(contents.get());
+  checkSameGeometry(restored, brush);
+
+  // restoring contents that are not compacted has no effect
+  CHECK(contents.restore().is_success());
+  checkSameGeometry(std::get<Brush>(contents.get()), brush);
+}
+} // namespace Model
+} // namespace TrenchBroom
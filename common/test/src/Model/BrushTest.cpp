@@ -39,11 +39,13 @@
 #include <kdl/vector_utils.h>
 
 #include <vecmath/approx.h>
+#include <vecmath/constants.h>
 #include <vecmath/polygon.h>
 #include <vecmath/ray.h>
 #include <vecmath/segment.h>
 #include <vecmath/vec.h>
 #include <vecmath/vec_ext.h>
+#include <vecmath/vec_io.h>
 
 #include <fstream>
 #include <string>
@@ -2235,5 +2237,182 @@ TEST_CASE("BrushTest.subtractEnclosed", "[BrushTest]") {
     brush1.subtract(MapFormat::Standard, worldBounds, "texture", brush2), [](const auto&) {});
   CHECK(result.size() == 0u);
 }
+
+TEST_CASE("BrushTest.queriesMatchGeometry", "[BrushTest]") {
+  const vm::bbox3 worldBounds(4096.0);
+
+  BrushBuilder builder(MapFormat::Standard, worldBounds);
+  const auto brushes = std::vector<Brush>{
+    builder.createCuboid(vm::bbox3(vm::vec3(0, 0, 0), vm::vec3(64, 64, 64)), "texture").value(),
+    builder.createCuboid(vm::bbox3(vm::vec3(16, 16, 16), vm::vec3(32, 32, 32)), "texture").value(),
+    builder.createCuboid(vm::bbox3(vm::vec3(64, 0, 0), vm::vec3(96, 32, 32)), "texture").value(),
+    builder.createCuboid(vm::bbox3(vm::vec3(48, 48, 48), vm::vec3(80, 80, 80)), "texture").value(),
+    builder.createCuboid(vm::bbox3(vm::vec3(128, 0, 0), vm::vec3(160, 32, 32)), "texture")
+      .value(),
+    builder
+      .createBrush(
+        std::vector<vm::vec3>{
+          vm::vec3(-32, -32, 0),
+          vm::vec3(32, -32, 0),
+          vm::vec3(-32, 32, 0),
+          vm::vec3(32, 32, 0),
+          vm::vec3(-32, -32, 64),
+          vm::vec3(-32, 32, 64)},
+        "texture")
+      .value(),
+  };
+
+  const auto geometries = kdl::vec_transform(brushes, [](const Brush& brush) {
+    return BrushGeometry(brush.vertexPositions());
+  });
+
+  for (size_t i = 0; i < brushes.size(); ++i) {
+    for (size_t j = 0; j < brushes.size(); ++j) {
+      CAPTURE(i, j);
+      CHECK(brushes[i].intersects(brushes[j]) == geometries[i].intersects(geometries[j]));
+      CHECK(brushes[i].contains(brushes[j]) == geometries[i].contains(geometries[j]));
+    }
+  }
+
+  const auto points = std::vector<vm::vec3>{
+    vm::vec3(0, 0, 0),   vm::vec3(8, 8, 8),     vm::vec3(64, 32, 32),
+    vm::vec3(70, 8, 8),  vm::vec3(-20, -20, 8), vm::vec3(31.5, 0.5, 63),
+    vm::vec3(96, 32, 0), vm::vec3(200, 0, 0),
+  };
+
+  for (size_t i = 0; i < brushes.size(); ++i) {
+    for (const auto& point : points) {
+      CAPTURE(i, point);
+      CHECK(
+        brushes[i].containsPoint(point) ==
+        geometries[i].contains(point, vm::constants<FloatType>::point_status_epsilon()));
+      CHECK(
+        brushes[i].hasVertex(point) == (geometries[i].findVertexByPosition(point) != nullptr));
+      CHECK(
+        brushes[i].findClosestVertexPosition(point) ==
+        geometries[i].findClosestVertex(point)->position());
+    }
+  }
+}
+
+TEST_CASE("BrushTest.subtractMultipleMergesFragments", "[BrushTest]") {
+  const vm::bbox3 worldBounds(4096.0);
+
+  BrushBuilder builder(MapFormat::Standard, worldBounds);
+  const Brush minuend =
+    builder.createCuboid(vm::bbox3(vm::vec3(0, 0, 0), vm::vec3(64, 64, 64)), "texture").value();
+  const Brush subtrahend1 =
+    builder.createCuboid(vm::bbox3(vm::vec3(16, 0, 32), vm::vec3(48, 64, 64)), "texture").value();
+  const Brush subtrahend2 =
+    builder.createCuboid(vm::bbox3(vm::vec3(0, 0, 32), vm::vec3(16, 64, 64)), "texture").value();
+  const Brush disjoint = builder
+                           .createCuboid(
+                             vm::bbox3(vm::vec3(128, 128, 128), vm::vec3(192, 192, 192)), "texture")
+                           .value();
+
+  // the first subtrahend splits the minuend at x = 16, which the second one makes unnecessary
+  const auto result = kdl::collect_values(
+    minuend.subtract(
+      MapFormat::Standard, worldBounds, "texture",
+      std::vector<const Brush*>{&subtrahend1, &disjoint, &subtrahend2}),
+    [](const auto&) {});
+
+  const auto resultBounds = kdl::vec_transform(result, [](const auto& brush) {
+    return brush.bounds();
+  });
+  CHECK_THAT(
+    resultBounds,
+    Catch::UnorderedEquals(std::vector<vm::bbox3>{
+      vm::bbox3(vm::vec3(0, 0, 0), vm::vec3(48, 64, 32)),
+      vm::bbox3(vm::vec3(48, 0, 0), vm::vec3(64, 64, 64)),
+    }));
+}
+
+TEST_CASE("BrushTest.subtractMultipleDoesNotMergeThinStep", "[BrushTest]") {
+  const vm::bbox3 worldBounds(4096.0);
+
+  BrushBuilder builder(MapFormat::Standard, worldBounds);
+  const Brush minuend =
+    builder.createCuboid(vm::bbox3(vm::vec3(0, 0, 0), vm::vec3(1024, 1024, 128)), "texture")
+      .value();
+  const Brush subtrahend1 =
+    builder.createCuboid(vm::bbox3(vm::vec3(0, 0, 65), vm::vec3(1024, 1023, 128)), "texture")
+      .value();
+  const Brush subtrahend2 =
+    builder.createCuboid(vm::bbox3(vm::vec3(0, 1023, 64), vm::vec3(1024, 1024, 128)), "texture")
+      .value();
+
+  // the remainder has a step of one unit, so its fragments must not be merged into a brush with a
+  // slanted face
+  const auto result = kdl::collect_values(
+    minuend.subtract(
+      MapFormat::Standard, worldBounds, "texture",
+      std::vector<const Brush*>{&subtrahend1, &subtrahend2}),
+    [](const auto&) {});
+
+  auto totalVolume = FloatType(0);
+  for (const auto& brush : result) {
+    const auto& bounds = brush.bounds();
+    CHECK(brush.vertexCount() == 8u);
+    for (const auto& position : brush.vertexPositions()) {
+      for (size_t i = 0; i < 3; ++i) {
+        CHECK((position[i] == bounds.min[i] || position[i] == bounds.max[i]));
+      }
+    }
+    totalVolume += bounds.volume();
+  }
+  CHECK(totalVolume == 1024.0 * 1023.0 * 65.0 + 1024.0 * 1.0 * 64.0);
+}
+
+TEST_CASE("BrushTest.subtractBrushes", "[BrushTest]") {
+  const vm::bbox3 worldBounds(4096.0);
+
+  BrushBuilder builder(MapFormat::Standard, worldBounds);
+  const Brush minuend1 =
+    builder.createCuboid(vm::bbox3(vm::vec3(0, 0, 0), vm::vec3(64, 64, 64)), "minuend").value();
+  const Brush minuend2 =
+    builder.createCuboid(vm::bbox3(vm::vec3(128, 0, 0), vm::vec3(192, 64, 64)), "minuend")
+      .value();
+  const Brush minuend3 =
+    builder.createCuboid(vm::bbox3(vm::vec3(512, 0, 0), vm::vec3(576, 64, 64)), "minuend")
+      .value();
+
+  // overlaps the first minuend
+  const Brush subtrahend1 =
+    builder.createCuboid(vm::bbox3(vm::vec3(16, 0, 32), vm::vec3(48, 64, 64)), "subtrahend")
+      .value();
+  // overlaps the first and the second minuend
+  const Brush subtrahend2 =
+    builder.createCuboid(vm::bbox3(vm::vec3(32, 16, 16), vm::vec3(144, 48, 48)), "subtrahend")
+      .value();
+  // overlaps the first minuend
+  const Brush subtrahend3 =
+    builder.createCuboid(vm::bbox3(vm::vec3(0, 0, 32), vm::vec3(16, 64, 64)), "subtrahend")
+      .value();
+
+  const auto minuends = std::vector<const Brush*>{&minuend1, &minuend2, &minuend3};
+  const auto subtrahends = std::vector<const Brush*>{&subtrahend1, &subtrahend2, &subtrahend3};
+
+  const auto results =
+    subtractBrushes(MapFormat::Standard, worldBounds, "texture", minuends, subtrahends);
+  REQUIRE(results.size() == minuends.size());
+
+  // every minuend yields the same result as subtracting all subtrahends from it
+  for (size_t i = 0; i < minuends.size(); ++i) {
+    CAPTURE(i);
+
+    const auto expected = kdl::collect_values(
+      minuends[i]->subtract(MapFormat::Standard, worldBounds, "texture", subtrahends),
+      [](const auto&) {});
+    const auto actual = kdl::collect_values(results[i], [](const auto&) {});
+    CHECK(actual == expected);
+  }
+
+  // the third minuend doesn't overlap any subtrahend
+  const auto unchanged = kdl::collect_values(results[2], [](const auto&) {});
+  REQUIRE(unchanged.size() == 1u);
+  CHECK_THAT(
+    unchanged.front().vertexPositions(), Catch::UnorderedEquals(minuend3.vertexPositions()));
+}
 } // namespace Model
 } // namespace TrenchBroom
@@ -226,6 +226,89 @@ TEST_CASE("GroupNodeTest.updateLinkedGroups", "[GroupNodeTest]") {
   }
 }
 
+TEST_CASE("GroupNodeTest.updateLinkedGroupNodes", "[GroupNodeTest]") {
+  const auto worldBounds = vm::bbox3(8192.0);
+
+  auto groupNode = GroupNode{Group{"name"}};
+  auto* entityNode = new EntityNode{Entity{}};
+  auto* otherEntityNode = new EntityNode{Entity{}};
+  groupNode.addChildren({entityNode, otherEntityNode});
+
+  auto groupNodeClone =
+    std::unique_ptr<GroupNode>{static_cast<GroupNode*>(groupNode.cloneRecursively(worldBounds))};
+  transformNode(*groupNodeClone, vm::translation_matrix(vm::vec3(0.0, 2.0, 0.0)), worldBounds);
+
+  auto* entityNodeClone = static_cast<EntityNode*>(groupNodeClone->children().front());
+  REQUIRE(entityNodeClone->entity().origin() == vm::vec3(0.0, 2.0, 0.0));
+
+  transformNode(*entityNode, vm::translation_matrix(vm::vec3(0.0, 0.0, 3.0)), worldBounds);
+  REQUIRE(entityNode->entity().origin() == vm::vec3(0.0, 0.0, 3.0));
+
+  SECTION("Only the changed nodes are updated") {
+    const auto updateResult =
+      updateLinkedGroupNodes(groupNode, {groupNodeClone.get()}, {entityNode}, worldBounds);
+    updateResult.visit(kdl::overload(
+      [&](const UpdateLinkedGroupNodesResult& r) {
+        CHECK(r.replacedChildren.empty());
+        REQUIRE(r.swappedContents.size() == 1u);
+
+        const auto& [nodeToUpdate, newContents] = r.swappedContents.front();
+        CHECK(nodeToUpdate == entityNodeClone);
+        CHECK(std::get<Entity>(newContents.get()).origin() == vm::vec3(0.0, 2.0, 3.0));
+      },
+      [](const auto&) {
+        FAIL();
+      }));
+  }
+
+  SECTION("Changed nodes outside of the source group are ignored") {
+    auto unrelatedEntityNode = EntityNode{Entity{}};
+
+    const auto updateResult = updateLinkedGroupNodes(
+      groupNode, {groupNodeClone.get()}, {&unrelatedEntityNode}, worldBounds);
+    updateResult.visit(kdl::overload(
+      [&](const UpdateLinkedGroupNodesResult& r) {
+        CHECK(r.replacedChildren.empty());
+        CHECK(r.swappedContents.empty());
+      },
+      [](const auto&) {
+        FAIL();
+      }));
+  }
+
+  SECTION("All children are replaced if the source group changed") {
+    const auto updateResult = updateLinkedGroupNodes(
+      groupNode, {groupNodeClone.get()}, {&groupNode, entityNode}, worldBounds);
+    updateResult.visit(kdl::overload(
+      [&](const UpdateLinkedGroupNodesResult& r) {
+        CHECK(r.swappedContents.empty());
+        REQUIRE(r.replacedChildren.size() == 1u);
+        CHECK(r.replacedChildren.front().first == groupNodeClone.get());
+        CHECK(r.replacedChildren.front().second.size() == 2u);
+      },
+      [](const auto&) {
+        FAIL();
+      }));
+  }
+
+  SECTION("All children are replaced if the structure of the target group does not match") {
+    groupNodeClone->addChild(new EntityNode{Entity{}});
+
+    const auto updateResult =
+      updateLinkedGroupNodes(groupNode, {groupNodeClone.get()}, {entityNode}, worldBounds);
+    updateResult.visit(kdl::overload(
+      [&](const UpdateLinkedGroupNodesResult& r) {
+        CHECK(r.swappedContents.empty());
+        REQUIRE(r.replacedChildren.size() == 1u);
+        CHECK(r.replacedChildren.front().first == groupNodeClone.get());
+        CHECK(r.replacedChildren.front().second.size() == 2u);
+      },
+      [](const auto&) {
+        FAIL();
+      }));
+  }
+}
+
 TEST_CASE("GroupNodeTest.updateNestedLinkedGroups", "[GroupNodeTest]") {
   const auto worldBounds = vm::bbox3(8192.0);
 
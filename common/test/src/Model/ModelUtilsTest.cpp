@@ -516,6 +516,49 @@ TEST_CASE("ModelUtils.collectContainedNodes") {
     Catch::Matchers::Equals(std::vector<Node*>{&groupNode, &entityNode, &brushNode, &patchNode}));
 }
 
+TEST_CASE("ModelUtils.collectMatchingNodesInWorld") {
+  constexpr auto worldBounds = vm::bbox3d{8192.0};
+  constexpr auto mapFormat = MapFormat::Quake3;
+
+  auto worldNode = WorldNode{{}, {}, mapFormat};
+  auto brushBuilder = BrushBuilder{mapFormat, worldBounds};
+
+  auto* layerNode = new LayerNode{Layer{"layer"}};
+  auto* groupNode = new GroupNode{Group{"group"}};
+  auto* groupedEntityNode = new EntityNode{Entity{}};
+  auto* entityNode = new EntityNode{Entity{}};
+  auto* brushNode = new BrushNode{brushBuilder.createCube(64.0, "texture").value()};
+  auto* brushEntityNode = new EntityNode{Entity{}};
+  auto* entityBrushNode = new BrushNode{brushBuilder.createCube(16.0, "texture").value()};
+  auto* queryBrushNode = new BrushNode{brushBuilder.createCube(24.0, "texture").value()};
+  auto* farBrushNode = new BrushNode{brushBuilder.createCube(24.0, "texture").value()};
+  transformNode(*farBrushNode, vm::translation_matrix(vm::vec3d{128, 0, 0}), worldBounds);
+
+  groupNode->addChild(groupedEntityNode);
+  brushEntityNode->addChild(entityBrushNode);
+  layerNode->addChildren(
+    {groupNode, entityNode, brushNode, brushEntityNode, queryBrushNode, farBrushNode});
+  worldNode.addChild(layerNode);
+
+  REQUIRE(queryBrushNode->contains(groupNode));
+  REQUIRE(queryBrushNode->contains(entityNode));
+  REQUIRE(queryBrushNode->intersects(brushNode));
+  REQUIRE_FALSE(queryBrushNode->contains(brushNode));
+  REQUIRE(queryBrushNode->contains(entityBrushNode));
+  REQUIRE_FALSE(queryBrushNode->intersects(farBrushNode));
+
+  CHECK_THAT(
+    collectTouchingNodes(worldNode, {queryBrushNode}),
+    Catch::Matchers::UnorderedEquals(
+      std::vector<Node*>{groupNode, entityNode, brushNode, entityBrushNode}));
+  CHECK_THAT(
+    collectContainedNodes(worldNode, {queryBrushNode}),
+    Catch::Matchers::UnorderedEquals(std::vector<Node*>{groupNode, entityNode, entityBrushNode}));
+  CHECK_THAT(
+    collectTouchingNodes(worldNode, {farBrushNode}),
+    Catch::Matchers::UnorderedEquals(std::vector<Node*>{}));
+}
+
 TEST_CASE("ModelUtils.collectSelectedNodes") {
   constexpr auto worldBounds = vm::bbox3d{8192.0};
   constexpr auto mapFormat = MapFormat::Quake3;
@@ -23,14 +23,20 @@
 #include "Model/Polyhedron_DefaultPayload.h"
 #include "Model/Polyhedron_Instantiation.h"
 
+#include <vecmath/bbox.h>
+#include <vecmath/constants.h>
 #include <vecmath/plane.h>
 #include <vecmath/scalar.h>
 #include <vecmath/vec.h>
 #include <vecmath/vec_io.h>
 
+#include <algorithm>
 #include <iterator>
+#include <optional>
+#include <random>
 #include <set>
 #include <tuple>
+#include <unordered_map>
 
 #include "Catch2.h"
 
@@ -449,6 +455,280 @@ TEST_CASE("PolyhedronTest.copy", "[PolyhedronTest]") {
   CHECK(Polyhedron3d({p1, p2, p3, p4}) == (Polyhedron3d() = Polyhedron3d({p1, p2, p3, p4})));
 }
 
+TEST_CASE("PolyhedronTest.fromFaces", "[PolyhedronTest]") {
+  const auto original = Polyhedron3d{vm::bbox3d{{-8.0, -4.0, 0.0}, {8.0, 4.0, 16.0}}};
+
+  auto positions = std::vector<vm::vec3d>{};
+  auto vertexIndices = std::unordered_map<const PVertex*, size_t>{};
+  for (const auto* vertex : original.vertices()) {
+    vertexIndices.emplace(vertex, positions.size());
+    positions.push_back(vertex->position());
+  }
+
+  auto facePlanes = std::vector<vm::plane3d>{};
+  auto faceSizes = std::vector<size_t>{};
+  auto faceIndices = std::vector<size_t>{};
+  for (const auto* face : original.faces()) {
+    facePlanes.push_back(face->plane());
+    faceSizes.push_back(face->boundary().size());
+    for (const auto* halfEdge : face->boundary()) {
+      faceIndices.push_back(vertexIndices[halfEdge->origin()]);
+    }
+  }
+
+  SECTION("Restores the polyhedron") {
+    const auto restored = Polyhedron3d::fromFaces(positions, facePlanes, faceSizes, faceIndices);
+    REQUIRE(restored.has_value());
+    CHECK(*restored == original);
+    CHECK(restored->bounds() == original.bounds());
+    CHECK(restored->polyhedron());
+    CHECK(restored->closed());
+    CHECK(restored->vertexPositions() == original.vertexPositions());
+
+    auto originalFace = std::begin(original.faces());
+    for (const auto* face : restored->faces()) {
+      CHECK(face->plane() == (*originalFace)->plane());
+      CHECK(face->vertexPositions() == (*originalFace)->vertexPositions());
+      ++originalFace;
+    }
+  }
+
+  SECTION("Rejects invalid faces") {
+    SECTION("Index out of range") {
+      faceIndices.front() = positions.size();
+    }
+    SECTION("Unused vertex") {
+      positions.push_back(vm::vec3d{32.0, 32.0, 32.0});
+    }
+    SECTION("Missing face") {
+      facePlanes.pop_back();
+      faceIndices.resize(faceIndices.size() - faceSizes.back());
+      faceSizes.pop_back();
+    }
+    SECTION("Inverted face") {
+      std::reverse(std::begin(faceIndices), std::next(std::begin(faceIndices), 4));
+    }
+    SECTION("Too few vertices") {
+      faceSizes.front() = 2u;
+      faceSizes.back() += 2u;
+    }
+    SECTION("Mismatched sizes") {
+      faceSizes.back() += 1u;
+    }
+
+    CHECK(Polyhedron3d::fromFaces(positions, facePlanes, faceSizes, faceIndices) == std::nullopt);
+  }
+}
+
+/**
+ * Clips a large cube with the given planes and returns the result together with the index of the
+ * plane of each face, or nothing if the planes don't bound a polyhedron.
+ */
+static std::optional<std::tuple<Polyhedron3d, std::vector<size_t>>> clipPlanes(
+  const std::vector<vm::plane3d>& planes) {
+  auto polyhedron = Polyhedron3d{vm::bbox3d{8192.0}};
+  auto facePlaneIndices = std::unordered_map<const PFace*, size_t>{};
+  for (size_t i = 0; i < planes.size(); ++i) {
+    const auto result = polyhedron.clip(planes[i]);
+    if (result.empty()) {
+      return std::nullopt;
+    }
+    if (result.success()) {
+      facePlaneIndices[result.face()] = i;
+    }
+  }
+
+  auto planeIndices = std::vector<size_t>{};
+  for (const auto* face : polyhedron.faces()) {
+    const auto it = facePlaneIndices.find(face);
+    if (it == std::end(facePlaneIndices)) {
+      return std::nullopt;
+    }
+    planeIndices.push_back(it->second);
+  }
+
+  return std::make_tuple(std::move(polyhedron), std::move(planeIndices));
+}
+
+static void checkSameTopology(
+  const Polyhedron3d& actual, const std::vector<size_t>& actualPlaneIndices,
+  const Polyhedron3d& expected, const std::vector<size_t>& expectedPlaneIndices) {
+  constexpr auto epsilon = vm::constants<double>::almost_zero();
+
+  CHECK(actual.vertexCount() == expected.vertexCount());
+  CHECK(actual.edgeCount() == expected.edgeCount());
+  CHECK(actual.faceCount() == expected.faceCount());
+  CHECK(actualPlaneIndices == expectedPlaneIndices);
+  CHECK(actual.closed());
+
+  for (const auto* vertex : expected.vertices()) {
+    CHECK(actual.hasVertex(vertex->position(), epsilon));
+  }
+  for (const auto* edge : expected.edges()) {
+    CHECK(actual.hasEdge(
+      edge->firstVertex()->position(), edge->secondVertex()->position(), epsilon));
+  }
+  for (const auto* face : expected.faces()) {
+    CHECK(actual.hasFace(face->vertexPositions(), epsilon));
+  }
+}
+
+/**
+ * Corrects the vertex positions of both polyhedra like Brush does and checks that every coordinate
+ * which was snapped in one polyhedron is identical in the other.
+ */
+static void checkSameCorrectedVertexPositions(Polyhedron3d actual, Polyhedron3d expected) {
+  constexpr auto epsilon = vm::constants<double>::almost_zero();
+
+  actual.correctVertexPositions();
+  expected.correctVertexPositions();
+
+  for (const auto* expectedVertex : expected.vertices()) {
+    const auto* actualVertex = actual.findClosestVertex(expectedVertex->position(), epsilon);
+    REQUIRE(actualVertex != nullptr);
+
+    const auto& expectedPosition = expectedVertex->position();
+    const auto& actualPosition = actualVertex->position();
+    for (size_t i = 0; i < 3; ++i) {
+      if (
+        vm::round(expectedPosition[i]) == expectedPosition[i]
+        || vm::round(actualPosition[i]) == actualPosition[i]) {
+        CHECK(actualPosition[i] == expectedPosition[i]);
+      }
+    }
+  }
+}
+
+TEST_CASE("PolyhedronTest.fromPlanes", "[PolyhedronTest]") {
+  const auto cube = std::vector<vm::plane3d>{
+    {vm::vec3d{-32.0, 0.0, 0.0}, vm::vec3d::neg_x()},
+    {vm::vec3d{32.0, 0.0, 0.0}, vm::vec3d::pos_x()},
+    {vm::vec3d{0.0, -32.0, 0.0}, vm::vec3d::neg_y()},
+    {vm::vec3d{0.0, 32.0, 0.0}, vm::vec3d::pos_y()},
+    {vm::vec3d{0.0, 0.0, -32.0}, vm::vec3d::neg_z()},
+    {vm::vec3d{0.0, 0.0, 32.0}, vm::vec3d::pos_z()},
+  };
+
+  SECTION("Cube") {
+    auto facePlaneIndices = std::vector<size_t>{};
+    const auto polyhedron = Polyhedron3d::fromPlanes(cube, facePlaneIndices);
+    REQUIRE(polyhedron.has_value());
+    CHECK(*polyhedron == Polyhedron3d{vm::bbox3d{32.0}});
+    CHECK(facePlaneIndices == std::vector<size_t>{0, 1, 2, 3, 4, 5});
+  }
+
+  SECTION("Redundant planes don't create faces") {
+    auto planes = cube;
+    // touches the cube in an edge
+    planes.emplace_back(vm::vec3d{32.0, 32.0, 0.0}, vm::normalize(vm::vec3d{1.0, 1.0, 0.0}));
+    // coincides with the first plane
+    planes.push_back(cube.front());
+    // doesn't touch the cube
+    planes.emplace_back(vm::vec3d{0.0, 0.0, 64.0}, vm::vec3d::pos_z());
+    // cuts off a corner
+    planes.emplace_back(vm::vec3d{32.0, 32.0, 16.0}, vm::normalize(vm::vec3d{1.0, 1.0, 1.0}));
+
+    auto facePlaneIndices = std::vector<size_t>{};
+    const auto polyhedron = Polyhedron3d::fromPlanes(planes, facePlaneIndices);
+    REQUIRE(polyhedron.has_value());
+    CHECK(polyhedron->vertexCount() == 10u);
+    CHECK(polyhedron->faceCount() == 7u);
+    CHECK(facePlaneIndices == std::vector<size_t>{0, 1, 2, 3, 4, 5, 10});
+
+    const auto [expected, expectedPlaneIndices] = clipPlanes(planes).value();
+    checkSameTopology(*polyhedron, facePlaneIndices, expected, expectedPlaneIndices);
+  }
+
+  SECTION("Unbounded planes") {
+    auto planes = cube;
+    planes.pop_back();
+
+    auto facePlaneIndices = std::vector<size_t>{};
+    CHECK(Polyhedron3d::fromPlanes(planes, facePlaneIndices) == std::nullopt);
+  }
+
+  SECTION("Empty intersection") {
+    auto planes = cube;
+    planes.emplace_back(vm::vec3d{0.0, 0.0, -64.0}, vm::vec3d::pos_z());
+
+    auto facePlaneIndices = std::vector<size_t>{};
+    CHECK(Polyhedron3d::fromPlanes(planes, facePlaneIndices) == std::nullopt);
+  }
+
+  SECTION("Random planes yield the same result as clipping") {
+    auto rng = std::mt19937{0};
+    auto coordinate = std::uniform_real_distribution<double>{-1.0, 1.0};
+    auto radius = std::uniform_real_distribution<double>{32.0, 96.0};
+
+    auto clippedCount = size_t(0);
+    auto intersectedCount = size_t(0);
+    for (size_t i = 0; i < 1000; ++i) {
+      // the cube planes make sure that most sets of planes are bounded
+      auto planes = i % 2 == 0 ? std::vector<vm::plane3d>{} : cube;
+      const auto planeCount = 4u + i % 9u;
+      for (size_t j = 0; j < planeCount; ++j) {
+        const auto normal =
+          vm::normalize(vm::vec3d{coordinate(rng), coordinate(rng), coordinate(rng)});
+        planes.emplace_back(radius(rng) * normal, normal);
+      }
+
+      const auto clipped = clipPlanes(planes);
+      auto facePlaneIndices = std::vector<size_t>{};
+      const auto intersected = Polyhedron3d::fromPlanes(planes, facePlaneIndices);
+
+      if (clipped) {
+        ++clippedCount;
+        if (intersected) {
+          ++intersectedCount;
+          const auto& [expected, expectedPlaneIndices] = *clipped;
+          checkSameTopology(*intersected, facePlaneIndices, expected, expectedPlaneIndices);
+          checkSameCorrectedVertexPositions(*intersected, expected);
+        }
+      }
+    }
+
+    // few results are rejected because they are ambiguous
+    CHECK(clippedCount > 500u);
+    CHECK(intersectedCount > clippedCount * 95u / 100u);
+  }
+
+  SECTION("Random planes through integer points yield the same vertices as clipping") {
+    // like the faces of a brush in a map file, which are defined by three integer points
+    auto rng = std::mt19937{0};
+    auto offset = std::uniform_int_distribution<int>{-16, 16};
+    auto distance = std::uniform_int_distribution<int>{16, 64};
+
+    auto intersectedCount = size_t(0);
+    for (size_t i = 0; i < 1000; ++i) {
+      auto planes = cube;
+      const auto planeCount = 1u + i % 6u;
+      for (size_t j = 0; j < planeCount; ++j) {
+        const auto d = static_cast<double>(distance(rng));
+        const auto p1 = vm::vec3d{d, double(offset(rng)), double(offset(rng))};
+        const auto p2 = vm::vec3d{double(offset(rng)), d, double(offset(rng))};
+        const auto p3 = vm::vec3d{double(offset(rng)), double(offset(rng)), d};
+        if (const auto [valid, plane] = vm::from_points(p1, p2, p3); valid) {
+          // the plane must face away from the origin
+          planes.push_back(plane.distance < 0.0 ? plane.flip() : plane);
+        }
+      }
+
+      const auto clipped = clipPlanes(planes);
+      auto facePlaneIndices = std::vector<size_t>{};
+      const auto intersected = Polyhedron3d::fromPlanes(planes, facePlaneIndices);
+
+      if (clipped && intersected) {
+        ++intersectedCount;
+        const auto& [expected, expectedPlaneIndices] = *clipped;
+        checkSameTopology(*intersected, facePlaneIndices, expected, expectedPlaneIndices);
+        checkSameCorrectedVertexPositions(*intersected, expected);
+      }
+    }
+
+    CHECK(intersectedCount > 500u);
+  }
+}
+
 TEST_CASE("PolyhedronTest.swap", "[PolyhedronTest]") {
   const vm::vec3d p1(0.0, 0.0, 8.0);
   const vm::vec3d p2(8.0, 0.0, 0.0);
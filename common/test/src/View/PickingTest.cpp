@@ -377,5 +377,66 @@ TEST_CASE_METHOD(MapDocumentTest, "PickingTest.pickBrushEntity") {
     brush1.face(*brush1.findFace(vm::vec3::neg_x())));
   CHECK(hits.front().distance() == vm::approx(32.0));
 }
+
+TEST_CASE_METHOD(MapDocumentTest, "PickingTest.pickRays") {
+  // delete default brush
+  document->selectAllNodes();
+  document->deleteObjects();
+
+  const Model::BrushBuilder builder(document->world()->mapFormat(), document->worldBounds());
+
+  auto* brushNode1 = new Model::BrushNode(
+    builder.createCuboid(vm::bbox3(vm::vec3(0, 0, 0), vm::vec3(64, 64, 64)), "texture").value());
+  auto* brushNode2 = new Model::BrushNode(
+    builder.createCuboid(vm::bbox3(vm::vec3(128, 0, 0), vm::vec3(192, 32, 32)), "texture")
+      .value());
+  auto* hiddenBrushNode = new Model::BrushNode(
+    builder.createCuboid(vm::bbox3(vm::vec3(256, 0, 0), vm::vec3(320, 64, 64)), "texture")
+      .value());
+  auto* entityNode = new Model::EntityNode{Model::Entity{{}, {{"origin", "96 48 48"}}}};
+
+  addNode(*document, document->parentForNodes(), brushNode1);
+  addNode(*document, document->parentForNodes(), brushNode2);
+  addNode(*document, document->parentForNodes(), hiddenBrushNode);
+  addNode(*document, document->parentForNodes(), entityNode);
+  document->hide({hiddenBrushNode});
+
+  // more rays than fit into one packet, some of which hit nothing
+  auto rays = std::vector<vm::ray3>{};
+  for (size_t y = 0; y < 12; ++y) {
+    for (size_t z = 0; z < 12; ++z) {
+      const auto origin = vm::vec3(
+        -32.0, static_cast<FloatType>(y) * 8.0 - 8.0, static_cast<FloatType>(z) * 8.0 - 8.0);
+      rays.emplace_back(origin, vm::vec3::pos_x());
+    }
+  }
+  rays.emplace_back(vm::vec3(400, 16, 16), vm::vec3::neg_x());
+  rays.emplace_back(vm::vec3(32, 32, 32), vm::vec3::pos_z());
+
+  const auto pickResults = document->pick(rays);
+  REQUIRE(pickResults.size() == rays.size());
+
+  auto hitCount = size_t(0);
+  for (size_t i = 0; i < rays.size(); ++i) {
+    auto expected = Model::PickResult::byDistance();
+    document->pick(rays[i], expected);
+
+    const auto& expectedHits = expected.all();
+    const auto& actualHits = pickResults[i].all();
+    REQUIRE(actualHits.size() == expectedHits.size());
+    for (size_t j = 0; j < actualHits.size(); ++j) {
+      CHECK(actualHits[j].type() == expectedHits[j].type());
+      CHECK(actualHits[j].distance() == expectedHits[j].distance());
+      CHECK(actualHits[j].hitPoint() == expectedHits[j].hitPoint());
+    }
+    hitCount += actualHits.size();
+  }
+  CHECK(hitCount > 0u);
+
+  // the hidden brush is not hit
+  const auto& hits = pickResults[rays.size() - 2].all();
+  REQUIRE(hits.size() == 2u);
+  CHECK(hits[0].hitPoint() == vm::approx(vm::vec3(192, 16, 16)));
+}
 } // namespace View
 } // namespace TrenchBroom
@@ -19,10 +19,17 @@
 
 #include "Model/BrushNode.h"
 #include "Model/NodeCollection.h"
+#include "TestUtils.h"
 #include "View/Grid.h"
 #include "View/MapDocument.h"
 #include "View/MapDocumentTest.h"
 
+#include <vecmath/bbox.h>
+#include <vecmath/bbox_io.h>
+#include <vecmath/vec.h>
+
+#include <vector>
+
 #include "Catch2.h"
 
 namespace TrenchBroom {
@@ -53,5 +60,32 @@ TEST_CASE_METHOD(MapDocumentTest, "SnapBrushVerticesTest.snapVerticesCrash_2244"
   CHECK(document->selectedNodes().brushCount() == 1u);
   CHECK_NOTHROW(document->snapVertices(document->grid().actualSize()));
 }
+
+TEST_CASE_METHOD(MapDocumentTest, "SnapBrushVerticesTest.snapVerticesOfSeveralBrushes") {
+  auto brushNodes = std::vector<Model::BrushNode*>{};
+  for (size_t i = 0; i < 16; ++i) {
+    auto* brushNode = createBrushNode();
+    addNode(*document, document->parentForNodes(), brushNode);
+    brushNodes.push_back(brushNode);
+  }
+
+  const auto originalBounds = brushNodes.front()->logicalBounds();
+
+  document->selectAllNodes();
+  REQUIRE(document->translateObjects(vm::vec3{0.5, 0.5, 0.0}));
+
+  const auto translatedBounds = brushNodes.front()->logicalBounds();
+  REQUIRE(translatedBounds != originalBounds);
+
+  CHECK(document->snapVertices(16.0));
+  for (const auto* brushNode : brushNodes) {
+    CHECK(brushNode->logicalBounds() == originalBounds);
+  }
+
+  document->undoCommand();
+  for (const auto* brushNode : brushNodes) {
+    CHECK(brushNode->logicalBounds() == translatedBounds);
+  }
+}
 } // namespace View
 } // namespace TrenchBroom
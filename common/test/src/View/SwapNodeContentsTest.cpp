@@ -72,6 +72,10 @@ TEST_CASE_METHOD(MapDocumentTest, "SwapNodeContentsTest.swapBrushes") {
 
   document->undoCommand();
   CHECK(brushNode->brush() == originalBrush);
+
+  document->redoCommand();
+  CHECK(brushNode->brush() == modifiedBrush);
+  CHECK(brushNode->brush().bounds() == modifiedBrush.bounds());
 }
 
 TEST_CASE_METHOD(MapDocumentTest, "SwapNodeContentsTest.swapPatches") {
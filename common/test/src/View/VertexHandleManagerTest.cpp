@@ -0,0 +1,190 @@
+/*
+ Copyright (C) 2023 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "View/VertexHandleManager.h"
+
+#include "Model/Brush.h"
+#include "Model/BrushBuilder.h"
+#include "Model/BrushNode.h"
+#include "Model/MapFormat.h"
+#include "Model/PickResult.h"
+#include "PreferenceManager.h"
+#include "Preferences.h"
+#include "Renderer/PerspectiveCamera.h"
+
+#include <kdl/result.h>
+#include <kdl/vector_utils.h>
+
+#include <vecmath/bbox.h>
+#include <vecmath/ray.h>
+#include <vecmath/vec.h>
+
+#include <memory>
+#include <vector>
+
+#include "Catch2.h"
+
+namespace TrenchBroom {
+namespace View {
+static std::vector<std::unique_ptr<Model::BrushNode>> makeBrushNodes() {
+  const auto builder = Model::BrushBuilder{Model::MapFormat::Standard, vm::bbox3{8192.0}};
+
+  auto result = std::vector<std::unique_ptr<Model::BrushNode>>{};
+  for (size_t i = 0; i < 3; ++i) {
+    const auto x = static_cast<FloatType>(i) * 64.0;
+    result.push_back(std::make_unique<Model::BrushNode>(
+      builder.createCuboid(vm::bbox3{vm::vec3{x, 0, 0}, vm::vec3{x + 64.0, 64.0, 64.0}}, "texture")
+        .value()));
+  }
+  return result;
+}
+
+TEST_CASE("VertexHandleManagerTest.addAndRemoveHandles", "[VertexHandleManagerTest]") {
+  const auto brushNodes = makeBrushNodes();
+
+  auto manager = VertexHandleManager{};
+  for (const auto& brushNode : brushNodes) {
+    manager.addHandles(brushNode.get());
+  }
+
+  // adjacent brushes share four vertices
+  CHECK(manager.totalHandleCount() == 16u);
+  CHECK(manager.contains(vm::vec3{64, 0, 0}));
+
+  manager.removeHandles(brushNodes[0].get());
+  CHECK(manager.totalHandleCount() == 12u);
+  CHECK(manager.contains(vm::vec3{64, 0, 0}));
+  CHECK_FALSE(manager.contains(vm::vec3{0, 0, 0}));
+
+  manager.removeHandles(brushNodes[1].get());
+  CHECK(manager.totalHandleCount() == 8u);
+  CHECK_FALSE(manager.contains(vm::vec3{64, 0, 0}));
+}
+
+TEST_CASE("VertexHandleManagerTest.selectCloseHandle", "[VertexHandleManagerTest]") {
+  const auto brushNodes = makeBrushNodes();
+
+  auto manager = VertexHandleManager{};
+  for (const auto& brushNode : brushNodes) {
+    manager.addHandles(brushNode.get());
+  }
+
+  manager.select(vm::vec3{64.0000001, 0, 0});
+  CHECK(manager.selectedHandleCount() == 1u);
+  CHECK(manager.selected(vm::vec3{64, 0, 0}));
+
+  manager.select(vm::vec3{32, 0, 0});
+  CHECK(manager.selectedHandleCount() == 1u);
+
+  manager.deselect(vm::vec3{64, 0, 0});
+  CHECK(manager.selectedHandleCount() == 0u);
+}
+
+TEST_CASE("VertexHandleManagerTest.selectAfterBatchedChanges", "[VertexHandleManagerTest]") {
+  const auto brushNodes = makeBrushNodes();
+
+  auto manager = VertexHandleManager{};
+  for (const auto& brushNode : brushNodes) {
+    manager.addHandles(brushNode.get());
+  }
+
+  // the pending changes are applied to the handle tree here
+  manager.select(vm::vec3{0, 0, 0});
+  CHECK(manager.selectedHandleCount() == 1u);
+
+  SECTION("Few changes are applied one by one") {
+    manager.removeHandles(brushNodes[2].get());
+    manager.addHandles(brushNodes[2].get());
+  }
+
+  SECTION("Many changes rebuild the tree") {
+    for (const auto& brushNode : brushNodes) {
+      manager.removeHandles(brushNode.get());
+    }
+    for (const auto& brushNode : brushNodes) {
+      manager.addHandles(brushNode.get());
+    }
+  }
+
+  SECTION("Handles that are added and removed again before a query are ignored") {
+    manager.removeHandles(brushNodes[0].get());
+    manager.addHandles(brushNodes[0].get());
+    manager.removeHandles(brushNodes[0].get());
+    manager.addHandles(brushNodes[0].get());
+  }
+
+  CHECK(manager.totalHandleCount() == 16u);
+
+  manager.select(vm::vec3{192, 64, 64});
+  manager.select(vm::vec3{64, 0, 0});
+  CHECK(manager.selected(vm::vec3{192, 64, 64}));
+  CHECK(manager.selected(vm::vec3{64, 0, 0}));
+
+  const auto allHandles = manager.allHandles();
+  manager.deselectAll();
+  manager.select(std::begin(allHandles), std::end(allHandles));
+  CHECK(manager.allSelected());
+}
+
+TEST_CASE("VertexHandleManagerTest.pick", "[VertexHandleManagerTest]") {
+  const auto brushNodes = makeBrushNodes();
+
+  auto vertexManager = VertexHandleManager{};
+  auto edgeManager = EdgeHandleManager{};
+  for (const auto& brushNode : brushNodes) {
+    vertexManager.addHandles(brushNode.get());
+    edgeManager.addHandles(brushNode.get());
+  }
+
+  const auto camera = Renderer::PerspectiveCamera{
+    90.0f,
+    1.0f,
+    8000.0f,
+    Renderer::Camera::Viewport{0, 0, 1920, 1080},
+    vm::vec3f{96.0f, -160.0f, 32.0f},
+    vm::vec3f::pos_y(),
+    vm::vec3f::pos_z()};
+  const auto origin = vm::vec3{camera.position()};
+
+  // only the handles near the pick ray are tested, but those must be found
+  const auto handleRadius = static_cast<FloatType>(pref(Preferences::HandleRadius));
+  const auto target = GENERATE(
+    vm::vec3{64, 0, 0}, vm::vec3{128, 0, 64}, vm::vec3{96, 0, 64}, vm::vec3{96, 0, 32});
+  const auto pickRay = vm::ray3{origin, vm::normalize(target - origin)};
+
+  auto vertexPickResult = Model::PickResult{};
+  vertexManager.pick(pickRay, camera, vertexPickResult);
+
+  const auto expectedVertexHits =
+    kdl::vec_filter(vertexManager.allHandles(), [&](const vm::vec3& handle) {
+      return !vm::is_nan(camera.pickPointHandle(pickRay, handle, handleRadius));
+    });
+  CHECK(vertexPickResult.all().size() == expectedVertexHits.size());
+
+  auto edgePickResult = Model::PickResult{};
+  edgeManager.pickCenterHandle(pickRay, camera, edgePickResult);
+
+  const auto expectedEdgeHits =
+    kdl::vec_filter(edgeManager.allHandles(), [&](const vm::segment3& handle) {
+      return !vm::is_nan(camera.pickPointHandle(pickRay, handle.center(), handleRadius));
+    });
+  CHECK(edgePickResult.all().size() == expectedEdgeHits.size());
+}
+} // namespace View
+} // namespace TrenchBroom
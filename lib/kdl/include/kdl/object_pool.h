@@ -0,0 +1,230 @@
+/*
+ Copyright 2023 Kristian Duske
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ associated documentation files (the "Software"), to deal in the Software without restriction,
+ including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or
+ substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT
+ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+
+namespace kdl {
+/**
+ * A pool of memory blocks for objects of type T. The blocks are carved out of slabs of `SlabSize`
+ * blocks each, so allocating and freeing many objects of the same type needs only a few calls to
+ * the global allocator.
+ *
+ * Every thread keeps a cache of free blocks and only takes the lock of the pool when its cache is
+ * empty or too full, in which case it exchanges a batch of `SlabSize` blocks with the pool. Blocks
+ * can be freed on a different thread than the one which allocated them.
+ *
+ * The pool keeps track of the free blocks of each slab. Once all blocks of a slab have been
+ * returned to the pool, the slab is released to the global allocator, except for one empty slab
+ * which is kept to avoid allocating and releasing a slab repeatedly. Blocks which are cached by a
+ * thread count as used, so a slab can only be released once the threads have returned its blocks.
+ *
+ * To allocate all objects of a type from the pool, the type can override its class specific
+ * operator new and operator delete:
+ *
+ * ```
+ * static void* operator new(std::size_t) { return object_pool<T>::allocate(); }
+ * static void operator delete(void* ptr) { object_pool<T>::deallocate(ptr); }
+ * ```
+ */
+template <typename T, std::size_t SlabSize = 256> class object_pool {
+  static_assert(SlabSize > 0, "slab size must not be 0");
+
+private:
+  union block {
+    block* next;
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+
+  struct free_list {
+    block* first = nullptr;
+    std::size_t size = 0;
+
+    void push(block* b) {
+      b->next = first;
+      first = b;
+      ++size;
+    }
+
+    block* pop() {
+      block* result = first;
+      first = first->next;
+      --size;
+      return result;
+    }
+
+    /**
+     * Moves up to `count` blocks from the given list to this list.
+     */
+    void take(free_list& other, std::size_t count) {
+      while (count > 0 && other.first != nullptr) {
+        push(other.pop());
+        --count;
+      }
+    }
+  };
+
+  struct slab {
+    std::unique_ptr<block[]> blocks;
+    free_list free;
+  };
+
+  struct shared_state {
+    std::mutex mutex;
+    // the slabs by the address of their first block
+    std::map<const block*, slab, std::less<const block*>> slabs;
+    // the slabs which have free blocks, by the address of their first block
+    std::set<const block*, std::less<const block*>> available;
+    std::size_t empty_slabs = 0;
+
+    /**
+     * Moves up to `count` blocks from the given list to the slabs they belong to. Must be called
+     * while holding the mutex.
+     */
+    void give_back(free_list& other, std::size_t count) {
+      while (count > 0 && other.first != nullptr) {
+        auto* b = other.pop();
+        auto it = std::prev(slabs.upper_bound(b));
+        auto& s = it->second;
+        s.free.push(b);
+        available.insert(it->first);
+
+        if (s.free.size == SlabSize) {
+          if (empty_slabs > 0) {
+            available.erase(it->first);
+            slabs.erase(it);
+          } else {
+            ++empty_slabs;
+          }
+        }
+        --count;
+      }
+    }
+
+    /**
+     * Moves up to `count` free blocks of the slabs to the given list, preferring the slabs at the
+     * lowest addresses. Must be called while holding the mutex.
+     */
+    void take_from_slabs(free_list& target, std::size_t count) {
+      while (count > 0 && !available.empty()) {
+        auto& s = slabs.find(*available.begin())->second;
+        if (s.free.size == SlabSize) {
+          --empty_slabs;
+        }
+
+        const auto taken = std::min(count, s.free.size);
+        target.take(s.free, taken);
+        if (s.free.first == nullptr) {
+          available.erase(available.begin());
+        }
+        count -= taken;
+      }
+    }
+  };
+
+  /**
+   * Returns the blocks cached by a thread to the pool when the thread exits.
+   */
+  struct thread_cache {
+    free_list free;
+
+    ~thread_cache() {
+      auto& state = shared();
+      auto lock = std::lock_guard{state.mutex};
+      state.give_back(free, free.size);
+    }
+  };
+
+public:
+  /**
+   * Returns uninitialized memory for one object of type T.
+   */
+  static void* allocate() {
+    auto& cache = local();
+    if (cache.free.first == nullptr) {
+      refill(cache.free);
+    }
+    return cache.free.pop()->storage;
+  }
+
+  /**
+   * Returns the given memory to the pool. The memory must have been obtained by calling allocate,
+   * and the object stored in it must have been destroyed.
+   */
+  static void deallocate(void* ptr) noexcept {
+    if (ptr == nullptr) {
+      return;
+    }
+
+    auto& cache = local();
+    cache.free.push(static_cast<block*>(ptr));
+    if (cache.free.size > 2u * SlabSize) {
+      auto& state = shared();
+      auto lock = std::lock_guard{state.mutex};
+      state.give_back(cache.free, SlabSize);
+    }
+  }
+
+  /**
+   * Returns the number of slabs currently allocated by the pool.
+   */
+  static std::size_t slab_count() {
+    auto& state = shared();
+    auto lock = std::lock_guard{state.mutex};
+    return state.slabs.size();
+  }
+
+private:
+  static void refill(free_list& free) {
+    auto& state = shared();
+    auto lock = std::lock_guard{state.mutex};
+    if (!state.available.empty()) {
+      state.take_from_slabs(free, SlabSize);
+      return;
+    }
+
+    auto blocks = std::make_unique<block[]>(SlabSize);
+    for (std::size_t i = 0; i < SlabSize; ++i) {
+      free.push(&blocks[SlabSize - i - 1u]);
+    }
+    const auto* key = blocks.get();
+    state.slabs.emplace(key, slab{std::move(blocks), free_list{}});
+  }
+
+  static shared_state& shared() {
+    // never destroyed, so that threads which exit during static destruction can still return
+    // their cached blocks and objects that outlive the static destruction can still be freed
+    static auto* state = new shared_state{};
+    return *state;
+  }
+
+  static thread_cache& local() {
+    static thread_local auto cache = thread_cache{};
+    return cache;
+  }
+};
+} // namespace kdl
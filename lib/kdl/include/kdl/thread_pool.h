@@ -0,0 +1,329 @@
+/*
+ Copyright 2023 Kristian Duske
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ associated documentation files (the "Software"), to deal in the Software without restriction,
+ including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or
+ substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT
+ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace kdl {
+/**
+ * A pool of persistent worker threads that run chunked index ranges in parallel.
+ *
+ * Every worker owns a task queue. A worker takes tasks from the back of its own queue first, then
+ * from a queue shared by all threads that are not workers of this pool, and finally steals tasks
+ * from the front of the other workers' queues.
+ *
+ * The thread that calls for_each_chunk always works on the range itself and only enqueues helper
+ * tasks for the workers, so the call completes even if all workers are busy. This makes it safe to
+ * call for_each_chunk from within a task that is running on this pool.
+ */
+class thread_pool {
+private:
+  using task = std::function<void()>;
+
+  struct task_queue {
+    std::mutex mutex;
+    std::deque<task> tasks;
+  };
+
+  struct worker_info {
+    const thread_pool* pool = nullptr;
+    size_t index = 0;
+  };
+
+  struct range_job {
+    size_t count;
+    size_t chunk_size;
+    size_t chunk_count;
+    const std::function<void(size_t, size_t)>& body;
+
+    std::atomic<size_t> next_chunk{0};
+    std::atomic<size_t> done_chunks{0};
+    std::atomic<bool> failed{false};
+
+    std::mutex mutex;
+    std::condition_variable done;
+    std::exception_ptr exception;
+
+    range_job(
+      const size_t i_count, const size_t i_chunk_size,
+      const std::function<void(size_t, size_t)>& i_body)
+      : count{i_count}
+      , chunk_size{i_chunk_size}
+      , chunk_count{(i_count + i_chunk_size - 1u) / i_chunk_size}
+      , body{i_body} {}
+
+    void run() {
+      while (true) {
+        const auto chunk = next_chunk.fetch_add(1u);
+        if (chunk >= chunk_count) {
+          return;
+        }
+
+        if (!failed) {
+          const auto begin = chunk * chunk_size;
+          const auto end = std::min(begin + chunk_size, count);
+          try {
+            body(begin, end);
+          } catch (...) {
+            auto lock = std::lock_guard{mutex};
+            if (!exception) {
+              exception = std::current_exception();
+            }
+            failed = true;
+          }
+        }
+
+        if (done_chunks.fetch_add(1u) + 1u == chunk_count) {
+          auto lock = std::lock_guard{mutex};
+          done.notify_all();
+        }
+      }
+    }
+
+    void wait() {
+      auto lock = std::unique_lock{mutex};
+      done.wait(lock, [&]() {
+        return done_chunks == chunk_count;
+      });
+    }
+  };
+
+  size_t m_worker_count;
+
+  // one queue per worker, followed by the queue shared by all other threads
+  std::vector<std::unique_ptr<task_queue>> m_queues;
+  std::vector<std::thread> m_workers;
+
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  std::atomic<size_t> m_pending_tasks{0};
+  bool m_stop{false};
+
+public:
+  /**
+   * Returns the pool shared by all parallel algorithms in kdl.
+   *
+   * The calling thread participates in the work, so the pool has one worker less than the number of
+   * threads returned by std::thread::hardware_concurrency().
+   */
+  static thread_pool& shared() {
+    static auto pool = thread_pool{default_worker_count()};
+    return pool;
+  }
+
+  /**
+   * Creates a pool with the given number of worker threads. If the number is 0, all work is done
+   * on the calling thread.
+   */
+  explicit thread_pool(const size_t worker_count)
+    : m_worker_count{worker_count} {
+    for (size_t i = 0; i < m_worker_count + 1u; ++i) {
+      m_queues.push_back(std::make_unique<task_queue>());
+    }
+    m_workers.reserve(m_worker_count);
+    for (size_t i = 0; i < m_worker_count; ++i) {
+      m_workers.emplace_back([this, i]() {
+        run_worker(i);
+      });
+    }
+  }
+
+  thread_pool(const thread_pool&) = delete;
+  thread_pool& operator=(const thread_pool&) = delete;
+
+  ~thread_pool() {
+    {
+      auto lock = std::lock_guard{m_mutex};
+      m_stop = true;
+    }
+    m_condition.notify_all();
+    for (auto& worker : m_workers) {
+      worker.join();
+    }
+  }
+
+  /**
+   * Returns the number of worker threads, not counting the threads that call for_each_chunk.
+   */
+  size_t worker_count() const { return m_worker_count; }
+
+  /**
+   * Splits the range `[0, count)` into chunks of `chunk_size` indices and calls `body(begin, end)`
+   * for each chunk, in parallel. Returns when all chunks have been processed.
+   *
+   * If `chunk_size` is 0, a chunk size is chosen so that every thread gets a few chunks to balance
+   * the load.
+   *
+   * If `body` throws, the remaining chunks are skipped and the first exception is rethrown once all
+   * chunks that were already started have finished.
+   */
+  template <typename L> void for_each_chunk(const size_t count, size_t chunk_size, L&& body) {
+    if (count == 0u) {
+      return;
+    }
+
+    if (chunk_size == 0u) {
+      chunk_size = std::max(count / ((worker_count() + 1u) * 4u), size_t(1));
+    }
+
+    const auto type_erased_body = std::function<void(size_t, size_t)>{std::forward<L>(body)};
+    const auto job = std::make_shared<range_job>(count, chunk_size, type_erased_body);
+
+    const auto helper_count = std::min(worker_count(), job->chunk_count - 1u);
+    for (size_t i = 0; i < helper_count; ++i) {
+      push([job]() {
+        job->run();
+      });
+    }
+
+    job->run();
+    job->wait();
+
+    if (job->exception) {
+      std::rethrow_exception(job->exception);
+    }
+  }
+
+  /**
+   * Calls `lambda(i)` for every index `i` in `[0, count)`, in parallel.
+   *
+   * @see for_each_chunk
+   */
+  template <typename L>
+  void parallel_for(const size_t count, L&& lambda, const size_t chunk_size = 0u) {
+    for_each_chunk(count, chunk_size, [&](const size_t begin, const size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        lambda(i);
+      }
+    });
+  }
+
+  /**
+   * Runs the given task on a worker thread and returns without waiting for it. If this pool has no
+   * workers, the task is run on the calling thread instead. Tasks that are still pending when the
+   * pool is destroyed are run before the destructor returns.
+   *
+   * The task must not throw.
+   */
+  void submit(task t) {
+    if (m_worker_count == 0u) {
+      t();
+    } else {
+      push(std::move(t));
+    }
+  }
+
+private:
+  static size_t default_worker_count() {
+    const auto thread_count = static_cast<size_t>(std::thread::hardware_concurrency());
+    return thread_count > 1u ? thread_count - 1u : 0u;
+  }
+
+  static worker_info& current_worker() {
+    static thread_local auto info = worker_info{};
+    return info;
+  }
+
+  size_t shared_queue_index() const { return m_queues.size() - 1u; }
+
+  void push(task t) {
+    const auto& worker = current_worker();
+    const auto index = worker.pool == this ? worker.index : shared_queue_index();
+
+    // count the task before it becomes visible, otherwise a worker could pop it and decrement the
+    // count before it was incremented
+    ++m_pending_tasks;
+    {
+      auto& queue = *m_queues[index];
+      auto lock = std::lock_guard{queue.mutex};
+      queue.tasks.push_back(std::move(t));
+    }
+
+    // acquire the mutex so that a worker cannot miss the notification between checking for pending
+    // tasks and going to sleep
+    {
+      auto lock = std::lock_guard{m_mutex};
+    }
+    m_condition.notify_one();
+  }
+
+  bool try_pop(const size_t worker_index, task& result) {
+    const auto try_pop_from = [&](const size_t index, const bool back) {
+      auto& queue = *m_queues[index];
+      auto lock = std::lock_guard{queue.mutex};
+      if (queue.tasks.empty()) {
+        return false;
+      }
+      if (back) {
+        result = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+      } else {
+        result = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+      }
+      --m_pending_tasks;
+      return true;
+    };
+
+    if (try_pop_from(worker_index, true) || try_pop_from(shared_queue_index(), false)) {
+      return true;
+    }
+
+    for (size_t i = 1; i < m_worker_count; ++i) {
+      if (try_pop_from((worker_index + i) % m_worker_count, false)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void run_worker(const size_t index) {
+    current_worker() = worker_info{this, index};
+
+    auto t = task{};
+    while (true) {
+      if (try_pop(index, t)) {
+        t();
+        t = nullptr;
+        continue;
+      }
+
+      auto lock = std::unique_lock{m_mutex};
+      m_condition.wait(lock, [&]() {
+        return m_stop || m_pending_tasks > 0u;
+      });
+      if (m_stop && m_pending_tasks == 0u) {
+        return;
+      }
+    }
+  }
+};
+} // namespace kdl
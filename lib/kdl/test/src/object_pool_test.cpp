@@ -0,0 +1,112 @@
+/*
+ Copyright 2023 Kristian Duske
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ associated documentation files (the "Software"), to deal in the Software without restriction,
+ including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or
+ substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT
+ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "kdl/object_pool.h"
+
+#include <cstdint>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace kdl {
+namespace {
+struct alignas(32) pooled {
+  int value;
+
+  explicit pooled(const int i_value)
+    : value{i_value} {}
+
+  static void* operator new(std::size_t) { return object_pool<pooled, 4>::allocate(); }
+  static void operator delete(void* ptr) { object_pool<pooled, 4>::deallocate(ptr); }
+};
+
+struct released {
+  int value;
+
+  static void* operator new(std::size_t) { return object_pool<released, 4>::allocate(); }
+  static void operator delete(void* ptr) { object_pool<released, 4>::deallocate(ptr); }
+};
+} // namespace
+
+TEST_CASE("object_pool.allocate", "[object_pool_test]") {
+  auto objects = std::vector<pooled*>{};
+  for (int i = 0; i < 100; ++i) {
+    objects.push_back(new pooled{i});
+  }
+
+  // all objects are distinct, aligned and intact
+  CHECK(std::set<pooled*>(objects.begin(), objects.end()).size() == objects.size());
+  for (size_t i = 0; i < objects.size(); ++i) {
+    CHECK(reinterpret_cast<std::uintptr_t>(objects[i]) % alignof(pooled) == 0u);
+    CHECK(objects[i]->value == static_cast<int>(i));
+  }
+
+  for (auto* object : objects) {
+    delete object;
+  }
+}
+
+TEST_CASE("object_pool.reuse", "[object_pool_test]") {
+  auto* first = new pooled{1};
+  delete first;
+
+  auto* second = new pooled{2};
+  CHECK(second == first);
+  delete second;
+}
+
+TEST_CASE("object_pool.deallocateOnOtherThread", "[object_pool_test]") {
+  auto objects = std::vector<pooled*>{};
+  auto thread = std::thread{[&]() {
+    for (int i = 0; i < 100; ++i) {
+      objects.push_back(new pooled{i});
+    }
+  }};
+  thread.join();
+
+  for (size_t i = 0; i < objects.size(); ++i) {
+    CHECK(objects[i]->value == static_cast<int>(i));
+    delete objects[i];
+  }
+}
+
+TEST_CASE("object_pool.releaseEmptySlabs", "[object_pool_test]") {
+  auto thread = std::thread{[]() {
+    auto objects = std::vector<released*>{};
+    for (int i = 0; i < 100; ++i) {
+      objects.push_back(new released{i});
+    }
+    CHECK(object_pool<released, 4>::slab_count() == 25u);
+
+    for (auto* object : objects) {
+      delete object;
+    }
+  }};
+  thread.join();
+
+  // the exiting thread has returned its cached blocks, and all slabs but one were released
+  CHECK(object_pool<released, 4>::slab_count() == 1u);
+
+  auto* object = new released{1};
+  CHECK(object_pool<released, 4>::slab_count() == 1u);
+  delete object;
+}
+} // namespace kdl
@@ -0,0 +1,135 @@
+/*
+ Copyright 2023 Kristian Duske
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ associated documentation files (the "Software"), to deal in the Software without restriction,
+ including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or
+ substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT
+ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "kdl/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace kdl {
+TEST_CASE("thread_pool.for_each_chunk", "[thread_pool_test]") {
+  const auto workerCount = GENERATE(size_t(0), size_t(1), size_t(4));
+  auto pool = thread_pool{workerCount};
+
+  CHECK(pool.worker_count() == workerCount);
+
+  SECTION("empty range") {
+    auto ran = false;
+    pool.for_each_chunk(0, 0, [&](size_t, size_t) {
+      ran = true;
+    });
+    CHECK(!ran);
+  }
+
+  SECTION("every index is visited once") {
+    const auto count = GENERATE(size_t(1), size_t(7), size_t(1000));
+    const auto chunkSize = GENERATE(size_t(0), size_t(1), size_t(3), size_t(2000));
+
+    // Catch2 assertions are not thread safe, so the chunks are only recorded by the workers
+    auto chunksMutex = std::mutex{};
+    auto chunks = std::vector<std::pair<size_t, size_t>>{};
+    pool.for_each_chunk(count, chunkSize, [&](const size_t begin, const size_t end) {
+      const auto lock = std::lock_guard{chunksMutex};
+      chunks.emplace_back(begin, end);
+    });
+
+    auto visited = std::vector<size_t>(count, 0u);
+    for (const auto& [begin, end] : chunks) {
+      CHECK(begin < end);
+      CHECK(end <= count);
+      if (chunkSize > 0) {
+        CHECK(end - begin <= chunkSize);
+      }
+      for (size_t i = begin; i < std::min(end, count); ++i) {
+        ++visited[i];
+      }
+    }
+
+    CHECK(visited == std::vector<size_t>(count, 1u));
+  }
+}
+
+TEST_CASE("thread_pool.parallel_for", "[thread_pool_test]") {
+  auto pool = thread_pool{3};
+
+  SECTION("nested parallel_for") {
+    constexpr size_t Outer = 16;
+    constexpr size_t Inner = 100;
+
+    auto counter = std::atomic<size_t>{0};
+    pool.parallel_for(
+      Outer,
+      [&](const size_t) {
+        pool.parallel_for(Inner, [&](const size_t) {
+          ++counter;
+        });
+      },
+      1);
+
+    CHECK(counter == Outer * Inner);
+  }
+
+  SECTION("exceptions are rethrown") {
+    CHECK_THROWS_AS(
+      pool.parallel_for(
+        100,
+        [](const size_t i) {
+          if (i == 42) {
+            throw std::runtime_error{"42"};
+          }
+        },
+        1),
+      std::runtime_error);
+
+    // the pool is still usable afterwards
+    auto counter = std::atomic<size_t>{0};
+    pool.parallel_for(100, [&](const size_t) {
+      ++counter;
+    });
+    CHECK(counter == 100u);
+  }
+}
+
+TEST_CASE("thread_pool.submit", "[thread_pool_test]") {
+  const auto workerCount = GENERATE(size_t(0), size_t(1), size_t(4));
+
+  auto counter = std::atomic<size_t>{0};
+  {
+    auto pool = thread_pool{workerCount};
+    for (size_t i = 0; i < 100; ++i) {
+      pool.submit([&]() {
+        ++counter;
+      });
+    }
+  }
+
+  // the pool runs all pending tasks before it is destroyed
+  CHECK(counter == 100u);
+}
+
+TEST_CASE("thread_pool.shared", "[thread_pool_test]") {
+  CHECK(&thread_pool::shared() == &thread_pool::shared());
+}
+} // namespace kdl